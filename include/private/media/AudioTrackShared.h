@@ -17,6 +17,7 @@
 #ifndef ANDROID_AUDIO_TRACK_SHARED_H
 #define ANDROID_AUDIO_TRACK_SHARED_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <sys/types.h>
 
@@ -53,19 +54,42 @@ namespace android {
 //EL_FIXME 20 seconds may not be enough and must be reconciled with new obtainBuffer implementation
 #define MAX_RUN_OFFLOADED_TIMEOUT_MS 20000 // assuming up to a maximum of 20 seconds of offloaded
 
+// Layout of audio_track_cblk_t, set by the server and checked by the client proxy.
+// Version 2 separates the consumer and producer state of the streaming ring buffer.
+#define CBLK_VERSION 2
+
+// Size of a line of data cache, used to keep the state written by the client and the state
+// written by the server apart in shared memory.
+#define CBLK_CACHE_LINE_SIZE 64
+
 struct AudioTrackSharedStreaming {
     // similar to NBAIO MonoPipe
     // in continuously incrementing frame units, take modulo buffer size, which must be a power of 2
+    //
+    // The consumer state and the producer state are CBLK_CACHE_LINE_SIZE bytes apart, so that
+    // the client and the server do not write the same line of data cache for every buffer.
+    // The control block is not necessarily aligned on a line of data cache, so padding is used
+    // rather than alignas().
+
+    // consumer state
     volatile int32_t mFront;    // read by consumer (output: server, input: client)
+    volatile uint32_t mUnderrunFrames; // server increments for each unavailable but desired frame
+    volatile uint32_t mUnderrunCount;  // server increments for each underrun occurrence
+             uint8_t  mPadConsumer[CBLK_CACHE_LINE_SIZE - 3 * sizeof(int32_t)];
+
+    // producer state
     volatile int32_t mRear;     // written by producer (output: client, input: server)
     volatile int32_t mFlush;    // incremented by client to indicate a request to flush;
                                 // server notices and discards all data between mFront and mRear
     volatile int32_t mStop;     // set by client to indicate a stop frame position; server
                                 // will not read beyond this position until start is called.
-    volatile uint32_t mUnderrunFrames; // server increments for each unavailable but desired frame
-    volatile uint32_t mUnderrunCount;  // server increments for each underrun occurrence
+             uint8_t  mPadProducer[CBLK_CACHE_LINE_SIZE - 3 * sizeof(int32_t)];
 };
 
+static_assert(offsetof(AudioTrackSharedStreaming, mRear) -
+        offsetof(AudioTrackSharedStreaming, mFront) == CBLK_CACHE_LINE_SIZE,
+        "the consumer and producer state must be on separate lines of data cache");
+
 // Represents a single state of an AudioTrack that was created in static mode (shared memory buffer
 // supplied by the client).  This state needs to be communicated from the client to server.  As this
 // state is too large to be updated atomically without a mutex, and mutexes aren't allowed here, the
@@ -151,7 +175,7 @@ struct audio_track_cblk_t
                                         // "for entertainment purposes only",
                                         // which means don't make important decisions based on it.
 
-                uint32_t    mPad1;      // unused
+                uint32_t    mVersion;   // CBLK_VERSION of the server, checked by the client
 
     volatile    int32_t     mFutex;     // event flag: down (P) by client,
                                         // up (V) by server or binderDied() or interrupt()
@@ -283,6 +307,20 @@ public:
     status_t    obtainBuffer(Buffer* buffer, const struct timespec *requested = NULL,
             struct timespec *elapsed = NULL);
 
+    // Like obtainBuffer(), but also returns the frames which wrap around to the start of the
+    // buffer, as a second region. This saves an obtainBuffer() and releaseBuffer() cycle at
+    // every wraparound, which matters for fast tracks exchanging small buffers.
+    // On entry:
+    //  buffers[0].mFrameCount is the maximum number of desired frames, which must be > 0.
+    // On exit:
+    //  buffers[0] is as returned by obtainBuffer(), except that buffers[0].mNonContig does not
+    //      count the frames of buffers[1].
+    //  buffers[1].mFrameCount has the number of frames at the start of the buffer, or 0.
+    //  buffers[1].mRaw is the start of the buffer, or NULL when buffers[1].mFrameCount == 0.
+    // The frames of both regions are released by releaseBuffer() with their total count.
+    status_t    obtainBuffers(Buffer buffers[2], const struct timespec *requested = NULL,
+            struct timespec *elapsed = NULL);
+
     // Release (some of) the frames last obtained.
     // On entry, buffer->mFrameCount should have the number of frames to release,
     // which must (cumulatively) be <= the number of frames last obtained but not yet released.
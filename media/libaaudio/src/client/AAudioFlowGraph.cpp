@@ -34,6 +34,25 @@
 
 using namespace flowgraph;
 
+static bool convertToSampleFormat(audio_format_t format, FusedConverter::SampleFormat *result) {
+    switch (format) {
+        case AUDIO_FORMAT_PCM_FLOAT:
+            *result = FusedConverter::SampleFormat::Float;
+            return true;
+        case AUDIO_FORMAT_PCM_16_BIT:
+            *result = FusedConverter::SampleFormat::I16;
+            return true;
+        case AUDIO_FORMAT_PCM_24_BIT_PACKED:
+            *result = FusedConverter::SampleFormat::I24Packed;
+            return true;
+        case AUDIO_FORMAT_PCM_32_BIT:
+            *result = FusedConverter::SampleFormat::I32;
+            return true;
+        default:
+            return false;
+    }
+}
+
 aaudio_result_t AAudioFlowGraph::configure(audio_format_t sourceFormat,
                           int32_t sourceChannelCount,
                           audio_format_t sinkFormat,
@@ -105,12 +124,39 @@ aaudio_result_t AAudioFlowGraph::configure(audio_format_t sourceFormat,
     }
     lastOutput->connect(&mSink->input);
 
+    // Compile the chain of nodes into a single kernel.
+    // The nodes are kept because the volume ramp holds the gain state used by the kernel.
+    FusedConverter::SampleFormat fusedSourceFormat;
+    FusedConverter::SampleFormat fusedSinkFormat;
+    if (convertToSampleFormat(sourceFormat, &fusedSourceFormat)
+            && convertToSampleFormat(sinkFormat, &fusedSinkFormat)) {
+        mFusedConverter.configure(fusedSourceFormat, sourceChannelCount,
+                                  fusedSinkFormat, sinkChannelCount,
+                                  mClipper != nullptr,
+                                  kDefaultMinHeadroom, kDefaultMaxHeadroom);
+    }
+    ALOGD("%s() fused = %d", __func__, mFusedConverter.isConfigured());
+
     return AAUDIO_OK;
 }
 
 void AAudioFlowGraph::process(const void *source, void *destination, int32_t numFrames) {
-    mSource->setData(source, numFrames);
-    mSink->read(destination, numFrames);
+    if (!isFused()) {
+        mSource->setData(source, numFrames);
+        mSink->read(destination, numFrames);
+        return;
+    }
+
+    int32_t frameIndex = 0;
+    while (frameIndex < numFrames) {
+        float level;
+        float levelIncrement;
+        int32_t framesToProcess = mVolumeRamp->nextSegment(numFrames - frameIndex,
+                                                           &level, &levelIncrement);
+        mFusedConverter.process(source, destination, frameIndex, framesToProcess,
+                                level, levelIncrement);
+        frameIndex += framesToProcess;
+    }
 }
 
 /**
@@ -24,6 +24,7 @@
 
 #include <aaudio/AAudio.h>
 #include <flowgraph/ClipToRange.h>
+#include <flowgraph/FusedConverter.h>
 #include <flowgraph/MonoToMultiConverter.h>
 #include <flowgraph/RampLinear.h>
 
@@ -52,12 +53,33 @@ public:
 
     void setRampLengthInFrames(int32_t numFrames);
 
+    /**
+     * Run the graph node by node instead of through the fused kernel.
+     * This is used to compare both paths and should be called before process().
+     *
+     * @param enabled true to use the fused kernel when the graph supports it, the default
+     */
+    void setFusionEnabled(bool enabled) {
+        mFusionEnabled = enabled;
+    }
+
+    /**
+     * @return true if process() uses the fused kernel
+     */
+    bool isFused() const {
+        return mFusionEnabled && mFusedConverter.isConfigured();
+    }
+
 private:
     std::unique_ptr<flowgraph::AudioSource>          mSource;
     std::unique_ptr<flowgraph::RampLinear>           mVolumeRamp;
     std::unique_ptr<flowgraph::ClipToRange>          mClipper;
     std::unique_ptr<flowgraph::MonoToMultiConverter> mChannelConverter;
     std::unique_ptr<flowgraph::AudioSink>            mSink;
+
+    // Does the work of all the nodes above in one pass.
+    flowgraph::FusedConverter                        mFusedConverter;
+    bool                                             mFusionEnabled = true;
 };
 
 
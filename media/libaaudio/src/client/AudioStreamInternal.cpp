@@ -759,6 +759,7 @@ aaudio_result_t AudioStreamInternal::processData(void *buffer, int32_t numFrames
 
             AudioClock::sleepUntilNanoTime(wakeTimeNanos);
             currentTimeNanos = AudioClock::getNanoseconds();
+            mClockModel.processWakeup(wakeTimeNanos, currentTimeNanos);
         }
     }
 
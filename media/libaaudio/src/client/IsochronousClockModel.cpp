@@ -22,6 +22,7 @@
 #include <inttypes.h>
 #include <stdint.h>
 #include <algorithm>
+#include <cmath>
 
 #include "utility/AudioClock.h"
 #include "utility/AAudioUtilities.h"
@@ -35,12 +36,18 @@ using namespace android::audio_utils;
 #define ICM_LOG_DRIFT   0
 #endif // ICM_LOG_DRIFT
 
+#ifndef ICM_LOG_TIMESTAMPS
+#define ICM_LOG_TIMESTAMPS   0
+#endif // ICM_LOG_TIMESTAMPS
+
 // To enable the timestamp histogram, enter this before opening the stream:
 //    adb root
 //    adb shell setprop aaudio.log_mask 1
 // A histogram of the lateness of the timestamps will be cleared when the stream is started.
 // It will be updated when the model is stable and receives a timestamp,
 // and dumped to the log when the stream is stopped.
+// The histograms are also enabled in adaptive mode:
+//    adb shell setprop aaudio.clock_model_adaptive true
 
 IsochronousClockModel::IsochronousClockModel()
         : mMarkerFramePosition(0)
@@ -52,10 +59,45 @@ IsochronousClockModel::IsochronousClockModel()
         , mLatenessForDriftNanos(kInitialLatenessForDriftNanos)
         , mState(STATE_STOPPED)
 {
-    if ((AAudioProperty_getLogMask() & AAUDIO_LOG_CLOCK_MODEL_HISTOGRAM) != 0) {
+    mLogHistograms = (AAudioProperty_getLogMask() & AAUDIO_LOG_CLOCK_MODEL_HISTOGRAM) != 0;
+    if (mLogHistograms) {
         mHistogramMicros = std::make_unique<Histogram>(kHistogramBinCount,
                 kHistogramBinWidthMicros);
+        mWakeupHistogramMicros = std::make_unique<Histogram>(kHistogramBinCount,
+                kHistogramBinWidthMicros);
+    }
+    setAdaptive(AAudioProperty_isClockModelAdaptive());
+}
+
+void IsochronousClockModel::setAdaptive(bool adaptive) {
+    mAdaptive = adaptive;
+    if (mAdaptive) {
+        if (!mHistogramMicros) {
+            mHistogramMicros = std::make_unique<Histogram>(kHistogramBinCount,
+                    kHistogramBinWidthMicros);
+        }
+        if (!mWakeupHistogramMicros) {
+            mWakeupHistogramMicros = std::make_unique<Histogram>(kHistogramBinCount,
+                    kHistogramBinWidthMicros);
+        }
+        // Allocate now so that timestamps can be processed without allocating.
+        mLatenessWindow.reserve(kLatenessWindowSize);
+        mLatenessScratch.reserve(kLatenessWindowSize);
     }
+    resetAdaptiveState();
+}
+
+void IsochronousClockModel::resetAdaptiveState() {
+    mDriftSumWeights = 0.0;
+    mDriftSumFrames = 0.0;
+    mDriftSumNanos = 0.0;
+    mDriftSumFramesSquared = 0.0;
+    mDriftSumFramesNanos = 0.0;
+    mDriftTimestampCount = 0;
+    mNanosPerFrame = 0.0;
+    mLatenessWindow.clear();
+    mLatenessWindowIndex = 0;
+    mAdaptiveLatenessNanos = -1;
 }
 
 void IsochronousClockModel::setPositionAndTime(int64_t framePosition, int64_t nanoTime) {
@@ -71,6 +113,10 @@ void IsochronousClockModel::start(int64_t nanoTime) {
     if (mHistogramMicros) {
         mHistogramMicros->clear();
     }
+    if (mWakeupHistogramMicros) {
+        mWakeupHistogramMicros->clear();
+    }
+    resetAdaptiveState();
 }
 
 void IsochronousClockModel::stop(int64_t nanoTime) {
@@ -80,7 +126,7 @@ void IsochronousClockModel::stop(int64_t nanoTime) {
     setPositionAndTime(convertTimeToPosition(nanoTime), nanoTime);
     // TODO should we set position?
     mState = STATE_STOPPED;
-    if (mHistogramMicros) {
+    if (mLogHistograms) {
         dumpHistogram();
     }
 }
@@ -95,9 +141,12 @@ bool IsochronousClockModel::isRunning() const {
 
 void IsochronousClockModel::processTimestamp(int64_t framePosition, int64_t nanoTime) {
     mTimestampCount++;
-// Log position and time in CSV format so we can import it easily into spreadsheets.
-    //ALOGD("%s() CSV, %d, %lld, %lld", __func__,
-          //mTimestampCount, (long long)framePosition, (long long)nanoTime);
+#if ICM_LOG_TIMESTAMPS
+    // Log position and time in CSV format so we can import it easily into spreadsheets.
+    // These traces can also be replayed by test_clock_model.
+    ALOGD("%s() CSV, %d, %lld, %lld", __func__,
+          mTimestampCount, (long long)framePosition, (long long)nanoTime);
+#endif
     int64_t framesDelta = framePosition - mMarkerFramePosition;
     int64_t nanosDelta = nanoTime - mMarkerNanoTime;
     if (nanosDelta < 1000) {
@@ -108,7 +157,7 @@ void IsochronousClockModel::processTimestamp(int64_t framePosition, int64_t nano
 //         (long long)mMarkerFramePosition,
 //         (long long)mMarkerNanoTime);
 
-    int64_t expectedNanosDelta = convertDeltaPositionToTime(framesDelta);
+    int64_t expectedNanosDelta = convertModelDeltaPositionToTime(framesDelta);
 //    ALOGD("processTimestamp() - expectedNanosDelta = %lld, nanosDelta = %llu",
 //         (long long)expectedNanosDelta,
 //         (long long)nanosDelta);
@@ -136,6 +185,10 @@ void IsochronousClockModel::processTimestamp(int64_t framePosition, int64_t nano
         if (mHistogramMicros) {
             mHistogramMicros->add(latenessNanos / AAUDIO_NANOS_PER_MICROSECOND);
         }
+        if (mAdaptive) {
+            updateDriftEstimate(framePosition, nanoTime);
+            updateAdaptiveLateness(latenessNanos);
+        }
         // Modify estimated position based on lateness.
         // This affects the "early" side of the window, which controls output glitches.
         if (latenessNanos < 0) {
@@ -196,6 +249,84 @@ void IsochronousClockModel::processTimestamp(int64_t framePosition, int64_t nano
     }
 }
 
+void IsochronousClockModel::processWakeup(int64_t plannedNanoTime, int64_t actualNanoTime) {
+    if (mWakeupHistogramMicros && mState == STATE_RUNNING) {
+        mWakeupHistogramMicros->add((actualNanoTime - plannedNanoTime)
+                / AAUDIO_NANOS_PER_MICROSECOND);
+    }
+}
+
+// Fit time = a + b * position with exponentially decaying weights.
+// This is a recursive least-squares fit, so each timestamp costs the same.
+void IsochronousClockModel::updateDriftEstimate(int64_t framePosition, int64_t nanoTime) {
+    if (mDriftTimestampCount > 0) {
+        // Move the origin of the sums to the new timestamp.
+        const double c = (double) (framePosition - mDriftLastFramePosition);
+        const double d = (double) (nanoTime - mDriftLastNanoTime);
+        mDriftSumFramesNanos += -c * mDriftSumNanos - d * mDriftSumFrames
+                + c * d * mDriftSumWeights;
+        mDriftSumFramesSquared += -2.0 * c * mDriftSumFrames + c * c * mDriftSumWeights;
+        mDriftSumFrames -= c * mDriftSumWeights;
+        mDriftSumNanos -= d * mDriftSumWeights;
+
+        mDriftSumWeights *= kDriftForgettingFactor;
+        mDriftSumFrames *= kDriftForgettingFactor;
+        mDriftSumNanos *= kDriftForgettingFactor;
+        mDriftSumFramesSquared *= kDriftForgettingFactor;
+        mDriftSumFramesNanos *= kDriftForgettingFactor;
+    }
+    // Add the new timestamp, which is at the origin.
+    mDriftSumWeights += 1.0;
+    mDriftLastFramePosition = framePosition;
+    mDriftLastNanoTime = nanoTime;
+    mDriftTimestampCount++;
+
+    if (mDriftTimestampCount < kMinTimestampsForDrift) {
+        return;
+    }
+    const double denominator = mDriftSumWeights * mDriftSumFramesSquared
+            - mDriftSumFrames * mDriftSumFrames;
+    if (denominator <= 0.0) {
+        return; // all timestamps at the same position
+    }
+    const double slope = (mDriftSumWeights * mDriftSumFramesNanos
+            - mDriftSumFrames * mDriftSumNanos) / denominator;
+    const double nominalNanosPerFrame = (double) AAUDIO_NANOS_PER_SECOND / mSampleRate;
+    mNanosPerFrame = std::clamp(slope,
+                                nominalNanosPerFrame * (1.0 - kMaxDriftRatio),
+                                nominalNanosPerFrame * (1.0 + kMaxDriftRatio));
+}
+
+void IsochronousClockModel::updateAdaptiveLateness(int64_t latenessNanos) {
+    const int32_t lateness = (int32_t) std::clamp(latenessNanos,
+            (int64_t) INT32_MIN, (int64_t) INT32_MAX);
+    if ((int32_t) mLatenessWindow.size() < kLatenessWindowSize) {
+        mLatenessWindow.push_back(lateness);
+    } else {
+        mLatenessWindow[mLatenessWindowIndex] = lateness;
+    }
+    mLatenessWindowIndex = (mLatenessWindowIndex + 1) % kLatenessWindowSize;
+
+    // Wait for a full window, the legacy margin is used until then.
+    if ((int32_t) mLatenessWindow.size() < kLatenessWindowSize
+            || (mLatenessWindowIndex % kLatenessUpdatePeriod) != 0) {
+        return;
+    }
+    mLatenessScratch.assign(mLatenessWindow.begin(), mLatenessWindow.end());
+    auto percentile = mLatenessScratch.begin()
+            + (kLatenessWindowSize * kLatenessPerMille / 1000);
+    std::nth_element(mLatenessScratch.begin(), percentile, mLatenessScratch.end());
+    mAdaptiveLatenessNanos = std::max(0, *percentile);
+}
+
+double IsochronousClockModel::getDriftRatio() const {
+    if (mNanosPerFrame == 0.0) {
+        return 0.0;
+    }
+    const double nominalNanosPerFrame = (double) AAUDIO_NANOS_PER_SECOND / mSampleRate;
+    return (mNanosPerFrame - nominalNanosPerFrame) / nominalNanosPerFrame;
+}
+
 void IsochronousClockModel::setSampleRate(int32_t sampleRate) {
     mSampleRate = sampleRate;
     update();
@@ -219,6 +350,20 @@ int64_t IsochronousClockModel::convertDeltaTimeToPosition(int64_t nanosDelta) co
     return (mSampleRate * nanosDelta) / AAUDIO_NANOS_PER_SECOND;
 }
 
+int64_t IsochronousClockModel::convertModelDeltaPositionToTime(int64_t framesDelta) const {
+    if (mAdaptive && mNanosPerFrame > 0.0) {
+        return (int64_t) std::llround(framesDelta * mNanosPerFrame);
+    }
+    return convertDeltaPositionToTime(framesDelta);
+}
+
+int64_t IsochronousClockModel::convertModelDeltaTimeToPosition(int64_t nanosDelta) const {
+    if (mAdaptive && mNanosPerFrame > 0.0) {
+        return (int64_t) (nanosDelta / mNanosPerFrame); // truncate like the integer version
+    }
+    return convertDeltaTimeToPosition(nanosDelta);
+}
+
 int64_t IsochronousClockModel::convertPositionToTime(int64_t framePosition) const {
     if (mState == STATE_STOPPED) {
         return mMarkerNanoTime;
@@ -226,7 +371,7 @@ int64_t IsochronousClockModel::convertPositionToTime(int64_t framePosition) cons
     int64_t nextBurstIndex = (framePosition + mFramesPerBurst - 1) / mFramesPerBurst;
     int64_t nextBurstPosition = mFramesPerBurst * nextBurstIndex;
     int64_t framesDelta = nextBurstPosition - mMarkerFramePosition;
-    int64_t nanosDelta = convertDeltaPositionToTime(framesDelta);
+    int64_t nanosDelta = convertModelDeltaPositionToTime(framesDelta);
     int64_t time = mMarkerNanoTime + nanosDelta;
 //    ALOGD("convertPositionToTime: pos = %llu --> time = %llu",
 //         (unsigned long long)framePosition,
@@ -239,7 +384,7 @@ int64_t IsochronousClockModel::convertTimeToPosition(int64_t nanoTime) const {
         return mMarkerFramePosition;
     }
     int64_t nanosDelta = nanoTime - mMarkerNanoTime;
-    int64_t framesDelta = convertDeltaTimeToPosition(nanosDelta);
+    int64_t framesDelta = convertModelDeltaTimeToPosition(nanosDelta);
     int64_t nextBurstPosition = mMarkerFramePosition + framesDelta;
     int64_t nextBurstIndex = nextBurstPosition / mFramesPerBurst;
     int64_t position = nextBurstIndex * mFramesPerBurst;
@@ -252,6 +397,9 @@ int64_t IsochronousClockModel::convertTimeToPosition(int64_t nanoTime) const {
 }
 
 int32_t IsochronousClockModel::getLateTimeOffsetNanos() const {
+    if (mAdaptive && mAdaptiveLatenessNanos >= 0) {
+        return mAdaptiveLatenessNanos + kAdaptiveExtraLatenessNanos;
+    }
     return mMaxMeasuredLatenessNanos + kExtraLatenessNanos;
 }
 
@@ -270,13 +418,25 @@ void IsochronousClockModel::dump() const {
     ALOGD("mFramesPerBurst      = %6d", mFramesPerBurst);
     ALOGD("mMaxMeasuredLatenessNanos = %6d", mMaxMeasuredLatenessNanos);
     ALOGD("mState               = %6d", mState);
+    if (mAdaptive) {
+        ALOGD("mAdaptiveLatenessNanos = %6d", mAdaptiveLatenessNanos);
+        ALOGD("drift ratio          = %8.6f", getDriftRatio());
+    }
 }
 
 void IsochronousClockModel::dumpHistogram() const {
-    if (!mHistogramMicros) return;
-    std::istringstream istr(mHistogramMicros->dump());
-    std::string line;
-    while (std::getline(istr, line)) {
-        ALOGD("lateness, %s", line.c_str());
+    if (mHistogramMicros) {
+        std::istringstream istr(mHistogramMicros->dump());
+        std::string line;
+        while (std::getline(istr, line)) {
+            ALOGD("lateness, %s", line.c_str());
+        }
+    }
+    if (mWakeupHistogramMicros) {
+        std::istringstream istr(mWakeupHistogramMicros->dump());
+        std::string line;
+        while (std::getline(istr, line)) {
+            ALOGD("wakeup, %s", line.c_str());
+        }
     }
 }
@@ -18,6 +18,7 @@
 #define ANDROID_AAUDIO_ISOCHRONOUS_CLOCK_MODEL_H
 
 #include <stdint.h>
+#include <vector>
 
 #include <audio_utils/Histogram.h>
 
@@ -29,6 +30,12 @@ namespace aaudio {
  * Model an isochronous data stream using occasional timestamps as input.
  * This can be used to predict the position of the stream at a given time.
  *
+ * In adaptive mode, the rate of the hardware clock is estimated with a least-squares
+ * fit over recent timestamps instead of being nudged by a fixed drift.
+ * And the margin added to the late side of the timestamp window follows a high
+ * percentile of the recently measured lateness instead of a slowly decaying maximum.
+ * So a stream with little timing jitter can use a smaller buffer.
+ *
  * This class is not thread safe and should only be called from one thread.
  */
 class IsochronousClockModel {
@@ -52,6 +59,32 @@ public:
 
     void processTimestamp(int64_t framePosition, int64_t nanoTime);
 
+    /**
+     * Record how late a thread woke up compared to the time it planned based on this model.
+     * This only updates the wakeup histogram.
+     *
+     * @param plannedNanoTime time the thread asked to wake up
+     * @param actualNanoTime time the thread actually woke up
+     */
+    void processWakeup(int64_t plannedNanoTime, int64_t actualNanoTime);
+
+    /**
+     * Enable or disable the adaptive mode described above.
+     * The default is set by the AAUDIO_PROP_CLOCK_MODEL_ADAPTIVE property.
+     * This should be called before start().
+     */
+    void setAdaptive(bool adaptive);
+
+    bool isAdaptive() const {
+        return mAdaptive;
+    }
+
+    /**
+     * @return estimated relative error of the hardware clock, eg. 0.001 if 0.1% slow,
+     *         or 0.0 if not estimated
+     */
+    double getDriftRatio() const;
+
     /**
      * @param sampleRate rate of the stream in frames per second
      */
@@ -127,11 +160,35 @@ public:
 
     void dumpHistogram() const;
 
+    /**
+     * @return distribution of the timestamp lateness in microseconds,
+     *         or nullptr if histograms are not enabled
+     */
+    const android::audio_utils::Histogram *getLatenessHistogram() const {
+        return mHistogramMicros.get();
+    }
+
+    /**
+     * @return distribution of the wakeup lateness in microseconds,
+     *         or nullptr if histograms are not enabled
+     */
+    const android::audio_utils::Histogram *getWakeupHistogram() const {
+        return mWakeupHistogramMicros.get();
+    }
+
 private:
 
     int32_t getLateTimeOffsetNanos() const;
     void update();
 
+    // Like convertDeltaPositionToTime() but using the estimated rate of the hardware clock.
+    int64_t convertModelDeltaPositionToTime(int64_t framesDelta) const;
+    int64_t convertModelDeltaTimeToPosition(int64_t nanosDelta) const;
+
+    void resetAdaptiveState();
+    void updateDriftEstimate(int64_t framePosition, int64_t nanoTime);
+    void updateAdaptiveLateness(int64_t latenessNanos);
+
     enum clock_model_state_t {
         STATE_STOPPED,
         STATE_STARTING,
@@ -149,6 +206,23 @@ private:
     static constexpr int32_t   kHistogramBinWidthMicros = 50;
     static constexpr int32_t   kHistogramBinCount = 128;
 
+    // Weight of the previous timestamps in the drift estimate, for each new timestamp.
+    // This gives the fit a memory of a few hundred timestamps.
+    static constexpr double    kDriftForgettingFactor = 0.995;
+    // Number of timestamps needed before the drift estimate is used.
+    static constexpr int32_t   kMinTimestampsForDrift = 64;
+    // Real hardware should never be off by more than this.
+    static constexpr double    kMaxDriftRatio = 0.01;
+    // Number of recent lateness measurements used for the adaptive margin.
+    static constexpr int32_t   kLatenessWindowSize = 1024;
+    // Quantile of the lateness used for the adaptive margin, in units of 0.1%.
+    // Lower values reduce the latency of input streams but outliers will cause more glitches.
+    static constexpr int32_t   kLatenessPerMille = 995;
+    // Recalculate the adaptive margin after this many timestamps.
+    static constexpr int32_t   kLatenessUpdatePeriod = 16;
+    // Safety margin to add to the measured lateness percentile.
+    static constexpr int32_t   kAdaptiveExtraLatenessNanos = 50 * 1000;
+
     int64_t             mMarkerFramePosition; // Estimated HW position.
     int64_t             mMarkerNanoTime;      // Estimated HW time.
     int32_t             mSampleRate;
@@ -164,6 +238,29 @@ private:
 
     // distribution of timestamps relative to earliest
     std::unique_ptr<android::audio_utils::Histogram>   mHistogramMicros;
+    // distribution of thread wakeups relative to the planned time
+    std::unique_ptr<android::audio_utils::Histogram>   mWakeupHistogramMicros;
+
+    bool                mLogHistograms = false; // dump the histograms when stopped
+    bool                mAdaptive = false;
+    // Exponentially weighted sums for the least-squares fit of time versus position.
+    // They are relative to the last timestamp to keep the precision.
+    double              mDriftSumWeights = 0.0;
+    double              mDriftSumFrames = 0.0;
+    double              mDriftSumNanos = 0.0;
+    double              mDriftSumFramesSquared = 0.0;
+    double              mDriftSumFramesNanos = 0.0;
+    int64_t             mDriftLastFramePosition = 0;
+    int64_t             mDriftLastNanoTime = 0;
+    int32_t             mDriftTimestampCount = 0;
+    // Estimated duration of a frame, or 0.0 if not estimated yet.
+    double              mNanosPerFrame = 0.0;
+    // Recent lateness measurements, used as a circular buffer.
+    std::vector<int32_t> mLatenessWindow;
+    int32_t             mLatenessWindowIndex = 0;
+    std::vector<int32_t> mLatenessScratch; // for selecting the percentile without allocating
+    // Margin for the late side of the window, or -1 if not measured yet.
+    int32_t             mAdaptiveLatenessNanos = -1;
 
 };
 
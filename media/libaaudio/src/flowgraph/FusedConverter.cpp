@@ -0,0 +1,275 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <unistd.h>
+
+#ifdef __ANDROID__
+#include <audio_utils/primitives.h>
+#endif
+
+#include "AudioProcessorBase.h"
+#include "FlowgraphUtilities.h"
+#include "FusedConverter.h"
+
+// The vector conversions round like audio_utils, which the nodes only use on Android.
+// They also need the rounding conversions of AArch64.
+#if defined(__ANDROID__) && defined(__aarch64__)
+#ifndef USE_NEON
+#define USE_NEON (true)
+#endif
+#else
+#define USE_NEON (false)
+#endif
+#if USE_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace flowgraph;
+
+namespace {
+
+constexpr int kBytesPerI24Packed = 3;
+
+// Each format converts single samples the same way as the matching Source and Sink nodes.
+// Formats with kHasVector also convert four samples at a time.
+
+struct FormatFloat {
+    static float load(const void *data, int32_t index) {
+        return static_cast<const float *>(data)[index];
+    }
+    static void store(void *data, int32_t index, float sample) {
+        static_cast<float *>(data)[index] = sample;
+    }
+#if USE_NEON
+    static constexpr bool kHasVector = true;
+    static float32x4_t load4(const void *data, int32_t index) {
+        return vld1q_f32(static_cast<const float *>(data) + index);
+    }
+    static void store4(void *data, int32_t index, float32x4_t samples) {
+        vst1q_f32(static_cast<float *>(data) + index, samples);
+    }
+#endif
+};
+
+struct FormatI16 {
+    static constexpr float kScale = 1.0f / 32768;
+    static float load(const void *data, int32_t index) {
+        return static_cast<const int16_t *>(data)[index] * kScale;
+    }
+    static void store(void *data, int32_t index, float sample) {
+#ifdef __ANDROID__
+        static_cast<int16_t *>(data)[index] = clamp16_from_float(sample);
+#else
+        int32_t n = (int32_t) (sample * 32768.0f);
+        static_cast<int16_t *>(data)[index] = std::min(INT16_MAX, std::max(INT16_MIN, n)); // clip
+#endif
+    }
+#if USE_NEON
+    static constexpr bool kHasVector = true;
+    static float32x4_t load4(const void *data, int32_t index) {
+        int32x4_t n = vmovl_s16(vld1_s16(static_cast<const int16_t *>(data) + index));
+        return vmulq_n_f32(vcvtq_f32_s32(n), kScale);
+    }
+    static void store4(void *data, int32_t index, float32x4_t samples) {
+        // Round to nearest even then saturate, like clamp16_from_float().
+        int32x4_t n = vcvtnq_s32_f32(vmulq_n_f32(samples, 32768.0f));
+        vst1_s16(static_cast<int16_t *>(data) + index, vqmovn_s32(n));
+    }
+#endif
+};
+
+struct FormatI24Packed {
+    static constexpr float kScale = 1.0 / (1UL << 31);
+    static float load(const void *data, int32_t index) {
+        const uint8_t *byteData = static_cast<const uint8_t *>(data) + index * kBytesPerI24Packed;
+        // Assemble the data assuming Little Endian format.
+        int32_t pad = byteData[2];
+        pad <<= 8;
+        pad |= byteData[1];
+        pad <<= 8;
+        pad |= byteData[0];
+        pad <<= 8; // Shift to 32 bit data so the sign is correct.
+        return pad * kScale; // scale to range -1.0 to 1.0
+    }
+    static void store(void *data, int32_t index, float sample) {
+#ifdef __ANDROID__
+        int32_t n = clamp24_from_float(sample);
+#else
+        const int32_t kI24PackedMax = 0x007FFFFF;
+        const int32_t kI24PackedMin = 0xFF800000;
+        int32_t n = (int32_t) (sample * 0x00800000);
+        n = std::min(kI24PackedMax, std::max(kI24PackedMin, n)); // clip
+#endif
+        // Write as a packed 24-bit integer in Little Endian format.
+        uint8_t *byteData = static_cast<uint8_t *>(data) + index * kBytesPerI24Packed;
+        byteData[0] = (uint8_t) n;
+        byteData[1] = (uint8_t) (n >> 8);
+        byteData[2] = (uint8_t) (n >> 16);
+    }
+#if USE_NEON
+    static constexpr bool kHasVector = false;
+#endif
+};
+
+struct FormatI32 {
+    static constexpr float kScale = 1.0 / (1UL << 31);
+    static float load(const void *data, int32_t index) {
+        return static_cast<const int32_t *>(data)[index] * kScale;
+    }
+    static void store(void *data, int32_t index, float sample) {
+        static_cast<int32_t *>(data)[index] = FlowgraphUtilities::clamp32FromFloat(sample);
+    }
+#if USE_NEON
+    static constexpr bool kHasVector = true;
+    static float32x4_t load4(const void *data, int32_t index) {
+        int32x4_t n = vld1q_s32(static_cast<const int32_t *>(data) + index);
+        return vmulq_n_f32(vcvtq_f32_s32(n), kScale);
+    }
+    static void store4(void *data, int32_t index, float32x4_t samples) {
+        // Round to nearest with ties away from zero then saturate, like clamp32FromFloat().
+        int32x4_t n = vcvtaq_s32_f32(vmulq_n_f32(samples, 2147483648.0f));
+        vst1q_s32(static_cast<int32_t *>(data) + index, n);
+    }
+#endif
+};
+
+template <bool kClip>
+inline float scaleSample(const FusedConverter::Params &params, float sample, float level) {
+    sample *= level;
+    if (kClip) {
+        sample = std::min(params.clipMaximum, std::max(params.clipMinimum, sample));
+    }
+    return sample;
+}
+
+template <typename Source, typename Sink, bool kClip, bool kMonoToMulti>
+void fusedKernel(const FusedConverter::Params &params, const void *source, void *destination,
+                 int32_t startFrame, int32_t numFrames, float level, float levelIncrement) {
+    if (kMonoToMulti) {
+        // read one, write many
+        const int32_t channelCount = params.sinkChannelCount;
+        int32_t sinkIndex = startFrame * channelCount;
+        for (int32_t frame = 0; frame < numFrames; frame++) {
+            float sample = scaleSample<kClip>(params, Source::load(source, startFrame + frame),
+                                              level + frame * levelIncrement);
+            for (int32_t channel = 0; channel < channelCount; channel++) {
+                Sink::store(destination, sinkIndex++, sample);
+            }
+        }
+        return;
+    }
+
+    const int32_t channelCount = params.sourceChannelCount;
+    int32_t index = startFrame * channelCount;
+    if (levelIncrement != 0.0f) { // Ramping? This doesn't happen very often.
+        for (int32_t frame = 0; frame < numFrames; frame++) {
+            const float currentLevel = level + frame * levelIncrement;
+            for (int32_t channel = 0; channel < channelCount; channel++) {
+                Sink::store(destination, index,
+                            scaleSample<kClip>(params, Source::load(source, index),
+                                               currentLevel));
+                index++;
+            }
+        }
+        return;
+    }
+
+    const int32_t endIndex = index + numFrames * channelCount;
+#if USE_NEON
+    if constexpr (Source::kHasVector && Sink::kHasVector) {
+        const float32x4_t levels = vdupq_n_f32(level);
+        const float32x4_t minimums = vdupq_n_f32(params.clipMinimum);
+        const float32x4_t maximums = vdupq_n_f32(params.clipMaximum);
+        for (; index + 4 <= endIndex; index += 4) {
+            float32x4_t samples = vmulq_f32(Source::load4(source, index), levels);
+            if (kClip) {
+                samples = vminq_f32(maximums, vmaxq_f32(minimums, samples));
+            }
+            Sink::store4(destination, index, samples);
+        }
+    }
+#endif // USE_NEON
+    for (; index < endIndex; index++) {
+        Sink::store(destination, index,
+                    scaleSample<kClip>(params, Source::load(source, index), level));
+    }
+}
+
+template <typename Source, typename Sink>
+FusedConverter::Kernel selectKernel(bool clip, bool monoToMulti) {
+    if (monoToMulti) {
+        return clip ? fusedKernel<Source, Sink, true, true>
+                    : fusedKernel<Source, Sink, false, true>;
+    }
+    return clip ? fusedKernel<Source, Sink, true, false>
+                : fusedKernel<Source, Sink, false, false>;
+}
+
+template <typename Source>
+FusedConverter::Kernel selectKernel(FusedConverter::SampleFormat sinkFormat,
+                                    bool clip, bool monoToMulti) {
+    switch (sinkFormat) {
+        case FusedConverter::SampleFormat::Float:
+            return selectKernel<Source, FormatFloat>(clip, monoToMulti);
+        case FusedConverter::SampleFormat::I16:
+            return selectKernel<Source, FormatI16>(clip, monoToMulti);
+        case FusedConverter::SampleFormat::I24Packed:
+            return selectKernel<Source, FormatI24Packed>(clip, monoToMulti);
+        case FusedConverter::SampleFormat::I32:
+            return selectKernel<Source, FormatI32>(clip, monoToMulti);
+    }
+    return nullptr;
+}
+
+} // namespace
+
+bool FusedConverter::configure(SampleFormat sourceFormat,
+                               int32_t sourceChannelCount,
+                               SampleFormat sinkFormat,
+                               int32_t sinkChannelCount,
+                               bool clip,
+                               float clipMinimum,
+                               float clipMaximum) {
+    mKernel = nullptr;
+    bool monoToMulti = false;
+    if (sourceChannelCount == 1 && sinkChannelCount > 1) {
+        monoToMulti = true;
+    } else if (sourceChannelCount != sinkChannelCount || sourceChannelCount < 1) {
+        return false;
+    }
+
+    mParams.sourceChannelCount = sourceChannelCount;
+    mParams.sinkChannelCount = sinkChannelCount;
+    mParams.clipMinimum = clipMinimum;
+    mParams.clipMaximum = clipMaximum;
+
+    switch (sourceFormat) {
+        case SampleFormat::Float:
+            mKernel = selectKernel<FormatFloat>(sinkFormat, clip, monoToMulti);
+            break;
+        case SampleFormat::I16:
+            mKernel = selectKernel<FormatI16>(sinkFormat, clip, monoToMulti);
+            break;
+        case SampleFormat::I24Packed:
+            mKernel = selectKernel<FormatI24Packed>(sinkFormat, clip, monoToMulti);
+            break;
+        case SampleFormat::I32:
+            mKernel = selectKernel<FormatI32>(sinkFormat, clip, monoToMulti);
+            break;
+    }
+    return mKernel != nullptr;
+}
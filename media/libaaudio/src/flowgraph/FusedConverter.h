@@ -0,0 +1,105 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOWGRAPH_FUSED_CONVERTER_H
+#define FLOWGRAPH_FUSED_CONVERTER_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+namespace flowgraph {
+
+/**
+ * Performs the work of a linear chain of nodes in a single pass:
+ *
+ *     Source* -> RampLinear -> [ClipToRange] -> [MonoToMultiConverter] -> Sink*
+ *
+ * The chain is compiled by configure() into one kernel that is specialized
+ * for the source format, sink format, clipping and channel expansion.
+ * So each sample is converted, scaled, clipped and written without going
+ * through the intermediate float blocks of the nodes.
+ *
+ * The gain is provided by the caller, typically from RampLinear::nextSegment(),
+ * so that the ramp state stays in one place.
+ */
+class FusedConverter {
+public:
+    enum class SampleFormat {
+        Float,
+        I16,
+        I24Packed,
+        I32,
+    };
+
+    /**
+     * Select the kernel for a chain.
+     *
+     * @param sourceFormat
+     * @param sourceChannelCount
+     * @param sinkFormat
+     * @param sinkChannelCount equal to sourceChannelCount, or more if sourceChannelCount is 1
+     * @param clip true to clip the scaled samples to [clipMinimum, clipMaximum]
+     * @param clipMinimum
+     * @param clipMaximum
+     * @return true if the chain can be fused
+     */
+    bool configure(SampleFormat sourceFormat,
+                   int32_t sourceChannelCount,
+                   SampleFormat sinkFormat,
+                   int32_t sinkChannelCount,
+                   bool clip,
+                   float clipMinimum,
+                   float clipMaximum);
+
+    bool isConfigured() const {
+        return mKernel != nullptr;
+    }
+
+    /**
+     * Convert frames from the source to the destination.
+     * The gain of frame i is (level + i * levelIncrement).
+     *
+     * @param source start of the source data
+     * @param destination start of the destination data
+     * @param startFrame index in source and destination of the first frame to convert
+     * @param numFrames number of frames to convert
+     * @param level gain of the first frame
+     * @param levelIncrement change of the gain for each frame
+     */
+    void process(const void *source, void *destination, int32_t startFrame, int32_t numFrames,
+                 float level, float levelIncrement) const {
+        mKernel(mParams, source, destination, startFrame, numFrames, level, levelIncrement);
+    }
+
+    struct Params {
+        int32_t sourceChannelCount = 0;
+        int32_t sinkChannelCount = 0;
+        float clipMinimum = 0.0f;
+        float clipMaximum = 0.0f;
+    };
+
+    using Kernel = void (*)(const Params &params, const void *source, void *destination,
+                            int32_t startFrame, int32_t numFrames,
+                            float level, float levelIncrement);
+
+private:
+    Params mParams;
+    Kernel mKernel = nullptr;
+};
+
+} /* namespace flowgraph */
+
+#endif //FLOWGRAPH_FUSED_CONVERTER_H
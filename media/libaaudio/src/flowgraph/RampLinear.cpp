@@ -43,12 +43,7 @@ float RampLinear::interpolateCurrent() {
     return mLevelTo - (mRemaining * mScaler);
 }
 
-int32_t RampLinear::onProcess(int64_t framePosition, int32_t numFrames) {
-    int32_t framesToProcess = input.pullData(framePosition, numFrames);
-    const float *inputBuffer = input.getBlock();
-    float *outputBuffer = output.getBlock();
-    int32_t channelCount = output.getSamplesPerFrame();
-
+int32_t RampLinear::nextSegment(int32_t numFrames, float *level, float *levelIncrement) {
     float target = getTarget();
     if (target != mLevelTo) {
         // Start new ramp. Continue from previous level.
@@ -60,25 +55,43 @@ int32_t RampLinear::onProcess(int64_t framePosition, int32_t numFrames) {
         mScaler = (mLevelTo - mLevelFrom) / mLengthInFrames; // for interpolation
     }
 
-    int32_t framesLeft = framesToProcess;
-
     if (mRemaining > 0) { // Ramping? This doesn't happen very often.
-        int32_t framesToRamp = std::min(framesLeft, mRemaining);
-        framesLeft -= framesToRamp;
-        while (framesToRamp > 0) {
-            float currentLevel = interpolateCurrent();
-            for (int ch = 0; ch < channelCount; ch++) {
-                *outputBuffer++ = *inputBuffer++ * currentLevel;
-            }
-            mRemaining--;
-            framesToRamp--;
-        }
+        int32_t framesToRamp = std::min(numFrames, mRemaining);
+        *level = interpolateCurrent();
+        *levelIncrement = mScaler;
+        mRemaining -= framesToRamp;
+        return framesToRamp;
     }
+    *level = mLevelTo;
+    *levelIncrement = 0.0f;
+    return numFrames;
+}
 
-    // Process any frames after the ramp.
-    int32_t samplesLeft = framesLeft * channelCount;
-    for (int i = 0; i < samplesLeft; i++) {
-        *outputBuffer++ = *inputBuffer++ * mLevelTo;
+int32_t RampLinear::onProcess(int64_t framePosition, int32_t numFrames) {
+    int32_t framesToProcess = input.pullData(framePosition, numFrames);
+    const float *inputBuffer = input.getBlock();
+    float *outputBuffer = output.getBlock();
+    int32_t channelCount = output.getSamplesPerFrame();
+
+    int32_t framesLeft = framesToProcess;
+    while (framesLeft > 0) {
+        float level;
+        float levelIncrement;
+        int32_t framesInSegment = nextSegment(framesLeft, &level, &levelIncrement);
+        framesLeft -= framesInSegment;
+        if (levelIncrement != 0.0f) {
+            for (int32_t frame = 0; frame < framesInSegment; frame++) {
+                float currentLevel = level + frame * levelIncrement;
+                for (int ch = 0; ch < channelCount; ch++) {
+                    *outputBuffer++ = *inputBuffer++ * currentLevel;
+                }
+            }
+        } else {
+            int32_t numSamples = framesInSegment * channelCount;
+            for (int i = 0; i < numSamples; i++) {
+                *outputBuffer++ = *inputBuffer++ * level;
+            }
+        }
     }
 
     return framesToProcess;
@@ -66,6 +66,20 @@ public:
         mLevelTo = level;
     }
 
+    /**
+     * Get the gain for the next frames and advance the ramp past them.
+     * The gain of frame i in the segment is (*level + i * *levelIncrement).
+     * A new ramp is started if the target has changed.
+     *
+     * This is used by onProcess() and by converters that apply the gain themselves.
+     *
+     * @param numFrames maximum number of frames in the segment
+     * @param level gain of the first frame in the segment
+     * @param levelIncrement change of the gain for each frame
+     * @return number of frames in the segment, less than numFrames if a ramp ends
+     */
+    int32_t nextSegment(int32_t numFrames, float *level, float *levelIncrement);
+
     AudioFloatInputPort input;
     AudioFloatOutputPort output;
 
@@ -166,6 +166,15 @@ int32_t AAudioProperty_getInputMMapOffsetMicros();
 int32_t AAudioProperty_getOutputMMapOffsetMicros();
 #define AAUDIO_PROP_OUTPUT_MMAP_OFFSET_USEC   "aaudio.out_mmap_offset_usec"
 
+/**
+ * Read a system property that enables the adaptive mode of the IsochronousClockModel,
+ * which estimates the clock drift and adapts the timing margin to the measured jitter.
+ *
+ * @return true if the adaptive clock model should be used
+ */
+bool AAudioProperty_isClockModelAdaptive();
+#define AAUDIO_PROP_CLOCK_MODEL_ADAPTIVE   "aaudio.clock_model_adaptive"
+
 // These are powers of two that can be combined as a bit mask.
 // AAUDIO_LOG_CLOCK_MODEL_HISTOGRAM must be enabled before the stream is opened.
 #define AAUDIO_LOG_CLOCK_MODEL_HISTOGRAM   1
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Benchmark the AAudioFlowGraph that converts the app data in every callback
+ * of a legacy or shared AAudio stream. Compare the fused kernel with running
+ * the graph node by node.
+ *
+ * To run the benchmark:
+ *   adb shell /data/benchmarktest64/aaudio_flowgraph_benchmark/aaudio_flowgraph_benchmark
+ */
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "client/AAudioFlowGraph.h"
+
+// Typical burst size of a low latency stream.
+static constexpr int32_t kFramesPerCallback = 192;
+
+static const audio_format_t kFormats[] = {
+    AUDIO_FORMAT_PCM_FLOAT,
+    AUDIO_FORMAT_PCM_16_BIT,
+    AUDIO_FORMAT_PCM_24_BIT_PACKED,
+    AUDIO_FORMAT_PCM_32_BIT,
+};
+
+/*
+ * Process one callback.
+ * Args: source format index, sink format index, source channel count, sink channel count,
+ *       fused, ramping.
+ */
+static void BM_FlowGraph(benchmark::State& state) {
+    const audio_format_t sourceFormat = kFormats[state.range(0)];
+    const audio_format_t sinkFormat = kFormats[state.range(1)];
+    const int32_t sourceChannelCount = state.range(2);
+    const int32_t sinkChannelCount = state.range(3);
+    const bool fused = state.range(4);
+    const bool ramping = state.range(5);
+
+    // Four bytes per sample is enough for every format. Zeros are valid samples in all of them.
+    std::vector<uint8_t> input(kFramesPerCallback * sourceChannelCount * sizeof(int32_t));
+    std::vector<uint8_t> output(kFramesPerCallback * sinkChannelCount * sizeof(int32_t));
+
+    AAudioFlowGraph flowGraph;
+    if (flowGraph.configure(sourceFormat, sourceChannelCount,
+                            sinkFormat, sinkChannelCount) != AAUDIO_OK) {
+        state.SkipWithError("configure() failed");
+        return;
+    }
+    flowGraph.setFusionEnabled(fused);
+    // Ramp over whole callbacks so that each one is either ramping or not.
+    flowGraph.setRampLengthInFrames(kFramesPerCallback);
+
+    int64_t callbackCount = 0;
+    for (auto _ : state) {
+        if (ramping) {
+            flowGraph.setTargetVolume((callbackCount & 1) ? 0.5f : 0.75f);
+        }
+        flowGraph.process(input.data(), output.data(), kFramesPerCallback);
+        benchmark::ClobberMemory();
+        callbackCount++;
+    }
+
+    state.SetItemsProcessed(state.iterations() * kFramesPerCallback);
+    state.SetLabel(std::string(flowGraph.isFused() ? "fused" : "nodes")
+            + (ramping ? " ramp" : ""));
+}
+
+static void FlowGraphArgs(benchmark::internal::Benchmark* b) {
+    const int64_t numFormats = sizeof(kFormats) / sizeof(kFormats[0]);
+    for (int64_t sourceFormat = 0; sourceFormat < numFormats; sourceFormat++) {
+        for (int64_t sinkFormat = 0; sinkFormat < numFormats; sinkFormat++) {
+            for (auto channels : std::vector<std::pair<int64_t, int64_t>>{{1, 1}, {1, 2}, {2, 2}}) {
+                for (int64_t fused : {0, 1}) {
+                    b->Args({sourceFormat, sinkFormat, channels.first, channels.second, fused, 0});
+                }
+            }
+        }
+    }
+    // Ramping only matters for the common stereo cases.
+    for (int64_t sinkFormat : {0, 1}) {
+        for (int64_t fused : {0, 1}) {
+            b->Args({1, sinkFormat, 2, 2, fused, 1});
+        }
+    }
+}
+
+BENCHMARK(BM_FlowGraph)->Apply(FlowGraphArgs);
+
+BENCHMARK_MAIN();
@@ -19,6 +19,13 @@
 #include <math.h>
 #include <stdlib.h>
 
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
 
 #include <aaudio/AAudio.h>
 #include <audio_utils/clock.h>
@@ -163,4 +170,173 @@ TEST_F(ClockModelTestFixture, clock_slow_drift) {
 
 TEST_F(ClockModelTestFixture, clock_fast_drift) {
     checkDriftingClock(1.002 * SAMPLE_RATE, NUM_LOOPS_DRIFT);
-}
\ No newline at end of file
+}
+
+// Offline simulator that replays timestamp traces through the model.
+
+struct TimestampEvent {
+    int64_t position;
+    int64_t nanoTime;
+};
+
+struct ReplayResult {
+    int32_t checks = 0;
+    // Number of times the model claimed that a position was reached before the timestamp
+    // shows it. An input stream would read stale data then.
+    int32_t inputGlitches = 0;
+    // Average time between a timestamp and the latest time the model predicts for it.
+    // This is latency that an input stream has to add to avoid glitches.
+    double meanMarginMicros = 0.0;
+    double driftRatio = 0.0;
+};
+
+// Generate the timestamps of a DSP that runs at hardwareFramesPerSecond and reports bursts
+// with a jitter that is mostly small with occasional large delays.
+static std::vector<TimestampEvent> generateTrace(double hardwareFramesPerSecond,
+                                                 int32_t typicalJitterMicros,
+                                                 int32_t outlierJitterMicros,
+                                                 int numTimestamps,
+                                                 unsigned int seed) {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> burstsBetweenTimestamps(1, 10);
+    std::exponential_distribution<double> jitterMicros(1.0 / typicalJitterMicros);
+    std::bernoulli_distribution outlier(0.002);
+    std::vector<TimestampEvent> trace;
+    const int64_t startTimeNanos = 500000000; // arbitrary
+    int64_t position = HW_FRAMES_PER_BURST;
+    for (int i = 0; i < numTimestamps; i++) {
+        position += HW_FRAMES_PER_BURST * burstsBetweenTimestamps(generator);
+        double jitter = outlier(generator) ? outlierJitterMicros : jitterMicros(generator);
+        int64_t burstTimeNanos = startTimeNanos
+                + (int64_t) (position * (double) NANOS_PER_SECOND / hardwareFramesPerSecond);
+        trace.push_back({position, burstTimeNanos + (int64_t) (jitter * NANOS_PER_MICROSECOND)});
+    }
+    return trace;
+}
+
+// Parse a trace logged by IsochronousClockModel with ICM_LOG_TIMESTAMPS enabled.
+// Each line contains "CSV, index, position, nanoTime". Other lines are ignored.
+static std::vector<TimestampEvent> parseTrace(std::istream &input) {
+    std::vector<TimestampEvent> trace;
+    std::string line;
+    while (std::getline(input, line)) {
+        size_t csv = line.find("CSV,");
+        if (csv == std::string::npos) continue;
+        int index;
+        long long position;
+        long long nanoTime;
+        if (sscanf(line.c_str() + csv, "CSV, %d, %lld, %lld",
+                   &index, &position, &nanoTime) == 3) {
+            trace.push_back({position, nanoTime});
+        }
+    }
+    return trace;
+}
+
+static ReplayResult replayTrace(IsochronousClockModel &model,
+                                const std::vector<TimestampEvent> &trace) {
+    ReplayResult result;
+    if (trace.empty()) return result;
+    constexpr size_t kWarmupTimestamps = 500;
+    model.start(trace[0].nanoTime - NANOS_PER_MILLISECOND);
+    double marginSum = 0.0;
+    for (size_t i = 0; i < trace.size(); i++) {
+        const TimestampEvent &event = trace[i];
+        if (i >= kWarmupTimestamps && model.isRunning()) {
+            int64_t marginNanos = model.convertPositionToLatestTime(event.position)
+                    - event.nanoTime;
+            if (marginNanos < 0) {
+                result.inputGlitches++;
+            }
+            marginSum += marginNanos;
+            result.checks++;
+        }
+        model.processTimestamp(event.position, event.nanoTime);
+    }
+    if (result.checks > 0) {
+        result.meanMarginMicros = marginSum / result.checks / NANOS_PER_MICROSECOND;
+    }
+    result.driftRatio = model.getDriftRatio();
+    model.stop(trace.back().nanoTime);
+    return result;
+}
+
+static ReplayResult replayTrace(bool adaptive, const std::vector<TimestampEvent> &trace) {
+    IsochronousClockModel model;
+    model.setSampleRate(SAMPLE_RATE);
+    model.setFramesPerBurst(HW_FRAMES_PER_BURST);
+    model.setAdaptive(adaptive);
+    return replayTrace(model, trace);
+}
+
+// With low jitter, the adaptive model should need a smaller margin with few glitches.
+TEST(ClockModelReplay, clock_replay_low_jitter) {
+    for (double drift : {0.0, 0.0005, 0.001}) {
+        SCOPED_TRACE(testing::Message() << "drift = " << drift);
+        auto trace = generateTrace((1.0 + drift) * SAMPLE_RATE,
+                                   20 /* typical */, 400 /* outlier */, 20000, 1234);
+        ReplayResult legacy = replayTrace(false, trace);
+        ReplayResult adaptive = replayTrace(true, trace);
+        ASSERT_GT(adaptive.checks, 0);
+        EXPECT_LE(adaptive.inputGlitches, adaptive.checks / 100);
+        EXPECT_LT(adaptive.meanMarginMicros, legacy.meanMarginMicros);
+        // The model measures the duration of a frame, which is the inverse of the rate.
+        EXPECT_NEAR(1.0 / (1.0 + drift) - 1.0, adaptive.driftRatio, 0.0001);
+    }
+}
+
+// With a slow hardware clock, the legacy model drifts late and glitches more often.
+TEST(ClockModelReplay, clock_replay_slow_clock) {
+    auto trace = generateTrace(0.999 * SAMPLE_RATE, 100 /* typical */, 400 /* outlier */,
+                               20000, 1234);
+    ReplayResult legacy = replayTrace(false, trace);
+    ReplayResult adaptive = replayTrace(true, trace);
+    ASSERT_GT(adaptive.checks, 0);
+    EXPECT_LT(adaptive.inputGlitches, legacy.inputGlitches);
+    EXPECT_NEAR(1.0 / 0.999 - 1.0, adaptive.driftRatio, 0.0001);
+}
+
+// With high jitter, the adaptive model should widen the margin and stay mostly glitch free.
+TEST(ClockModelReplay, clock_replay_high_jitter) {
+    auto trace = generateTrace(1.0005 * SAMPLE_RATE, 300 /* typical */, 2000 /* outlier */,
+                               20000, 5678);
+    ReplayResult adaptive = replayTrace(true, trace);
+    ASSERT_GT(adaptive.checks, 0);
+    EXPECT_LE(adaptive.inputGlitches, adaptive.checks / 100);
+}
+
+TEST(ClockModelReplay, clock_replay_parse) {
+    auto trace = generateTrace(SAMPLE_RATE, 20, 400, 100, 42);
+    std::stringstream log;
+    log << "unrelated line\n";
+    for (size_t i = 0; i < trace.size(); i++) {
+        log << "D IsochronousClockModel: processTimestamp() CSV, " << (i + 1) << ", "
+            << trace[i].position << ", " << trace[i].nanoTime << "\n";
+    }
+    auto parsed = parseTrace(log);
+    ASSERT_EQ(trace.size(), parsed.size());
+    for (size_t i = 0; i < trace.size(); i++) {
+        EXPECT_EQ(trace[i].position, parsed[i].position);
+        EXPECT_EQ(trace[i].nanoTime, parsed[i].nanoTime);
+    }
+}
+
+// Replay a trace recorded on a device, for example with:
+//    adb logcat -d -s IsochronousClockModel > trace.txt
+// Set AAUDIO_CLOCK_TRACE to the path of the file on the device to run this test.
+TEST(ClockModelReplay, clock_replay_recorded) {
+    const char *path = getenv("AAUDIO_CLOCK_TRACE");
+    if (path == nullptr) {
+        GTEST_SKIP() << "AAUDIO_CLOCK_TRACE not set";
+    }
+    std::ifstream input(path);
+    ASSERT_TRUE(input.is_open()) << path;
+    auto trace = parseTrace(input);
+    ASSERT_FALSE(trace.empty());
+    ReplayResult legacy = replayTrace(false, trace);
+    ReplayResult adaptive = replayTrace(true, trace);
+    std::cout << "legacy: " << legacy.inputGlitches << " glitches in " << legacy.checks
+              << " checks, mean margin " << legacy.meanMarginMicros << " micros" << std::endl;
+    std::cout << "adaptive: " << adaptive.inputGlitches << " glitches in " << adaptive.checks
+              << " checks, mean margin " << adaptive.meanMarginMicros << " micros" << std::endl;
+}
@@ -19,9 +19,11 @@
  */
 
 #include <iostream>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#include "client/AAudioFlowGraph.h"
 #include "flowgraph/ClipToRange.h"
 #include "flowgraph/MonoToMultiConverter.h"
 #include "flowgraph/SourceFloat.h"
@@ -155,3 +157,112 @@ TEST(test_flowgraph, module_clip_to_range) {
         EXPECT_NEAR(expected[i], output[i], tolerance);
     }
 }
+
+static int32_t bytesPerSample(audio_format_t format) {
+    return format == AUDIO_FORMAT_PCM_24_BIT_PACKED ? kBytesPerI24Packed
+            : audio_bytes_per_sample(format);
+}
+
+// Decode a sample to a float so that outputs of different formats can be compared.
+static float decodeSample(audio_format_t format, const uint8_t *data, int32_t index) {
+    switch (format) {
+        case AUDIO_FORMAT_PCM_FLOAT:
+            return reinterpret_cast<const float *>(data)[index];
+        case AUDIO_FORMAT_PCM_16_BIT:
+            return reinterpret_cast<const int16_t *>(data)[index] / 32768.0f;
+        case AUDIO_FORMAT_PCM_24_BIT_PACKED: {
+            const uint8_t *bytes = &data[index * kBytesPerI24Packed];
+            int32_t n = (bytes[2] << 24) | (bytes[1] << 16) | (bytes[0] << 8);
+            return n / 2147483648.0f;
+        }
+        case AUDIO_FORMAT_PCM_32_BIT:
+            return reinterpret_cast<const int32_t *>(data)[index] / 2147483648.0f;
+        default:
+            return 0.0f;
+    }
+}
+
+// Run the same data through a fused graph and a node by node graph and compare the outputs.
+static void checkFusedGraph(audio_format_t sourceFormat, int32_t sourceChannelCount,
+                            audio_format_t sinkFormat, int32_t sinkChannelCount) {
+    constexpr int32_t kNumFrames = 100;
+    constexpr int32_t kRampLength = 37; // not a multiple of the block size
+    std::vector<float> floatInput(kNumFrames * sourceChannelCount);
+    for (size_t i = 0; i < floatInput.size(); i++) {
+        // Include values out of range to exercise clipping.
+        floatInput[i] = ((int32_t)(i * 7919) % 301 - 150) / 100.0f;
+    }
+    std::vector<uint8_t> input(floatInput.size() * bytesPerSample(sourceFormat));
+    for (size_t i = 0; i < floatInput.size(); i++) {
+        float sample = std::min(1.0f, std::max(-1.0f, floatInput[i]));
+        switch (sourceFormat) {
+            case AUDIO_FORMAT_PCM_FLOAT:
+                reinterpret_cast<float *>(input.data())[i] = floatInput[i];
+                break;
+            case AUDIO_FORMAT_PCM_16_BIT:
+                reinterpret_cast<int16_t *>(input.data())[i] = sample * INT16_MAX;
+                break;
+            case AUDIO_FORMAT_PCM_24_BIT_PACKED: {
+                int32_t n = sample * 0x7FFFFF;
+                input[i * kBytesPerI24Packed] = (uint8_t) n;
+                input[i * kBytesPerI24Packed + 1] = (uint8_t) (n >> 8);
+                input[i * kBytesPerI24Packed + 2] = (uint8_t) (n >> 16);
+            } break;
+            case AUDIO_FORMAT_PCM_32_BIT:
+                reinterpret_cast<int32_t *>(input.data())[i] = sample * INT32_MAX;
+                break;
+            default:
+                break;
+        }
+    }
+
+    const size_t outputSize = kNumFrames * sinkChannelCount * bytesPerSample(sinkFormat);
+    std::vector<uint8_t> fusedOutput(outputSize);
+    std::vector<uint8_t> nodeOutput(outputSize);
+    AAudioFlowGraph fusedGraph;
+    AAudioFlowGraph nodeGraph;
+    for (AAudioFlowGraph *graph : {&fusedGraph, &nodeGraph}) {
+        ASSERT_EQ(AAUDIO_OK, graph->configure(sourceFormat, sourceChannelCount,
+                                              sinkFormat, sinkChannelCount));
+        graph->setRampLengthInFrames(kRampLength);
+    }
+    nodeGraph.setFusionEnabled(false);
+    ASSERT_TRUE(fusedGraph.isFused());
+    ASSERT_FALSE(nodeGraph.isFused());
+
+    // Process at full volume, then during and after a ramp.
+    const int32_t bytesPerFrame = sinkChannelCount * bytesPerSample(sinkFormat);
+    for (float volume : {1.0f, 0.25f}) {
+        fusedGraph.setTargetVolume(volume);
+        nodeGraph.setTargetVolume(volume);
+        fusedGraph.process(input.data(), fusedOutput.data(), kNumFrames);
+        nodeGraph.process(input.data(), nodeOutput.data(), kNumFrames);
+
+        constexpr float tolerance = 0.0001f; // a few LSBs of 16-bit data
+        for (int32_t i = 0; i < kNumFrames * sinkChannelCount; i++) {
+            ASSERT_NEAR(decodeSample(sinkFormat, nodeOutput.data(), i),
+                        decodeSample(sinkFormat, fusedOutput.data(), i), tolerance)
+                    << "volume = " << volume << ", sample = " << i
+                    << ", frame = " << (i * bytesPerSample(sinkFormat) / bytesPerFrame);
+        }
+    }
+}
+
+TEST(test_flowgraph, fused_matches_nodes) {
+    static const audio_format_t formats[] = {
+        AUDIO_FORMAT_PCM_FLOAT,
+        AUDIO_FORMAT_PCM_16_BIT,
+        AUDIO_FORMAT_PCM_24_BIT_PACKED,
+        AUDIO_FORMAT_PCM_32_BIT,
+    };
+    for (audio_format_t sourceFormat : formats) {
+        for (audio_format_t sinkFormat : formats) {
+            SCOPED_TRACE(testing::Message() << "source format = " << sourceFormat
+                         << ", sink format = " << sinkFormat);
+            checkFusedGraph(sourceFormat, 1, sinkFormat, 1);
+            checkFusedGraph(sourceFormat, 2, sinkFormat, 2);
+            checkFusedGraph(sourceFormat, 1, sinkFormat, 2);
+            checkFusedGraph(sourceFormat, 6, sinkFormat, 6);
+        }
+    }
+}
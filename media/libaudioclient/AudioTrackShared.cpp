@@ -64,7 +64,7 @@ static uint32_t incrementSequence(uint32_t self, uint32_t other) {
 }
 
 audio_track_cblk_t::audio_track_cblk_t()
-    : mServer(0), mFutex(0), mMinimum(0)
+    : mServer(0), mVersion(CBLK_VERSION), mFutex(0), mMinimum(0)
     , mVolumeLR(GAIN_MINIFLOAT_PACKED_UNITY), mSampleRate(0), mSendLevel(0)
     , mBufferSizeInFrames(0)
     , mStartThresholdInFrames(0) // filled in by the server.
@@ -111,6 +111,13 @@ ClientProxy::ClientProxy(audio_track_cblk_t* cblk, void *buffers, size_t frameCo
     , mEpoch(0)
     , mTimestampObserver(&cblk->mExtendedTimestampQueue)
 {
+    if (cblk->mVersion != CBLK_VERSION) {
+        // The server lays out the control block differently. Client and server are built
+        // together, so a mismatch is rejected like corruption rather than translated.
+        ALOGE("%s: control block version %u, expected %u",
+                __func__, cblk->mVersion, CBLK_VERSION);
+        mIsShutdown = true;
+    }
     setBufferSizeInFrames(frameCount);
 }
 
@@ -374,6 +381,26 @@ end:
     return status;
 }
 
+status_t ClientProxy::obtainBuffers(Buffer buffers[2], const struct timespec *requested,
+        struct timespec *elapsed)
+{
+    LOG_ALWAYS_FATAL_IF(buffers == NULL);
+    const size_t desired = buffers[0].mFrameCount;
+    status_t status = obtainBuffer(&buffers[0], requested, elapsed);
+    size_t part2 = 0;
+    if (status == NO_ERROR) {
+        // The first region is shorter than desired only when it reaches the end of the buffer
+        // or all the available frames, so the non-contiguous frames start the buffer.
+        part2 = std::min(buffers[0].mNonContig, desired - buffers[0].mFrameCount);
+        buffers[0].mNonContig -= part2;
+        mUnreleased += part2;
+    }
+    buffers[1].mFrameCount = part2;
+    buffers[1].mRaw = part2 > 0 ? mBuffers : NULL;
+    buffers[1].mNonContig = 0;
+    return status;
+}
+
 __attribute__((no_sanitize("integer")))
 void ClientProxy::releaseBuffer(Buffer* buffer)
 {
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <new>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+#include <private/media/AudioTrackShared.h>
+
+using namespace android;
+
+// Stereo 16 bit, like most fast tracks.
+constexpr size_t kFrameSize = 4;
+constexpr uint32_t kSampleRate = 48000;
+
+/*******************************************************************
+ * A client process writes an AudioTrack buffer which a server process reads,
+ * through the control block in shared memory, as AudioTrack and AudioFlinger do.
+ *
+ * The first parameter is the frames written and read per obtain/release cycle.
+ * The buffer holds 3 such periods, which is not a divisor of the power of 2 ring,
+ * so that cycles regularly wrap around the end of the buffer.
+ * The second parameter is 1 when the client obtains both regions at a wraparound
+ * with a single obtainBuffers(), otherwise it uses obtainBuffer().
+ * The real time per iteration is the time for the client to write one period.
+ *******************************************************************/
+
+struct SharedState {
+    volatile int32_t mStop;
+};
+
+// Reads everything written by the client, until stopped.
+static void runServer(audio_track_cblk_t* cblk, void* buffers, size_t frameCount,
+        SharedState* state) {
+    sp<AudioTrackServerProxy> proxy = new AudioTrackServerProxy(
+            cblk, buffers, frameCount, kFrameSize, false /*clientInServer*/, kSampleRate);
+    while (!android_atomic_acquire_load(&state->mStop)) {
+        Proxy::Buffer buffer;
+        buffer.mFrameCount = frameCount;
+        if (proxy->obtainBuffer(&buffer) == NO_ERROR && buffer.mFrameCount > 0) {
+            benchmark::DoNotOptimize(*(volatile char *)buffer.mRaw);
+            proxy->releaseBuffer(&buffer);
+        }
+    }
+}
+
+static void BM_ObtainReleaseCycle(benchmark::State& state) {
+    const size_t periodFrames = state.range(0);
+    const bool batched = state.range(1) != 0;
+    const size_t frameCount = 3 * periodFrames;
+    const size_t bufferFrames = roundup(frameCount);  // as allocated by AudioFlinger
+
+    const size_t size = sizeof(audio_track_cblk_t) + bufferFrames * kFrameSize
+            + sizeof(SharedState);
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+            -1 /* fd */, 0 /* offset */);
+    if (memory == MAP_FAILED) {
+        state.SkipWithError("mmap failed");
+        return;
+    }
+    audio_track_cblk_t* cblk = new(memory) audio_track_cblk_t();
+    void* buffers = (char*)memory + sizeof(audio_track_cblk_t);
+    SharedState* shared = (SharedState*)((char*)buffers + bufferFrames * kFrameSize);
+    shared->mStop = 0;
+
+    const pid_t pid = fork();
+    if (pid == 0) {
+        runServer(cblk, buffers, frameCount, shared);
+        _exit(0);
+    }
+    if (pid < 0) {
+        state.SkipWithError("fork failed");
+        munmap(memory, size);
+        return;
+    }
+
+    sp<AudioTrackClientProxy> proxy = new AudioTrackClientProxy(
+            cblk, buffers, frameCount, kFrameSize);
+    const char pattern[kFrameSize * 4] = {};
+    bool failed = false;
+    for (auto _ : state) {
+        size_t frames = periodFrames;
+        while (frames > 0) {
+            Proxy::Buffer regions[2];
+            regions[0].mFrameCount = frames;
+            status_t status = batched
+                    ? proxy->obtainBuffers(regions, &ClientProxy::kForever)
+                    : proxy->obtainBuffer(&regions[0], &ClientProxy::kForever);
+            if (status != NO_ERROR) {
+                // kForever only returns on an error such as DEAD_OBJECT, which would repeat
+                state.SkipWithError("obtainBuffer failed");
+                failed = true;
+                break;
+            }
+            memcpy(regions[0].mRaw, pattern, std::min(sizeof(pattern),
+                    regions[0].mFrameCount * kFrameSize));
+            Proxy::Buffer release;
+            release.mFrameCount = regions[0].mFrameCount;
+            if (batched) {
+                release.mFrameCount += regions[1].mFrameCount;
+            }
+            frames -= release.mFrameCount;
+            proxy->releaseBuffer(&release);
+        }
+        if (failed) {
+            break;
+        }
+    }
+
+    android_atomic_release_store(1, &shared->mStop);
+    waitpid(pid, nullptr, 0);
+    munmap(memory, size);
+}
+
+static void ObtainReleaseCycleArgs(benchmark::internal::Benchmark* b) {
+    for (int batched = 0; batched <= 1; batched++) {
+        for (int periodFrames : {16, 48, 96, 192, 480}) {
+            b->Args({periodFrames, batched});
+        }
+    }
+}
+
+BENCHMARK(BM_ObtainReleaseCycle)->Apply(ObtainReleaseCycleArgs)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -25,6 +25,7 @@
 #include <math.h>
 #include <sys/types.h>
 
+#include <cutils/properties.h>
 #include <utils/Errors.h>
 #include <utils/Log.h>
 
@@ -440,6 +441,19 @@ void AudioMixer::setParameter(int name, int target, int param, void *value)
         break;
 
     case RESAMPLE:
+        if (param == SAMPLE_RATE && track->mTimestretchResamples) {
+            // The time stretcher converts the sample rate with its own resampler.
+            ALOG_ASSERT(valueInt > 0, "bad sample rate %d", valueInt);
+            static_cast<WsolaBufferProvider*>(track->mTimestretchBufferProvider.get())
+                    ->setSampleRates(uint32_t(valueInt), mSampleRate);
+            if (track->sampleRate != uint32_t(valueInt)) {
+                track->sampleRate = uint32_t(valueInt);
+                invalidate();
+            }
+            break;
+        }
+        AudioMixerBase::setParameter(name, target, param, value);
+        break;
     case RAMP_VOLUME:
     case VOLUME:
         AudioMixerBase::setParameter(name, target, param, value);
@@ -459,6 +473,14 @@ void AudioMixer::setParameter(int name, int target, int param, void *value)
                         playbackRate->mPitch,
                         playbackRate->mStretchMode,
                         playbackRate->mFallbackMode);
+                if (track->mTimestretchResamples && track->mResampler.get() != nullptr) {
+                    // The time stretcher takes over from the resampler.
+                    const uint32_t sampleRate = track->sampleRate;
+                    static_cast<WsolaBufferProvider*>(track->mTimestretchBufferProvider.get())
+                            ->setSampleRates(sampleRate, mSampleRate);
+                    AudioMixerBase::setParameter(name, RESAMPLE, REMOVE, nullptr);
+                    track->sampleRate = sampleRate; // REMOVE sets the device rate
+                }
                 // invalidate();  (should not require reconfigure)
             }
         } break;
@@ -485,9 +507,24 @@ bool AudioMixer::Track::setPlaybackRate(const AudioPlaybackRate &playbackRate)
         // TODO: Remove MONO_HACK. Resampler sees #channels after the downmixer
         // but if none exists, it is the channel count (1 for mono).
         const int timestretchChannelCount = getOutputChannelCount();
-        mTimestretchBufferProvider.reset(new TimestretchBufferProvider(timestretchChannelCount,
-                mMixerInFormat, sampleRate, playbackRate));
+        // 0 for Sonic, otherwise a TimeStretcher::quality_t for WSOLA, which is float only.
+        const int32_t quality = property_get_int32("af.timestretch.quality", 0);
+        if (quality > 0 && mMixerInFormat == AUDIO_FORMAT_PCM_FLOAT
+                && isAudioPlaybackRateValid(playbackRate)) {
+            // sampleRate is the device rate unless there is a resampler, which
+            // AudioMixer::setParameter() then replaces with the time stretcher.
+            mTimestretchBufferProvider.reset(new WsolaBufferProvider(timestretchChannelCount,
+                    sampleRate, sampleRate, playbackRate,
+                    static_cast<TimeStretcher::quality_t>(quality)));
+            mTimestretchResamples = true;
+        } else {
+            mTimestretchBufferProvider.reset(new TimestretchBufferProvider(
+                    timestretchChannelCount, mMixerInFormat, sampleRate, playbackRate));
+        }
         reconfigureBufferProviders();
+    } else if (mTimestretchResamples) {
+        static_cast<WsolaBufferProvider*>(mTimestretchBufferProvider.get())
+                ->setPlaybackRate(playbackRate);
     } else {
         static_cast<TimestretchBufferProvider*>(mTimestretchBufferProvider.get())
                 ->setPlaybackRate(playbackRate);
@@ -52,6 +52,11 @@
 // TODO: remove BLOCKSIZE unit of processing - it isn't needed anymore.
 static constexpr int BLOCKSIZE = 16;
 
+// Digital silence on a track input for this long makes the mixer skip the track.
+// It is well above the length of the resampler filters, so that a skipped resampler
+// holds only silence in its history.
+static constexpr uint32_t kSilenceHysteresisMs = 100;
+
 #ifdef QTI_RESAMPLER
 #define QTI_RESAMPLER_MAX_SAMPLERATE 192000
 #endif
@@ -421,6 +426,7 @@ void AudioMixerBase::setParameter(int name, int target, int param, void *value)
             break;
         case RESET:
             track->resetResampler();
+            track->resetSilence();
             invalidate();
             break;
         case REMOVE:
@@ -610,6 +616,110 @@ std::string AudioMixerBase::trackNames() const
     return ss.str();
 }
 
+std::string AudioMixerBase::skippedFrames() const
+{
+    std::stringstream ss;
+    for (const auto &pair : mTracks) {
+        ss << pair.first << ":" << pair.second->mSkippedFrames << " ";
+    }
+    return ss.str();
+}
+
+// Returns the number of leading frames that are digital silence, all bits zero.
+// The whole buffer is checked first in blocks, as an OR reduction which the compiler
+// vectorizes, then the frame of the first non-zero block is searched.
+static size_t silentFrames(const void *in, size_t frameCount, size_t frameSize)
+{
+    constexpr size_t kBlockSize = 64;
+    const uint8_t * const bytes = static_cast<const uint8_t *>(in);
+    const auto isZero = [](const uint8_t *data, size_t size) {
+        uint8_t accumulator = 0;
+        for (size_t i = 0; i < size; i++) {
+            accumulator |= data[i];
+        }
+        return accumulator == 0;
+    };
+    const size_t size = frameCount * frameSize;
+    size_t offset = 0;
+    while (offset + kBlockSize <= size && isZero(bytes + offset, kBlockSize)) {
+        offset += kBlockSize;
+    }
+    size_t frame = offset / frameSize;
+    while (frame < frameCount && isZero(bytes + frame * frameSize, frameSize)) {
+        frame++;
+    }
+    return frame;
+}
+
+status_t AudioMixerBase::TrackBase::SilenceProbe::getNextBuffer(Buffer *buffer)
+{
+    const status_t status = mTrack->bufferProvider->getNextBuffer(buffer);
+    if (buffer->raw != nullptr) {
+        const size_t silent = silentFrames(buffer->raw, buffer->frameCount, mTrack->mInFrameSize);
+        mTrack->mSilentFrames = silent < buffer->frameCount ? 0
+                : std::min(mTrack->mSilentFrames + silent, mTrack->mSilenceFrames);
+    }
+    return status;
+}
+
+void AudioMixerBase::TrackBase::SilenceProbe::releaseBuffer(Buffer *buffer)
+{
+    mTrack->bufferProvider->releaseBuffer(buffer);
+}
+
+bool AudioMixerBase::TrackBase::skipSilence(const void *in, size_t frameCount)
+{
+    if (!mSkipSilence || (needs & NEEDS_MUTE)) {
+        return false; // when muted, the hook is track__nop
+    }
+    if (silentFrames(in, frameCount, mInFrameSize) < frameCount) {
+        mSilentFrames = 0;
+        return false;
+    }
+    mSilentFrames = std::min(mSilentFrames + frameCount, mSilenceFrames);
+    // a volume ramp must still advance
+    if (mSilentFrames < mSilenceFrames || needsRamp()) {
+        return false;
+    }
+    mSkippedFrames += frameCount;
+    return true;
+}
+
+size_t AudioMixerBase::TrackBase::skipResampledSilence(size_t outFrameCount)
+{
+    // A muted track also waits for silence: the resampler history must be silence to skip,
+    // and on unmute it must hold the input played while muted.
+    size_t inFrameCount;
+    if (!mSkipSilence || needsRamp() || mSilentFrames < mSilenceFrames
+            || mResampler->holdsInputBuffer()
+            || !mResampler->getSkipFrameCount(outFrameCount, &inFrameCount)) {
+        return 0;
+    }
+    // Consume the input that the resampler would have read, up to the first frame of sound.
+    size_t consumed = 0;
+    while (consumed < inFrameCount) {
+        buffer.frameCount = inFrameCount - consumed;
+        bufferProvider->getNextBuffer(&buffer);
+        if (buffer.raw == nullptr) {
+            break; // underrun, the resampler outputs the frames it can
+        }
+        const size_t frameCount = buffer.frameCount;
+        buffer.frameCount = silentFrames(buffer.raw, frameCount, mInFrameSize);
+        consumed += buffer.frameCount;
+        const bool sound = buffer.frameCount < frameCount;
+        bufferProvider->releaseBuffer(&buffer); // the sound is left in the provider
+        if (sound) {
+            mSilentFrames = 0;
+            break;
+        }
+    }
+    // The resampler skips the output frames computed from the consumed input only,
+    // and resumes in phase.
+    const size_t skipped = mResampler->skip(outFrameCount, consumed);
+    mSkippedFrames += skipped;
+    return skipped;
+}
+
 void AudioMixerBase::process__validate()
 {
     // TODO: fix all16BitsStereNoResample logic to
@@ -629,6 +739,12 @@ void AudioMixerBase::process__validate()
         mEnabled.emplace_back(name);  // we add to mEnabled in order of name.
         mGroups[t->mainBuffer].emplace_back(name); // mGroups also in order of name.
 
+        t->mSkipSilence = mSkipSilence;
+        t->mInFrameSize = audio_bytes_per_frame(t->getOutputChannelCount(), t->mMixerInFormat);
+        // without a resampler, the input frames are at the device rate
+        t->mSilenceFrames = (size_t)(t->doesResample() ? t->sampleRate : mSampleRate)
+                * kSilenceHysteresisMs / 1000;
+
         uint32_t n = 0;
         // FIXME can overflow (mask is only 3 bits)
         n |= NEEDS_CHANNEL_1 + t->channelCount - 1;
@@ -1122,9 +1238,13 @@ void AudioMixerBase::process__genericNoResampling()
                     }
                     size_t inFrames = (t->frameCount > outFrames)?outFrames:t->frameCount;
                     if (inFrames > 0) {
-                        (t.get()->*t->hook)(
-                                outTemp + (frameCount - outFrames) * t->mMixerChannelCount,
-                                inFrames, mResampleTemp.get() /* naked ptr */, aux);
+                        if (t->skipSilence(t->mIn, inFrames)) {
+                            t->mIn = (const uint8_t *)t->mIn + inFrames * t->mInFrameSize;
+                        } else {
+                            (t.get()->*t->hook)(
+                                    outTemp + (frameCount - outFrames) * t->mMixerChannelCount,
+                                    inFrames, mResampleTemp.get() /* naked ptr */, aux);
+                        }
                         t->frameCount -= inFrames;
                         outFrames -= inFrames;
                         if (CC_UNLIKELY(aux != NULL)) {
@@ -1187,7 +1307,12 @@ void AudioMixerBase::process__genericResampling()
             // acquire/release the buffers because it's done by
             // the resampler.
             if (t->needs & NEEDS_RESAMPLE) {
-                (t.get()->*t->hook)(outTemp, numFrames, mResampleTemp.get() /* naked ptr */, aux);
+                const size_t skipped = t->skipResampledSilence(numFrames);
+                if (skipped < numFrames) {
+                    (t.get()->*t->hook)(outTemp + skipped * t->mMixerChannelCount,
+                            numFrames - skipped, mResampleTemp.get() /* naked ptr */,
+                            aux != nullptr ? aux + skipped : nullptr);
+                }
             } else {
 
                 size_t outFrames = 0;
@@ -1200,10 +1325,12 @@ void AudioMixerBase::process__genericResampling()
                     // been enabled for mixing.
                     if (t->mIn == nullptr) break;
 
-                    (t.get()->*t->hook)(
-                            outTemp + outFrames * t->mMixerChannelCount, t->buffer.frameCount,
-                            mResampleTemp.get() /* naked ptr */,
-                            aux != nullptr ? aux + outFrames : nullptr);
+                    if (!t->skipSilence(t->mIn, t->buffer.frameCount)) {
+                        (t.get()->*t->hook)(
+                                outTemp + outFrames * t->mMixerChannelCount, t->buffer.frameCount,
+                                mResampleTemp.get() /* naked ptr */,
+                                aux != nullptr ? aux + outFrames : nullptr);
+                    }
                     outFrames += t->buffer.frameCount;
 
                     t->bufferProvider->releaseBuffer(&t->buffer);
@@ -1472,8 +1599,12 @@ void AudioMixerBase::process__noResampleOneTrack()
         }
 
         const size_t outFrames = b.frameCount;
-        t->volumeMix<MIXTYPE, std::is_same_v<TI, float> /* USEFLOATVOL */, false /* ADJUSTVOL */> (
-                out, outFrames, in, aux, ramp);
+        if (t->skipSilence(in, outFrames)) {
+            memset(out, 0, outFrames * channels * sizeof(TO));
+        } else {
+            t->volumeMix<MIXTYPE, std::is_same_v<TI, float> /* USEFLOATVOL */,
+                    false /* ADJUSTVOL */>(out, outFrames, in, aux, ramp);
+        }
 
         out += outFrames * channels;
         if (aux != NULL) {
@@ -1510,14 +1641,14 @@ void AudioMixerBase::TrackBase::track__Resample(TO* out, size_t outFrameCount, T
 
         mResampler->setVolume(UNITY_GAIN_FLOAT, UNITY_GAIN_FLOAT);
         memset(temp, 0, outFrameCount * mMixerChannelCount * sizeof(TO));
-        mResampler->resample((int32_t*)temp, outFrameCount, bufferProvider);
+        mResampler->resample((int32_t*)temp, outFrameCount, &mSilenceProbe);
 
         volumeMix<MIXTYPE, std::is_same_v<TI, float> /* USEFLOATVOL */, true /* ADJUSTVOL */>(
                 out, outFrameCount, temp, aux, ramp);
 
     } else { // constant volume gain
         mResampler->setVolume(mVolume[0], mVolume[1]);
-        mResampler->resample((int32_t*)out, outFrameCount, bufferProvider);
+        mResampler->resample((int32_t*)out, outFrameCount, &mSilenceProbe);
     }
 }
 
@@ -17,6 +17,7 @@
 #define LOG_TAG "AudioResamplerDyn"
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
 #include <malloc.h>
 #include <string.h>
 #include <stdlib.h>
@@ -42,6 +43,84 @@ constexpr size_t CACHE_LINE_SIZE = 64;
 
 namespace android {
 
+AudioResamplerDynFilterCache &AudioResamplerDynFilterCache::getInstance()
+{
+    // never deleted, resamplers may be destroyed by static destructors
+    static AudioResamplerDynFilterCache *instance = new AudioResamplerDynFilterCache();
+    return *instance;
+}
+
+AudioResamplerDynFilterCache::AudioResamplerDynFilterCache()
+    : mMaxSize(std::max(property_get_int32("ro.audio.resampler.cache_kb", 512), 0) * 1024)
+{
+}
+
+std::shared_ptr<void> AudioResamplerDynFilterCache::get(const Key &key, size_t size,
+        const std::function<void(void *coefs)> &design)
+{
+    {
+        std::lock_guard<std::mutex> _l(mLock);
+        const auto it = mEntries.find(key);
+        if (it != mEntries.end()) {
+            mLru.splice(mLru.begin(), mLru, it->second.lru);
+            return it->second.coefs;
+        }
+    }
+
+    // design without the lock, it takes milliseconds
+    void *coefs = nullptr;
+    const int ret = posix_memalign(&coefs, CACHE_LINE_SIZE /* alignment */, size);
+    LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
+    design(coefs);
+    std::shared_ptr<void> filter(coefs, free);
+
+    std::lock_guard<std::mutex> _l(mLock);
+    if (size > mMaxSize) {
+        return filter;
+    }
+    const auto [it, inserted] = mEntries.try_emplace(key);
+    if (!inserted) {
+        // designed concurrently by another resampler, share the cached one
+        mLru.splice(mLru.begin(), mLru, it->second.lru);
+        return it->second.coefs;
+    }
+    mLru.push_front(key);
+    it->second = {filter, size, mLru.begin()};
+    mSize += size;
+    trim_l();
+    return filter;
+}
+
+void AudioResamplerDynFilterCache::setMaxSize(size_t maxSize)
+{
+    std::lock_guard<std::mutex> _l(mLock);
+    mMaxSize = maxSize;
+    trim_l();
+}
+
+size_t AudioResamplerDynFilterCache::getMaxSize() const
+{
+    std::lock_guard<std::mutex> _l(mLock);
+    return mMaxSize;
+}
+
+size_t AudioResamplerDynFilterCache::getSize() const
+{
+    std::lock_guard<std::mutex> _l(mLock);
+    return mSize;
+}
+
+void AudioResamplerDynFilterCache::trim_l()
+{
+    // the resamplers using an evicted filter bank keep it until they change filter
+    while (mSize > mMaxSize) {
+        const auto it = mEntries.find(mLru.back());
+        mSize -= it->second.size;
+        mEntries.erase(it);
+        mLru.pop_back();
+    }
+}
+
 /*
  * InBuffer is a type agnostic input buffer.
  *
@@ -181,8 +260,7 @@ template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
         int inChannelCount, int32_t sampleRate, src_quality quality)
     : AudioResampler(inChannelCount, sampleRate, quality),
-      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY),
-    mCoefBuffer(NULL)
+      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY)
 {
     mVolumeSimd[0] = mVolumeSimd[1] = 0;
     // The AudioResampler base class assumes we are always ready for 1:1 resampling.
@@ -207,7 +285,6 @@ AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
 template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::~AudioResamplerDyn()
 {
-    free(mCoefBuffer);
 }
 
 template<typename TC, typename TI, typename TO>
@@ -263,24 +340,21 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
     const int phases = c.mL;
     const int halfLength = c.mHalfNumCoefs;
 
-    // create buffer
-    TC *coefs = nullptr;
-    int ret = posix_memalign(
-            reinterpret_cast<void **>(&coefs),
-            CACHE_LINE_SIZE /* alignment */,
-            (phases + 1) * halfLength * sizeof(TC));
-    LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
-    c.mFirCoefs = coefs;
-    free(mCoefBuffer);
-    mCoefBuffer = coefs;
-
     // square the computed minimum passband value (extra safety).
     double attenuation =
             computeWindowedSincMinimumPassbandValue(stopBandAtten);
     attenuation *= attenuation;
 
-    // design filter
-    firKaiserGen(coefs, phases, halfLength, stopBandAtten, fcr, attenuation);
+    // design filter, unless a resampler with the same design has done it
+    const AudioResamplerDynFilterCache::Key key = {
+            std::is_floating_point<TC>::value ? -(int)sizeof(TC) : (int)sizeof(TC),
+            phases, halfLength, stopBandAtten, fcr};
+    mCoefBuffer = AudioResamplerDynFilterCache::getInstance().get(
+            key, (phases + 1) * halfLength * sizeof(TC), [&](void *coefs) {
+                firKaiserGen(static_cast<TC *>(coefs), phases, halfLength,
+                        stopBandAtten, fcr, attenuation);
+            });
+    c.mFirCoefs = static_cast<const TC *>(mCoefBuffer.get());
 
     // update the design criteria
     mNormalizedCutoffFrequency = fcr;
@@ -306,7 +380,7 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
 
     const int32_t passSteps = 1000;
 
-    testFir(coefs, c.mL, c.mHalfNumCoefs, fp, fs, passSteps, passSteps * c.mL /*stopSteps*/,
+    testFir(c.mFirCoefs, c.mL, c.mHalfNumCoefs, fp, fs, passSteps, passSteps * c.mL /*stopSteps*/,
             passMin, passMax, passRipple, stopMax, stopRipple);
     ALOGD("passband(%lf, %lf): %.8lf %.8lf %.8lf\n", 0., fp, passMin, passMax, passRipple);
     ALOGD("stopband(%lf, %lf): %.8lf %.3lf\n", fs, 0.5, stopMax, stopRipple);
@@ -629,6 +703,38 @@ size_t AudioResamplerDyn<TC, TI, TO>::resample(int32_t* out, size_t outFrameCoun
     return (this->*mResampleFunc)(reinterpret_cast<TO*>(out), outFrameCount, provider);
 }
 
+template<typename TC, typename TI, typename TO>
+bool AudioResamplerDyn<TC, TI, TO>::getSkipFrameCount(
+        size_t outFrameCount, size_t *inFrameCount) const
+{
+    // as in resample(), the input is read as the phase wraps
+    const uint32_t phaseWrapLimit = mConstants.mL << mConstants.mShift;
+    *inFrameCount = (mPhaseIncrement * (uint64_t)outFrameCount + mPhaseFraction)
+            / phaseWrapLimit;
+    return true;
+}
+
+template<typename TC, typename TI, typename TO>
+size_t AudioResamplerDyn<TC, TI, TO>::skip(size_t outFrameCount, size_t inFrameCount)
+{
+    ALOG_ASSERT(mBuffer.frameCount == 0);
+    // Output frame k (from 0) convolves the input read before it, that is
+    // (mPhaseFraction + k * mPhaseIncrement) / phaseWrapLimit frames. Skip the output frames
+    // which read at most inFrameCount frames; the phase keeps the reads still due, if any.
+    const uint64_t phaseWrapLimit = mConstants.mL << mConstants.mShift;
+    const uint64_t readLimit = (inFrameCount + 1) * phaseWrapLimit;
+    size_t skipped = 0;
+    if (readLimit > mPhaseFraction) {
+        skipped = mPhaseIncrement == 0 ? outFrameCount : std::min(outFrameCount,
+                (size_t)((readLimit - mPhaseFraction + mPhaseIncrement - 1) / mPhaseIncrement));
+    }
+    const uint64_t phaseFraction = mPhaseFraction + mPhaseIncrement * (uint64_t)skipped;
+    ALOG_ASSERT(phaseFraction >= inFrameCount * phaseWrapLimit);
+    mPhaseFraction = phaseFraction - inFrameCount * phaseWrapLimit;
+    // the input history is silence, before and after the frames consumed
+    return skipped;
+}
+
 template<typename TC, typename TI, typename TO>
 template<int CHANNELS, bool LOCKED, int STRIDE>
 size_t AudioResamplerDyn<TC, TI, TO>::resample(TO* out, size_t outFrameCount,
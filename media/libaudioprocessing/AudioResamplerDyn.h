@@ -21,10 +21,74 @@
 #include <sys/types.h>
 #include <android/log.h>
 
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
 #include <media/AudioResampler.h>
 
 namespace android {
 
+/* AudioResamplerDynFilterCache
+ *
+ * Process wide cache of the polyphase filter banks designed by AudioResamplerDyn.
+ *
+ * Designing a filter bank takes milliseconds, and the tracks of an output mostly use
+ * the same few sample rates, so resamplers with the same design share one filter bank.
+ * A filter bank is freed with its last user, and the cache keeps the most recently used
+ * ones up to a total size set by the property "ro.audio.resampler.cache_kb".
+ * A size of 0 disables the cache.
+ */
+class AudioResamplerDynFilterCache {
+public:
+    // The filter design parameters. The channel count does not change the filter.
+    struct Key {
+        int coefType;           // sizeof(TC), negative for floating point coefficients
+        int phases;
+        int halfNumCoefs;
+        double stopBandAtten;
+        double fcr;
+
+        bool operator<(const Key &other) const {
+            return std::tie(coefType, phases, halfNumCoefs, stopBandAtten, fcr)
+                    < std::tie(other.coefType, other.phases, other.halfNumCoefs,
+                            other.stopBandAtten, other.fcr);
+        }
+    };
+
+    static AudioResamplerDynFilterCache &getInstance();
+
+    // Returns the filter bank of size bytes for key.
+    // If it is not cached, it is allocated and design() is called to compute it.
+    std::shared_ptr<void> get(const Key &key, size_t size,
+            const std::function<void(void *coefs)> &design);
+
+    // The maximum and current size in bytes of the cached filter banks.
+    void setMaxSize(size_t maxSize);
+    size_t getMaxSize() const;
+    size_t getSize() const;
+
+private:
+    AudioResamplerDynFilterCache();
+
+    void trim_l();
+
+    struct Entry {
+        std::shared_ptr<void> coefs;
+        size_t size;
+        std::list<Key>::iterator lru;
+    };
+
+    mutable std::mutex    mLock;
+    size_t                mMaxSize;
+    size_t                mSize = 0;
+    std::list<Key>        mLru;       // most recently used first
+    std::map<Key, Entry>  mEntries;
+};
+
 /* AudioResamplerDyn
  *
  * This class template is used for floating point and integer resamplers.
@@ -60,6 +124,10 @@ public:
         mInBuffer.reset();
     }
 
+    bool getSkipFrameCount(size_t outFrameCount, size_t *inFrameCount) const override;
+
+    size_t skip(size_t outFrameCount, size_t inFrameCount) override;
+
     // Make available key design criteria for testing
     int getHalfLength() const {
         return mConstants.mHalfNumCoefs;
@@ -166,7 +234,7 @@ private:
      resample_ABP_t mResampleFunc;     // called function for resampling
             int32_t mFilterSampleRate; // designed filter sample rate.
         src_quality mFilterQuality;    // designed filter quality.
-              void* mCoefBuffer;       // if a filter is created, this is not null
+    std::shared_ptr<void> mCoefBuffer;       // if a filter is created, this is not null
 
     // Property selected design parameters.
               // This will enable fixed high quality resampling.
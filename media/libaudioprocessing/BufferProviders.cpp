@@ -28,6 +28,7 @@
 #include <media/audiohal/EffectsFactoryHalInterface.h>
 #include <media/AudioResamplerPublic.h>
 #include <media/BufferProviders.h>
+#include <media/PcmConversion.h>
 #include <system/audio_effects/effect_downmix.h>
 #include <utils/Log.h>
 
@@ -381,7 +382,7 @@ ReformatBufferProvider::ReformatBufferProvider(int32_t channelCount,
 
 void ReformatBufferProvider::copyFrames(void *dst, const void *src, size_t frames)
 {
-    memcpy_by_audio_format(dst, mOutputFormat, src, mInputFormat, frames * mChannelCount);
+    convertPcm(dst, mOutputFormat, src, mInputFormat, frames * mChannelCount);
 }
 
 ClampFloatBufferProvider::ClampFloatBufferProvider(int32_t channelCount, size_t bufferFrameCount) :
@@ -628,6 +629,94 @@ void TimestretchBufferProvider::processFrames(void *dstBuffer, size_t *dstFrames
     }
 }
 
+WsolaBufferProvider::WsolaBufferProvider(int32_t channelCount,
+        uint32_t inSampleRate, uint32_t outSampleRate, const AudioPlaybackRate &playbackRate,
+        TimeStretcher::quality_t quality) :
+        mStretcher(channelCount, inSampleRate, outSampleRate, quality)
+{
+    setPlaybackRate(playbackRate);
+    ALOGV("WsolaBufferProvider(%p)(%u, %u, %u, %f %d)",
+            this, channelCount, inSampleRate, outSampleRate, playbackRate.mSpeed, quality);
+    mBuffer.frameCount = 0;
+}
+
+WsolaBufferProvider::~WsolaBufferProvider()
+{
+    ALOGV("~WsolaBufferProvider(%p)", this);
+    if (mBuffer.frameCount != 0) {
+        mTrackBufferProvider->releaseBuffer(&mBuffer);
+    }
+}
+
+status_t WsolaBufferProvider::getNextBuffer(AudioBufferProvider::Buffer *pBuffer)
+{
+    ALOGV("WsolaBufferProvider(%p)::getNextBuffer(%p (%zu))",
+            this, pBuffer, pBuffer->frameCount);
+
+    // stretch upstream data until the request is met or the upstream provider runs dry.
+    while (mStretcher.framesReady() < pBuffer->frameCount) {
+        mBuffer.frameCount = mStretcher.inputFramesNeeded(
+                pBuffer->frameCount - mStretcher.framesReady());
+        const status_t res = mTrackBufferProvider->getNextBuffer(&mBuffer);
+
+        ALOG_ASSERT(res == OK || mBuffer.frameCount == 0);
+        if (res != OK || mBuffer.frameCount == 0) { // not needed by API spec, but to be safe.
+            ALOGV("upstream provider cannot provide data");
+            if (mStretcher.framesReady() == 0) {
+                pBuffer->raw = NULL;
+                pBuffer->frameCount = 0;
+                return res;
+            }
+            break; // return partial count
+        }
+        mStretcher.write((const float *)mBuffer.raw, mBuffer.frameCount);
+        mTrackBufferProvider->releaseBuffer(&mBuffer);
+    }
+
+    // the stretched frames are returned in place, they stay valid until the next call.
+    pBuffer->raw = const_cast<float *>(mStretcher.outputBuffer());
+    pBuffer->frameCount = std::min(pBuffer->frameCount, mStretcher.framesReady());
+    return OK;
+}
+
+void WsolaBufferProvider::releaseBuffer(AudioBufferProvider::Buffer *pBuffer)
+{
+    ALOGV("WsolaBufferProvider(%p)::releaseBuffer(%p (%zu))",
+            this, pBuffer, pBuffer->frameCount);
+    mStretcher.consume(pBuffer->frameCount);
+    pBuffer->raw = NULL;
+    pBuffer->frameCount = 0;
+}
+
+void WsolaBufferProvider::reset()
+{
+    mStretcher.reset();
+}
+
+void WsolaBufferProvider::setBufferProvider(AudioBufferProvider *p) {
+    ALOGV("%s(%p): mTrackBufferProvider:%p  mBuffer.frameCount:%zu",
+            __func__, p, mTrackBufferProvider, mBuffer.frameCount);
+    if (mTrackBufferProvider == p) {
+        return;
+    }
+    mBuffer.frameCount = 0;
+    PassthruBufferProvider::setBufferProvider(p);
+}
+
+status_t WsolaBufferProvider::setPlaybackRate(const AudioPlaybackRate &playbackRate)
+{
+    mPlaybackRate = playbackRate;
+    // pitch is applied by the track sample rate, as for TimestretchBufferProvider.
+    mStretcher.setSpeed(std::clamp(playbackRate.mSpeed,
+            AUDIO_TIMESTRETCH_SPEED_MIN, AUDIO_TIMESTRETCH_SPEED_MAX));
+    return OK;
+}
+
+void WsolaBufferProvider::setSampleRates(uint32_t inSampleRate, uint32_t outSampleRate)
+{
+    mStretcher.setSampleRates(inSampleRate, outSampleRate);
+}
+
 AdjustChannelsBufferProvider::AdjustChannelsBufferProvider(
         audio_format_t format, size_t inChannelCount, size_t outChannelCount,
         size_t frameCount, audio_format_t contractedFormat, void* contractedBuffer) :
@@ -676,7 +765,7 @@ void AdjustChannelsBufferProvider::copyFrames(void *dst, const void *src, size_t
         if (mContractedFormat != AUDIO_FORMAT_INVALID
             && mContractedBuffer != nullptr) {
             const size_t contractedIdx = frames * mOutChannelCount * mSampleSizeInBytes;
-            memcpy_by_audio_format(
+            convertPcm(
                     (uint8_t*) mContractedBuffer + mContractedWrittenFrames * mContractedFrameSize,
                     mContractedFormat, (uint8_t*) dst + contractedIdx, mFormat,
                     mContractedChannelCount * frames);
@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "PcmConversion"
+//#define LOG_NDEBUG 0
+
+#include <stdint.h>
+
+#include <audio_utils/format.h>
+#include <audio_utils/primitives.h>
+#include <media/PcmConversion.h>
+
+// NEON and SSE2 are part of the arm64 and x86 ABIs, so the kernels are selected at compile time.
+// The arm32 NEON instruction set has no rounding float to integer conversion, it uses audio_utils.
+#if defined(__aarch64__)
+#define USE_NEON_CONVERSION (true)
+#include <arm_neon.h>
+#else
+#define USE_NEON_CONVERSION (false)
+#endif
+
+#if defined(__SSE2__)
+#define USE_SSE_CONVERSION (true)
+#include <emmintrin.h>
+#else
+#define USE_SSE_CONVERSION (false)
+#endif
+
+namespace android {
+
+namespace {
+
+// The kernels convert the largest multiple of 8 samples and return the number of samples
+// converted. They round and clamp as the audio_utils primitives do, which convert the rest.
+
+#if USE_NEON_CONVERSION
+
+// clamp16_from_float(): round half to even, saturate.
+size_t i16FromFloat(int16_t *dst, const float *src, size_t count)
+{
+    const size_t n = count & ~(size_t)7;
+    for (size_t i = 0; i < n; i += 8) {
+        const int32x4_t lo = vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(src + i), 32768.f));
+        const int32x4_t hi = vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(src + i + 4), 32768.f));
+        vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+    }
+    return n;
+}
+
+size_t floatFromI16(float *dst, const int16_t *src, size_t count)
+{
+    const size_t n = count & ~(size_t)7;
+    for (size_t i = 0; i < n; i += 8) {
+        const int16x8_t v = vld1q_s16(src + i);
+        vst1q_f32(dst + i, vmulq_n_f32(
+                vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), 1.f / 32768.f));
+        vst1q_f32(dst + i + 4, vmulq_n_f32(
+                vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), 1.f / 32768.f));
+    }
+    return n;
+}
+
+// clamp32_from_float() and clamp24_from_float(): round half away from zero, saturate.
+template <int32_t kMin, int32_t kMax>
+size_t fixedFromFloat(int32_t *dst, const float *src, size_t count, float scale)
+{
+    const float32x4_t lower = vdupq_n_f32(kMin / scale);
+    const float32x4_t upper = vdupq_n_f32(kMax / scale);
+    const size_t n = count & ~(size_t)7;
+    for (size_t i = 0; i < n; i += 4) {
+        // for 32 bit the conversion saturates, as the limits do not fit in a float
+        float32x4_t v = vld1q_f32(src + i);
+        if (kMax != INT32_MAX) {
+            v = vminq_f32(vmaxq_f32(v, lower), upper);
+        }
+        vst1q_s32(dst + i, vcvtaq_s32_f32(vmulq_n_f32(v, scale)));
+    }
+    return n;
+}
+
+size_t floatFromFixed(float *dst, const int32_t *src, size_t count, float scale)
+{
+    const size_t n = count & ~(size_t)7;
+    for (size_t i = 0; i < n; i += 4) {
+        vst1q_f32(dst + i, vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(src + i)), scale));
+    }
+    return n;
+}
+
+#elif USE_SSE_CONVERSION
+
+// clamp16_from_float(): round half to even (the default MXCSR rounding), saturate.
+size_t i16FromFloat(int16_t *dst, const float *src, size_t count)
+{
+    // clamp as floats, _mm_cvtps_epi32() returns INT32_MIN on overflow
+    const __m128 scale = _mm_set1_ps(32768.f);
+    const __m128 lower = _mm_set1_ps(-32768.f);
+    const __m128 upper = _mm_set1_ps(32767.f);
+    const size_t n = count & ~(size_t)7;
+    for (size_t i = 0; i < n; i += 8) {
+        const __m128 lo = _mm_min_ps(_mm_max_ps(
+                _mm_mul_ps(_mm_loadu_ps(src + i), scale), lower), upper);
+        const __m128 hi = _mm_min_ps(_mm_max_ps(
+                _mm_mul_ps(_mm_loadu_ps(src + i + 4), scale), lower), upper);
+        _mm_storeu_si128((__m128i *)(dst + i),
+                _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi)));
+    }
+    return n;
+}
+
+size_t floatFromI16(float *dst, const int16_t *src, size_t count)
+{
+    const __m128 scale = _mm_set1_ps(1.f / 32768.f);
+    const size_t n = count & ~(size_t)7;
+    for (size_t i = 0; i < n; i += 8) {
+        const __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        // sign extend by shifting down from the upper half of each 32 bit lane
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    return n;
+}
+
+inline __m128i select(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// clamp32_from_float() and clamp24_from_float(): round half away from zero, saturate.
+template <int32_t kMin, int32_t kMax>
+size_t fixedFromFloat(int32_t *dst, const float *src, size_t count, float scale)
+{
+    const __m128 lower = _mm_set1_ps(kMin / scale);
+    const __m128 upper = _mm_set1_ps(kMax / scale);
+    const __m128i min = _mm_set1_epi32(kMin);
+    const __m128i max = _mm_set1_epi32(kMax);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 minusHalf = _mm_set1_ps(-0.5f);
+    const __m128 scales = _mm_set1_ps(scale);
+    const size_t n = count & ~(size_t)7;
+    for (size_t i = 0; i < n; i += 4) {
+        const __m128 v = _mm_loadu_ps(src + i);
+        const __m128 scaled = _mm_mul_ps(v, scales);
+        // truncate, then round the fraction away from zero; the fraction is exact
+        // as a float with a fraction is below 2^24
+        const __m128i truncated = _mm_cvttps_epi32(scaled);
+        const __m128 fraction = _mm_sub_ps(scaled, _mm_cvtepi32_ps(truncated));
+        __m128i rounded = _mm_sub_epi32(truncated,
+                _mm_castps_si128(_mm_cmpge_ps(fraction, half)));
+        rounded = _mm_add_epi32(rounded, _mm_castps_si128(_mm_cmple_ps(fraction, minusHalf)));
+        rounded = select(_mm_castps_si128(_mm_cmpge_ps(v, upper)), max, rounded);
+        rounded = select(_mm_castps_si128(_mm_cmple_ps(v, lower)), min, rounded);
+        _mm_storeu_si128((__m128i *)(dst + i), rounded);
+    }
+    return n;
+}
+
+size_t floatFromFixed(float *dst, const int32_t *src, size_t count, float scale)
+{
+    const __m128 scales = _mm_set1_ps(scale);
+    const size_t n = count & ~(size_t)7;
+    for (size_t i = 0; i < n; i += 4) {
+        _mm_storeu_ps(dst + i, _mm_mul_ps(
+                _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(src + i))), scales));
+    }
+    return n;
+}
+
+#endif
+
+// Returns the number of samples converted by a kernel, 0 if there is none for the pair.
+size_t convertVector(void *dst, audio_format_t dstFormat,
+        const void *src, audio_format_t srcFormat, size_t count)
+{
+#if USE_NEON_CONVERSION || USE_SSE_CONVERSION
+    constexpr float kScale32 = 2147483648.f;    // 1 << 31
+    constexpr float kScale24 = 8388608.f;       // 1 << 23
+    if (srcFormat == AUDIO_FORMAT_PCM_FLOAT) {
+        switch (dstFormat) {
+        case AUDIO_FORMAT_PCM_16_BIT:
+            return i16FromFloat((int16_t *)dst, (const float *)src, count);
+        case AUDIO_FORMAT_PCM_32_BIT:
+            return fixedFromFloat<INT32_MIN, INT32_MAX>(
+                    (int32_t *)dst, (const float *)src, count, kScale32);
+        case AUDIO_FORMAT_PCM_8_24_BIT:
+            return fixedFromFloat<-0x800000, 0x7fffff>(
+                    (int32_t *)dst, (const float *)src, count, kScale24);
+        default:
+            break;
+        }
+    } else if (dstFormat == AUDIO_FORMAT_PCM_FLOAT) {
+        switch (srcFormat) {
+        case AUDIO_FORMAT_PCM_16_BIT:
+            return floatFromI16((float *)dst, (const int16_t *)src, count);
+        case AUDIO_FORMAT_PCM_32_BIT:
+            return floatFromFixed((float *)dst, (const int32_t *)src, count, 1.f / kScale32);
+        case AUDIO_FORMAT_PCM_8_24_BIT:
+            return floatFromFixed((float *)dst, (const int32_t *)src, count, 1.f / kScale24);
+        default:
+            break;
+        }
+    }
+#else
+    (void)dst; (void)dstFormat; (void)src; (void)srcFormat; (void)count;
+#endif
+    return 0;
+}
+
+} // namespace
+
+void convertPcm(void *dst, audio_format_t dstFormat,
+        const void *src, audio_format_t srcFormat, size_t count)
+{
+    const size_t dstSize = audio_bytes_per_sample(dstFormat);
+    const size_t srcSize = audio_bytes_per_sample(srcFormat);
+    // The kernels go forward, like audio_utils does when the samples do not grow.
+    // Other overlaps are left to audio_utils.
+    const uintptr_t dstBegin = (uintptr_t)dst;
+    const uintptr_t srcBegin = (uintptr_t)src;
+    const bool overlap = dstBegin < srcBegin + count * srcSize
+            && srcBegin < dstBegin + count * dstSize;
+    size_t done = 0;
+    if (dstFormat != srcFormat
+            && (!overlap || (dstBegin == srcBegin && dstSize <= srcSize))) {
+        done = convertVector(dst, dstFormat, src, srcFormat, count);
+    }
+    if (done < count) {
+        memcpy_by_audio_format((uint8_t *)dst + done * dstSize, dstFormat,
+                (const uint8_t *)src + done * srcSize, srcFormat, count - done);
+    }
+}
+
+void convertPcmToI16Dithered(int16_t *dst, const float *src, size_t count, uint32_t *seed)
+{
+    // Each xorshift32 output gives two uniform values in [0, 1) LSB, their difference
+    // has a triangular distribution over (-1, 1) LSB.
+    constexpr float kScale = 1.f / (65536.f * 32768.f);
+    uint32_t state = *seed != 0 ? *seed : 1;    // xorshift never leaves 0
+    for (size_t i = 0; i < count; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        const float dither = ((int32_t)(state & 0xffff) - (int32_t)(state >> 16)) * kScale;
+        dst[i] = clamp16_from_float(src[i] + dither);
+    }
+    *seed = state;
+}
+
+} // namespace android
@@ -22,6 +22,7 @@
 #include <media/AudioMixer.h>  // for UNITY_GAIN_FLOAT
 #include <media/AudioResampler.h>
 #include <media/BufferProviders.h>
+#include <media/PcmConversion.h>
 #include <media/RecordBufferConverter.h>
 #include <utils/Log.h>
 
@@ -241,7 +242,7 @@ void RecordBufferConverter::convertNoResampler(
                     (const float *)src, frames);
         }
         if (mBuf != NULL) {
-            memcpy_by_audio_format(dst, mDstFormat, mBuf, AUDIO_FORMAT_PCM_FLOAT,
+            convertPcm(dst, mDstFormat, mBuf, AUDIO_FORMAT_PCM_FLOAT,
                     frames * mDstChannelCount);
         }
         return;
@@ -257,7 +258,7 @@ void RecordBufferConverter::convertNoResampler(
     }
     // convert to destination buffer
     const void *convertBuf = mBuf != NULL ? mBuf : src;
-    memcpy_by_audio_format(dst, mDstFormat, convertBuf, mSrcFormat,
+    convertPcm(dst, mDstFormat, convertBuf, mSrcFormat,
             frames * mDstChannelCount);
 }
 
@@ -282,7 +283,7 @@ void RecordBufferConverter::convertResampler(
         }
         // convert to destination format (in place, OK as float is larger than other types)
         if (mDstFormat != AUDIO_FORMAT_PCM_FLOAT) {
-            memcpy_by_audio_format(src, mDstFormat, src, AUDIO_FORMAT_PCM_FLOAT,
+            convertPcm(src, mDstFormat, src, AUDIO_FORMAT_PCM_FLOAT,
                     frames * mSrcChannelCount);
         }
         // channel convert and save to dst
@@ -291,7 +292,7 @@ void RecordBufferConverter::convertResampler(
         return;
     }
     // convert to destination format and save to dst
-    memcpy_by_audio_format(dst, mDstFormat, src, AUDIO_FORMAT_PCM_FLOAT,
+    convertPcm(dst, mDstFormat, src, AUDIO_FORMAT_PCM_FLOAT,
             frames * mDstChannelCount);
 }
 
@@ -0,0 +1,378 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "TimeStretcher"
+//#define LOG_NDEBUG 0
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include <media/AudioResampler.h>
+#include <media/TimeStretcher.h>
+#include <utils/Log.h>
+
+// NEON and SSE are part of the arm64 and x86 ABIs, so the correlation is selected at compile
+// time. Unlike PcmConversion, the arm32 NEON instruction set has all that is needed here.
+#if defined(__ARM_NEON__) || defined(__aarch64__)
+#define USE_NEON_CORRELATION (true)
+#include <arm_neon.h>
+#else
+#define USE_NEON_CORRELATION (false)
+#endif
+
+#if defined(__SSE__)
+#define USE_SSE_CORRELATION (true)
+#include <xmmintrin.h>
+#else
+#define USE_SSE_CORRELATION (false)
+#endif
+
+namespace android {
+
+namespace {
+
+struct Geometry {
+    uint32_t segmentMs;     // length of a segment, including the overlap
+    uint32_t overlapMs;     // crossfade between segments, and length of the correlation
+    uint32_t searchMs;      // the segment is moved by up to +/- this to find the best match
+    uint32_t searchStep;    // candidate spacing of the coarse search, in input frames
+    AudioResampler::src_quality resamplerQuality;
+};
+
+constexpr Geometry kGeometries[] = {
+    { 40, 8, 8, 4, AudioResampler::DYN_LOW_QUALITY },       // LOW_QUALITY
+    { 40, 10, 10, 2, AudioResampler::DYN_MED_QUALITY },     // MED_QUALITY
+    { 40, 12, 12, 1, AudioResampler::DYN_HIGH_QUALITY },    // HIGH_QUALITY
+};
+
+// Computes the dot products of x with y and of y with itself over count samples.
+// The precision is only that needed to rank the search candidates.
+void correlate(const float *x, const float *y, size_t count, float *xy, float *yy)
+{
+    size_t i = 0;
+    float sumXY = 0.f;
+    float sumYY = 0.f;
+#if USE_NEON_CORRELATION
+    float32x4_t accXY = vdupq_n_f32(0.f);
+    float32x4_t accYY = vdupq_n_f32(0.f);
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t vy = vld1q_f32(y + i);
+        accXY = vmlaq_f32(accXY, vld1q_f32(x + i), vy);
+        accYY = vmlaq_f32(accYY, vy, vy);
+    }
+#if defined(__aarch64__)
+    sumXY = vaddvq_f32(accXY);
+    sumYY = vaddvq_f32(accYY);
+#else
+    const float32x2_t pairs = vpadd_f32(
+            vadd_f32(vget_low_f32(accXY), vget_high_f32(accXY)),
+            vadd_f32(vget_low_f32(accYY), vget_high_f32(accYY)));
+    sumXY = vget_lane_f32(pairs, 0);
+    sumYY = vget_lane_f32(pairs, 1);
+#endif
+#elif USE_SSE_CORRELATION
+    __m128 accXY = _mm_setzero_ps();
+    __m128 accYY = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        const __m128 vy = _mm_loadu_ps(y + i);
+        accXY = _mm_add_ps(accXY, _mm_mul_ps(_mm_loadu_ps(x + i), vy));
+        accYY = _mm_add_ps(accYY, _mm_mul_ps(vy, vy));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, accXY);
+    sumXY = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm_storeu_ps(lanes, accYY);
+    sumYY = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; i < count; i++) {
+        sumXY += x[i] * y[i];
+        sumYY += y[i] * y[i];
+    }
+    *xy = sumXY;
+    *yy = sumYY;
+}
+
+} // namespace
+
+TimeStretcher::TimeStretcher(uint32_t channelCount, uint32_t inSampleRate,
+        uint32_t outSampleRate, quality_t quality) :
+        mChannelCount(channelCount),
+        mQuality(std::clamp(quality, LOW_QUALITY, HIGH_QUALITY)),
+        mSpeed(1.f),
+        mInSampleRate(0),
+        mOutSampleRate(0),
+        mInputFrames(0),
+        mFirstSegment(true),
+        mStretchedProvider(this),
+        mStretchedFrames(0),
+        mStretchedFront(0),
+        mOutputFrames(0)
+{
+    setSampleRates(inSampleRate, outSampleRate);
+    reset();
+    ALOGV("TimeStretcher(%p)(%u, %u, %u, %d)",
+            this, channelCount, inSampleRate, outSampleRate, quality);
+}
+
+TimeStretcher::~TimeStretcher()
+{
+}
+
+void TimeStretcher::setSpeed(float speed)
+{
+    mSpeed = speed;
+}
+
+void TimeStretcher::setSampleRates(uint32_t inSampleRate, uint32_t outSampleRate)
+{
+    const Geometry &geometry = kGeometries[mQuality - LOW_QUALITY];
+    // The buffered input, positions and overlap are in frames of the segment geometry,
+    // so it is kept once a segment is output. A pitch change then only scales its duration.
+    if (mFirstSegment) {
+        mSegmentFrames = (size_t)inSampleRate * geometry.segmentMs / 1000;
+        mOverlapFrames = (size_t)inSampleRate * geometry.overlapMs / 1000;
+        mSearchFrames = (size_t)inSampleRate * geometry.searchMs / 1000;
+        mSearchStep = geometry.searchStep;
+        mOverlap.resize(mOverlapFrames * mChannelCount);
+    }
+
+    if (inSampleRate == outSampleRate) {
+        if (mResampler != nullptr) {
+            // the stretched frames the resampler has not read are already at the output rate
+            resample();
+            const size_t frames = mStretchedFrames - mStretchedFront;
+            mOutput.resize((mOutputFrames + frames) * mChannelCount);
+            memcpy(&mOutput[mOutputFrames * mChannelCount],
+                    &mStretched[mStretchedFront * mChannelCount],
+                    frames * mChannelCount * sizeof(float));
+            mOutputFrames += frames;
+            mStretchedFrames = 0;
+            mStretchedFront = 0;
+            mResampler.reset();
+        }
+    } else {
+        if (mResampler == nullptr || outSampleRate != mOutSampleRate) {
+            // The resampler of a track at the same quality designs the same filter bank,
+            // which AudioResamplerDynFilterCache shares.
+            mResampler.reset(AudioResampler::create(AUDIO_FORMAT_PCM_FLOAT, mChannelCount,
+                    outSampleRate, geometry.resamplerQuality));
+            mResampler->setVolume(AudioResampler::UNITY_GAIN_FLOAT,
+                    AudioResampler::UNITY_GAIN_FLOAT);
+        }
+        // a pitch change only changes the input rate, the resampler keeps its state
+        mResampler->setSampleRate(inSampleRate);
+    }
+    mInSampleRate = inSampleRate;
+    mOutSampleRate = outSampleRate;
+}
+
+size_t TimeStretcher::inputFramesNeeded(size_t frameCount) const
+{
+    return (size_t)ceil(frameCount * mSpeed * mInSampleRate / mOutSampleRate) + 1;
+}
+
+void TimeStretcher::write(const float *in, size_t frameCount)
+{
+    const size_t needed = (mInputFrames + frameCount) * mChannelCount;
+    if (mInput.size() < needed) {
+        mInput.resize(needed);
+    }
+    memcpy(&mInput[mInputFrames * mChannelCount], in,
+            frameCount * mChannelCount * sizeof(float));
+    mInputFrames += frameCount;
+    while (stretchSegment()) {
+    }
+    if (mResampler != nullptr) {
+        resample();
+    }
+}
+
+void TimeStretcher::consume(size_t frameCount)
+{
+    LOG_ALWAYS_FATAL_IF(frameCount > mOutputFrames,
+            "Consuming more frames(%zu) than available(%zu)", frameCount, mOutputFrames);
+    mOutputFrames -= frameCount;
+    memmove(mOutput.data(), &mOutput[frameCount * mChannelCount],
+            mOutputFrames * mChannelCount * sizeof(float));
+}
+
+void TimeStretcher::reset()
+{
+    mInputFrames = 0;
+    mOutputFrames = 0;
+    mNominal = 0.;
+    mContinuation = 0;
+    mFirstSegment = true;
+    mStretchedFrames = 0;
+    mStretchedFront = 0;
+    if (mResampler != nullptr) {
+        mResampler->reset();
+    }
+}
+
+// Outputs the next segment if enough input is buffered, returns false otherwise.
+bool TimeStretcher::stretchSegment()
+{
+    const size_t hopFrames = mSegmentFrames - mOverlapFrames;
+    const size_t center = (size_t)mNominal;
+    const size_t begin = center > mSearchFrames ? center - mSearchFrames : 0;
+    const size_t end = mFirstSegment ? center : center + mSearchFrames;
+    size_t needed = end + mSegmentFrames;
+    if (!mFirstSegment) {
+        needed = std::max(needed, mContinuation + mOverlapFrames);
+    }
+    if (mInputFrames < needed) {
+        return false;
+    }
+
+    size_t position = center;
+    if (!mFirstSegment) {
+        position = search(mContinuation, begin, end, mSearchStep);
+        if (mSearchStep > 1) {
+            const size_t margin = mSearchStep - 1;
+            position = search(mContinuation,
+                    position > begin + margin ? position - margin : begin,
+                    std::min(position + margin, end), 1);
+        }
+    }
+
+    // the segments are at the input rate, the resampler converts them
+    std::vector<float> &stretched = mResampler != nullptr ? mStretched : mOutput;
+    size_t &stretchedFrames = mResampler != nullptr ? mStretchedFrames : mOutputFrames;
+    const size_t stretchedSamples = (stretchedFrames + hopFrames) * mChannelCount;
+    if (stretched.size() < stretchedSamples) {
+        stretched.resize(stretchedSamples);
+    }
+    float *out = &stretched[stretchedFrames * mChannelCount];
+    const float *in = &mInput[position * mChannelCount];
+    memcpy(out, in, hopFrames * mChannelCount * sizeof(float));
+    if (!mFirstSegment) {
+        for (size_t i = 0; i < mOverlapFrames; i++) {
+            const float fadeIn = (i + 0.5f) / mOverlapFrames;
+            for (size_t j = 0; j < mChannelCount; j++) {
+                const size_t index = i * mChannelCount + j;
+                out[index] = mOverlap[index] + fadeIn * (out[index] - mOverlap[index]);
+            }
+        }
+    }
+    memcpy(mOverlap.data(), in + hopFrames * mChannelCount,
+            mOverlapFrames * mChannelCount * sizeof(float));
+    stretchedFrames += hopFrames;
+    mFirstSegment = false;
+
+    // The next segment is crossfaded with the input that follows this one, and is placed
+    // around the position the exact speed gives.
+    mContinuation = position + hopFrames;
+    mNominal += hopFrames * mSpeed;
+
+    // Drop the input before the next search range and the continuation.
+    const double keep = std::min(mNominal - mSearchFrames, (double)mContinuation);
+    if (keep >= 1.) {
+        const size_t drop = (size_t)keep;
+        mInputFrames -= drop;
+        memmove(mInput.data(), &mInput[drop * mChannelCount],
+                mInputFrames * mChannelCount * sizeof(float));
+        mNominal -= drop;
+        mContinuation -= drop;
+    }
+    return true;
+}
+
+// Converts the stretched frames to the output sample rate.
+void TimeStretcher::resample()
+{
+    // The resampler resets its history when its provider runs dry, so only ask for the
+    // output frames it has all the input for. Besides the ratio, its phase may hold back
+    // up to one input frame.
+    const size_t available = mStretchedFrames - mStretchedFront;
+    const double inFramesPerOutFrame = (double)mInSampleRate / mOutSampleRate;
+    const double maxFrameCount = (available - 1.) / inFramesPerOutFrame - 1.;
+    if (maxFrameCount >= 1.) {
+        const size_t frameCount = (size_t)maxFrameCount;
+        // the resampler accumulates, and outputs stereo for mono
+        const bool mono = mChannelCount == 1;
+        float *out;
+        if (mono) {
+            mResampled.assign(frameCount * 2, 0.f);
+            out = mResampled.data();
+        } else {
+            mOutput.resize((mOutputFrames + frameCount) * mChannelCount);
+            out = &mOutput[mOutputFrames * mChannelCount];
+            memset(out, 0, frameCount * mChannelCount * sizeof(float));
+        }
+        const size_t frames = mResampler->resample(
+                reinterpret_cast<int32_t *>(out), frameCount, &mStretchedProvider);
+        if (mono) {
+            mOutput.resize(mOutputFrames + frames);
+            for (size_t i = 0; i < frames; i++) {
+                mOutput[mOutputFrames + i] = mResampled[i * 2];
+            }
+        }
+        mOutputFrames += frames;
+    }
+    mStretchedFrames -= mStretchedFront;
+    memmove(mStretched.data(), &mStretched[mStretchedFront * mChannelCount],
+            mStretchedFrames * mChannelCount * sizeof(float));
+    mStretchedFront = 0;
+}
+
+status_t TimeStretcher::StretchedProvider::getNextBuffer(Buffer *buffer)
+{
+    const size_t available = mStretcher->mStretchedFrames - mStretcher->mStretchedFront;
+    buffer->frameCount = std::min(buffer->frameCount, available);
+    if (buffer->frameCount == 0) {
+        buffer->raw = nullptr;
+        return NOT_ENOUGH_DATA;
+    }
+    buffer->raw = &mStretcher->mStretched[mStretcher->mStretchedFront * mStretcher->mChannelCount];
+    return OK;
+}
+
+void TimeStretcher::StretchedProvider::releaseBuffer(Buffer *buffer)
+{
+    mStretcher->mStretchedFront += buffer->frameCount;
+    buffer->raw = nullptr;
+    buffer->frameCount = 0;
+}
+
+// Returns the position in [begin, end] at step intervals where the input best matches
+// the input at reference, by normalized cross-correlation. Of equal matches, as in silence,
+// the one closest to reference is returned.
+size_t TimeStretcher::search(size_t reference, size_t begin, size_t end, size_t step) const
+{
+    const float *x = &mInput[reference * mChannelCount];
+    const size_t count = mOverlapFrames * mChannelCount;
+    size_t best = begin;
+    size_t bestDistance = SIZE_MAX;
+    float bestScore = -INFINITY;
+    for (size_t position = begin; position <= end; position += step) {
+        float xy;
+        float yy;
+        correlate(x, &mInput[position * mChannelCount], count, &xy, &yy);
+        const float score = yy > 0.f ? xy / sqrtf(yy) : 0.f;
+        const size_t distance = position > reference ? position - reference : reference - position;
+        if (score > bestScore || (score == bestScore && distance < bestDistance)) {
+            bestScore = score;
+            bestDistance = distance;
+            best = position;
+        }
+    }
+    return best;
+}
+
+} // namespace android
@@ -124,7 +124,9 @@ private:
          *    the number of channels required by the mixer sink.
          * 6) mPostDownmixReformatBufferProvider: If not NULL, performs reformatting from
          *    the downmixer requirements to the mixer engine input requirements.
-         * 7) mTimestretchBufferProvider: Adds timestretching for playback rate
+         * 7) mTimestretchBufferProvider: Adds timestretching for playback rate, with Sonic or, if
+         *    the "af.timestretch.quality" property selects it, with the WSOLA time stretcher
+         *    which also converts the sample rate.
          */
         AudioBufferProvider* mInputBufferProvider;    // externally provided buffer provider.
         // TODO: combine mAdjustChannelsBufferProvider and
@@ -135,6 +137,9 @@ private:
         std::unique_ptr<PassthruBufferProvider> mDownmixerBufferProvider;
         std::unique_ptr<PassthruBufferProvider> mPostDownmixReformatBufferProvider;
         std::unique_ptr<PassthruBufferProvider> mTimestretchBufferProvider;
+        // mTimestretchBufferProvider is a WsolaBufferProvider, which also does the
+        // sample rate conversion of the track instead of mResampler.
+        bool mTimestretchResamples = false;
 
         audio_format_t mDownmixRequiresFormat;  // required downmixer format
                                                 // AUDIO_FORMAT_PCM_16_BIT if 16 bit necessary
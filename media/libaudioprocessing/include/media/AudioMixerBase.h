@@ -135,6 +135,16 @@ public:
 
     std::string trackNames() const;
 
+    // Returns the output frames that each track skipped because it was silent,
+    // as "name:frames" separated by spaces.
+    std::string skippedFrames() const;
+
+    // Enables or disables skipping the tracks that are silent, enabled by default.
+    void        setSkipSilence(bool skipSilence) {
+        mSkipSilence = skipSilence;
+        invalidate();
+    }
+
   protected:
     // Set kUseNewMixer to true to use the new mixer engine always. Otherwise the
     // original code will be used for stereo sinks, the new mixer for everything else.
@@ -209,6 +219,7 @@ public:
     struct TrackBase {
         TrackBase()
             : bufferProvider(nullptr)
+            , mSilenceProbe(this)
         {
             // TODO: move additional initialization here.
         }
@@ -232,6 +243,15 @@ public:
         static hook_t getTrackHook(int trackType, uint32_t channelCount,
                 audio_format_t mixerInFormat, audio_format_t mixerOutFormat);
 
+        // Returns true if the frameCount input frames at in can be skipped rather than mixed:
+        // the input has been digital silence for the hysteresis and there is no volume ramp.
+        bool        skipSilence(const void *in, size_t frameCount);
+        // Returns the number of leading output frames that a resampling track skips.
+        // The input that the resampler would have read is consumed directly, and the
+        // resampler advances its phase so that it resumes exactly where it would have been.
+        size_t      skipResampledSilence(size_t outFrameCount);
+        void        resetSilence() { mSilentFrames = 0; }
+
         void track__nop(int32_t* out, size_t numFrames, int32_t* temp, int32_t* aux);
 
         template <int MIXTYPE, bool USEFLOATVOL, bool ADJUSTVOL,
@@ -290,6 +310,22 @@ public:
         audio_channel_mask_t mMixerChannelMask;
         uint32_t             mMixerChannelCount;
 
+        // Forwards the resampler input from bufferProvider, to detect silence in it.
+        struct SilenceProbe : public AudioBufferProvider {
+            explicit SilenceProbe(TrackBase *track) : mTrack(track) {}
+            status_t getNextBuffer(Buffer *buffer) override;
+            void releaseBuffer(Buffer *buffer) override;
+
+            TrackBase * const mTrack;
+        };
+
+        SilenceProbe   mSilenceProbe;
+        bool           mSkipSilence = true;     // copy of the mixer setting
+        size_t         mInFrameSize = 0;        // input frame size of the hooks and resampler
+        size_t         mSilenceFrames = 0;      // input frames of silence before skipping
+        size_t         mSilentFrames = 0;       // consecutive silent input frames, up to above
+        int64_t        mSkippedFrames = 0;      // output frames skipped, for dump
+
       protected:
 
         // hooks
@@ -349,6 +385,8 @@ public:
 
     process_hook_t mHook = &AudioMixerBase::process__nop;   // one of process__*, never nullptr
 
+    bool mSkipSilence = true;
+
     // the size of the type (int32_t) should be the largest of all types supported
     // by the mixer.
     std::unique_ptr<int32_t[]> mOutputTemp;
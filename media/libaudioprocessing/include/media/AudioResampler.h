@@ -83,6 +83,24 @@ public:
     virtual void reset();
     virtual size_t getUnreleasedFrames() const { return mInputIndex; }
 
+    // Returns true if a buffer obtained from the provider is kept between calls to resample().
+    bool holdsInputBuffer() const { return mBuffer.frameCount != 0; }
+
+    // Skipping output frames of silence without computing them, while the input history of
+    // the resampler is silence and it holds no input buffer.
+    // Returns true if the resampler supports skipping, and sets *inFrameCount to the input
+    // frames that resample() would consume to output outFrameCount frames.
+    virtual bool getSkipFrameCount(size_t outFrameCount __unused,
+            size_t *inFrameCount __unused) const { return false; }
+    // Advances the phase over the leading output frames of outFrameCount which read only
+    // from the next inFrameCount input frames, which the caller has consumed from the provider
+    // as silence. inFrameCount is at most the count from getSkipFrameCount().
+    // Returns the output frames skipped. The phase is then exactly the one that resample()
+    // would have reached, so the output is unchanged.
+    virtual size_t skip(size_t outFrameCount __unused, size_t inFrameCount __unused) {
+        return 0;
+    }
+
     // called from destructor, so must not be virtual
     src_quality getQuality() const { return mQuality; }
 
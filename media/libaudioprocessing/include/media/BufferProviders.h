@@ -22,6 +22,7 @@
 
 #include <media/AudioBufferProvider.h>
 #include <media/AudioResamplerPublic.h>
+#include <media/TimeStretcher.h>
 #include <system/audio.h>
 #include <system/audio_effect.h>
 #include <utils/StrongPointer.h>
@@ -218,6 +219,32 @@ private:
     bool                 mAudioPlaybackRateValid; // flag for current parameters validity
 };
 
+// WsolaBufferProvider derives from PassthruBufferProvider for time stretching float audio
+// with TimeStretcher, which also converts the sample rate so the track needs no resampler.
+class WsolaBufferProvider : public PassthruBufferProvider {
+public:
+    WsolaBufferProvider(int32_t channelCount, uint32_t inSampleRate, uint32_t outSampleRate,
+            const AudioPlaybackRate &playbackRate, TimeStretcher::quality_t quality);
+    virtual ~WsolaBufferProvider();
+
+    // Overrides AudioBufferProvider methods
+    status_t getNextBuffer(Buffer* buffer) override;
+    void releaseBuffer(Buffer* buffer) override;
+
+    // Overrides PassthruBufferProvider
+    void reset() override;
+    void setBufferProvider(AudioBufferProvider *p) override;
+
+    // Invalid rates are clamped to the supported range, there is no fallback mode.
+    status_t setPlaybackRate(const AudioPlaybackRate &playbackRate);
+    void setSampleRates(uint32_t inSampleRate, uint32_t outSampleRate);
+
+private:
+    AudioBufferProvider::Buffer mBuffer;          // for upstream request
+    AudioPlaybackRate    mPlaybackRate;
+    TimeStretcher        mStretcher;
+};
+
 // AdjustChannelsBufferProvider derives from CopyBufferProvider to adjust sample data.
 // Expands or contracts sample data from one interleaved channel format to another.
 // Extra expanded channels are filled with zeros and put at the end of each audio frame.
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_PCM_CONVERSION_H
+#define ANDROID_PCM_CONVERSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <system/audio.h>
+
+namespace android {
+
+/**
+ * Converts count samples from srcFormat to dstFormat.
+ *
+ * This is a drop-in replacement for memcpy_by_audio_format(), with the same parameters,
+ * in-place rules and bit-exact results. The conversions between float and 16 bit, 32 bit
+ * and Q8.23 PCM use NEON on arm64 and SSE2 on x86, the other pairs and any partial vector
+ * at the end of the buffer use audio_utils.
+ */
+void convertPcm(void *dst, audio_format_t dstFormat,
+        const void *src, audio_format_t srcFormat, size_t count);
+
+/**
+ * Converts count float samples to 16 bit PCM with triangular (TPDF) dither of +/- 1 LSB,
+ * so that the quantization error of a low level signal is noise rather than distortion.
+ *
+ * \param seed the state of the dither noise generator, carried over between calls.
+ *             Any initial value may be used.
+ */
+void convertPcmToI16Dithered(int16_t *dst, const float *src, size_t count, uint32_t *seed);
+
+} // namespace android
+
+#endif // ANDROID_PCM_CONVERSION_H
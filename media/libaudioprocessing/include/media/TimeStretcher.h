@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_TIME_STRETCHER_H
+#define ANDROID_TIME_STRETCHER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include <media/AudioBufferProvider.h>
+
+namespace android {
+
+class AudioResampler;
+
+/**
+ * WSOLA (waveform similarity overlap-add) time stretcher for interleaved float audio,
+ * which also converts the sample rate.
+ *
+ * The output is made of segments of the input, spaced by the speed. Each segment is
+ * shifted within a search range to the position where it best matches the natural
+ * continuation of the previous segment, and is crossfaded with it. The stretched frames
+ * are then converted to the output sample rate by a polyphase AudioResampler of the same
+ * quality as the one of a track, sharing its filter bank, so a track that needs both a
+ * playback speed and a sample rate conversion needs a single buffer provider.
+ */
+class TimeStretcher {
+public:
+    // The values match the "af.timestretch.quality" property.
+    enum quality_t {
+        LOW_QUALITY = 1,    // coarse search, AudioResampler::DYN_LOW_QUALITY
+        MED_QUALITY = 2,    // finer search, AudioResampler::DYN_MED_QUALITY
+        HIGH_QUALITY = 3,   // exhaustive search, AudioResampler::DYN_HIGH_QUALITY
+    };
+
+    TimeStretcher(uint32_t channelCount, uint32_t inSampleRate, uint32_t outSampleRate,
+            quality_t quality);
+    ~TimeStretcher();
+
+    // speed is the ratio of input to output duration, at equal sample rates.
+    void setSpeed(float speed);
+    void setSampleRates(uint32_t inSampleRate, uint32_t outSampleRate);
+
+    // Returns an estimate of the input frames needed for frameCount more output frames.
+    size_t inputFramesNeeded(size_t frameCount) const;
+
+    // Appends frameCount input frames and stretches as much of the input as possible.
+    void write(const float *in, size_t frameCount);
+
+    // The stretched frames not yet consumed, valid until the next call to write().
+    size_t framesReady() const { return mOutputFrames; }
+    const float *outputBuffer() const { return mOutput.data(); }
+    void consume(size_t frameCount);
+
+    // Drops all buffered input and output, for an audio discontinuity.
+    void reset();
+
+    quality_t getQuality() const { return mQuality; }
+
+private:
+    // Provides the stretched frames to the resampler.
+    class StretchedProvider : public AudioBufferProvider {
+    public:
+        explicit StretchedProvider(TimeStretcher *stretcher) : mStretcher(stretcher) {}
+        status_t getNextBuffer(Buffer *buffer) override;
+        void releaseBuffer(Buffer *buffer) override;
+    private:
+        TimeStretcher * const mStretcher;
+    };
+
+    bool stretchSegment();
+    void resample();
+    size_t search(size_t reference, size_t begin, size_t end, size_t step) const;
+
+    const uint32_t  mChannelCount;
+    const quality_t mQuality;
+    float           mSpeed;
+    uint32_t        mInSampleRate;
+    uint32_t        mOutSampleRate;
+
+    // Segment geometry, search range and correlation length in input frames.
+    size_t          mSegmentFrames;
+    size_t          mOverlapFrames;
+    size_t          mSearchFrames;
+    size_t          mSearchStep;
+
+    std::vector<float> mInput;
+    size_t          mInputFrames;       // valid frames in mInput
+    double          mNominal;           // input position of the next segment at the exact speed
+    size_t          mContinuation;      // input position that follows the previous segment
+    bool            mFirstSegment;
+    std::vector<float> mOverlap;        // tail of the previous segment, to crossfade
+
+    // The stretched frames at the input sample rate, when the sample rates differ.
+    std::unique_ptr<AudioResampler> mResampler;
+    StretchedProvider mStretchedProvider;
+    std::vector<float> mStretched;
+    size_t          mStretchedFrames;   // valid frames in mStretched
+    size_t          mStretchedFront;    // frames of mStretched read by the resampler
+    std::vector<float> mResampled;      // stereo output of the resampler for mono
+
+    std::vector<float> mOutput;
+    size_t          mOutputFrames;      // valid frames in mOutput
+};
+
+} // namespace android
+
+#endif // ANDROID_TIME_STRETCHER_H
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "mixer_tests"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <log/log.h>
+#include <media/AudioMixer.h>
+
+#include "test_utils.h"
+
+using namespace android;
+
+static constexpr uint32_t kMixerSampleRate = 48000;
+static constexpr size_t kMixerFrameCount = 240;    // 5 ms
+static constexpr size_t kChannelCount = 2;
+static constexpr size_t kSilenceMs = 300;           // longer than the silence hysteresis
+static constexpr size_t kSoundMs = 300;
+static constexpr size_t kMixCount = 100;            // 500 ms of output
+
+// Returns the stereo float input: silence, then a 1 kHz tone starting at its peak.
+static std::vector<float> makeInput(uint32_t sampleRate, size_t silenceMs = kSilenceMs,
+        size_t soundMs = kSoundMs) {
+    const size_t silenceFrames = sampleRate * silenceMs / 1000;
+    const size_t frames = silenceFrames + sampleRate * soundMs / 1000;
+    std::vector<float> input(frames * kChannelCount);
+    for (size_t i = silenceFrames; i < frames; ++i) {
+        const float sample = 0.5f * cosf(2 * M_PI * 1000. * (i - silenceFrames) / sampleRate);
+        for (size_t c = 0; c < kChannelCount; ++c) {
+            input[i * kChannelCount + c] = sample;
+        }
+    }
+    return input;
+}
+
+// Mixes the input at sampleRate into kMixerSampleRate, with the track muted for the mixes
+// in [muteBegin, muteEnd), and returns the output frames skipped because the track was silent.
+static size_t mix(std::vector<float> &input, uint32_t sampleRate, bool skipSilence,
+        std::vector<float> *output, size_t muteBegin = 0, size_t muteEnd = 0) {
+    const size_t frameSize = kChannelCount * sizeof(float);
+    TestProvider provider(input.data(), input.size() / kChannelCount, frameSize,
+            std::vector<int>());
+    output->assign(kMixCount * kMixerFrameCount * kChannelCount, 0.f);
+
+    AudioMixer mixer(kMixerFrameCount, kMixerSampleRate);
+    mixer.setSkipSilence(skipSilence);
+    const int name = 0;
+    EXPECT_EQ(OK, mixer.create(name, AUDIO_CHANNEL_OUT_STEREO, AUDIO_FORMAT_PCM_FLOAT,
+            AUDIO_SESSION_OUTPUT_MIX));
+    mixer.setBufferProvider(name, &provider);
+    mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_FORMAT,
+            (void *)(uintptr_t)AUDIO_FORMAT_PCM_FLOAT);
+    mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::FORMAT,
+            (void *)(uintptr_t)AUDIO_FORMAT_PCM_FLOAT);
+    mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_CHANNEL_MASK,
+            (void *)(uintptr_t)AUDIO_CHANNEL_OUT_STEREO);
+    mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::CHANNEL_MASK,
+            (void *)(uintptr_t)AUDIO_CHANNEL_OUT_STEREO);
+    mixer.setParameter(name, AudioMixer::RESAMPLE, AudioMixer::SAMPLE_RATE,
+            (void *)(uintptr_t)sampleRate);
+    float volume = AudioMixer::UNITY_GAIN_FLOAT;
+    mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME0, &volume);
+    mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME1, &volume);
+    mixer.enable(name);
+
+    for (size_t i = 0; i < kMixCount; ++i) {
+        if (i == muteBegin || i == muteEnd) {
+            volume = i == muteBegin && muteBegin < muteEnd ? 0.f : AudioMixer::UNITY_GAIN_FLOAT;
+            mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME0, &volume);
+            mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME1, &volume);
+        }
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MAIN_BUFFER,
+                output->data() + i * kMixerFrameCount * kChannelCount);
+        mixer.process();
+    }
+
+    // skippedFrames() is "name:frames "
+    const std::string skipped = mixer.skippedFrames();
+    return strtoul(skipped.substr(skipped.find(':') + 1).c_str(), nullptr, 10);
+}
+
+// Returns the index of the first output frame of sound.
+static size_t firstSoundFrame(const std::vector<float> &output) {
+    size_t i = 0;
+    while (i < output.size() && output[i] == 0.f) {
+        ++i;
+    }
+    return i / kChannelCount;
+}
+
+TEST(mixer, SkipSilenceNoResampling) {
+    std::vector<float> input = makeInput(kMixerSampleRate);
+    std::vector<float> mixed, skipped;
+    EXPECT_EQ(0u, mix(input, kMixerSampleRate, false /* skipSilence */, &mixed));
+    EXPECT_GT(mix(input, kMixerSampleRate, true /* skipSilence */, &skipped), 0u);
+
+    // without resampling, skipping the silence is bit exact
+    EXPECT_EQ(kMixerSampleRate * kSilenceMs / 1000, firstSoundFrame(mixed));
+    EXPECT_EQ(mixed, skipped);
+}
+
+TEST(mixer, SkipSilenceResampling) {
+    constexpr uint32_t kSampleRate = 44100;
+    std::vector<float> input = makeInput(kSampleRate);
+    std::vector<float> mixed, skipped;
+    EXPECT_EQ(0u, mix(input, kSampleRate, false /* skipSilence */, &mixed));
+    EXPECT_GT(mix(input, kSampleRate, true /* skipSilence */, &skipped), 0u);
+
+    // the resampler resumes with the phase it would have had, so skipping is bit exact too
+    EXPECT_NEAR(kMixerSampleRate * kSilenceMs / 1000, firstSoundFrame(mixed), 32);
+    EXPECT_EQ(mixed, skipped);
+}
+
+TEST(mixer, SkipSilenceResamplingMuted) {
+    constexpr uint32_t kSampleRate = 44100;
+    // the tone plays through the mute, which is longer than the silence hysteresis
+    std::vector<float> input = makeInput(kSampleRate, 0 /* silenceMs */, 600 /* soundMs */);
+    constexpr size_t kMuteBegin = 20;
+    constexpr size_t kMuteEnd = 80;
+    std::vector<float> mixed, skipped;
+    EXPECT_EQ(0u, mix(input, kSampleRate, false /* skipSilence */, &mixed,
+            kMuteBegin, kMuteEnd));
+    mix(input, kSampleRate, true /* skipSilence */, &skipped, kMuteBegin, kMuteEnd);
+
+    // after the unmute, the resampler history holds the input played while muted
+    EXPECT_NE(0.f, mixed[kMuteEnd * kMixerFrameCount * kChannelCount]);
+    EXPECT_EQ(mixed, skipped);
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <audio_utils/format.h>
+#include <benchmark/benchmark.h>
+#include <media/PcmConversion.h>
+
+using namespace android;
+
+// A 20 ms mixer period of 48 kHz stereo.
+constexpr size_t kSampleCount = 960 * 2;
+
+static constexpr audio_format_t kFormats[] = {
+    AUDIO_FORMAT_PCM_16_BIT,
+    AUDIO_FORMAT_PCM_24_BIT_PACKED,
+    AUDIO_FORMAT_PCM_32_BIT,
+    AUDIO_FORMAT_PCM_8_24_BIT,
+    AUDIO_FORMAT_PCM_FLOAT,
+};
+
+/*******************************************************************
+ * The first parameter is the source format, the second the destination format.
+ * The third parameter is 1 for convertPcm(), 0 for memcpy_by_audio_format().
+ * The bytes per second counter is the source and destination bytes per second.
+ *******************************************************************/
+
+static void BM_PcmConversion(benchmark::State& state) {
+    const audio_format_t srcFormat = (audio_format_t)state.range(0);
+    const audio_format_t dstFormat = (audio_format_t)state.range(1);
+    const bool vectorized = state.range(2) != 0;
+
+    // in range float samples, random bytes for the other formats
+    std::minstd_rand gen(42);
+    std::vector<uint8_t> src(kSampleCount * audio_bytes_per_sample(srcFormat));
+    for (auto& byte : src) {
+        byte = gen();
+    }
+    if (srcFormat == AUDIO_FORMAT_PCM_FLOAT) {
+        std::uniform_real_distribution<float> dis(-1.f, 1.f);
+        float* data = (float*)src.data();
+        for (size_t i = 0; i < kSampleCount; i++) {
+            data[i] = dis(gen);
+        }
+    }
+    std::vector<uint8_t> dst(kSampleCount * audio_bytes_per_sample(dstFormat));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(src.data());
+        if (vectorized) {
+            convertPcm(dst.data(), dstFormat, src.data(), srcFormat, kSampleCount);
+        } else {
+            memcpy_by_audio_format(dst.data(), dstFormat, src.data(), srcFormat, kSampleCount);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * (src.size() + dst.size()));
+    state.SetLabel(std::string(audio_format_to_string(srcFormat)) + " -> "
+            + audio_format_to_string(dstFormat));
+}
+
+static void PcmConversionArgs(benchmark::internal::Benchmark* b) {
+    for (audio_format_t srcFormat : kFormats) {
+        for (audio_format_t dstFormat : kFormats) {
+            if (srcFormat == dstFormat) {
+                continue;
+            }
+            for (int vectorized = 0; vectorized <= 1; vectorized++) {
+                b->Args({srcFormat, dstFormat, vectorized});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_PcmConversion)->Apply(PcmConversionArgs);
+
+// Float to 16 bit with dither, to compare with the undithered BM_PcmConversion.
+static void BM_PcmConversionDithered(benchmark::State& state) {
+    std::minstd_rand gen(42);
+    std::uniform_real_distribution<float> dis(-1.f, 1.f);
+    std::vector<float> src(kSampleCount);
+    for (auto& sample : src) {
+        sample = dis(gen);
+    }
+    std::vector<int16_t> dst(kSampleCount);
+    uint32_t seed = 1;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(src.data());
+        convertPcmToI16Dithered(dst.data(), src.data(), kSampleCount, &seed);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * kSampleCount
+            * (sizeof(float) + sizeof(int16_t)));
+}
+
+BENCHMARK(BM_PcmConversionDithered);
+
+BENCHMARK_MAIN();
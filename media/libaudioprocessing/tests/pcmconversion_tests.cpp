@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "pcmconversion_tests"
+
+#include <math.h>
+#include <random>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include <audio_utils/format.h>
+#include <gtest/gtest.h>
+#include <media/PcmConversion.h>
+
+using namespace android;
+
+static constexpr audio_format_t kFormats[] = {
+    AUDIO_FORMAT_PCM_16_BIT,
+    AUDIO_FORMAT_PCM_24_BIT_PACKED,
+    AUDIO_FORMAT_PCM_32_BIT,
+    AUDIO_FORMAT_PCM_8_24_BIT,
+    AUDIO_FORMAT_PCM_FLOAT,
+};
+
+// Not a multiple of the vector width, so that the audio_utils tail is exercised too.
+static constexpr size_t kSampleCount = 1003;
+
+// Returns random samples of the format, with the rounding ties and the limits
+// of each format at the start of float data.
+static std::vector<uint8_t> makeSamples(audio_format_t format, size_t count) {
+    std::minstd_rand gen(format);
+    std::vector<uint8_t> samples(count * audio_bytes_per_sample(format));
+    if (format != AUDIO_FORMAT_PCM_FLOAT) {
+        for (auto &byte : samples) {
+            byte = gen();
+        }
+        return samples;
+    }
+    std::uniform_real_distribution<float> dis(-1.5f, 1.5f);
+    float *data = (float *)samples.data();
+    for (size_t i = 0; i < count; i++) {
+        data[i] = dis(gen);
+    }
+    const float specials[] = {
+        0.f, -0.f, 1.f, -1.f, 1e10f, -1e10f, 0.99999994f, -0.99999994f,
+        0.5f / 32768, 1.5f / 32768, -0.5f / 32768, -2.5f / 32768,
+        32767.5f / 32768, -32768.5f / 32768,
+        0.5f / (1 << 23), -0.5f / (1 << 23), 1.5f / (1 << 23), 0.49999997f / (1 << 23),
+        (float)0x7fffff / (1 << 23), 0.5f / 2147483648.f, -3.5f / 2147483648.f,
+    };
+    memcpy(data, specials, std::min(sizeof(specials), count * sizeof(float)));
+    return samples;
+}
+
+TEST(pcmconversion_tests, bit_exact_with_audio_utils) {
+    for (audio_format_t srcFormat : kFormats) {
+        const std::vector<uint8_t> src = makeSamples(srcFormat, kSampleCount);
+        for (audio_format_t dstFormat : kFormats) {
+            const size_t dstBytes = kSampleCount * audio_bytes_per_sample(dstFormat);
+            std::vector<uint8_t> expected(dstBytes);
+            std::vector<uint8_t> actual(dstBytes);
+            memcpy_by_audio_format(expected.data(), dstFormat, src.data(), srcFormat,
+                    kSampleCount);
+            convertPcm(actual.data(), dstFormat, src.data(), srcFormat, kSampleCount);
+            EXPECT_EQ(0, memcmp(expected.data(), actual.data(), dstBytes))
+                    << "src format " << srcFormat << " dst format " << dstFormat;
+        }
+    }
+}
+
+TEST(pcmconversion_tests, in_place) {
+    for (audio_format_t srcFormat : kFormats) {
+        for (audio_format_t dstFormat : kFormats) {
+            const size_t srcSize = audio_bytes_per_sample(srcFormat);
+            const size_t dstSize = audio_bytes_per_sample(dstFormat);
+            const std::vector<uint8_t> src = makeSamples(srcFormat, kSampleCount);
+            std::vector<uint8_t> expected(kSampleCount * std::max(srcSize, dstSize));
+            std::vector<uint8_t> actual(expected.size());
+            memcpy(expected.data(), src.data(), src.size());
+            memcpy(actual.data(), src.data(), src.size());
+            memcpy_by_audio_format(expected.data(), dstFormat, expected.data(), srcFormat,
+                    kSampleCount);
+            convertPcm(actual.data(), dstFormat, actual.data(), srcFormat, kSampleCount);
+            EXPECT_EQ(0, memcmp(expected.data(), actual.data(), kSampleCount * dstSize))
+                    << "src format " << srcFormat << " dst format " << dstFormat;
+        }
+    }
+}
+
+TEST(pcmconversion_tests, dither) {
+    // A constant signal of a quarter LSB quantizes to 0 without dither.
+    // With TPDF dither the average of the output is the signal, with an error of about
+    // 0.6 LSB / sqrt(N).
+    constexpr size_t kCount = 1 << 16;
+    const std::vector<float> src(kCount, 0.25f / 32768);
+    std::vector<int16_t> dst(kCount);
+    uint32_t seed = 0;
+    convertPcmToI16Dithered(dst.data(), src.data(), kCount, &seed);
+    double sum = 0;
+    for (int16_t sample : dst) {
+        EXPECT_LE(abs(sample), 1);
+        sum += sample;
+    }
+    EXPECT_NEAR(0.25, sum / kCount, 0.02);
+
+    // The generator state carries over between calls.
+    std::vector<int16_t> next(kCount);
+    convertPcmToI16Dithered(next.data(), src.data(), kCount, &seed);
+    EXPECT_NE(0, memcmp(dst.data(), next.data(), kCount * sizeof(int16_t)));
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string.h>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/RecordBufferConverter.h>
+
+using namespace android;
+
+// Capture of 48 kHz stereo 16 bit by 20 ms periods, as read by the RecordThread.
+constexpr uint32_t kSrcSampleRate = 48000;
+constexpr size_t kSrcChannelCount = 2;
+constexpr size_t kSrcFrameCount = 960;
+
+/* Provides the same capture period over and over, like the RecordThread buffer does for each
+ * RecordTrack.
+ */
+class LoopProvider : public AudioBufferProvider {
+public:
+    explicit LoopProvider(const std::vector<int16_t>& data) : mData(data) { }
+
+    status_t getNextBuffer(Buffer* buffer) override {
+        const size_t frames = mData.size() / kSrcChannelCount;
+        buffer->frameCount = std::min(buffer->frameCount, frames - mFront);
+        buffer->raw = const_cast<int16_t*>(mData.data()) + mFront * kSrcChannelCount;
+        return NO_ERROR;
+    }
+
+    void releaseBuffer(Buffer* buffer) override {
+        mFront = (mFront + buffer->frameCount) % (mData.size() / kSrcChannelCount);
+        buffer->raw = nullptr;
+        buffer->frameCount = 0;
+    }
+
+private:
+    const std::vector<int16_t>& mData;
+    size_t mFront = 0;
+};
+
+/*******************************************************************
+ * The first parameter is the number of RecordTracks with the same configuration.
+ * The second parameter is the destination sample rate.
+ * The third parameter is 1 when the tracks share one conversion: it is done once and
+ * copied to each track, otherwise each track converts with its own RecordBufferConverter.
+ * The RecordThread shares a resampling conversion between tracks which start together,
+ * or which join it when they start.
+ *******************************************************************/
+
+static void BM_RecordBufferConverter(benchmark::State& state) {
+    const size_t trackCount = state.range(0);
+    const uint32_t dstSampleRate = state.range(1);
+    const bool shared = state.range(2) != 0;
+
+    std::minstd_rand gen(trackCount);
+    std::uniform_int_distribution<int16_t> dis(INT16_MIN, INT16_MAX);
+    std::vector<int16_t> input(kSrcFrameCount * kSrcChannelCount);
+    for (auto& in : input) {
+        in = dis(gen);
+    }
+
+    const size_t converters = shared ? 1 : trackCount;
+    std::vector<std::unique_ptr<RecordBufferConverter>> converter;
+    std::vector<std::unique_ptr<LoopProvider>> provider;
+    for (size_t i = 0; i < converters; i++) {
+        converter.emplace_back(std::make_unique<RecordBufferConverter>(
+                AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_16_BIT, kSrcSampleRate,
+                AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT, dstSampleRate));
+        if (converter.back()->initCheck() != NO_ERROR) {
+            state.SkipWithError("RecordBufferConverter initCheck failed");
+            return;
+        }
+        provider.emplace_back(std::make_unique<LoopProvider>(input));
+    }
+
+    const size_t dstFrameCount = kSrcFrameCount * dstSampleRate / kSrcSampleRate;
+    std::vector<int16_t> converted(dstFrameCount);
+    std::vector<std::vector<int16_t>> output(trackCount, std::vector<int16_t>(dstFrameCount));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(input.data());
+        if (shared) {
+            converter[0]->convert(converted.data(), provider[0].get(), dstFrameCount);
+            for (auto& out : output) {
+                memcpy(out.data(), converted.data(), dstFrameCount * sizeof(int16_t));
+            }
+        } else {
+            for (size_t i = 0; i < trackCount; i++) {
+                converter[i]->convert(output[i].data(), provider[i].get(), dstFrameCount);
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetComplexityN(trackCount);
+}
+
+static void RecordBufferConverterArgs(benchmark::internal::Benchmark* b) {
+    for (int rate : {48000, 16000}) {
+        for (int shared = 0; shared <= 1; shared++) {
+            for (int tracks = 1; tracks <= 8; tracks++) {
+                b->Args({tracks, rate, shared});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_RecordBufferConverter)->Apply(RecordBufferConverterArgs);
+
+BENCHMARK_MAIN();
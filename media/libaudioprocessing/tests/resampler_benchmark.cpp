@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <malloc.h>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/AudioResampler.h>
+#include "../AudioResamplerDyn.h"
+
+using namespace android;
+
+// Tracks of 44.1 kHz content played on a 48 kHz output.
+constexpr int32_t kSrcSampleRate = 44100;
+constexpr int32_t kDstSampleRate = 48000;
+
+/*******************************************************************
+ * The first parameter is the number of resampled tracks created together.
+ * The second parameter is the resampler quality.
+ * The third parameter is 1 with the filter cache, 0 without.
+ * The items per second counter is the tracks created per second, and the heap counter
+ * is the heap used per track, coefficients included.
+ *******************************************************************/
+
+static void BM_ResamplerCreate(benchmark::State& state) {
+    const size_t trackCount = state.range(0);
+    const auto quality = (AudioResampler::src_quality)state.range(1);
+    const bool cached = state.range(2) != 0;
+
+    auto& cache = AudioResamplerDynFilterCache::getInstance();
+    const size_t maxSize = cache.getMaxSize();
+    cache.setMaxSize(cached ? 1 << 20 : 0);
+
+    std::vector<std::unique_ptr<AudioResampler>> resamplers(trackCount);
+    size_t heapBytes = 0;
+    for (auto _ : state) {
+        const size_t heapBefore = mallinfo().uordblks;
+        for (auto& resampler : resamplers) {
+            resampler.reset(AudioResampler::create(
+                    AUDIO_FORMAT_PCM_FLOAT, 2 /* channels */, kDstSampleRate, quality));
+            resampler->setSampleRate(kSrcSampleRate);
+        }
+        heapBytes = mallinfo().uordblks - heapBefore;
+
+        state.PauseTiming();
+        for (auto& resampler : resamplers) {
+            resampler.reset();
+        }
+        state.ResumeTiming();
+    }
+    cache.setMaxSize(maxSize);
+
+    state.SetItemsProcessed(state.iterations() * trackCount);
+    state.counters["heapKBPerTrack"] = heapBytes / 1024. / trackCount;
+}
+
+static void ResamplerCreateArgs(benchmark::internal::Benchmark* b) {
+    for (int trackCount : {1, 8, 32}) {
+        for (int quality : {AudioResampler::DYN_MED_QUALITY, AudioResampler::DYN_HIGH_QUALITY}) {
+            for (int cached = 0; cached <= 1; cached++) {
+                b->Args({trackCount, quality, cached});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_ResamplerCreate)->Apply(ResamplerCreateArgs);
+
+BENCHMARK_MAIN();
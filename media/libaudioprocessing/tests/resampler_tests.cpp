@@ -601,3 +601,38 @@ TEST(audioflinger_resampler, generalresponse) {
         }
     }
 }
+
+// Resamplers with the same filter design share the coefficients of the filter cache,
+// whatever their channel count. Without the cache each resampler designs its own.
+TEST(audioflinger_resampler, filtercache) {
+    using ResamplerType = android::AudioResamplerDyn<float, float, float>;
+    const auto createResampler = [](int channels, int inputFreq) {
+        std::unique_ptr<ResamplerType> rdyn(
+                static_cast<ResamplerType *>(
+                        android::AudioResampler::create(
+                                AUDIO_FORMAT_PCM_FLOAT,
+                                channels,
+                                48000 /* outputFreq */,
+                                android::AudioResampler::DYN_HIGH_QUALITY)));
+        rdyn->setSampleRate(inputFreq);
+        return rdyn;
+    };
+    auto &cache = android::AudioResamplerDynFilterCache::getInstance();
+    const size_t maxSize = cache.getMaxSize();
+    cache.setMaxSize(1 << 20);
+
+    auto first = createResampler(2, 44100);
+    auto second = createResampler(6, 44100);
+    auto other = createResampler(2, 32000);
+    EXPECT_EQ(first->getFilterCoefs(), second->getFilterCoefs());
+    EXPECT_NE(first->getFilterCoefs(), other->getFilterCoefs());
+
+    cache.setMaxSize(0);
+    EXPECT_EQ(0u, cache.getSize());
+    auto uncached = createResampler(2, 44100);
+    EXPECT_NE(first->getFilterCoefs(), uncached->getFilterCoefs());
+    const size_t size = (first->getPhases() + 1) * first->getHalfLength() * sizeof(float);
+    EXPECT_EQ(0, memcmp(first->getFilterCoefs(), uncached->getFilterCoefs(), size));
+
+    cache.setMaxSize(maxSize);
+}
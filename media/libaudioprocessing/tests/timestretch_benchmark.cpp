@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <memory>
+#include <random>
+#include <string.h>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/AudioResampler.h>
+#include <media/BufferProviders.h>
+
+using namespace android;
+
+// A 44.1 kHz stereo track sped up on a 48 kHz mixer, by 20 ms mixer periods.
+constexpr uint32_t kSrcSampleRate = 44100;
+constexpr uint32_t kDstSampleRate = 48000;
+constexpr size_t kChannelCount = 2;
+constexpr size_t kDstFrameCount = 960;
+
+/* Provides one second of float audio over and over, like an AudioTrack would.
+ */
+class LoopProvider : public AudioBufferProvider {
+public:
+    explicit LoopProvider(const std::vector<float>& data) : mData(data) { }
+
+    status_t getNextBuffer(Buffer* buffer) override {
+        const size_t frames = mData.size() / kChannelCount;
+        buffer->frameCount = std::min(buffer->frameCount, frames - mFront);
+        buffer->raw = const_cast<float*>(mData.data()) + mFront * kChannelCount;
+        return NO_ERROR;
+    }
+
+    void releaseBuffer(Buffer* buffer) override {
+        mFront = (mFront + buffer->frameCount) % (mData.size() / kChannelCount);
+        buffer->raw = nullptr;
+        buffer->frameCount = 0;
+    }
+
+private:
+    const std::vector<float>& mData;
+    size_t mFront = 0;
+};
+
+/*******************************************************************
+ * The first parameter is the speed in percent.
+ * The second parameter is the TimeStretcher quality, which sets the AudioResampler
+ * quality of both paths so that they convert the sample rate with the same filter.
+ * The third parameter is 0 for the Sonic TimestretchBufferProvider followed by
+ * an AudioResampler, as the AudioMixer does by default, or 1 for a WsolaBufferProvider.
+ * The items per second counter is the output frames per second.
+ *******************************************************************/
+
+static void BM_TimeStretch(benchmark::State& state) {
+    const float speed = state.range(0) / 100.f;
+    const auto quality = static_cast<TimeStretcher::quality_t>(state.range(1));
+    const bool wsola = state.range(2) != 0;
+
+    // a few harmonics with noise, for the correlation search to have something to find.
+    std::minstd_rand gen(42);
+    std::uniform_real_distribution<float> dis(-0.05f, 0.05f);
+    std::vector<float> input(kSrcSampleRate * kChannelCount);
+    for (size_t i = 0; i < kSrcSampleRate; i++) {
+        const float t = 2 * M_PI * 180 * i / kSrcSampleRate;
+        input[i * kChannelCount] = 0.4f * sinf(t) + 0.2f * sinf(2 * t) + 0.1f * sinf(5 * t)
+                + dis(gen);
+        input[i * kChannelCount + 1] = input[i * kChannelCount] + dis(gen);
+    }
+    LoopProvider provider(input);
+    AudioPlaybackRate playbackRate = AUDIO_PLAYBACK_RATE_DEFAULT;
+    playbackRate.mSpeed = speed;
+
+    std::vector<float> output(kDstFrameCount * kChannelCount);
+    if (!wsola) {
+        TimestretchBufferProvider timestretch(
+                kChannelCount, AUDIO_FORMAT_PCM_FLOAT, kSrcSampleRate, playbackRate);
+        timestretch.setBufferProvider(&provider);
+        // the TimeStretcher resampler qualities, see TimeStretcher.h
+        static constexpr AudioResampler::src_quality kResamplerQualities[] = {
+            AudioResampler::DYN_LOW_QUALITY,
+            AudioResampler::DYN_MED_QUALITY,
+            AudioResampler::DYN_HIGH_QUALITY,
+        };
+        std::unique_ptr<AudioResampler> resampler(AudioResampler::create(
+                AUDIO_FORMAT_PCM_FLOAT, kChannelCount, kDstSampleRate,
+                kResamplerQualities[quality - TimeStretcher::LOW_QUALITY]));
+        resampler->setSampleRate(kSrcSampleRate);
+        resampler->setVolume(AudioResampler::UNITY_GAIN_FLOAT, AudioResampler::UNITY_GAIN_FLOAT);
+        for (auto _ : state) {
+            // the resampler accumulates into the output
+            memset(output.data(), 0, output.size() * sizeof(float));
+            resampler->resample((int32_t*)output.data(), kDstFrameCount, &timestretch);
+            benchmark::ClobberMemory();
+        }
+    } else {
+        WsolaBufferProvider wsolaProvider(kChannelCount, kSrcSampleRate, kDstSampleRate,
+                playbackRate, quality);
+        wsolaProvider.setBufferProvider(&provider);
+        for (auto _ : state) {
+            for (size_t done = 0; done < kDstFrameCount; ) {
+                AudioBufferProvider::Buffer buffer;
+                buffer.frameCount = kDstFrameCount - done;
+                wsolaProvider.getNextBuffer(&buffer);
+                memcpy(&output[done * kChannelCount], buffer.raw,
+                        buffer.frameCount * kChannelCount * sizeof(float));
+                done += buffer.frameCount;
+                wsolaProvider.releaseBuffer(&buffer);
+            }
+            benchmark::ClobberMemory();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kDstFrameCount);
+}
+
+static void TimeStretchArgs(benchmark::internal::Benchmark* b) {
+    for (int speed : {150, 200, 300}) {
+        for (int quality = TimeStretcher::LOW_QUALITY; quality <= TimeStretcher::HIGH_QUALITY;
+                quality++) {
+            b->Args({speed, quality, 0 /* Sonic */});
+            b->Args({speed, quality, 1 /* WSOLA */});
+        }
+    }
+}
+
+BENCHMARK(BM_TimeStretch)->Apply(TimeStretchArgs);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "timestretcher_tests"
+
+#include <math.h>
+#include <random>
+#include <string.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <media/TimeStretcher.h>
+
+using namespace android;
+
+static constexpr uint32_t kChannelCount = 2;
+static constexpr TimeStretcher::quality_t kQualities[] = {
+    TimeStretcher::LOW_QUALITY,
+    TimeStretcher::MED_QUALITY,
+    TimeStretcher::HIGH_QUALITY,
+};
+
+// Writes the input by mixer sized chunks and returns all the output.
+static std::vector<float> stretch(TimeStretcher *stretcher, const std::vector<float> &in) {
+    constexpr size_t kChunkFrames = 256;
+    const size_t frames = in.size() / kChannelCount;
+    std::vector<float> out;
+    for (size_t i = 0; i < frames; i += kChunkFrames) {
+        stretcher->write(&in[i * kChannelCount], std::min(kChunkFrames, frames - i));
+        out.insert(out.end(), stretcher->outputBuffer(),
+                stretcher->outputBuffer() + stretcher->framesReady() * kChannelCount);
+        stretcher->consume(stretcher->framesReady());
+    }
+    return out;
+}
+
+TEST(timestretcher_tests, unity_is_bit_exact) {
+    std::minstd_rand gen(42);
+    std::uniform_real_distribution<float> dis(-1.f, 1.f);
+    std::vector<float> in(48000 * kChannelCount);
+    // full scale and -100 dBFS noise, then silence
+    for (float amplitude : {1.f, 1e-5f, 0.f}) {
+        for (auto &sample : in) {
+            sample = amplitude == 0.f ? 0.f : amplitude * dis(gen);
+        }
+        for (auto quality : kQualities) {
+            TimeStretcher stretcher(kChannelCount, 48000, 48000, quality);
+            const std::vector<float> out = stretch(&stretcher, in);
+            // the end of the input stays buffered
+            ASSERT_GT(out.size(), in.size() / 2) << "quality " << quality;
+            EXPECT_EQ(0, memcmp(in.data(), out.data(), out.size() * sizeof(float)))
+                    << "quality " << quality << " amplitude " << amplitude;
+        }
+    }
+}
+
+TEST(timestretcher_tests, keeps_pitch_and_converts_rate) {
+    // A 1 kHz tone at 44.1 kHz, stretched and converted to 48 kHz.
+    constexpr uint32_t kInRate = 44100;
+    constexpr uint32_t kOutRate = 48000;
+    constexpr size_t kFrames = kInRate * 4;
+    std::vector<float> in(kFrames * kChannelCount);
+    for (size_t i = 0; i < kFrames; i++) {
+        in[i * kChannelCount] = in[i * kChannelCount + 1] = sinf(2 * M_PI * 1000 * i / kInRate);
+    }
+    for (auto quality : kQualities) {
+        for (float speed : {0.5f, 1.5f, 2.f, 3.f}) {
+            TimeStretcher stretcher(kChannelCount, kInRate, kOutRate, quality);
+            stretcher.setSpeed(speed);
+            const std::vector<float> out = stretch(&stretcher, in);
+            const size_t frames = out.size() / kChannelCount;
+
+            // up to a segment and a search range of input stays buffered
+            const double expected = kFrames / speed * kOutRate / kInRate;
+            EXPECT_NEAR(expected, frames, 0.1 * kOutRate / speed)
+                    << "quality " << quality << " speed " << speed;
+
+            // the polyphase filter rings before the tone starts, skip its first 10 ms
+            const size_t start = kOutRate / 100;
+            size_t crossings = 0;
+            float maxStep = 0.f;
+            for (size_t i = start + 1; i < frames; i++) {
+                const float previous = out[(i - 1) * kChannelCount];
+                const float current = out[i * kChannelCount];
+                crossings += (previous < 0.f) != (current < 0.f);
+                maxStep = std::max(maxStep, fabsf(current - previous));
+                ASSERT_EQ(current, out[i * kChannelCount + 1]);
+            }
+            EXPECT_NEAR(1000., crossings / 2. * kOutRate / (frames - start - 1), 5.)
+                    << "quality " << quality << " speed " << speed;
+            // no discontinuity at the segment boundaries: the largest step of the tone
+            // is 2 pi 1000 / 48000.
+            EXPECT_LT(maxStep, 0.14f) << "quality " << quality << " speed " << speed;
+        }
+    }
+}
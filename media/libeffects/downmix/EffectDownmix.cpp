@@ -20,6 +20,9 @@
 
 #include "EffectDownmix.h"
 #include <math.h>
+#include <string.h>
+
+#include <algorithm>
 
 // Do not submit with DOWNMIX_TEST_CHANNEL_INDEX defined, strictly for testing
 //#define DOWNMIX_TEST_CHANNEL_INDEX 0
@@ -40,6 +43,8 @@ typedef struct {
     downmix_type_t type;
     bool apply_volume_correction;
     uint8_t input_channel_count;
+    // fold coefficients of the input channel mask, left row then right row
+    float fold_matrix[2 * DOWNMIX_MATRIX_STRIDE];
 } downmix_object_t;
 
 typedef struct downmix_module_s {
@@ -77,11 +82,6 @@ static int Downmix_setParameter(
         downmix_object_t *pDownmixer, int32_t param, uint32_t size, void *pValue);
 static int Downmix_getParameter(
         downmix_object_t *pDownmixer, int32_t param, uint32_t *pSize, void *pValue);
-static void Downmix_foldFromQuad(float *pSrc, float *pDst, size_t numFrames, bool accumulate);
-static void Downmix_foldFrom5Point1(float *pSrc, float *pDst, size_t numFrames, bool accumulate);
-static void Downmix_foldFrom7Point1(float *pSrc, float *pDst, size_t numFrames, bool accumulate);
-static bool Downmix_foldGeneric(
-        uint32_t mask, float *pSrc, float *pDst, size_t numFrames, bool accumulate);
 
 // effect_handle_t interface implementation for downmix effect
 const struct effect_interface_s gDownmixInterface = {
@@ -393,12 +393,9 @@ static int32_t Downmix_Process(effect_handle_t self,
             Downmix_foldFrom7Point1(pSrc, pDst, numFrames, accumulate);
             break;
         default:
-            if (!Downmix_foldGeneric(
-                    downmixInputChannelMask, pSrc, pDst, numFrames, accumulate)) {
-                ALOGE("Multichannel configuration %#x is not supported",
-                      downmixInputChannelMask);
-                return -EINVAL;
-            }
+            // the matrix was compiled for the input channel mask by Downmix_Configure()
+            Downmix_foldMatrix(pDownmixer->fold_matrix, pDownmixer->input_channel_count,
+                    pSrc, pDst, numFrames, accumulate);
             break;
         }
         break;
@@ -693,6 +690,11 @@ static int Downmix_Configure(downmix_module_t *pDwmModule, effect_config_t *pCon
         pDownmixer->input_channel_count =
                 audio_channel_count_from_out_mask(pConfig->inputCfg.channels);
     }
+    if (!Downmix_computeFoldMatrix(pConfig->inputCfg.channels, pDownmixer->fold_matrix)) {
+        ALOGE("Downmix_Configure error: no fold matrix for input channel mask(0x%x)",
+                                                    pConfig->inputCfg.channels);
+        return -EINVAL;
+    }
 
     Downmix_Reset(pDownmixer, init);
 
@@ -1125,3 +1127,177 @@ bool Downmix_foldGeneric(
     }
     return true;
 }
+
+/*----------------------------------------------------------------------------
+ * Downmix_computeFoldMatrix()
+ *----------------------------------------------------------------------------
+ * Purpose:
+ * compute the 2 x N transfer matrix that Downmix_foldGeneric() applies to a channel mask.
+ * Channels other than FL FR FC LFE BL BR BC SL SR get a zero coefficient.
+ *
+ * Inputs:
+ *  mask       the channel mask of the multichannel signal
+ *
+ * Outputs:
+ *  pMatrix    2 * DOWNMIX_MATRIX_STRIDE coefficients: the left output row, then the right
+ *               one, each indexed by input channel and zero padded
+ *
+ * Returns: false if multichannel format is not supported
+ *
+ *----------------------------------------------------------------------------
+ */
+bool Downmix_computeFoldMatrix(uint32_t mask, float *pMatrix) {
+    memset(pMatrix, 0, 2 * DOWNMIX_MATRIX_STRIDE * sizeof(float));
+    if (!Downmix_validChannelMask(mask)) {
+        return false;
+    }
+    float *pLeft = pMatrix;
+    float *pRight = pMatrix + DOWNMIX_MATRIX_STRIDE;
+
+    // same gains as Downmix_foldGeneric(), including the final scaling by 0.5
+    constexpr float kSideGain = 0.5f;
+    constexpr float kCenterGain = MINUS_3_DB_IN_FLOAT * 0.5f;
+    int index = 0;
+    for (unsigned tmp = mask; tmp != 0; ++index) {
+        const unsigned lowestBit = tmp & -(signed)tmp;
+        switch (lowestBit) {
+        case AUDIO_CHANNEL_OUT_FRONT_LEFT:
+        case AUDIO_CHANNEL_OUT_BACK_LEFT:
+        case AUDIO_CHANNEL_OUT_SIDE_LEFT:
+            pLeft[index] = kSideGain;
+            break;
+        case AUDIO_CHANNEL_OUT_FRONT_RIGHT:
+        case AUDIO_CHANNEL_OUT_BACK_RIGHT:
+        case AUDIO_CHANNEL_OUT_SIDE_RIGHT:
+            pRight[index] = kSideGain;
+            break;
+        case AUDIO_CHANNEL_OUT_FRONT_CENTER:
+        case AUDIO_CHANNEL_OUT_LOW_FREQUENCY:
+        case AUDIO_CHANNEL_OUT_BACK_CENTER:
+            pLeft[index] = kCenterGain;
+            pRight[index] = kCenterGain;
+            break;
+        }
+        tmp ^= lowestBit;
+    }
+    return true;
+}
+
+typedef float downmix_float4_t __attribute__((vector_size(4 * sizeof(float))));
+typedef int32_t downmix_int4_t __attribute__((vector_size(4 * sizeof(int32_t))));
+
+// Folds the first 4 * NumVectors channels of each frame, a vector of 4 channels at a time.
+// Further channels must have zero coefficients. Lanes past the end of the frame are masked,
+// and frames near the end of pSrc that would be read past it are first copied to a zero padded
+// frame.
+template <int NumVectors>
+static void Downmix_foldMatrixKernel(const float *pMatrix, uint32_t channelCount,
+        const float *pSrc, float *pDst, size_t numFrames, bool accumulate) {
+    constexpr size_t kPaddedChannels = 4 * NumVectors;
+    downmix_float4_t left[NumVectors];
+    downmix_float4_t right[NumVectors];
+    memcpy(left, pMatrix, sizeof(left));
+    memcpy(right, pMatrix + DOWNMIX_MATRIX_STRIDE, sizeof(right));
+
+    // lanes of the last vector that belong to the frame
+    downmix_int4_t lastMask;
+    for (size_t i = 0; i < 4; i++) {
+        lastMask[i] = (kPaddedChannels - 4 + i < channelCount) ? -1 : 0;
+    }
+
+    // frames that can be read whole without going past the end of pSrc
+    const size_t readAhead = kPaddedChannels > channelCount ? kPaddedChannels - channelCount : 0;
+    const size_t directFrames = numFrames * channelCount >= readAhead
+            ? numFrames - (readAhead + channelCount - 1) / channelCount : 0;
+
+    float paddedFrame[kPaddedChannels];
+    for (size_t n = 0; n < numFrames; n++) {
+        const float *pFrame = pSrc;
+        if (n >= directFrames) {
+            memset(paddedFrame, 0, sizeof(paddedFrame));
+            memcpy(paddedFrame, pSrc, std::min<size_t>(channelCount, kPaddedChannels)
+                    * sizeof(float));
+            pFrame = paddedFrame;
+        }
+        downmix_float4_t accLeft = {};
+        downmix_float4_t accRight = {};
+        for (int v = 0; v < NumVectors; v++) {
+            downmix_float4_t x;
+            memcpy(&x, pFrame + 4 * v, sizeof(x));
+            if (v == NumVectors - 1) {
+                // clear the lanes of the next frame, which may hold Inf or NaN
+                x = (downmix_float4_t)((downmix_int4_t)x & lastMask);
+            }
+            accLeft += x * left[v];
+            accRight += x * right[v];
+        }
+        float ch[2];
+        ch[0] = (accLeft[0] + accLeft[1]) + (accLeft[2] + accLeft[3]);
+        ch[1] = (accRight[0] + accRight[1]) + (accRight[2] + accRight[3]);
+        if (accumulate) {
+            ch[0] += pDst[0];
+            ch[1] += pDst[1];
+        }
+        pDst[0] = clamp_float(ch[0]);
+        pDst[1] = clamp_float(ch[1]);
+        pSrc += channelCount;
+        pDst += 2;
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * Downmix_foldMatrix()
+ *----------------------------------------------------------------------------
+ * Purpose:
+ * downmix to stereo a multichannel signal with a matrix from Downmix_computeFoldMatrix().
+ *
+ * Inputs:
+ *  pMatrix      the fold matrix of the channel mask of pSrc
+ *  channelCount the number of channels of pSrc, up to FCC_24
+ *  pSrc         multichannel audio buffer to downmix
+ *  numFrames    the number of multichannel frames to downmix
+ *  accumulate   whether to mix (when true) the result of the downmix with the contents of pDst,
+ *                 or overwrite pDst (when false)
+ *
+ * Outputs:
+ *  pDst         downmixed stereo audio samples
+ *
+ *----------------------------------------------------------------------------
+ */
+void Downmix_foldMatrix(const float *pMatrix, uint32_t channelCount,
+        const float *pSrc, float *pDst, size_t numFrames, bool accumulate) {
+    // only the channels up to the last one with a non zero coefficient are read,
+    // eg. the first 12 channels of 22.2
+    uint32_t usedChannels = 0;
+    for (uint32_t c = 0; c < channelCount && c < DOWNMIX_MATRIX_STRIDE; c++) {
+        if (pMatrix[c] != 0.f || pMatrix[DOWNMIX_MATRIX_STRIDE + c] != 0.f) {
+            usedChannels = c + 1;
+        }
+    }
+    if (usedChannels == 0) {
+        usedChannels = 1; // silent input, still clamp or overwrite the output
+    }
+    switch ((usedChannels + 3) / 4) {
+    case 1:
+        Downmix_foldMatrixKernel<1>(pMatrix, channelCount, pSrc, pDst, numFrames, accumulate);
+        break;
+    case 2:
+        Downmix_foldMatrixKernel<2>(pMatrix, channelCount, pSrc, pDst, numFrames, accumulate);
+        break;
+    case 3:
+        Downmix_foldMatrixKernel<3>(pMatrix, channelCount, pSrc, pDst, numFrames, accumulate);
+        break;
+    case 4:
+        Downmix_foldMatrixKernel<4>(pMatrix, channelCount, pSrc, pDst, numFrames, accumulate);
+        break;
+    case 5:
+        Downmix_foldMatrixKernel<5>(pMatrix, channelCount, pSrc, pDst, numFrames, accumulate);
+        break;
+    case 6:
+        Downmix_foldMatrixKernel<6>(pMatrix, channelCount, pSrc, pDst, numFrames, accumulate);
+        break;
+    default:
+        ALOGE("Downmix_foldMatrix unsupported channel count %u", channelCount);
+        break;
+    }
+}
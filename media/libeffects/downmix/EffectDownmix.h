@@ -23,4 +23,18 @@
 // Use the following declaration to obtain the Downmix library information.
 // extern audio_effect_library_t AUDIO_EFFECT_LIBRARY_INFO_SYM;
 
+// Stride of each output channel row of a fold matrix, in floats.
+// Rows are zero padded up to a multiple of 4 input channels, up to FCC_24 channels for 22.2.
+#define DOWNMIX_MATRIX_STRIDE FCC_24
+
+// Fold downmixers, exposed for tests and benchmarks. The effect selects between them.
+void Downmix_foldFromQuad(float *pSrc, float *pDst, size_t numFrames, bool accumulate);
+void Downmix_foldFrom5Point1(float *pSrc, float *pDst, size_t numFrames, bool accumulate);
+void Downmix_foldFrom7Point1(float *pSrc, float *pDst, size_t numFrames, bool accumulate);
+bool Downmix_foldGeneric(
+        uint32_t mask, float *pSrc, float *pDst, size_t numFrames, bool accumulate);
+bool Downmix_computeFoldMatrix(uint32_t mask, float *pMatrix);
+void Downmix_foldMatrix(const float *pMatrix, uint32_t channelCount,
+        const float *pSrc, float *pDst, size_t numFrames, bool accumulate);
+
 #endif /*ANDROID_EFFECTDOWNMIX_H_*/
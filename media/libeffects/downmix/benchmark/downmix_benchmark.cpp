@@ -195,6 +195,68 @@ static void BM_Downmix(benchmark::State& state) {
     }
 }
 
+// Runs the fold downmixers directly, without the effect interface.
+// Legacy is the hand written function of the mask, or Downmix_foldGeneric() for the other masks.
+// Matrix is Downmix_foldMatrix() with the matrix of the mask.
+static void BM_DownmixFold(benchmark::State& state, bool useMatrix) {
+    const audio_channel_mask_t channelMask = kChannelPositionMasks[state.range(0)];
+    const size_t channelCount = audio_channel_count_from_out_mask(channelMask);
+
+    // Initialize input buffer with deterministic pseudo-random values
+    std::minstd_rand gen(channelMask);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<float> input(kFrameCount * channelCount);
+    std::vector<float> output(kFrameCount * 2);
+    for (auto& in : input) {
+        in = dis(gen);
+    }
+    float matrix[2 * DOWNMIX_MATRIX_STRIDE];
+    if (!Downmix_computeFoldMatrix(channelMask, matrix)) {
+        state.SkipWithError("unsupported channel mask");
+        return;
+    }
+
+    // Run the test
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(input.data());
+        benchmark::DoNotOptimize(output.data());
+
+        if (useMatrix) {
+            Downmix_foldMatrix(matrix, channelCount, input.data(), output.data(), kFrameCount,
+                    false /* accumulate */);
+        } else {
+            switch (channelMask) {
+            case AUDIO_CHANNEL_OUT_QUAD_BACK:
+            case AUDIO_CHANNEL_OUT_QUAD_SIDE:
+                Downmix_foldFromQuad(input.data(), output.data(), kFrameCount, false);
+                break;
+            case AUDIO_CHANNEL_OUT_5POINT1_BACK:
+            case AUDIO_CHANNEL_OUT_5POINT1_SIDE:
+                Downmix_foldFrom5Point1(input.data(), output.data(), kFrameCount, false);
+                break;
+            case AUDIO_CHANNEL_OUT_7POINT1:
+                Downmix_foldFrom7Point1(input.data(), output.data(), kFrameCount, false);
+                break;
+            default:
+                Downmix_foldGeneric(channelMask, input.data(), output.data(), kFrameCount, false);
+                break;
+            }
+        }
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetComplexityN(state.range(0));
+}
+
+static void BM_DownmixLegacy(benchmark::State& state) {
+    BM_DownmixFold(state, false /* useMatrix */);
+}
+
+static void BM_DownmixMatrix(benchmark::State& state) {
+    BM_DownmixFold(state, true /* useMatrix */);
+}
+
 static void DownmixArgs(benchmark::internal::Benchmark* b) {
     for (int i = 0; i < (int)std::size(kChannelPositionMasks); i++) {
         b->Args({i});
@@ -202,5 +264,7 @@ static void DownmixArgs(benchmark::internal::Benchmark* b) {
 }
 
 BENCHMARK(BM_Downmix)->Apply(DownmixArgs);
+BENCHMARK(BM_DownmixLegacy)->Apply(DownmixArgs);
+BENCHMARK(BM_DownmixMatrix)->Apply(DownmixArgs);
 
 BENCHMARK_MAIN();
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <random>
 #include <vector>
 
 #include "EffectDownmix.h"
@@ -246,6 +247,39 @@ INSTANTIATE_TEST_SUITE_P(
                 ::testing::Range(0, (int)std::size(kChannelPositionMasks))
                 ));
 
+// The fold matrix must give the same result as the generic downmixer for every mask,
+// including the frames at the end of the buffer that are not a multiple of 4 channels.
+TEST(DownmixMatrixTest, matchesGeneric) {
+    std::minstd_rand gen(42);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    for (const audio_channel_mask_t channelMask : kChannelPositionMasks) {
+        const size_t channelCount = audio_channel_count_from_out_mask(channelMask);
+        float matrix[2 * DOWNMIX_MATRIX_STRIDE];
+        ASSERT_TRUE(Downmix_computeFoldMatrix(channelMask, matrix));
+        for (size_t frames : {1, 3, 100}) {
+            for (bool accumulate : {false, true}) {
+                std::vector<float> input(frames * channelCount);
+                std::vector<float> expected(frames * 2);
+                for (auto& in : input) {
+                    in = dis(gen);
+                }
+                for (auto& out : expected) {
+                    out = dis(gen) * 0.5f;
+                }
+                std::vector<float> output = expected;
+                ASSERT_TRUE(Downmix_foldGeneric(channelMask, input.data(), expected.data(),
+                        frames, accumulate));
+                Downmix_foldMatrix(matrix, channelCount, input.data(), output.data(),
+                        frames, accumulate);
+                for (size_t i = 0; i < expected.size(); ++i) {
+                    EXPECT_NEAR(expected[i], output[i], 1e-6f)
+                            << "mask " << std::hex << channelMask << " index " << std::dec << i;
+                }
+            }
+        }
+    }
+}
+
 int main(int argc, /* const */ char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     int status = RUN_ALL_TESTS();
@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <log/log.h>
+#include <audio_effects/effect_dynamicsprocessing.h>
+#include <benchmark/benchmark.h>
+#include <hardware/audio_effect.h>
+#include <system/audio.h>
+
+extern audio_effect_library_t AUDIO_EFFECT_LIBRARY_INFO_SYM;
+
+// AOSP Dynamics Processing
+constexpr effect_uuid_t kEffectUuid = {
+        0xe0e6539b, 0x1781, 0x7261, 0x676f, {0x6d, 0x75, 0x73, 0x69, 0x63, 0x40}};
+
+constexpr size_t kFrameCount = 2048;
+
+constexpr audio_channel_mask_t kChMasks[] = {
+        AUDIO_CHANNEL_INDEX_MASK_1, AUDIO_CHANNEL_INDEX_MASK_2, AUDIO_CHANNEL_INDEX_MASK_3,
+        AUDIO_CHANNEL_INDEX_MASK_4, AUDIO_CHANNEL_INDEX_MASK_5, AUDIO_CHANNEL_INDEX_MASK_6,
+        AUDIO_CHANNEL_INDEX_MASK_7, AUDIO_CHANNEL_INDEX_MASK_8,
+};
+
+constexpr size_t kNumChMasks = std::size(kChMasks);
+
+// Preferred frame durations in ms. They select the FFT block size, which is the duration
+// rounded up to a power of 2 frames: 64, 256, 512 and 1024 frames at 48 kHz.
+constexpr float kFrameDurationsMs[] = {1.0f, 5.0f, 10.0f, 20.0f};
+
+constexpr size_t kNumFrameDurations = std::size(kFrameDurationsMs);
+constexpr int kSampleRate = 48000;
+
+constexpr int32_t kEqBandCount = 6;
+constexpr float kEqCutoffsHz[kEqBandCount] = {100, 300, 1000, 3000, 10000, 20000};
+constexpr int32_t kMbcBandCount = 3;
+constexpr float kMbcCutoffsHz[kMbcBandCount] = {250, 4000, 20000};
+
+using value_t = union {
+    int32_t i;
+    float f;
+};
+
+/*******************************************************************
+ * The first parameter indicates the number of channels.
+ * The second parameter indicates the preferred frame duration, as an index
+ * into kFrameDurationsMs.
+ * The third parameter indicates the stages in use.
+ * 0: Limiter, 1: Pre EQ, MBC, Post EQ and Limiter
+ * The ns_per_frame counter is the wall time of the process calls divided by the frames.
+ *******************************************************************/
+
+static int setParam(effect_handle_t effectHandle, const std::vector<int32_t>& params,
+                    const std::vector<value_t>& values) {
+    const uint32_t psize = params.size() * sizeof(int32_t);
+    const uint32_t vsize = values.size() * sizeof(value_t);
+    std::vector<uint8_t> cmd(sizeof(effect_param_t) + psize + vsize);
+    effect_param_t* p = (effect_param_t*)cmd.data();
+    p->psize = psize;
+    p->vsize = vsize;
+    memcpy(p->data, params.data(), psize);
+    memcpy(p->data + psize, values.data(), vsize);
+
+    int reply = 0;
+    uint32_t replySize = sizeof(reply);
+    if (int status = (*effectHandle)
+                             ->command(effectHandle, EFFECT_CMD_SET_PARAM, cmd.size(), cmd.data(),
+                                       &replySize, &reply);
+        status != 0) {
+        return status;
+    }
+    return reply;
+}
+
+static int configureStages(effect_handle_t effectHandle, size_t channelCount, float frameDurationMs,
+                           bool allStages) {
+    const int32_t inUse = allStages ? 1 : 0;
+    value_t architecture[] = {
+            {.i = VARIANT_FAVOR_FREQUENCY_RESOLUTION}, {.f = frameDurationMs},
+            {.i = inUse}, {.i = kEqBandCount},
+            {.i = inUse}, {.i = kMbcBandCount},
+            {.i = inUse}, {.i = kEqBandCount},
+            {.i = 1}};
+    if (int status = setParam(effectHandle, {DP_PARAM_ENGINE_ARCHITECTURE},
+                              {std::begin(architecture), std::end(architecture)});
+        status != 0) {
+        return status;
+    }
+
+    int status = 0;
+    for (int32_t ch = 0; ch < (int32_t)channelCount && status == 0; ch++) {
+        // attack, release, ratio, threshold, postGain
+        status = setParam(effectHandle, {DP_PARAM_LIMITER, ch},
+                          {{.i = 1}, {.i = 1}, {.i = 0}, {.f = 1.0f}, {.f = 60.0f}, {.f = 10.0f},
+                           {.f = -10.0f}, {.f = 0.0f}});
+        if (!allStages) {
+            continue;
+        }
+        for (int32_t eq : {DP_PARAM_PRE_EQ, DP_PARAM_POST_EQ}) {
+            status |= setParam(effectHandle, {eq, ch}, {{.i = 1}, {.i = 1}, {.i = kEqBandCount}});
+            const int32_t eqBand = eq == DP_PARAM_PRE_EQ ? DP_PARAM_PRE_EQ_BAND
+                                                         : DP_PARAM_POST_EQ_BAND;
+            for (int32_t b = 0; b < kEqBandCount; b++) {
+                status |= setParam(effectHandle, {eqBand, ch, b},
+                                   {{.i = 1}, {.f = kEqCutoffsHz[b]}, {.f = b - 3.0f}});
+            }
+        }
+        status |= setParam(effectHandle, {DP_PARAM_MBC, ch},
+                           {{.i = 1}, {.i = 1}, {.i = kMbcBandCount}});
+        for (int32_t b = 0; b < kMbcBandCount; b++) {
+            // attack, release, ratio, threshold, knee, noise gate, expander, preGain, postGain
+            status |= setParam(effectHandle, {DP_PARAM_MBC_BAND, ch, b},
+                               {{.i = 1}, {.f = kMbcCutoffsHz[b]}, {.f = 3.0f}, {.f = 80.0f},
+                                {.f = 4.0f}, {.f = -30.0f}, {.f = 6.0f}, {.f = -70.0f},
+                                {.f = 2.0f}, {.f = 0.0f}, {.f = 0.0f}});
+        }
+    }
+    return status;
+}
+
+static effect_handle_t createEffect(audio_channel_mask_t chMask, float frameDurationMs,
+                                    bool allStages) {
+    effect_handle_t effectHandle = nullptr;
+    if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.create_effect(&kEffectUuid, 1, 1,
+                                                                 &effectHandle);
+        status != 0) {
+        ALOGE("create_effect returned an error = %d\n", status);
+        return nullptr;
+    }
+
+    effect_config_t config{};
+    config.inputCfg.samplingRate = config.outputCfg.samplingRate = kSampleRate;
+    config.inputCfg.channels = config.outputCfg.channels = chMask;
+    config.inputCfg.format = config.outputCfg.format = AUDIO_FORMAT_PCM_FLOAT;
+
+    int reply = 0;
+    uint32_t replySize = sizeof(reply);
+    if (int status = (*effectHandle)
+                             ->command(effectHandle, EFFECT_CMD_SET_CONFIG, sizeof(effect_config_t),
+                                       &config, &replySize, &reply);
+        status != 0) {
+        ALOGE("command returned an error = %d\n", status);
+        AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+        return nullptr;
+    }
+
+    if (int status = configureStages(effectHandle, audio_channel_count_from_out_mask(chMask),
+                                     frameDurationMs, allStages);
+        status != 0) {
+        ALOGE("setting the parameters returned an error = %d\n", status);
+        AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+        return nullptr;
+    }
+
+    if (int status =
+                (*effectHandle)
+                        ->command(effectHandle, EFFECT_CMD_ENABLE, 0, nullptr, &replySize, &reply);
+        status != 0) {
+        ALOGE("Command enable call returned error %d\n", reply);
+        AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+        return nullptr;
+    }
+    return effectHandle;
+}
+
+static void BM_DYNAMICS_PROCESSING(benchmark::State& state) {
+    const audio_channel_mask_t chMask = kChMasks[state.range(0) - 1];
+    const size_t channelCount = audio_channel_count_from_out_mask(chMask);
+    const float frameDurationMs = kFrameDurationsMs[state.range(1)];
+    const bool allStages = state.range(2) != 0;
+
+    // Initialize input buffer with deterministic pseudo-random values
+    std::minstd_rand gen(chMask);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<float> input(kFrameCount * channelCount);
+    for (auto& in : input) {
+        in = dis(gen);
+    }
+
+    effect_handle_t effectHandle = createEffect(chMask, frameDurationMs, allStages);
+    if (effectHandle == nullptr) {
+        return;
+    }
+
+    // Run the test
+    std::vector<float> output(kFrameCount * channelCount);
+    std::chrono::nanoseconds processTime{0};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(input.data());
+        benchmark::DoNotOptimize(output.data());
+
+        const auto start = std::chrono::steady_clock::now();
+        audio_buffer_t inBuffer = {.frameCount = kFrameCount, .f32 = input.data()};
+        audio_buffer_t outBuffer = {.frameCount = kFrameCount, .f32 = output.data()};
+        (*effectHandle)->process(effectHandle, &inBuffer, &outBuffer);
+        processTime += std::chrono::steady_clock::now() - start;
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetComplexityN(state.range(0));
+    state.counters["ns_per_frame"] =
+            (double)processTime.count() / ((double)state.iterations() * kFrameCount);
+
+    if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle); status != 0) {
+        ALOGE("release_effect returned an error = %d\n", status);
+    }
+}
+
+static void DynamicsProcessingArgs(benchmark::internal::Benchmark* b) {
+    for (int i = FCC_1; i <= (int)kNumChMasks; i++) {
+        for (int j = 0; j < (int)kNumFrameDurations; j++) {
+            for (int k = 0; k <= 1; k++) {
+                b->Args({i, j, k});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_DYNAMICS_PROCESSING)->Apply(DynamicsProcessingArgs);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DPBATCHFFT_H_
+#define DPBATCHFFT_H_
+
+#include <stddef.h>
+#include <vector>
+
+#include <effects/RadixTwoFft.h>
+
+namespace dp_fx {
+
+// Four floats processed together, one per channel.
+typedef float FloatLanes __attribute__((vector_size(4 * sizeof(float))));
+static constexpr size_t kBatchLanes = 4;
+
+using FloatLanesVec = std::vector<FloatLanes>;
+
+// Real FFT of up to kBatchLanes signals at once.
+// Sample n of all signals is stored in one FloatLanes, and so is bin k of all spectra, so
+// every butterfly works on all the signals with vector instructions and no shuffles.
+using DPBatchFft = android::effects::RealFft<FloatLanes>;
+
+} //namespace dp_fx
+
+#endif  // DPBATCHFFT_H_
@@ -29,6 +29,7 @@ using Eigen::MatrixXd;
 #define MIN_BLOCKSIZE 8
 
 #define CIRCULAR_BUFFER_UPSAMPLE 4  //4 times buffer size
+#define CHUNK_BLOCKS 2 //max blocks written to the circular buffers per pass
 
 static constexpr float MIN_ENVELOPE = 1e-6f; //-120 dB
 static constexpr float EPSILON = 0.0000001f;
@@ -88,6 +89,16 @@ void ChannelBuffer::initBuffers(unsigned int blockSize, unsigned int overlapSize
     mLimiterParams.linkGroup = -1; //no group.
 }
 
+void ChannelBatch::initBuffers(unsigned int blockSize, unsigned int halfFftSize) {
+    const FloatLanes zero = {};
+    const FloatLanes one = zero + 1.0f;
+    windowed.assign(blockSize, zero);
+    re.assign(halfFftSize, zero);
+    im.assign(halfFftSize, zero);
+    gain.assign(halfFftSize, one);
+    power.assign(halfFftSize, zero);
+}
+
 void ChannelBuffer::computeBinStartStop(BandParams &bp, size_t binStart) {
 
     bp.binStart = binStart;
@@ -159,6 +170,11 @@ void DPFrequency::configure(size_t blockSize, size_t overlapSize,
         mChannelBuffers[ch].initBuffers(mBlockSize, mOverlapSize, mHalfFFTSize,
                 mSamplingRate, *this);
     }
+    mChannelBatches.resize((channelcount + kBatchLanes - 1) / kBatchLanes);
+    for (auto &batch : mChannelBatches) {
+        batch.initBuffers(mBlockSize, mHalfFFTSize);
+    }
+    mBatchFft.configure(mBlockSize);
 
     //effective number of frames processed per second
     mBlocksPerSecond = (float)mSamplingRate / (mBlockSize - mOverlapSize);
@@ -385,38 +401,47 @@ size_t DPFrequency::processSamples(const float *in, float *out, size_t samples)
            updateParameters(mChannelBuffers[ch], ch);
        }
 
-       //**separate into channels
-       for (size_t k = 0; k < samples; k += channelCount) {
-           for (int ch = 0; ch < channelCount; ch++) {
-               mChannelBuffers[ch].cBInput.write(*pIn++);
+       //**process in chunks the circular buffers can hold. Small blocks have small buffers,
+       //  which would overflow with the frame counts of a typical mixer period.
+       const size_t maxChunkSamples = CHUNK_BLOCKS * mBlockSize * channelCount;
+       size_t remaining = samples;
+       while (remaining > 0) {
+           const size_t chunkSamples = std::min(remaining, maxChunkSamples);
+
+           //**separate into channels
+           for (size_t k = 0; k < chunkSamples; k += channelCount) {
+               for (int ch = 0; ch < channelCount; ch++) {
+                   mChannelBuffers[ch].cBInput.write(*pIn++);
+               }
            }
-       }
 
-       //**process all channelBuffers
-       processChannelBuffers(mChannelBuffers);
+           //**process all channelBuffers
+           processChannelBuffers(mChannelBuffers);
 
-       //** estimate how much data is available in ALL channels
-       size_t available = mChannelBuffers[0].cBOutput.availableToRead();
-       for (int ch = 1; ch < channelCount; ch++) {
-           available = std::min(available, mChannelBuffers[ch].cBOutput.availableToRead());
-       }
+           //** estimate how much data is available in ALL channels
+           size_t available = mChannelBuffers[0].cBOutput.availableToRead();
+           for (int ch = 1; ch < channelCount; ch++) {
+               available = std::min(available, mChannelBuffers[ch].cBOutput.availableToRead());
+           }
 
-       //** make sure to output just what the buffer can handle
-       if (available > samples/channelCount) {
-           available = samples/channelCount;
-       }
+           //** make sure to output just what the buffer can handle
+           if (available > chunkSamples/channelCount) {
+               available = chunkSamples/channelCount;
+           }
 
-       //**Prepend zeroes if necessary
-       size_t fill = samples - (channelCount * available);
-       for (size_t k = 0; k < fill; k++) {
-           *pOut++ = 0;
-       }
+           //**Prepend zeroes if necessary
+           size_t fill = chunkSamples - (channelCount * available);
+           for (size_t k = 0; k < fill; k++) {
+               *pOut++ = 0;
+           }
 
-       //**interleave channels
-       for (size_t k = 0; k < available; k++) {
-           for (int ch = 0; ch < channelCount; ch++) {
-               *pOut++ = mChannelBuffers[ch].cBOutput.read();
+           //**interleave channels
+           for (size_t k = 0; k < available; k++) {
+               for (int ch = 0; ch < channelCount; ch++) {
+                   *pOut++ = mChannelBuffers[ch].cBOutput.read();
+               }
            }
+           remaining -= chunkSamples;
        }
 
        return samples;
@@ -433,7 +458,6 @@ size_t DPFrequency::processChannelBuffers(CBufferVector &channelBuffers) {
     }
 
     while (available >= processFrames) {
-        //First pass
         for (int ch = 0; ch < channelCount; ch++) {
             ChannelBuffer * pCb = &channelBuffers[ch];
             //move tail of previous
@@ -445,20 +469,26 @@ size_t DPFrequency::processChannelBuffers(CBufferVector &channelBuffers) {
             for (unsigned int k = 0; k < processFrames; k++) {
                 pCb->input[mOverlapSize + k] = pCb->cBInput.read();
             }
+        }
+
+        //First pass, kBatchLanes channels at a time
+        for (size_t b = 0; b < mChannelBatches.size(); b++) {
             //first stages: fft, preEq, mbc, postEq and start of Limiter
-            processedSamples += processFirstStages(*pCb);
+            processedSamples += processFirstStages(mChannelBatches[b], b * kBatchLanes);
         }
 
         //**compute linked limiters and update levels if needed
         processLinkedLimiters(channelBuffers);
 
         //final pass.
+        for (size_t b = 0; b < mChannelBatches.size(); b++) {
+            //linked limiter and ifft
+            processLastStages(mChannelBatches[b], b * kBatchLanes);
+        }
+
         for (int ch = 0; ch < channelCount; ch++) {
             ChannelBuffer * pCb = &channelBuffers[ch];
 
-            //linked limiter and ifft
-            processLastStages(*pCb);
-
             //mix tail (and capture new tail
             for (unsigned int k = 0; k < mOverlapSize; k++) {
                 pCb->output[k] += pCb->outTail[k];
@@ -474,154 +504,197 @@ size_t DPFrequency::processChannelBuffers(CBufferVector &channelBuffers) {
     }
     return processedSamples;
 }
-size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
 
-    //##apply window
-    Eigen::Map<Eigen::VectorXf> eWindow(&mVWindow[0], mVWindow.size());
-    Eigen::Map<Eigen::VectorXf> eInput(&cb.input[0], cb.input.size());
-
-    Eigen::VectorXf eWin = eInput.cwiseProduct(eWindow); //apply window
-
-    //##fft
-    //Note: we are using eigen with the default scaling, which ensures that
-    //  IFFT( FFT(x) ) = x.
-    // TODO: optimize by using the noscale option, and compensate with dB scale offsets
-    mFftServer.fwd(cb.complexTemp, eWin);
+size_t DPFrequency::processFirstStages(ChannelBatch &batch, size_t firstChannel) {
+    const size_t lanes = std::min(kBatchLanes, mChannelBuffers.size() - firstChannel);
+    const size_t nyquistBin = mHalfFFTSize - 1;
 
-    size_t cSize = cb.complexTemp.size();
-    size_t maxBin = std::min(cSize/2, mHalfFFTSize);
-
-    //== EqPre (always runs)
-    for (size_t k = 0; k < maxBin; k++) {
-        cb.complexTemp[k] *= cb.mPreEqFactorVector[k];
+    //##apply window. Unused lanes stay at zero.
+    for (size_t lane = 0; lane < lanes; lane++) {
+        const ChannelBuffer &cb = mChannelBuffers[firstChannel + lane];
+        for (size_t n = 0; n < mBlockSize; n++) {
+            batch.windowed[n][lane] = cb.input[n] * mVWindow[n];
+        }
     }
 
-    //== MBC
-    if (cb.mMbcInUse && cb.mMbcEnabled) {
-        for (size_t band = 0; band < cb.mMbcBands.size(); band++) {
-            ChannelBuffer::MbcBandParams *pMbcBandParams = &cb.mMbcBands[band];
-            float fEnergySum = 0;
+    //##fft. Unscaled, the inverse is scaled so that IFFT( FFT(x) ) = x.
+    mBatchFft.forward(batch.windowed.data(), batch.re.data(), batch.im.data());
 
-            //apply pre gain.
-            float preGainFactor = dBtoLinear(pMbcBandParams->gainPreDb);
-            float preGainSquared = preGainFactor * preGainFactor;
+    //== EqPre (always runs). The Nyquist bin is not equalized.
+    for (size_t lane = 0; lane < lanes; lane++) {
+        const ChannelBuffer &cb = mChannelBuffers[firstChannel + lane];
+        for (size_t k = 0; k < nyquistBin; k++) {
+            batch.gain[k][lane] = cb.mPreEqFactorVector[k];
+        }
+        batch.gain[nyquistBin][lane] = 1.0f;
+    }
 
-            for (size_t k = pMbcBandParams->binStart; k <= pMbcBandParams->binStop; k++) {
-                fEnergySum += std::norm(cb.complexTemp[k]) * preGainSquared; //mag squared
+    //== MBC. Band energies are taken after preEq, and the band factors are folded into the
+    //  gain of each bin, which is applied to the spectrum once in processLastStages().
+    bool mbcActive = false;
+    for (size_t lane = 0; lane < lanes; lane++) {
+        const ChannelBuffer &cb = mChannelBuffers[firstChannel + lane];
+        mbcActive |= cb.mMbcInUse && cb.mMbcEnabled;
+    }
+    if (mbcActive) {
+        for (size_t k = 0; k < mHalfFFTSize; k++) {
+            const FloatLanes g = batch.gain[k];
+            batch.power[k] = (batch.re[k] * batch.re[k] + batch.im[k] * batch.im[k]) * g * g;
+        }
+        for (size_t lane = 0; lane < lanes; lane++) {
+            ChannelBuffer &cb = mChannelBuffers[firstChannel + lane];
+            if (!cb.mMbcInUse || !cb.mMbcEnabled) {
+                continue;
             }
+            for (size_t band = 0; band < cb.mMbcBands.size(); band++) {
+                ChannelBuffer::MbcBandParams *pMbcBandParams = &cb.mMbcBands[band];
+                if (pMbcBandParams->binStart > nyquistBin) {
+                    //band above the Nyquist frequency, it only tracks silence.
+                    computeMbcBandFactor(*pMbcBandParams, 0);
+                    continue;
+                }
+                const size_t binStop = std::min(pMbcBandParams->binStop, nyquistBin);
+                float fEnergySum = 0;
+                for (size_t k = pMbcBandParams->binStart; k <= binStop; k++) {
+                    fEnergySum += batch.power[k][lane]; //mag squared
+                }
 
-            //Eigen FFT is full spectrum, even if the source was real data.
-            // Each half spectrum has half the energy. This is taken into account with the * 2
-            // factor in the energy computations.
-            // energy = sqrt(sum_components_squared) number_points
-            // in here, the fEnergySum is duplicated to account for the second half spectrum,
-            // and the windowRms is used to normalize by the expected energy reduction
-            // caused by the window used (expected for steady state signals)
-            fEnergySum = sqrt(fEnergySum * 2) / (mBlockSize * mWindowRms);
-
-            // updates computed per frame advance.
-            float fTheta = 0.0;
-            float fFAttSec = pMbcBandParams->attackTimeMs / 1000; //in seconds
-            float fFRelSec = pMbcBandParams->releaseTimeMs / 1000; //in seconds
-
-            if (fEnergySum > pMbcBandParams->previousEnvelope) {
-                fTheta = exp(-1.0 / (fFAttSec * mBlocksPerSecond));
-            } else {
-                fTheta = exp(-1.0 / (fFRelSec * mBlocksPerSecond));
-            }
+                const float newFactor = computeMbcBandFactor(*pMbcBandParams, fEnergySum);
 
-            float fEnv = (1.0 - fTheta) * fEnergySum + fTheta * pMbcBandParams->previousEnvelope;
-            //preserve for next iteration
-            pMbcBandParams->previousEnvelope = fEnv;
+                //apply to this band
+                for (size_t k = pMbcBandParams->binStart; k <= binStop; k++) {
+                    batch.gain[k][lane] *= newFactor;
+                }
+            } //end per band process
+        }
+    } //end MBC
 
-            if (fEnv < MIN_ENVELOPE) {
-                fEnv = MIN_ENVELOPE;
-            }
-            const float envDb = linearToDb(fEnv);
-            float newLevelDb = envDb;
-            //using shorter variables for code clarity
-            const float thresholdDb = pMbcBandParams->thresholdDb;
-            const float ratio = pMbcBandParams->ratio;
-            const float kneeWidthDbHalf = pMbcBandParams->kneeWidthDb / 2;
-            const float noiseGateThresholdDb = pMbcBandParams->noiseGateThresholdDb;
-            const float expanderRatio = pMbcBandParams->expanderRatio;
-
-            //find segment
-            if (envDb > thresholdDb + kneeWidthDbHalf) {
-                //compression segment
-                newLevelDb = envDb + ((1 / ratio) - 1) * (envDb - thresholdDb);
-            } else if (envDb > thresholdDb - kneeWidthDbHalf) {
-                //knee-compression segment
-                float temp = (envDb - thresholdDb + kneeWidthDbHalf);
-                newLevelDb = envDb + ((1 / ratio) - 1) *
-                        temp * temp / (kneeWidthDbHalf * 4);
-            } else if (envDb < noiseGateThresholdDb) {
-                //expander segment
-                newLevelDb = noiseGateThresholdDb -
-                        expanderRatio * (noiseGateThresholdDb - envDb);
+    //== EqPost
+    for (size_t lane = 0; lane < lanes; lane++) {
+        const ChannelBuffer &cb = mChannelBuffers[firstChannel + lane];
+        if (cb.mPostEqInUse && cb.mPostEqEnabled) {
+            for (size_t k = 0; k < nyquistBin; k++) {
+                batch.gain[k][lane] *= cb.mPostEqFactorVector[k];
             }
+        }
+    }
 
-            float newFactor = dBtoLinear(newLevelDb - envDb);
-
-            //apply post gain.
-            newFactor *= dBtoLinear(pMbcBandParams->gainPostDb);
-
-            //apply to this band
-            for (size_t k = pMbcBandParams->binStart; k <= pMbcBandParams->binStop; k++) {
-                cb.complexTemp[k] *= newFactor;
+    //== Limiter. First Pass
+    bool limiterActive = false;
+    for (size_t lane = 0; lane < lanes; lane++) {
+        const ChannelBuffer &cb = mChannelBuffers[firstChannel + lane];
+        limiterActive |= cb.mLimiterInUse && cb.mLimiterEnabled;
+    }
+    if (limiterActive) {
+        FloatLanes energySum = {};
+        for (size_t k = 0; k < nyquistBin; k++) {
+            const FloatLanes g = batch.gain[k];
+            energySum += (batch.re[k] * batch.re[k] + batch.im[k] * batch.im[k]) * g * g;
+        }
+        for (size_t lane = 0; lane < lanes; lane++) {
+            ChannelBuffer &cb = mChannelBuffers[firstChannel + lane];
+            if (cb.mLimiterInUse && cb.mLimiterEnabled) {
+                computeLimiterFactor(cb, energySum[lane]);
             }
+        }
+    } //end Limiter
+    return mBlockSize * lanes;
+}
 
-        } //end per band process
+float DPFrequency::computeMbcBandFactor(ChannelBuffer::MbcBandParams &bandParams,
+        float energySum) {
+    //apply pre gain.
+    float preGainFactor = dBtoLinear(bandParams.gainPreDb);
+    float fEnergySum = energySum * preGainFactor * preGainFactor;
+
+    //The spectrum only holds the bins up to Nyquist, each half spectrum has half the energy.
+    // This is taken into account with the * 2 factor in the energy computations.
+    // energy = sqrt(sum_components_squared) number_points
+    // in here, the fEnergySum is duplicated to account for the second half spectrum,
+    // and the windowRms is used to normalize by the expected energy reduction
+    // caused by the window used (expected for steady state signals)
+    fEnergySum = sqrt(fEnergySum * 2) / (mBlockSize * mWindowRms);
+
+    // updates computed per frame advance.
+    float fTheta = 0.0;
+    float fFAttSec = bandParams.attackTimeMs / 1000; //in seconds
+    float fFRelSec = bandParams.releaseTimeMs / 1000; //in seconds
+
+    if (fEnergySum > bandParams.previousEnvelope) {
+        fTheta = exp(-1.0 / (fFAttSec * mBlocksPerSecond));
+    } else {
+        fTheta = exp(-1.0 / (fFRelSec * mBlocksPerSecond));
+    }
 
-    } //end MBC
+    float fEnv = (1.0 - fTheta) * fEnergySum + fTheta * bandParams.previousEnvelope;
+    //preserve for next iteration
+    bandParams.previousEnvelope = fEnv;
 
-    //== EqPost
-    if (cb.mPostEqInUse && cb.mPostEqEnabled) {
-        for (size_t k = 0; k < maxBin; k++) {
-            cb.complexTemp[k] *= cb.mPostEqFactorVector[k];
-        }
+    if (fEnv < MIN_ENVELOPE) {
+        fEnv = MIN_ENVELOPE;
+    }
+    const float envDb = linearToDb(fEnv);
+    float newLevelDb = envDb;
+    //using shorter variables for code clarity
+    const float thresholdDb = bandParams.thresholdDb;
+    const float ratio = bandParams.ratio;
+    const float kneeWidthDbHalf = bandParams.kneeWidthDb / 2;
+    const float noiseGateThresholdDb = bandParams.noiseGateThresholdDb;
+    const float expanderRatio = bandParams.expanderRatio;
+
+    //find segment
+    if (envDb > thresholdDb + kneeWidthDbHalf) {
+        //compression segment
+        newLevelDb = envDb + ((1 / ratio) - 1) * (envDb - thresholdDb);
+    } else if (envDb > thresholdDb - kneeWidthDbHalf) {
+        //knee-compression segment
+        float temp = (envDb - thresholdDb + kneeWidthDbHalf);
+        newLevelDb = envDb + ((1 / ratio) - 1) *
+                temp * temp / (kneeWidthDbHalf * 4);
+    } else if (envDb < noiseGateThresholdDb) {
+        //expander segment
+        newLevelDb = noiseGateThresholdDb -
+                expanderRatio * (noiseGateThresholdDb - envDb);
     }
 
-    //== Limiter. First Pass
-    if (cb.mLimiterInUse && cb.mLimiterEnabled) {
-        float fEnergySum = 0;
-        for (size_t k = 0; k < maxBin; k++) {
-            fEnergySum += std::norm(cb.complexTemp[k]);
-        }
+    float newFactor = dBtoLinear(newLevelDb - envDb);
 
-        //see explanation above for energy computation logic
-        fEnergySum = sqrt(fEnergySum * 2) / (mBlockSize * mWindowRms);
-        float fTheta = 0.0;
-        float fFAttSec = cb.mLimiterParams.attackTimeMs / 1000; //in seconds
-        float fFRelSec = cb.mLimiterParams.releaseTimeMs / 1000; //in seconds
+    //apply post gain.
+    newFactor *= dBtoLinear(bandParams.gainPostDb);
+    return newFactor;
+}
 
-        if (fEnergySum > cb.mLimiterParams.previousEnvelope) {
-            fTheta = exp(-1.0 / (fFAttSec * mBlocksPerSecond));
-        } else {
-            fTheta = exp(-1.0 / (fFRelSec * mBlocksPerSecond));
-        }
+void DPFrequency::computeLimiterFactor(ChannelBuffer &cb, float energySum) {
+    //see explanation above for energy computation logic
+    float fEnergySum = sqrt(energySum * 2) / (mBlockSize * mWindowRms);
+    float fTheta = 0.0;
+    float fFAttSec = cb.mLimiterParams.attackTimeMs / 1000; //in seconds
+    float fFRelSec = cb.mLimiterParams.releaseTimeMs / 1000; //in seconds
 
-        float fEnv = (1.0 - fTheta) * fEnergySum + fTheta * cb.mLimiterParams.previousEnvelope;
-        //preserve for next iteration
-        cb.mLimiterParams.previousEnvelope = fEnv;
+    if (fEnergySum > cb.mLimiterParams.previousEnvelope) {
+        fTheta = exp(-1.0 / (fFAttSec * mBlocksPerSecond));
+    } else {
+        fTheta = exp(-1.0 / (fFRelSec * mBlocksPerSecond));
+    }
 
-        const float envDb = linearToDb(fEnv);
-        float newFactorDb = 0;
-        //using shorter variables for code clarity
-        const float thresholdDb = cb.mLimiterParams.thresholdDb;
-        const float ratio = cb.mLimiterParams.ratio;
+    float fEnv = (1.0 - fTheta) * fEnergySum + fTheta * cb.mLimiterParams.previousEnvelope;
+    //preserve for next iteration
+    cb.mLimiterParams.previousEnvelope = fEnv;
 
-        if (envDb > thresholdDb) {
-            //limiter segment
-            newFactorDb = ((1 / ratio) - 1) * (envDb - thresholdDb);
-        }
+    const float envDb = linearToDb(fEnv);
+    float newFactorDb = 0;
+    //using shorter variables for code clarity
+    const float thresholdDb = cb.mLimiterParams.thresholdDb;
+    const float ratio = cb.mLimiterParams.ratio;
 
-        float newFactor = dBtoLinear(newFactorDb);
+    if (envDb > thresholdDb) {
+        //limiter segment
+        newFactorDb = ((1 / ratio) - 1) * (envDb - thresholdDb);
+    }
 
-        cb.mLimiterParams.newFactor = newFactor;
+    float newFactor = dBtoLinear(newFactorDb);
 
-    } //end Limiter
-    return mBlockSize;
+    cb.mLimiterParams.newFactor = newFactor;
 }
 
 void DPFrequency::processLinkedLimiters(CBufferVector &channelBuffers) {
@@ -644,34 +717,43 @@ void DPFrequency::processLinkedLimiters(CBufferVector &channelBuffers) {
     }
 }
 
-size_t DPFrequency::processLastStages(ChannelBuffer &cb) {
-
-    float outputGainFactor = dBtoLinear(cb.outputGainDb);
-    //== Limiter. last Pass
-    if (cb.mLimiterInUse && cb.mLimiterEnabled) {
-        //compute factor, with post-gain
-        float factor = cb.mLimiterParams.linkFactor * dBtoLinear(cb.mLimiterParams.postGainDb);
-        outputGainFactor *= factor;
+size_t DPFrequency::processLastStages(ChannelBatch &batch, size_t firstChannel) {
+    const size_t lanes = std::min(kBatchLanes, mChannelBuffers.size() - firstChannel);
+    const size_t nyquistBin = mHalfFFTSize - 1;
+
+    FloatLanes outputGainFactor = {};
+    for (size_t lane = 0; lane < lanes; lane++) {
+        const ChannelBuffer &cb = mChannelBuffers[firstChannel + lane];
+        outputGainFactor[lane] = dBtoLinear(cb.outputGainDb);
+        //== Limiter. last Pass
+        if (cb.mLimiterInUse && cb.mLimiterEnabled) {
+            //compute factor, with post-gain
+            outputGainFactor[lane] *= cb.mLimiterParams.linkFactor *
+                    dBtoLinear(cb.mLimiterParams.postGainDb);
+        }
     }
 
-    //apply to all if != 1.0
-    if (!compareEquality(outputGainFactor, 1.0f)) {
-        size_t cSize = cb.complexTemp.size();
-        size_t maxBin = std::min(cSize/2, mHalfFFTSize);
-        for (size_t k = 0; k < maxBin; k++) {
-            cb.complexTemp[k] *= outputGainFactor;
-        }
+    //apply preEq, mbc, postEq, limiter and output gain in a single pass over the bins.
+    for (size_t k = 0; k < nyquistBin; k++) {
+        const FloatLanes g = batch.gain[k] * outputGainFactor;
+        batch.re[k] *= g;
+        batch.im[k] *= g;
     }
+    batch.re[nyquistBin] *= batch.gain[nyquistBin];
+    batch.im[nyquistBin] *= batch.gain[nyquistBin];
 
-    //##ifft directly to output.
-    Eigen::Map<Eigen::VectorXf> eOutput(&cb.output[0], cb.output.size());
-    mFftServer.inv(eOutput, cb.complexTemp);
+    //##ifft
+    mBatchFft.inverse(batch.re.data(), batch.im.data(), batch.windowed.data());
 
     //apply rest of window for resynthesis
-    Eigen::Map<Eigen::VectorXf> eWindow(&mVWindow[0], mVWindow.size());
-    eOutput = eOutput.cwiseProduct(eWindow);
+    for (size_t lane = 0; lane < lanes; lane++) {
+        ChannelBuffer &cb = mChannelBuffers[firstChannel + lane];
+        for (size_t n = 0; n < mBlockSize; n++) {
+            cb.output[n] = batch.windowed[n][lane] * mVWindow[n];
+        }
+    }
 
-    return mBlockSize;
+    return mBlockSize * lanes;
 }
 
 } //namespace dp_fx
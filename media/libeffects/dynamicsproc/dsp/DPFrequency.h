@@ -19,10 +19,10 @@
 #define DPFREQUENCY_H_
 
 #include <Eigen/Dense>
-#include <unsupported/Eigen/FFT>
 
 #include "RDsp.h"
 #include "SHCircularBuffer.h"
+#include "DPBatchFft.h"
 
 #include "DPBase.h"
 
@@ -39,8 +39,6 @@ public:
     FloatVec output;    // time domain temp vector for output
     FloatVec outTail;   // time domain temp vector for output tail (for overlap-add method)
 
-    Eigen::VectorXcf complexTemp; // complex temp vector for frequency domain operations
-
     //Current parameters
     float inputGainDb;
     float outputGainDb;
@@ -110,6 +108,21 @@ private:
 
 using CBufferVector = std::vector<ChannelBuffer>;
 
+// Up to kBatchLanes channels that are transformed and processed together.
+// Each FloatLanes holds the same sample or bin of all the channels of the batch.
+class ChannelBatch {
+public:
+    FloatLanesVec windowed; // time domain, windowed input and then output
+    FloatLanesVec re;       // spectrum, bins 0 to Nyquist
+    FloatLanesVec im;
+    FloatLanesVec gain;     // combined preEq, mbc and postEq gain per bin
+    FloatLanesVec power;    // energy per bin after preEq
+
+    void initBuffers(unsigned int blockSize, unsigned int halfFftSize);
+};
+
+using CBatchVector = std::vector<ChannelBatch>;
+
 using GroupsMap = std::map<int32_t, IntVec>;
 
 class LinkedLimiters {
@@ -134,8 +147,10 @@ private:
     size_t processOneVector(FloatVec &output, FloatVec &input, ChannelBuffer &cb);
 
     size_t processChannelBuffers(CBufferVector &channelBuffers);
-    size_t processFirstStages(ChannelBuffer &cb);
-    size_t processLastStages(ChannelBuffer &cb);
+    size_t processFirstStages(ChannelBatch &batch, size_t firstChannel);
+    size_t processLastStages(ChannelBatch &batch, size_t firstChannel);
+    float computeMbcBandFactor(ChannelBuffer::MbcBandParams &bandParams, float energySum);
+    void computeLimiterFactor(ChannelBuffer &cb, float energySum);
     void processLinkedLimiters(CBufferVector &channelBuffers);
 
     size_t mBlockSize;
@@ -146,13 +161,14 @@ private:
     float mBlocksPerSecond;
 
     CBufferVector mChannelBuffers;
+    CBatchVector mChannelBatches;
 
     LinkedLimiters mLinkedLimiters;
 
     //dsp
     FloatVec mVWindow;  //window class.
     float mWindowRms;
-    Eigen::FFT<float> mFftServer;
+    DPBatchFft mBatchFft;
 };
 
 } //namespace dp_fx
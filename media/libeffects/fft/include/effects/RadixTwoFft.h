@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_EFFECTS_RADIX_TWO_FFT_H_
+#define ANDROID_EFFECTS_RADIX_TWO_FFT_H_
+
+#include <math.h>
+#include <stddef.h>
+
+#include <utility>
+#include <vector>
+
+namespace android::effects {
+
+// In place radix-2 complex FFT, without scaling.
+// T is float, or a vector of floats to transform one signal per lane with the same
+// instructions.
+template <typename T>
+class ComplexFft {
+public:
+    // size must be a power of 2.
+    void configure(size_t size) {
+        mSize = size;
+        size_t bits = 0;
+        while (((size_t)1 << bits) < size) {
+            bits++;
+        }
+        mBitReverse.resize(size);
+        for (size_t i = 0; i < size; i++) {
+            size_t reversed = 0;
+            for (size_t b = 0; b < bits; b++) {
+                reversed |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            mBitReverse[i] = reversed;
+        }
+        mCos.resize(size / 2);
+        mSin.resize(size / 2);
+        for (size_t i = 0; i < size / 2; i++) {
+            mCos[i] = cos(2 * M_PI * i / size);
+            mSin[i] = sin(2 * M_PI * i / size);
+        }
+    }
+
+    size_t getSize() const {
+        return mSize;
+    }
+
+    void transform(T *re, T *im, bool inverse) const {
+        for (size_t i = 0; i < mSize; i++) {
+            const size_t j = mBitReverse[i];
+            if (j > i) {
+                std::swap(re[i], re[j]);
+                std::swap(im[i], im[j]);
+            }
+        }
+        const float sign = inverse ? 1.0f : -1.0f;
+        for (size_t size = 2; size <= mSize; size <<= 1) {
+            const size_t half = size >> 1;
+            const size_t step = mSize / size;
+            for (size_t start = 0; start < mSize; start += size) {
+                for (size_t j = 0; j < half; j++) {
+                    const float wr = mCos[j * step];
+                    const float wi = sign * mSin[j * step];
+                    const size_t a = start + j;
+                    const size_t b = a + half;
+                    const T tr = re[b] * wr - im[b] * wi;
+                    const T ti = re[b] * wi + im[b] * wr;
+                    re[b] = re[a] - tr;
+                    im[b] = im[a] - ti;
+                    re[a] += tr;
+                    im[a] += ti;
+                }
+            }
+        }
+    }
+
+private:
+    size_t mSize = 0;
+    std::vector<size_t> mBitReverse;
+    std::vector<float> mCos;
+    std::vector<float> mSin;
+};
+
+// FFT of a real signal, computed with a complex FFT of half the size.
+template <typename T>
+class RealFft {
+public:
+    // fftSize must be a power of 2 and at least 4.
+    void configure(size_t fftSize) {
+        mFftSize = fftSize;
+        mHalfSize = fftSize / 2;
+        mComplexFft.configure(mHalfSize);
+        mSplitCos.resize(mHalfSize + 1);
+        mSplitSin.resize(mHalfSize + 1);
+        for (size_t k = 0; k <= mHalfSize; k++) {
+            mSplitCos[k] = cos(2 * M_PI * k / fftSize);
+            mSplitSin[k] = sin(2 * M_PI * k / fftSize);
+        }
+        mZRe.resize(mHalfSize);
+        mZIm.resize(mHalfSize);
+    }
+
+    size_t getFftSize() const {
+        return mFftSize;
+    }
+
+    // Bins 0 to fftSize / 2, including the Nyquist bin.
+    size_t getBinCount() const {
+        return mFftSize / 2 + 1;
+    }
+
+    // Unscaled forward transform of fftSize samples into getBinCount() bins.
+    void forward(const T *in, T *re, T *im) {
+        //pack even samples as real and odd samples as imaginary part
+        for (size_t n = 0; n < mHalfSize; n++) {
+            mZRe[n] = in[2 * n];
+            mZIm[n] = in[2 * n + 1];
+        }
+        mComplexFft.transform(mZRe.data(), mZIm.data(), false /* inverse */);
+
+        //split into the spectra of the even and odd samples, and combine them
+        for (size_t k = 0; k <= mHalfSize; k++) {
+            const size_t i = k < mHalfSize ? k : 0;
+            const size_t m = k > 0 ? mHalfSize - k : 0;
+            const T evenRe = (mZRe[i] + mZRe[m]) * 0.5f;
+            const T evenIm = (mZIm[i] - mZIm[m]) * 0.5f;
+            const T oddRe = (mZIm[i] + mZIm[m]) * 0.5f;
+            const T oddIm = (mZRe[m] - mZRe[i]) * 0.5f;
+            const float c = mSplitCos[k];
+            const float s = mSplitSin[k];
+            re[k] = evenRe + oddRe * c + oddIm * s;
+            im[k] = evenIm + oddIm * c - oddRe * s;
+        }
+    }
+
+    // Inverse transform, scaled so that inverse(forward(x)) == x.
+    void inverse(const T *re, const T *im, T *out) {
+        for (size_t k = 0; k < mHalfSize; k++) {
+            const size_t m = mHalfSize - k;
+            const T evenRe = (re[k] + re[m]) * 0.5f;
+            const T evenIm = (im[k] - im[m]) * 0.5f;
+            const T diffRe = (re[k] - re[m]) * 0.5f;
+            const T diffIm = (im[k] + im[m]) * 0.5f;
+            const float c = mSplitCos[k];
+            const float s = mSplitSin[k];
+            const T oddRe = diffRe * c - diffIm * s;
+            const T oddIm = diffRe * s + diffIm * c;
+            mZRe[k] = evenRe - oddIm;
+            mZIm[k] = evenIm + oddRe;
+        }
+        mComplexFft.transform(mZRe.data(), mZIm.data(), true /* inverse */);
+
+        const float scale = 1.0f / mHalfSize;
+        for (size_t n = 0; n < mHalfSize; n++) {
+            out[2 * n] = mZRe[n] * scale;
+            out[2 * n + 1] = mZIm[n] * scale;
+        }
+    }
+
+private:
+    size_t mFftSize = 0;
+    size_t mHalfSize = 0;           // size of the complex transform
+    ComplexFft<T> mComplexFft;
+    std::vector<float> mSplitCos;   // twiddles to split the real transform, per bin
+    std::vector<float> mSplitSin;
+    std::vector<T> mZRe;            // complex work buffers
+    std::vector<T> mZIm;
+};
+
+} // namespace android::effects
+
+#endif // ANDROID_EFFECTS_RADIX_TWO_FFT_H_
@@ -15,6 +15,7 @@
  */
 
 #include <array>
+#include <chrono>
 #include <climits>
 #include <cstdlib>
 #include <random>
@@ -38,6 +39,10 @@ constexpr effect_uuid_t kEffectUuids[] = {
 
 constexpr size_t kNumEffectUuids = std::size(kEffectUuids);
 
+// Bass Boost and Equalizer share the bundle instance of a session, so they are also measured
+// together. This configuration is benchmarked with the effect index kNumEffectUuids.
+constexpr size_t kBassBoostAndEqualizer[] = {0, 2};
+
 constexpr size_t kFrameCount = 2048;
 
 constexpr audio_channel_mask_t kChMasks[] = {
@@ -58,7 +63,9 @@ constexpr int kSampleRate = 44100;
  * A test result running on Pixel 3 for comparison.
  * The first parameter indicates the number of channels.
  * The second parameter indicates the effect.
- * 0: Bass Boost, 1: Virtualizer, 2: Equalizer, 3: Volume
+ * 0: Bass Boost, 1: Virtualizer, 2: Equalizer, 3: Volume, 4: Bass Boost + Equalizer
+ * (4 was added later and is not part of these results).
+ * The ns_per_frame counter is the wall time of the process calls divided by the frames.
  * -----------------------------------------------------
  * Benchmark           Time             CPU   Iterations
  * -----------------------------------------------------
@@ -160,24 +167,12 @@ constexpr int kSampleRate = 44100;
  * BM_LVM/24/3     183192 ns       182634 ns         3824
  *******************************************************************/
 
-static void BM_LVM(benchmark::State& state) {
-    const size_t chMask = kChMasks[state.range(0) - 1];
-    const effect_uuid_t uuid = kEffectUuids[state.range(1)];
-    const size_t channelCount = audio_channel_count_from_out_mask(chMask);
-
-    // Initialize input buffer with deterministic pseudo-random values
-    std::minstd_rand gen(chMask);
-    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
-    std::vector<float> input(kFrameCount * channelCount);
-    for (auto& in : input) {
-        in = dis(gen);
-    }
-
+static effect_handle_t createEffect(const effect_uuid_t& uuid, audio_channel_mask_t chMask) {
     effect_handle_t effectHandle = nullptr;
     if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.create_effect(&uuid, 1, 1, &effectHandle);
         status != 0) {
         ALOGE("create_effect returned an error = %d\n", status);
-        return;
+        return nullptr;
     }
 
     effect_config_t config{};
@@ -192,7 +187,8 @@ static void BM_LVM(benchmark::State& state) {
                                        &config, &replySize, &reply);
         status != 0) {
         ALOGE("command returned an error = %d\n", status);
-        return;
+        AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+        return nullptr;
     }
 
     if (int status =
@@ -200,34 +196,77 @@ static void BM_LVM(benchmark::State& state) {
                         ->command(effectHandle, EFFECT_CMD_ENABLE, 0, nullptr, &replySize, &reply);
         status != 0) {
         ALOGE("Command enable call returned error %d\n", reply);
-        return;
+        AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+        return nullptr;
+    }
+    return effectHandle;
+}
+
+static void BM_LVM(benchmark::State& state) {
+    const audio_channel_mask_t chMask = kChMasks[state.range(0) - 1];
+    const size_t channelCount = audio_channel_count_from_out_mask(chMask);
+
+    std::vector<size_t> effects;
+    if ((size_t)state.range(1) == kNumEffectUuids) {
+        effects.assign(std::begin(kBassBoostAndEqualizer), std::end(kBassBoostAndEqualizer));
+    } else {
+        effects.push_back(state.range(1));
+    }
+
+    // Initialize input buffer with deterministic pseudo-random values
+    std::minstd_rand gen(chMask);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<float> input(kFrameCount * channelCount);
+    for (auto& in : input) {
+        in = dis(gen);
+    }
+
+    std::vector<effect_handle_t> effectHandles;
+    for (size_t effect : effects) {
+        effect_handle_t effectHandle = createEffect(kEffectUuids[effect], chMask);
+        if (effectHandle == nullptr) {
+            for (effect_handle_t handle : effectHandles) {
+                AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(handle);
+            }
+            return;
+        }
+        effectHandles.push_back(effectHandle);
     }
 
     // Run the test
+    std::vector<float> output(kFrameCount * channelCount);
+    std::chrono::nanoseconds processTime{0};
     for (auto _ : state) {
-        std::vector<float> output(kFrameCount * channelCount);
-
         benchmark::DoNotOptimize(input.data());
         benchmark::DoNotOptimize(output.data());
 
-        audio_buffer_t inBuffer = {.frameCount = kFrameCount, .f32 = input.data()};
-        audio_buffer_t outBuffer = {.frameCount = kFrameCount, .f32 = output.data()};
-        (*effectHandle)->process(effectHandle, &inBuffer, &outBuffer);
+        const auto start = std::chrono::steady_clock::now();
+        // The bundle processes all effects of the session once each of them has been called.
+        for (effect_handle_t effectHandle : effectHandles) {
+            audio_buffer_t inBuffer = {.frameCount = kFrameCount, .f32 = input.data()};
+            audio_buffer_t outBuffer = {.frameCount = kFrameCount, .f32 = output.data()};
+            (*effectHandle)->process(effectHandle, &inBuffer, &outBuffer);
+        }
+        processTime += std::chrono::steady_clock::now() - start;
 
         benchmark::ClobberMemory();
     }
 
     state.SetComplexityN(state.range(0));
+    state.counters["ns_per_frame"] =
+            (double)processTime.count() / ((double)state.iterations() * kFrameCount);
 
-    if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle); status != 0) {
-        ALOGE("release_effect returned an error = %d\n", status);
-        return;
+    for (effect_handle_t effectHandle : effectHandles) {
+        if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+            status != 0) {
+            ALOGE("release_effect returned an error = %d\n", status);
+        }
     }
 }
 
 static void LVMArgs(benchmark::internal::Benchmark* b) {
     for (int i = FCC_1; i <= kNumChMasks; i++) {
-        for (int j = 0; j < kNumEffectUuids; ++j) {
+        for (int j = 0; j <= kNumEffectUuids; ++j) {
             b->Args({i, j});
         }
     }
@@ -37,6 +37,16 @@ constexpr effect_uuid_t kEffectUuids[] = {
          0x11df,
          0x8ddc,
          {0x00, 0x02, 0xa5, 0xd5, 0xc5, 0x1b}},  // preset-aux mode
+        {0x51494ad1,
+         0xe3cf,
+         0x4f3a,
+         0x98d4,
+         {0xe6, 0x1a, 0x8f, 0x9f, 0xbe, 0xf1}},  // convolution preset-insert mode
+        {0xb02befd5,
+         0x5b36,
+         0x4458,
+         0xb66d,
+         {0x61, 0x8a, 0xf5, 0x1f, 0xc7, 0x03}},  // convolution preset-aux mode
 };
 
 constexpr size_t kNumEffectUuids = std::size(kEffectUuids);
@@ -78,6 +88,7 @@ int reverbSetConfigParam(uint32_t paramType, uint32_t paramValue, effect_handle_
  * The first parameter indicates the preset level id.
  * The second parameter indicates the effect.
  * 0: preset-insert mode, 1: preset-aux mode
+ * 2: convolution preset-insert mode, 3: convolution preset-aux mode (not in the table below)
  * --------------------------------------------------------
  * Benchmark              Time             CPU   Iterations
  * --------------------------------------------------------
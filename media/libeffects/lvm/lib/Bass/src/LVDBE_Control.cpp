@@ -21,7 +21,6 @@
 /*                                                                                      */
 /****************************************************************************************/
 
-#include <audio_utils/BiquadFilter.h>
 #include <system/audio.h>
 #include "LVDBE.h"
 #include "LVDBE_Private.h"
@@ -109,19 +108,17 @@ void LVDBE_SetFilters(LVDBE_Instance_t* pInstance, LVDBE_Params_t* pParams) {
     /*
      * Setup the high pass filter
      */
-    std::array<LVM_FLOAT, android::audio_utils::kBiquadNumCoefs> coefs = {
+    BiquadCascade::Coefs_t coefs = {
             LVDBE_HPF_Table[Offset].A0, LVDBE_HPF_Table[Offset].A1, LVDBE_HPF_Table[Offset].A2,
             -(LVDBE_HPF_Table[Offset].B1), -(LVDBE_HPF_Table[Offset].B2)};
-    pInstance->pHPFBiquad
-            ->setCoefficients<std::array<LVM_FLOAT, android::audio_utils::kBiquadNumCoefs>>(coefs);
+    pInstance->HPFCascade.setStage(0, coefs, 0.0f /* DryGain */, 1.0f /* WetGain */);
 
     /*
      * Setup the band pass filter
      */
     coefs = {LVDBE_BPF_Table[Offset].A0, 0.0, -(LVDBE_BPF_Table[Offset].A0),
              -(LVDBE_BPF_Table[Offset].B1), -(LVDBE_BPF_Table[Offset].B2)};
-    pInstance->pBPFBiquad
-            ->setCoefficients<std::array<LVM_FLOAT, android::audio_utils::kBiquadNumCoefs>>(coefs);
+    pInstance->BPFCascade.setStage(0, coefs, 0.0f /* DryGain */, 1.0f /* WetGain */);
 }
 
 /************************************************************************************/
@@ -275,11 +272,10 @@ LVDBE_ReturnStatus_en LVDBE_Control(LVDBE_Handle_t hInstance, LVDBE_Params_t* pP
     LVMixer3_2St_FLOAT_st* pBypassMixer_Instance = &pInstance->pData->BypassMixer;
 
     /*
-     * Create biquad instance
+     * Resize the HPF, this clears its history
      */
     if (pInstance->Params.NrChannels != pParams->NrChannels) {
-        pInstance->pHPFBiquad.reset(
-                new android::audio_utils::BiquadFilter<LVM_FLOAT>(pParams->NrChannels));
+        pInstance->HPFCascade.setChannelCount(pParams->NrChannels);
     }
     /*
      * Update the filters
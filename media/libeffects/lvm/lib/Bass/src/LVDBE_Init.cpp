@@ -91,9 +91,10 @@ LVDBE_ReturnStatus_en LVDBE_Init(LVDBE_Handle_t* phInstance, LVDBE_Capabilities_
     /*
      * Create biquad instance
      */
-    pInstance->pHPFBiquad.reset(
-            new android::audio_utils::BiquadFilter<LVM_FLOAT>(pInstance->Params.NrChannels));
-    pInstance->pBPFBiquad.reset(new android::audio_utils::BiquadFilter<LVM_FLOAT>(FCC_1));
+    pInstance->HPFCascade.setChannelCount(pInstance->Params.NrChannels);
+    pInstance->HPFCascade.resize(1);
+    pInstance->BPFCascade.setChannelCount(FCC_1);
+    pInstance->BPFCascade.resize(1);
 
     /*
      * Initialise the filters
@@ -33,9 +33,9 @@
 /*                                                                                      */
 /****************************************************************************************/
 
-#include <audio_utils/BiquadFilter.h>
 #include "LVDBE.h" /* Calling or Application layer definitions */
 #include "BIQUAD.h"
+#include "BiquadCascade.h"
 #include "LVC_Mixer.h"
 #include "AGC.h"
 
@@ -79,10 +79,8 @@ typedef struct {
     /* Data and coefficient pointers */
     LVDBE_Data_FLOAT_t* pData; /* Instance data */
     void* pScratch;            /* scratch pointer */
-    std::unique_ptr<android::audio_utils::BiquadFilter<LVM_FLOAT>>
-            pHPFBiquad; /* Biquad filter instance for HPF */
-    std::unique_ptr<android::audio_utils::BiquadFilter<LVM_FLOAT>>
-            pBPFBiquad; /* Biquad filter instance for BPF */
+    BiquadCascade HPFCascade;  /* Single stage cascade for the HPF */
+    BiquadCascade BPFCascade;  /* Single stage cascade for the downmix and BPF */
 } LVDBE_Instance_t;
 
 /****************************************************************************************/
@@ -20,8 +20,6 @@
 /*    Includes                                                                          */
 /*                                                                                      */
 /****************************************************************************************/
-#include <audio_utils/BiquadFilter.h>
-
 #include <string.h>  // memset
 #include "LVDBE.h"
 #include "LVDBE_Private.h"
@@ -115,28 +113,22 @@ LVDBE_ReturnStatus_en LVDBE_Process(
     if ((pInstance->Params.OperatingMode == LVDBE_ON) ||
         (LVC_Mixer_GetCurrent(&pInstance->pData->BypassMixer.MixerStream[0]) !=
          LVC_Mixer_GetTarget(&pInstance->pData->BypassMixer.MixerStream[0]))) {
-        // make copy of input data
-        Copy_Float(pInData, pScratch, (LVM_INT16)NrSamples);
-
         /*
-         * Apply the high pass filter if selected
+         * Apply the high pass filter if selected while copying the input data
          */
         if (pInstance->Params.HPFSelect == LVDBE_HPF_ON) {
-            pInstance->pHPFBiquad->process(pScratch, pScratch, NrFrames);
+            pInstance->HPFCascade.process(pInData, pScratch, NrFrames);
+        } else {
+            Copy_Float(pInData, pScratch, (LVM_INT16)NrSamples);
         }
 
         /*
-         * Create the mono stream
-         */
-        FromMcToMono_Float(pScratch,            /* Source */
-                           pMono,               /* Mono destination */
-                           (LVM_INT16)NrFrames, /* Number of frames */
-                           (LVM_INT16)NrChannels);
-
-        /*
-         * Apply the band pass filter
+         * Create the mono stream and apply the band pass filter in one pass
          */
-        pInstance->pBPFBiquad->process(pMono, pMono, NrFrames);
+        pInstance->BPFCascade.processDownmix(pScratch, /* Source */
+                                             pMono,    /* Mono destination */
+                                             NrFrames, /* Number of frames */
+                                             NrChannels);
 
         /*
          * Apply the AGC and mix
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __BIQUADCASCADE_H__
+#define __BIQUADCASCADE_H__
+
+#include <array>
+#include <vector>
+
+#include "LVM_Types.h"
+
+/**********************************************************************************
+   DEFINES
+***********************************************************************************/
+#define BIQUADCASCADE_NUM_COEFS 5 /* b0, b1, b2, a1, a2 */
+
+/**********************************************************************************
+   CLASS
+***********************************************************************************/
+
+/*
+ * A cascade of biquad stages that runs all stages over a block in a single pass.
+ *
+ * Each stage computes y = DryGain * x + WetGain * H(x), where H is a biquad with
+ * coefficients {b0, b1, b2, a1, a2} in the same convention as audio_utils BiquadFilter:
+ *   H(x)[n] = b0 * x[n] + b1 * x[n-1] + b2 * x[n-2] - a1 * h[n-1] - a2 * h[n-2]
+ * A plain filter stage uses DryGain 0 and WetGain 1, an LVEQNB peaking band uses DryGain 1
+ * and the band gain as WetGain. The output of a stage is the input of the next one.
+ *
+ * The samples of all channels of a frame are processed together as a vector, so there is no
+ * loop over channels inside the filter recursion. Channel counts above 2 are processed in
+ * groups of 4. The filter state of up to 8 stages is kept in local variables for the whole
+ * block, so the audio is read and written once per block instead of once per stage.
+ */
+class BiquadCascade {
+  public:
+    typedef std::array<LVM_FLOAT, BIQUADCASCADE_NUM_COEFS> Coefs_t;
+
+    explicit BiquadCascade(LVM_INT32 NrChannels = FCC_2) { setChannelCount(NrChannels); }
+
+    /* Set the number of interleaved channels. This clears the filter history. */
+    void setChannelCount(LVM_INT32 NrChannels);
+    LVM_INT32 getChannelCount() const { return mNrChannels; }
+
+    /* Set the number of stages. New stages are disabled, existing stages are kept. */
+    void resize(LVM_INT32 NrStages);
+    LVM_INT32 getStageCount() const { return (LVM_INT32)mStages.size(); }
+
+    /* Set the coefficients and mix gains of a stage and enable or disable it. */
+    void setStage(LVM_INT32 Stage, const Coefs_t& Coefs, LVM_FLOAT DryGain, LVM_FLOAT WetGain,
+                  bool Enabled = true);
+
+    /* Enable or disable a stage. A disabled stage passes the signal and keeps its history. */
+    void setStageEnabled(LVM_INT32 Stage, bool Enabled);
+
+    /* Number of enabled stages. process() just copies when this is 0. */
+    LVM_INT32 getActiveStageCount() const { return (LVM_INT32)mActiveStages.size(); }
+
+    /* Clear the filter history of all stages. */
+    void clear();
+
+    /*
+     * Process interleaved frames with mNrChannels channels. pIn and pOut may be the same.
+     */
+    void process(const LVM_FLOAT* pIn, LVM_FLOAT* pOut, LVM_INT32 NrFrames);
+
+    /*
+     * Average the NrInChannels interleaved channels of pIn to mono and run the cascade on the
+     * result. The cascade must have been set up for one channel.
+     */
+    void processDownmix(const LVM_FLOAT* pIn, LVM_FLOAT* pOut, LVM_INT32 NrFrames,
+                        LVM_INT32 NrInChannels);
+
+  private:
+    struct Stage {
+        Coefs_t Coefs{};
+        LVM_FLOAT DryGain = 0.0f;
+        LVM_FLOAT WetGain = 1.0f;
+        bool Enabled = false;
+    };
+
+    void updateActiveStages();
+
+    LVM_INT32 mNrChannels = 0;
+    LVM_INT32 mNrChannelsPadded = 0;    /* mNrChannels rounded up to the vector width */
+    std::vector<Stage> mStages;
+    std::vector<LVM_INT32> mActiveStages; /* Indices of the enabled stages */
+    /* Filter state [stage][s1/s2][channel], mNrChannelsPadded floats per channel group */
+    std::vector<LVM_FLOAT> mState;
+};
+
+#endif /* __BIQUADCASCADE_H__ */
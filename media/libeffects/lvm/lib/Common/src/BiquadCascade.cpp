@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**********************************************************************************
+   INCLUDES
+***********************************************************************************/
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "BiquadCascade.h"
+
+/**********************************************************************************
+   DEFINES
+***********************************************************************************/
+
+/* Stages that are run together in one pass over the block. */
+#define BIQUADCASCADE_STAGES_PER_PASS 8
+
+/* Vector types, mapped to NEON or SSE registers by the compiler. */
+typedef LVM_FLOAT LVM_FLOAT2 __attribute__((vector_size(2 * sizeof(LVM_FLOAT))));
+typedef LVM_FLOAT LVM_FLOAT4 __attribute__((vector_size(4 * sizeof(LVM_FLOAT))));
+
+/* Number of channels processed together. Channel counts above 2 are processed in groups
+ * of 4, the last group being padded. */
+static inline LVM_INT32 BiquadCascade_Lanes(LVM_INT32 NrChannels) {
+    return NrChannels <= 2 ? NrChannels : 4;
+}
+
+/**********************************************************************************
+   KERNEL
+***********************************************************************************/
+
+/*
+ * Run NrStages stages over the frames of one group of channels.
+ *
+ * V is the vector type holding Lanes channels (LVM_FLOAT for mono). ValidLanes channels
+ * starting at pIn / pOut are read and written, the remaining lanes only see zeros.
+ * pState holds s1 and s2 of each stage, Lanes floats each.
+ */
+template <typename V, int Lanes>
+static void BiquadCascade_Kernel(const LVM_FLOAT* pIn, LVM_FLOAT* pOut, LVM_INT32 NrFrames,
+                                 LVM_INT32 Stride, LVM_INT32 ValidLanes,
+                                 const LVM_FLOAT* const* pCoefs, LVM_FLOAT* const* pState,
+                                 LVM_INT32 NrStages) {
+    V b0[BIQUADCASCADE_STAGES_PER_PASS], b1[BIQUADCASCADE_STAGES_PER_PASS],
+            b2[BIQUADCASCADE_STAGES_PER_PASS], a1[BIQUADCASCADE_STAGES_PER_PASS],
+            a2[BIQUADCASCADE_STAGES_PER_PASS], dry[BIQUADCASCADE_STAGES_PER_PASS],
+            wet[BIQUADCASCADE_STAGES_PER_PASS], s1[BIQUADCASCADE_STAGES_PER_PASS],
+            s2[BIQUADCASCADE_STAGES_PER_PASS];
+    const V zero = {};
+    for (LVM_INT32 i = 0; i < NrStages; i++) {
+        /* Coefficients are b0, b1, b2, a1, a2, dry, wet */
+        b0[i] = zero + pCoefs[i][0];
+        b1[i] = zero + pCoefs[i][1];
+        b2[i] = zero + pCoefs[i][2];
+        a1[i] = zero + pCoefs[i][3];
+        a2[i] = zero + pCoefs[i][4];
+        dry[i] = zero + pCoefs[i][5];
+        wet[i] = zero + pCoefs[i][6];
+        memcpy(&s1[i], pState[i], sizeof(V));
+        memcpy(&s2[i], pState[i] + Lanes, sizeof(V));
+    }
+
+    const bool fullGroup = ValidLanes == Lanes;
+    for (LVM_INT32 n = 0; n < NrFrames; n++) {
+        V x = zero;
+        if (fullGroup) {
+            memcpy(&x, pIn, sizeof(V));
+        } else {
+            memcpy(&x, pIn, ValidLanes * sizeof(LVM_FLOAT));
+        }
+        for (LVM_INT32 i = 0; i < NrStages; i++) {
+            /* Transposed direct form II */
+            const V h = b0[i] * x + s1[i];
+            s1[i] = b1[i] * x - a1[i] * h + s2[i];
+            s2[i] = b2[i] * x - a2[i] * h;
+            x = dry[i] * x + wet[i] * h;
+        }
+        if (fullGroup) {
+            memcpy(pOut, &x, sizeof(V));
+        } else {
+            memcpy(pOut, &x, ValidLanes * sizeof(LVM_FLOAT));
+        }
+        pIn += Stride;
+        pOut += Stride;
+    }
+
+    for (LVM_INT32 i = 0; i < NrStages; i++) {
+        memcpy(pState[i], &s1[i], sizeof(V));
+        memcpy(pState[i] + Lanes, &s2[i], sizeof(V));
+    }
+}
+
+/**********************************************************************************
+   CLASS METHODS
+***********************************************************************************/
+
+void BiquadCascade::setChannelCount(LVM_INT32 NrChannels) {
+    mNrChannels = NrChannels;
+    const LVM_INT32 lanes = BiquadCascade_Lanes(NrChannels);
+    mNrChannelsPadded = (NrChannels + lanes - 1) / lanes * lanes;
+    mState.assign(mStages.size() * 2 * mNrChannelsPadded, 0.0f);
+}
+
+void BiquadCascade::resize(LVM_INT32 NrStages) {
+    mStages.resize(NrStages);
+    mState.resize(mStages.size() * 2 * mNrChannelsPadded, 0.0f);
+    updateActiveStages();
+}
+
+void BiquadCascade::setStage(LVM_INT32 Stage, const Coefs_t& Coefs, LVM_FLOAT DryGain,
+                             LVM_FLOAT WetGain, bool Enabled) {
+    mStages[Stage].Coefs = Coefs;
+    mStages[Stage].DryGain = DryGain;
+    mStages[Stage].WetGain = WetGain;
+    mStages[Stage].Enabled = Enabled;
+    updateActiveStages();
+}
+
+void BiquadCascade::setStageEnabled(LVM_INT32 Stage, bool Enabled) {
+    mStages[Stage].Enabled = Enabled;
+    updateActiveStages();
+}
+
+void BiquadCascade::clear() {
+    std::fill(mState.begin(), mState.end(), 0.0f);
+}
+
+void BiquadCascade::updateActiveStages() {
+    mActiveStages.clear();
+    for (LVM_INT32 i = 0; i < (LVM_INT32)mStages.size(); i++) {
+        if (mStages[i].Enabled) {
+            mActiveStages.push_back(i);
+        }
+    }
+}
+
+void BiquadCascade::process(const LVM_FLOAT* pIn, LVM_FLOAT* pOut, LVM_INT32 NrFrames) {
+    const LVM_INT32 nrActive = (LVM_INT32)mActiveStages.size();
+    if (nrActive == 0) {
+        if (pIn != pOut) {
+            memmove(pOut, pIn, NrFrames * mNrChannels * sizeof(LVM_FLOAT));
+        }
+        return;
+    }
+
+    const LVM_INT32 lanes = BiquadCascade_Lanes(mNrChannels);
+    /* Coefficients are repacked as b0, b1, b2, a1, a2, dry, wet for the kernel */
+    LVM_FLOAT coefs[BIQUADCASCADE_STAGES_PER_PASS][BIQUADCASCADE_NUM_COEFS + 2];
+    const LVM_FLOAT* pCoefs[BIQUADCASCADE_STAGES_PER_PASS];
+    LVM_FLOAT* pState[BIQUADCASCADE_STAGES_PER_PASS];
+
+    for (LVM_INT32 first = 0; first < nrActive; first += BIQUADCASCADE_STAGES_PER_PASS) {
+        const LVM_INT32 nrStages = std::min(nrActive - first, BIQUADCASCADE_STAGES_PER_PASS);
+        for (LVM_INT32 i = 0; i < nrStages; i++) {
+            const Stage& stage = mStages[mActiveStages[first + i]];
+            std::copy(stage.Coefs.begin(), stage.Coefs.end(), coefs[i]);
+            coefs[i][BIQUADCASCADE_NUM_COEFS] = stage.DryGain;
+            coefs[i][BIQUADCASCADE_NUM_COEFS + 1] = stage.WetGain;
+            pCoefs[i] = coefs[i];
+        }
+        for (LVM_INT32 channel = 0; channel < mNrChannels; channel += lanes) {
+            const LVM_INT32 validLanes = std::min(lanes, mNrChannels - channel);
+            for (LVM_INT32 i = 0; i < nrStages; i++) {
+                pState[i] = &mState[mActiveStages[first + i] * 2 * mNrChannelsPadded +
+                                    2 * channel];
+            }
+            /* After the first pass the data is already in pOut */
+            const LVM_FLOAT* pSrc = (first == 0 ? pIn : pOut) + channel;
+            LVM_FLOAT* pDst = pOut + channel;
+            switch (lanes) {
+                case 1:
+                    BiquadCascade_Kernel<LVM_FLOAT, 1>(pSrc, pDst, NrFrames, mNrChannels,
+                                                       validLanes, pCoefs, pState, nrStages);
+                    break;
+                case 2:
+                    BiquadCascade_Kernel<LVM_FLOAT2, 2>(pSrc, pDst, NrFrames, mNrChannels,
+                                                        validLanes, pCoefs, pState, nrStages);
+                    break;
+                default:
+                    BiquadCascade_Kernel<LVM_FLOAT4, 4>(pSrc, pDst, NrFrames, mNrChannels,
+                                                        validLanes, pCoefs, pState, nrStages);
+                    break;
+            }
+        }
+    }
+}
+
+void BiquadCascade::processDownmix(const LVM_FLOAT* pIn, LVM_FLOAT* pOut, LVM_INT32 NrFrames,
+                                   LVM_INT32 NrInChannels) {
+    /* Downmix in chunks that stay in the L1 cache, then filter each chunk in place */
+    constexpr LVM_INT32 kChunkFrames = 256;
+    while (NrFrames > 0) {
+        const LVM_INT32 chunk = std::min(NrFrames, kChunkFrames);
+        for (LVM_INT32 n = 0; n < chunk; n++) {
+            LVM_FLOAT sum = 0.0f;
+            for (LVM_INT32 c = 0; c < NrInChannels; c++) {
+                sum += pIn[c];
+            }
+            pOut[n] = sum / NrInChannels;
+            pIn += NrInChannels;
+        }
+        process(pOut, pOut, chunk);
+        pOut += chunk;
+        NrFrames -= chunk;
+    }
+}
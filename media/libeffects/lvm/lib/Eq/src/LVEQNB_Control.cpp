@@ -180,7 +180,6 @@ void LVEQNB_SetCoefficients(LVEQNB_Instance_t* pInstance) {
     LVM_UINT16 i;                    /* Filter band index */
     LVEQNB_BiquadType_en BiquadType; /* Filter biquad type */
 
-    pInstance->gain.resize(pInstance->Params.NBands);
     /*
      * Set the coefficients for each band by the init function
      */
@@ -198,19 +197,17 @@ void LVEQNB_SetCoefficients(LVEQNB_Instance_t* pInstance) {
                 LVEQNB_SinglePrecCoefs((LVM_UINT16)pInstance->Params.SampleRate,
                                        &pInstance->pBandDefinitions[i], &Coefficients);
                 /*
-                 * Set the coefficients
+                 * Set the coefficients, the band is only processed for a non-zero dB gain
                  */
-                pInstance->gain[i] = Coefficients.G;
-                std::array<LVM_FLOAT, android::audio_utils::kBiquadNumCoefs> coefs = {
-                        Coefficients.A0, 0.0, -(Coefficients.A0), -(Coefficients.B1),
-                        -(Coefficients.B2)};
-                pInstance->eqBiquad[i]
-                        .setCoefficients<
-                                std::array<LVM_FLOAT, android::audio_utils::kBiquadNumCoefs>>(
-                                coefs);
+                BiquadCascade::Coefs_t coefs = {Coefficients.A0, 0.0, -(Coefficients.A0),
+                                                -(Coefficients.B1), -(Coefficients.B2)};
+                pInstance->eqCascade.setStage(i, coefs, 1.0f /* DryGain */,
+                                              Coefficients.G /* WetGain */,
+                                              pInstance->pBandDefinitions[i].Gain != 0);
                 break;
             }
             default:
+                pInstance->eqCascade.setStageEnabled(i, false);
                 break;
         }
     }
@@ -228,9 +225,7 @@ void LVEQNB_SetCoefficients(LVEQNB_Instance_t* pInstance) {
 /*                                                                                  */
 /************************************************************************************/
 void LVEQNB_ClearFilterHistory(LVEQNB_Instance_t* pInstance) {
-    for (size_t i = 0; i < pInstance->eqBiquad.size(); i++) {
-        pInstance->eqBiquad[i].clear();
-    }
+    pInstance->eqCascade.clear();
 }
 /****************************************************************************************/
 /*                                                                                      */
@@ -309,10 +304,12 @@ LVEQNB_ReturnStatus_en LVEQNB_Control(LVEQNB_Handle_t hInstance, LVEQNB_Params_t
              LVC_Mixer_GetTarget(&pInstance->BypassMixer.MixerStream[0]) == 0);
 
     /*
-     * Create biquad instance
+     * Size the biquad cascade
      */
-    pInstance->eqBiquad.resize(pParams->NBands,
-                               android::audio_utils::BiquadFilter<LVM_FLOAT>(pParams->NrChannels));
+    if (pInstance->eqCascade.getChannelCount() != pParams->NrChannels) {
+        pInstance->eqCascade.setChannelCount(pParams->NrChannels);
+    }
+    pInstance->eqCascade.resize(pParams->NBands);
     LVEQNB_ClearFilterHistory(pInstance);
 
     if (bChange || modeChange) {
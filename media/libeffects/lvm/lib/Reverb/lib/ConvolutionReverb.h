@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CONVOLUTIONREVERB_H__
+#define __CONVOLUTIONREVERB_H__
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <effects/RadixTwoFft.h>
+
+#include "LVREV.h"
+
+/****************************************************************************************/
+/*                                                                                      */
+/*  Definitions                                                                         */
+/*                                                                                      */
+/****************************************************************************************/
+
+/* Frames per partition of the impulse response. The output is delayed by this many frames. */
+#define CONVREV_PARTITION_SIZE 256
+/*
+ * Maximum number of partitions. The impulse response is as long as T60 at the sample rate up
+ * to this limit, which bounds the memory and the CPU load of an instance. Longer responses are
+ * truncated with a fade over the last partition: the limit is 171 ms at 48 kHz, so the long
+ * decay times of LVREV are cut well before they reach -60 dB.
+ */
+#define CONVREV_MAX_PARTITIONS 32
+/* Blocks between a request for a new impulse response and its use, see process() */
+#define CONVREV_SWAP_DELAY_BLOCKS 4
+
+/****************************************************************************************/
+/*                                                                                      */
+/*  Class                                                                               */
+/*                                                                                      */
+/****************************************************************************************/
+
+/*
+ * Reverb that convolves the input with a stereo impulse response, using uniformly
+ * partitioned overlap-save FFT convolution.
+ *
+ * It takes the same control parameters as LVREV. The impulse response is synthesized from
+ * them: two decorrelated velvet noise sequences shaped by an exponential decay of length T60,
+ * a faster decay above the damping frequency, a build-up time that grows with the room size
+ * and the LPF and HPF corners. The input is mixed to mono as in LVREV and the output is
+ * stereo.
+ *
+ * The input spectra of the last CONVREV_PARTITION_SIZE * CONVREV_MAX_PARTITIONS frames are
+ * kept in a frequency domain delay line. Every CONVREV_PARTITION_SIZE frames the new input
+ * block is transformed and multiplied with the spectrum of every partition of the impulse
+ * response, four bins at a time, so the work per block depends only on the impulse response
+ * length.
+ *
+ * The impulse response is synthesized and transformed on a thread owned by the instance, so
+ * setting the control parameters does not block processing. process() swaps the new response
+ * in CONVREV_SWAP_DELAY_BLOCKS blocks after it was requested, which keeps the output
+ * independent of the thread timing. If the response is not ready by then, process() keeps
+ * the current one and retries on the next block, it never waits for the builder.
+ */
+class ConvolutionReverb {
+  public:
+    ConvolutionReverb();
+    ~ConvolutionReverb();
+
+    /*
+     * Set the control parameters. Returns LVREV_OUTOFRANGE for the same values that
+     * LVREV_SetControlParameters rejects.
+     */
+    LVREV_ReturnStatus_en setControlParameters(const LVREV_ControlParams_st* pNewParams);
+    LVREV_ReturnStatus_en getControlParameters(LVREV_ControlParams_st* pControlParams) const;
+
+    /*
+     * Replace the synthesized impulse response, eg. by a measured one. Responses longer than
+     * CONVREV_MAX_PARTITIONS partitions are truncated. The response is transformed on the
+     * calling thread and kept until a control parameter other than the level, the operating
+     * mode or the source format changes.
+     */
+    LVREV_ReturnStatus_en setImpulseResponse(const LVM_FLOAT* pLeft, const LVM_FLOAT* pRight,
+                                             LVM_INT32 Length);
+
+    /* Number of partitions of the impulse response in use */
+    LVM_INT32 getPartitionCount() const;
+
+    /* Clear the input history and the pending output */
+    void clear();
+
+    /*
+     * Process NumSamples frames of mono or stereo input, depending on the SourceFormat,
+     * into stereo output. Returns LVREV_NULLADDRESS if the control parameters were never set.
+     */
+    LVREV_ReturnStatus_en process(const LVM_FLOAT* pInput, LVM_FLOAT* pOutput,
+                                  LVM_UINT16 NumSamples);
+
+  private:
+    typedef LVM_FLOAT Float4 __attribute__((vector_size(4 * sizeof(LVM_FLOAT))));
+
+    struct ImpulseResponse {
+        LVM_INT32 NrPartitions;
+        /* Spectrum of each partition, [partition][left re, left im, right re, right im][bin] */
+        std::vector<Float4> Spectra;
+    };
+
+    std::unique_ptr<ImpulseResponse> synthesizeImpulseResponse(
+            const LVREV_ControlParams_st& params) const;
+    std::unique_ptr<ImpulseResponse> loadPartitions(const LVM_FLOAT* const* pIr,
+                                                    LVM_INT32 Length) const;
+    void publishImpulseResponse(std::unique_ptr<ImpulseResponse> response, uint32_t generation);
+    void installImpulseResponse();
+    void builderLoop();
+    void processBlock();
+
+    LVREV_ControlParams_st mParams{};
+    bool mConfigured = false;
+
+    /* Impulse response in use, only accessed by process() */
+    std::unique_ptr<ImpulseResponse> mResponse;
+    /* Generation of the last requested response and of mResponse */
+    uint32_t mRequestedGeneration = 0;
+    uint32_t mInstalledGeneration = 0;
+    /* Generation counted down by mSwapCountdown */
+    uint32_t mCountdownGeneration = 0;
+    LVM_INT32 mSwapCountdown = 0;
+
+    /* Hand over between the builder thread and process() */
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    LVREV_ControlParams_st mBuildParams{};  /* guarded by mLock */
+    uint32_t mBuildGeneration = 0;          /* guarded by mLock, 0 if there is nothing to build */
+    std::unique_ptr<ImpulseResponse> mPending;  /* guarded by mLock */
+    uint32_t mPendingGeneration = 0;            /* guarded by mLock */
+    /* Response replaced by process(), freed by the builder thread. Guarded by mLock */
+    std::unique_ptr<ImpulseResponse> mRetired;
+    bool mExit = false;  /* guarded by mLock */
+    std::thread mBuilder;
+
+    /* Input spectra, [partition][re, im][bin], mFdlHead is the newest one */
+    std::vector<Float4> mFdl;
+    LVM_INT32 mFdlHead = 0;
+    /* Output spectra, [left re, left im, right re, right im][bin] */
+    std::vector<Float4> mAccumulator;
+
+    /* FFT of 2 * CONVREV_PARTITION_SIZE points. Read only after construction */
+    android::effects::ComplexFft<LVM_FLOAT> mFft;
+    /* FFT work buffers of process() */
+    std::vector<LVM_FLOAT> mTimeRe;
+    std::vector<LVM_FLOAT> mTimeIm;
+
+    /* Input of the previous and the current block, and the stereo output of the last block */
+    std::vector<LVM_FLOAT> mInput;
+    std::vector<LVM_FLOAT> mOutput;
+    LVM_INT32 mBlockFill = 0;
+
+    /* Level, ramped to a new value over one partition */
+    LVM_FLOAT mGain = 0.0f;
+    LVM_FLOAT mTargetGain = 0.0f;
+    LVM_FLOAT mGainStep = 0.0f;
+};
+
+#endif /* __CONVOLUTIONREVERB_H__ */
@@ -0,0 +1,463 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/****************************************************************************************/
+/*                                                                                      */
+/*  Includes                                                                            */
+/*                                                                                      */
+/****************************************************************************************/
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <random>
+
+#include "ConvolutionReverb.h"
+#include "LVREV_Private.h"
+#include "LVREV_Tables.h"
+#include "VectorArithmetic.h"
+
+/****************************************************************************************/
+/*                                                                                      */
+/*  Definitions                                                                         */
+/*                                                                                      */
+/****************************************************************************************/
+
+#define CONVREV_FFT_SIZE (2 * CONVREV_PARTITION_SIZE)
+/* Bins 0 to N/2 of the real input, rounded up to whole vectors */
+#define CONVREV_NUM_BINS (CONVREV_PARTITION_SIZE + 1)
+#define CONVREV_BIN_VECTORS ((CONVREV_NUM_BINS + 3) / 4)
+
+/* Decay time above the damping frequency, relative to T60 */
+#define CONVREV_HF_DECAY_RATIO 0.3f
+/* Velvet noise pulses per second at density 0 and per percent of density */
+#define CONVREV_MIN_PULSE_RATE 500.0f
+#define CONVREV_PULSE_RATE_STEP 25.0f
+/* ln(0.001), the decay over T60 */
+#define CONVREV_LN_MINUS_60DB (-6.9077553f)
+
+/****************************************************************************************/
+/*                                                                                      */
+/*  Local functions                                                                     */
+/*                                                                                      */
+/****************************************************************************************/
+
+/* Coefficient of a one pole low pass filter y += (1 - a) * (x - y) */
+static LVM_FLOAT ConvRev_OnePole(LVM_FLOAT Frequency, LVM_FLOAT Fs) {
+    return expf(-2.0f * (LVM_FLOAT)M_PI * Frequency / Fs);
+}
+
+/****************************************************************************************/
+/*                                                                                      */
+/*  Class methods                                                                       */
+/*                                                                                      */
+/****************************************************************************************/
+
+ConvolutionReverb::ConvolutionReverb()
+    : mFdl(CONVREV_MAX_PARTITIONS * 2 * CONVREV_BIN_VECTORS),
+      mAccumulator(4 * CONVREV_BIN_VECTORS),
+      mTimeRe(CONVREV_FFT_SIZE),
+      mTimeIm(CONVREV_FFT_SIZE),
+      mInput(2 * CONVREV_PARTITION_SIZE),
+      mOutput(FCC_2 * CONVREV_PARTITION_SIZE) {
+    mFft.configure(CONVREV_FFT_SIZE);
+    mBuilder = std::thread(&ConvolutionReverb::builderLoop, this);
+}
+
+ConvolutionReverb::~ConvolutionReverb() {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mExit = true;
+    }
+    mCondition.notify_all();
+    mBuilder.join();
+}
+
+LVREV_ReturnStatus_en ConvolutionReverb::setControlParameters(
+        const LVREV_ControlParams_st* pNewParams) {
+    if (pNewParams == LVM_NULL) {
+        return LVREV_NULLADDRESS;
+    }
+    if ((pNewParams->OperatingMode != LVM_MODE_OFF && pNewParams->OperatingMode != LVM_MODE_ON) ||
+        pNewParams->SampleRate > LVM_FS_192000 ||
+        (pNewParams->SourceFormat != LVM_STEREO && pNewParams->SourceFormat != LVM_MONOINSTEREO &&
+         pNewParams->SourceFormat != LVM_MONO && pNewParams->SourceFormat != LVM_MULTICHANNEL) ||
+        pNewParams->Level > LVREV_MAX_LEVEL || pNewParams->LPF < LVREV_MIN_LPF_CORNER ||
+        pNewParams->LPF > LVREV_MAX_LPF_CORNER || pNewParams->HPF < LVREV_MIN_HPF_CORNER ||
+        pNewParams->HPF > LVREV_MAX_HPF_CORNER || pNewParams->T60 > LVREV_MAX_T60 ||
+        pNewParams->Density > LVREV_MAX_DENSITY || pNewParams->Damping > LVREV_MAX_DAMPING ||
+        pNewParams->RoomSize > LVREV_MAX_ROOMSIZE) {
+        return LVREV_OUTOFRANGE;
+    }
+
+    const bool newRate = !mConfigured || pNewParams->SampleRate != mParams.SampleRate;
+    const bool newResponse = newRate || pNewParams->LPF != mParams.LPF ||
+                             pNewParams->HPF != mParams.HPF || pNewParams->T60 != mParams.T60 ||
+                             pNewParams->Density != mParams.Density ||
+                             pNewParams->Damping != mParams.Damping ||
+                             pNewParams->RoomSize != mParams.RoomSize;
+
+    mTargetGain = (LVM_FLOAT)pNewParams->Level / 100.0f;
+    if (!mConfigured) {
+        mGain = mTargetGain;
+    }
+    mGainStep = (mTargetGain - mGain) / CONVREV_PARTITION_SIZE;
+    mParams = *pNewParams;
+    mConfigured = true;
+
+    if (newResponse) {
+        /* Only hand the parameters over, the builder thread does the work */
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mBuildParams = mParams;
+            mBuildGeneration = ++mRequestedGeneration;
+        }
+        mCondition.notify_all();
+    }
+    if (newRate) {
+        clear();
+    }
+    return LVREV_SUCCESS;
+}
+
+LVREV_ReturnStatus_en ConvolutionReverb::getControlParameters(
+        LVREV_ControlParams_st* pControlParams) const {
+    if (pControlParams == LVM_NULL) {
+        return LVREV_NULLADDRESS;
+    }
+    *pControlParams = mParams;
+    return LVREV_SUCCESS;
+}
+
+LVREV_ReturnStatus_en ConvolutionReverb::setImpulseResponse(const LVM_FLOAT* pLeft,
+                                                            const LVM_FLOAT* pRight,
+                                                            LVM_INT32 Length) {
+    if (pLeft == LVM_NULL || pRight == LVM_NULL) {
+        return LVREV_NULLADDRESS;
+    }
+    if (Length <= 0) {
+        return LVREV_OUTOFRANGE;
+    }
+    const LVM_FLOAT* ir[FCC_2] = {pLeft, pRight};
+    publishImpulseResponse(loadPartitions(ir, Length), ++mRequestedGeneration);
+    return LVREV_SUCCESS;
+}
+
+LVM_INT32 ConvolutionReverb::getPartitionCount() const {
+    return mResponse ? mResponse->NrPartitions : 0;
+}
+
+void ConvolutionReverb::clear() {
+    std::fill(mFdl.begin(), mFdl.end(), Float4{});
+    std::fill(mInput.begin(), mInput.end(), 0.0f);
+    std::fill(mOutput.begin(), mOutput.end(), 0.0f);
+    mBlockFill = 0;
+}
+
+std::unique_ptr<ConvolutionReverb::ImpulseResponse> ConvolutionReverb::synthesizeImpulseResponse(
+        const LVREV_ControlParams_st& params) const {
+    const LVM_FLOAT fs = (LVM_FLOAT)LVM_GetFsFromTable(params.SampleRate);
+    const LVM_FLOAT t60 = std::max((LVM_FLOAT)params.T60, 1.0f) * fs / 1000.0f;
+    const LVM_INT32 length = std::max(
+            std::min((LVM_INT32)ceilf(t60), CONVREV_MAX_PARTITIONS * CONVREV_PARTITION_SIZE),
+            (LVM_INT32)1);
+
+    const LVM_FLOAT lowDecay = expf(CONVREV_LN_MINUS_60DB / t60);
+    const LVM_FLOAT highDecay = expf(CONVREV_LN_MINUS_60DB / (t60 * CONVREV_HF_DECAY_RATIO));
+    /* Same corner as the LVREV damping filter */
+    const LVM_FLOAT crossover =
+            ConvRev_OnePole(std::min(params.Damping * 100.0f + 1000.0f, 0.45f * fs), fs);
+    /* The diffuse tail builds up over the room size time of LVREV */
+    const LVM_FLOAT roomSizeInms = 10.0f + (LVM_FLOAT)((params.RoomSize * 11 + 5) / 10);
+    const LVM_FLOAT buildUp = expf(-3000.0f / (roomSizeInms * fs));
+    const LVM_FLOAT lowPass =
+            params.LPF < fs / 2 ? ConvRev_OnePole((LVM_FLOAT)params.LPF, fs) : 0.0f;
+    const LVM_FLOAT highPass = ConvRev_OnePole((LVM_FLOAT)params.HPF, fs);
+    const LVM_FLOAT pulseSpacing =
+            fs / (CONVREV_MIN_PULSE_RATE + CONVREV_PULSE_RATE_STEP * params.Density);
+    const LVM_INT32 fadeLength = std::min(length, (LVM_INT32)CONVREV_PARTITION_SIZE);
+
+    std::vector<LVM_FLOAT> ir[FCC_2];
+    for (LVM_INT32 channel = 0; channel < FCC_2; channel++) {
+        std::vector<LVM_FLOAT>& h = ir[channel];
+        h.assign(length, 0.0f);
+
+        /* Velvet noise, one pulse of random sign at a random position in every period.
+         * A different sequence per channel decorrelates left and right. */
+        std::minstd_rand gen(channel + 1);
+        std::uniform_real_distribution<LVM_FLOAT> dis(0.0f, 1.0f);
+        for (LVM_FLOAT period = 0.0f; period < length; period += pulseSpacing) {
+            const LVM_INT32 n = (LVM_INT32)(period + dis(gen) * pulseSpacing);
+            const LVM_FLOAT pulse = dis(gen) < 0.5f ? -1.0f : 1.0f;
+            if (n < length) {
+                h[n] = pulse;
+            }
+        }
+
+        LVM_FLOAT low = 0.0f, lowEnvelope = 1.0f, highEnvelope = 1.0f, attack = 1.0f;
+        LVM_FLOAT lpfState = 0.0f, hpfState = 0.0f, energy = 0.0f;
+        for (LVM_INT32 n = 0; n < length; n++) {
+            /* Two band decay */
+            low += (1.0f - crossover) * (h[n] - low);
+            LVM_FLOAT y = low * lowEnvelope + (h[n] - low) * highEnvelope;
+            lowEnvelope *= lowDecay;
+            highEnvelope *= highDecay;
+            y *= 1.0f - attack;
+            attack *= buildUp;
+
+            lpfState += (1.0f - lowPass) * (y - lpfState);
+            y = lpfState;
+            hpfState += (1.0f - highPass) * (y - hpfState);
+            y -= hpfState;
+
+            if (n >= length - fadeLength) {
+                y *= (LVM_FLOAT)(length - n) / fadeLength;
+            }
+            h[n] = y;
+            energy += y * y;
+        }
+
+        /* Unit energy, so white noise keeps its power at level 100 */
+        const LVM_FLOAT scale = energy > 0.0f ? 1.0f / sqrtf(energy) : 0.0f;
+        for (auto& sample : h) {
+            sample *= scale;
+        }
+    }
+
+    const LVM_FLOAT* pIr[FCC_2] = {ir[0].data(), ir[1].data()};
+    return loadPartitions(pIr, length);
+}
+
+std::unique_ptr<ConvolutionReverb::ImpulseResponse> ConvolutionReverb::loadPartitions(
+        const LVM_FLOAT* const* pIr, LVM_INT32 Length) const {
+    auto response = std::make_unique<ImpulseResponse>();
+    response->NrPartitions =
+            std::min((Length + CONVREV_PARTITION_SIZE - 1) / CONVREV_PARTITION_SIZE,
+                     (LVM_INT32)CONVREV_MAX_PARTITIONS);
+    response->Spectra.assign(response->NrPartitions * 4 * CONVREV_BIN_VECTORS, Float4{});
+    Length = std::min(Length, response->NrPartitions * CONVREV_PARTITION_SIZE);
+
+    /* The 1 / N scaling of the inverse FFT is applied to the spectra */
+    const LVM_FLOAT scale = 1.0f / CONVREV_FFT_SIZE;
+    std::vector<LVM_FLOAT> timeRe(CONVREV_FFT_SIZE);
+    std::vector<LVM_FLOAT> timeIm(CONVREV_FFT_SIZE);
+    for (LVM_INT32 p = 0; p < response->NrPartitions; p++) {
+        for (LVM_INT32 channel = 0; channel < FCC_2; channel++) {
+            const LVM_INT32 offset = p * CONVREV_PARTITION_SIZE;
+            const LVM_INT32 count = std::min((LVM_INT32)CONVREV_PARTITION_SIZE, Length - offset);
+            std::fill(timeRe.begin(), timeRe.end(), 0.0f);
+            std::fill(timeIm.begin(), timeIm.end(), 0.0f);
+            std::copy(pIr[channel] + offset, pIr[channel] + offset + count, timeRe.begin());
+            mFft.transform(timeRe.data(), timeIm.data(), false /* inverse */);
+
+            Float4* pRe = &response->Spectra[(p * 4 + 2 * channel) * CONVREV_BIN_VECTORS];
+            Float4* pIm = pRe + CONVREV_BIN_VECTORS;
+            for (LVM_INT32 k = 0; k < CONVREV_BIN_VECTORS * 4; k++) {
+                pRe[k / 4][k % 4] = k < CONVREV_NUM_BINS ? timeRe[k] * scale : 0.0f;
+                pIm[k / 4][k % 4] = k < CONVREV_NUM_BINS ? timeIm[k] * scale : 0.0f;
+            }
+        }
+    }
+    return response;
+}
+
+void ConvolutionReverb::publishImpulseResponse(std::unique_ptr<ImpulseResponse> response,
+                                               uint32_t generation) {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        /* A newer response may have been published while this one was built */
+        if (generation > mPendingGeneration) {
+            std::swap(mPending, response);
+            mPendingGeneration = generation;
+        }
+    }
+    mCondition.notify_all();
+    /* Any replaced response is freed here, on the publishing thread */
+}
+
+void ConvolutionReverb::installImpulseResponse() {
+    /* Never block the audio thread: if the builder holds the lock, fell behind or has not
+       freed the previous response yet, keep the current response and retry next block */
+    std::unique_lock<std::mutex> lock(mLock, std::try_to_lock);
+    if (!lock.owns_lock() || mPendingGeneration != mRequestedGeneration || mRetired != nullptr) {
+        return;
+    }
+    mRetired = std::move(mResponse);
+    mResponse = std::move(mPending);
+    mInstalledGeneration = mPendingGeneration;
+    lock.unlock();
+    /* The builder thread frees the replaced response */
+    mCondition.notify_all();
+}
+
+void ConvolutionReverb::builderLoop() {
+    std::unique_lock<std::mutex> lock(mLock);
+    uint32_t builtGeneration = 0;
+    while (!mExit) {
+        if (mRetired != nullptr) {
+            std::unique_ptr<ImpulseResponse> retired = std::move(mRetired);
+            lock.unlock();
+            retired.reset();
+            mCondition.notify_all();
+            lock.lock();
+        } else if (mBuildGeneration != builtGeneration) {
+            builtGeneration = mBuildGeneration;
+            const LVREV_ControlParams_st params = mBuildParams;
+            lock.unlock();
+            publishImpulseResponse(synthesizeImpulseResponse(params), builtGeneration);
+            lock.lock();
+        } else {
+            mCondition.wait(lock);
+        }
+    }
+}
+
+void ConvolutionReverb::processBlock() {
+    /* Swap in a new impulse response a fixed number of blocks after the last request */
+    if (mInstalledGeneration != mRequestedGeneration) {
+        if (mCountdownGeneration != mRequestedGeneration) {
+            mCountdownGeneration = mRequestedGeneration;
+            mSwapCountdown = CONVREV_SWAP_DELAY_BLOCKS;
+        }
+        /* Retried on every block until the response is ready */
+        if (--mSwapCountdown <= 0) {
+            installImpulseResponse();
+        }
+    }
+
+    /* Overlap-save: transform the previous and the current block */
+    std::copy(mInput.begin(), mInput.end(), mTimeRe.begin());
+    std::fill(mTimeIm.begin(), mTimeIm.end(), 0.0f);
+    mFft.transform(mTimeRe.data(), mTimeIm.data(), false /* inverse */);
+
+    Float4* pNewRe = &mFdl[mFdlHead * 2 * CONVREV_BIN_VECTORS];
+    Float4* pNewIm = pNewRe + CONVREV_BIN_VECTORS;
+    for (LVM_INT32 k = 0; k < CONVREV_BIN_VECTORS * 4; k++) {
+        pNewRe[k / 4][k % 4] = k < CONVREV_NUM_BINS ? mTimeRe[k] : 0.0f;
+        pNewIm[k / 4][k % 4] = k < CONVREV_NUM_BINS ? mTimeIm[k] : 0.0f;
+    }
+
+    /* Complex multiply-accumulate of every input spectrum with its partition */
+    Float4* pLeftRe = &mAccumulator[0];
+    Float4* pLeftIm = pLeftRe + CONVREV_BIN_VECTORS;
+    Float4* pRightRe = pLeftIm + CONVREV_BIN_VECTORS;
+    Float4* pRightIm = pRightRe + CONVREV_BIN_VECTORS;
+    std::fill(mAccumulator.begin(), mAccumulator.end(), Float4{});
+    const LVM_INT32 nrPartitions = mResponse ? mResponse->NrPartitions : 0;
+    for (LVM_INT32 p = 0; p < nrPartitions; p++) {
+        LVM_INT32 slot = mFdlHead - p;
+        if (slot < 0) {
+            slot += CONVREV_MAX_PARTITIONS;
+        }
+        const Float4* pXRe = &mFdl[slot * 2 * CONVREV_BIN_VECTORS];
+        const Float4* pXIm = pXRe + CONVREV_BIN_VECTORS;
+        const Float4* pHLeftRe = &mResponse->Spectra[p * 4 * CONVREV_BIN_VECTORS];
+        const Float4* pHLeftIm = pHLeftRe + CONVREV_BIN_VECTORS;
+        const Float4* pHRightRe = pHLeftIm + CONVREV_BIN_VECTORS;
+        const Float4* pHRightIm = pHRightRe + CONVREV_BIN_VECTORS;
+        for (LVM_INT32 v = 0; v < CONVREV_BIN_VECTORS; v++) {
+            const Float4 xr = pXRe[v];
+            const Float4 xi = pXIm[v];
+            pLeftRe[v] += xr * pHLeftRe[v] - xi * pHLeftIm[v];
+            pLeftIm[v] += xr * pHLeftIm[v] + xi * pHLeftRe[v];
+            pRightRe[v] += xr * pHRightRe[v] - xi * pHRightIm[v];
+            pRightIm[v] += xr * pHRightIm[v] + xi * pHRightRe[v];
+        }
+    }
+    mFdlHead = mFdlHead + 1 < CONVREV_MAX_PARTITIONS ? mFdlHead + 1 : 0;
+
+    /* Both outputs are real, so one inverse FFT of left + i * right gives left in the real
+     * part and right in the imaginary part. The upper bins follow from conjugate symmetry. */
+    for (LVM_INT32 k = 0; k < CONVREV_NUM_BINS; k++) {
+        mTimeRe[k] = pLeftRe[k / 4][k % 4] - pRightIm[k / 4][k % 4];
+        mTimeIm[k] = pLeftIm[k / 4][k % 4] + pRightRe[k / 4][k % 4];
+    }
+    for (LVM_INT32 k = CONVREV_NUM_BINS; k < CONVREV_FFT_SIZE; k++) {
+        const LVM_INT32 m = CONVREV_FFT_SIZE - k;
+        mTimeRe[k] = pLeftRe[m / 4][m % 4] + pRightIm[m / 4][m % 4];
+        mTimeIm[k] = pRightRe[m / 4][m % 4] - pLeftIm[m / 4][m % 4];
+    }
+    mFft.transform(mTimeRe.data(), mTimeIm.data(), true /* inverse */);
+
+    for (LVM_INT32 j = 0; j < CONVREV_PARTITION_SIZE; j++) {
+        mOutput[FCC_2 * j] = mTimeRe[CONVREV_PARTITION_SIZE + j];
+        mOutput[FCC_2 * j + 1] = mTimeIm[CONVREV_PARTITION_SIZE + j];
+    }
+    std::copy(mInput.begin() + CONVREV_PARTITION_SIZE, mInput.end(), mInput.begin());
+}
+
+LVREV_ReturnStatus_en ConvolutionReverb::process(const LVM_FLOAT* pInput, LVM_FLOAT* pOutput,
+                                                 LVM_UINT16 NumSamples) {
+    if (pInput == LVM_NULL || pOutput == LVM_NULL || !mConfigured) {
+        return LVREV_NULLADDRESS;
+    }
+
+    const bool mono = mParams.SourceFormat == LVM_MONO;
+    if (mParams.OperatingMode == LVM_MODE_OFF) {
+        /* Same as LVREV, copy the input to the stereo output */
+        if (pInput != pOutput) {
+            if (mono) {
+                MonoTo2I_Float(pInput, pOutput, NumSamples);
+            } else {
+                Copy_Float(pInput, pOutput, (LVM_INT16)(NumSamples * FCC_2));
+            }
+        }
+        return LVREV_SUCCESS;
+    }
+
+    LVM_INT32 remaining = NumSamples;
+    while (remaining > 0) {
+        const LVM_INT32 n = std::min(remaining, CONVREV_PARTITION_SIZE - mBlockFill);
+
+        /* Read all input frames before writing, the buffers may be the same */
+        LVM_FLOAT* pBlockIn = &mInput[CONVREV_PARTITION_SIZE + mBlockFill];
+        if (mono) {
+            std::copy(pInput, pInput + n, pBlockIn);
+            pInput += n;
+        } else {
+            for (LVM_INT32 i = 0; i < n; i++) {
+                pBlockIn[i] = 0.5f * (pInput[FCC_2 * i] + pInput[FCC_2 * i + 1]);
+            }
+            pInput += FCC_2 * n;
+        }
+
+        const LVM_FLOAT* pBlockOut = &mOutput[FCC_2 * mBlockFill];
+        if (mGain == mTargetGain) {
+            for (LVM_INT32 i = 0; i < FCC_2 * n; i++) {
+                pOutput[i] = pBlockOut[i] * mGain;
+            }
+        } else {
+            for (LVM_INT32 i = 0; i < n; i++) {
+                mGain += mGainStep;
+                if ((mGainStep > 0.0f && mGain > mTargetGain) ||
+                    (mGainStep < 0.0f && mGain < mTargetGain)) {
+                    mGain = mTargetGain;
+                }
+                pOutput[FCC_2 * i] = pBlockOut[FCC_2 * i] * mGain;
+                pOutput[FCC_2 * i + 1] = pBlockOut[FCC_2 * i + 1] * mGain;
+            }
+        }
+        pOutput += FCC_2 * n;
+
+        mBlockFill += n;
+        remaining -= n;
+        if (mBlockFill == CONVREV_PARTITION_SIZE) {
+            processBlock();
+            mBlockFill = 0;
+        }
+    }
+    return LVREV_SUCCESS;
+}
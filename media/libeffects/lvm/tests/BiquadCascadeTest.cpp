@@ -0,0 +1,131 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include <audio_utils/BiquadFilter.h>
+#include <gtest/gtest.h>
+
+#include "BiquadCascade.h"
+
+using namespace android;
+
+constexpr LVM_FLOAT kSampleRate = 48000;
+// Equalizer bands, a 0 dB band is disabled as in LVEQNB_SetCoefficients()
+constexpr LVM_FLOAT kBandFrequencies[] = {60, 230, 910, 3600, 14000};
+constexpr LVM_FLOAT kBandGainsDb[] = {6, -3, 0, 9, -12};
+constexpr LVM_FLOAT kBandQ = 0.96f;
+constexpr size_t kNumBands = std::size(kBandFrequencies);
+
+// Block sizes processed in turn, so that the state is carried across calls
+constexpr LVM_INT32 kBlockSizes[] = {1, 17, 240, 64, 3, 480};
+constexpr size_t kNumBlocks = 12;
+
+// A band pass with 0 dB peak gain, in the LVEQNB form {A0, 0, -A0, a1, a2}.
+static BiquadCascade::Coefs_t bandPassCoefs(LVM_FLOAT frequency) {
+    const double w0 = 2 * M_PI * frequency / kSampleRate;
+    const double alpha = sin(w0) / (2 * kBandQ);
+    const double a0 = 1 + alpha;
+    return {(LVM_FLOAT)(alpha / a0), 0.0f, (LVM_FLOAT)(-alpha / a0),
+            (LVM_FLOAT)(-2 * cos(w0) / a0), (LVM_FLOAT)((1 - alpha) / a0)};
+}
+
+// The band gain G of LVEQNB, the band adds G times its band passed input.
+static LVM_FLOAT bandGain(LVM_FLOAT gainDb) {
+    return powf(10.0f, gainDb / 20.0f) - 1.0f;
+}
+
+// The equalizer as LVEQNB_Process() ran it before BiquadCascade: the input is copied, then
+// each band with a non-zero gain filters the result and adds it, scaled by the band gain.
+class ReferenceEqualizer {
+  public:
+    explicit ReferenceEqualizer(LVM_INT32 channelCount) : mChannelCount(channelCount) {
+        for (size_t i = 0; i < kNumBands; i++) {
+            mBiquads.emplace_back(channelCount);
+            const BiquadCascade::Coefs_t coefs = bandPassCoefs(kBandFrequencies[i]);
+            mBiquads[i].setCoefficients(
+                    std::array<LVM_FLOAT, audio_utils::kBiquadNumCoefs>{
+                            coefs[0], coefs[1], coefs[2], coefs[3], coefs[4]});
+        }
+    }
+
+    void process(const LVM_FLOAT* in, LVM_FLOAT* out, LVM_INT32 frameCount) {
+        const size_t sampleCount = (size_t)frameCount * mChannelCount;
+        std::copy(in, in + sampleCount, out);
+        mTemp.resize(sampleCount);
+        for (size_t i = 0; i < kNumBands; i++) {
+            if (kBandGainsDb[i] == 0) {
+                continue;
+            }
+            mBiquads[i].process(mTemp.data(), out, frameCount);
+            const LVM_FLOAT gain = bandGain(kBandGainsDb[i]);
+            for (size_t j = 0; j < sampleCount; j++) {
+                out[j] += mTemp[j] * gain;
+            }
+        }
+    }
+
+  private:
+    const LVM_INT32 mChannelCount;
+    std::vector<audio_utils::BiquadFilter<LVM_FLOAT>> mBiquads;
+    std::vector<LVM_FLOAT> mTemp;
+};
+
+class BiquadCascadeTest : public ::testing::TestWithParam<LVM_INT32> {};
+
+// Runs the equalizer bands through BiquadCascade and the reference in blocks of varying
+// sizes, and compares the outputs.
+TEST_P(BiquadCascadeTest, MatchesEqualizerBands) {
+    const LVM_INT32 channelCount = GetParam();
+    BiquadCascade cascade(channelCount);
+    cascade.resize(kNumBands);
+    for (size_t i = 0; i < kNumBands; i++) {
+        cascade.setStage(i, bandPassCoefs(kBandFrequencies[i]), 1.0f /* DryGain */,
+                         bandGain(kBandGainsDb[i]) /* WetGain */, kBandGainsDb[i] != 0);
+    }
+    ASSERT_EQ((LVM_INT32)kNumBands - 1, cascade.getActiveStageCount());
+    ReferenceEqualizer reference(channelCount);
+
+    std::minstd_rand gen(channelCount);
+    std::uniform_real_distribution<LVM_FLOAT> dis(-1.0f, 1.0f);
+    LVM_FLOAT maxDiff = 0.0f;
+    for (size_t block = 0; block < kNumBlocks; block++) {
+        const LVM_INT32 frameCount = kBlockSizes[block % std::size(kBlockSizes)];
+        std::vector<LVM_FLOAT> input(frameCount * channelCount);
+        for (auto& sample : input) {
+            sample = dis(gen);
+        }
+        std::vector<LVM_FLOAT> expected(input.size());
+        reference.process(input.data(), expected.data(), frameCount);
+        // odd blocks are processed in place
+        std::vector<LVM_FLOAT> output(input);
+        cascade.process(block % 2 ? output.data() : input.data(), output.data(), frameCount);
+        for (size_t j = 0; j < output.size(); j++) {
+            maxDiff = std::max(maxDiff, std::abs(output[j] - expected[j]));
+        }
+    }
+    // The cascade only differs by float rounding, which the poles of the 60 Hz band, close
+    // to the unit circle, amplify to about 1e-5.
+    EXPECT_LT(maxDiff, 1e-4f) << "channel count " << channelCount;
+}
+
+INSTANTIATE_TEST_SUITE_P(BiquadCascade, BiquadCascadeTest,
+                         ::testing::Values(1, 2, 3, 4, 5, 6, 8, 12, 24));
@@ -29,13 +29,22 @@ constexpr effect_uuid_t kEffectUuids[] = {
         {0x4a387fc0, 0x8ab3, 0x11df, 0x8bad, {0x00, 0x02, 0xa5, 0xd5, 0xc5, 0x1b}},
         // NXP SW auxiliary preset reverb
         {0xf29a1400, 0xa3bb, 0x11df, 0x8ddc, {0x00, 0x02, 0xa5, 0xd5, 0xc5, 0x1b}},
+        // Convolution insert environmental reverb
+        {0xefce94de, 0xd444, 0x4f35, 0xbb9a, {0xa5, 0x04, 0xca, 0x6c, 0xee, 0x7c}},
+        // Convolution insert preset reverb
+        {0x51494ad1, 0xe3cf, 0x4f3a, 0x98d4, {0xe6, 0x1a, 0x8f, 0x9f, 0xbe, 0xf1}},
+        // Convolution auxiliary environmental reverb
+        {0xb3d2efa4, 0x150e, 0x4597, 0xb4ae, {0x91, 0x88, 0x0b, 0x8b, 0xd8, 0x7c}},
+        // Convolution auxiliary preset reverb
+        {0xb02befd5, 0x5b36, 0x4458, 0xb66d, {0x61, 0x8a, 0xf5, 0x1f, 0xc7, 0x03}},
 };
 
 constexpr size_t kNumEffectUuids = std::size(kEffectUuids);
 
 static bool isAuxMode(const effect_uuid_t* uuid) {
     // Update this, if the order of effects in kEffectUuids is updated
-    return (uuid == &kEffectUuids[2] || uuid == &kEffectUuids[3]);
+    return (uuid == &kEffectUuids[2] || uuid == &kEffectUuids[3] || uuid == &kEffectUuids[6] ||
+            uuid == &kEffectUuids[7]);
 }
 
 constexpr int kPresets[] = {
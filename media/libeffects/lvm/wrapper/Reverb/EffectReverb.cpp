@@ -32,6 +32,7 @@ typedef float LVM_FLOAT;
 
 #include "EffectReverb.h"
 // from Reverb/lib
+#include "ConvolutionReverb.h"
 #include "LVREV.h"
 #include "VectorArithmetic.h"
 
@@ -132,10 +133,60 @@ static const effect_descriptor_t gInsertPresetReverbDescriptor = {
         "NXP Software Ltd.",
 };
 
+// Convolution auxiliary environmental reverb
+static const effect_descriptor_t gAuxEnvConvReverbDescriptor = {
+        {0xc2e5d5f0, 0x94bd, 0x4763, 0x9cac, {0x4e, 0x23, 0x4d, 0x06, 0x83, 0x9e}},
+        {0xb3d2efa4, 0x150e, 0x4597, 0xb4ae, {0x91, 0x88, 0x0b, 0x8b, 0xd8, 0x7c}},
+        EFFECT_CONTROL_API_VERSION,
+        EFFECT_FLAG_TYPE_AUXILIARY,
+        CONVREV_CPU_LOAD_ARM9E,
+        CONVREV_MEM_USAGE,
+        "Auxiliary Environmental Convolution Reverb",
+        "The Android Open Source Project",
+};
+
+// Convolution insert environmental reverb
+static const effect_descriptor_t gInsertEnvConvReverbDescriptor = {
+        {0xc2e5d5f0, 0x94bd, 0x4763, 0x9cac, {0x4e, 0x23, 0x4d, 0x06, 0x83, 0x9e}},
+        {0xefce94de, 0xd444, 0x4f35, 0xbb9a, {0xa5, 0x04, 0xca, 0x6c, 0xee, 0x7c}},
+        EFFECT_CONTROL_API_VERSION,
+        EFFECT_FLAG_TYPE_INSERT | EFFECT_FLAG_INSERT_FIRST | EFFECT_FLAG_VOLUME_CTRL,
+        CONVREV_CPU_LOAD_ARM9E,
+        CONVREV_MEM_USAGE,
+        "Insert Environmental Convolution Reverb",
+        "The Android Open Source Project",
+};
+
+// Convolution auxiliary preset reverb
+static const effect_descriptor_t gAuxPresetConvReverbDescriptor = {
+        {0x47382d60, 0xddd8, 0x11db, 0xbf3a, {0x00, 0x02, 0xa5, 0xd5, 0xc5, 0x1b}},
+        {0xb02befd5, 0x5b36, 0x4458, 0xb66d, {0x61, 0x8a, 0xf5, 0x1f, 0xc7, 0x03}},
+        EFFECT_CONTROL_API_VERSION,
+        EFFECT_FLAG_TYPE_AUXILIARY,
+        CONVREV_CPU_LOAD_ARM9E,
+        CONVREV_MEM_USAGE,
+        "Auxiliary Preset Convolution Reverb",
+        "The Android Open Source Project",
+};
+
+// Convolution insert preset reverb
+static const effect_descriptor_t gInsertPresetConvReverbDescriptor = {
+        {0x47382d60, 0xddd8, 0x11db, 0xbf3a, {0x00, 0x02, 0xa5, 0xd5, 0xc5, 0x1b}},
+        {0x51494ad1, 0xe3cf, 0x4f3a, 0x98d4, {0xe6, 0x1a, 0x8f, 0x9f, 0xbe, 0xf1}},
+        EFFECT_CONTROL_API_VERSION,
+        EFFECT_FLAG_TYPE_INSERT | EFFECT_FLAG_INSERT_FIRST | EFFECT_FLAG_VOLUME_CTRL,
+        CONVREV_CPU_LOAD_ARM9E,
+        CONVREV_MEM_USAGE,
+        "Insert Preset Convolution Reverb",
+        "The Android Open Source Project",
+};
+
 // gDescriptors contains pointers to all defined effect descriptor in this library
 static const effect_descriptor_t* const gDescriptors[] = {
-        &gAuxEnvReverbDescriptor, &gInsertEnvReverbDescriptor, &gAuxPresetReverbDescriptor,
-        &gInsertPresetReverbDescriptor};
+        &gAuxEnvReverbDescriptor,        &gInsertEnvReverbDescriptor,
+        &gAuxPresetReverbDescriptor,     &gInsertPresetReverbDescriptor,
+        &gAuxEnvConvReverbDescriptor,    &gInsertEnvConvReverbDescriptor,
+        &gAuxPresetConvReverbDescriptor, &gInsertPresetConvReverbDescriptor};
 
 typedef float process_buffer_t;  // process in float
 
@@ -143,6 +194,9 @@ struct ReverbContext {
     const struct effect_interface_s* itfe;
     effect_config_t config;
     LVREV_Handle_t hInstance;
+    // Set for the convolution reverbs. hInstance then only holds the control parameters.
+    bool convolution;
+    ConvolutionReverb* pConvolution;
     int16_t SavedRoomLevel;
     int16_t SavedHfLevel;
     int16_t SavedDecayTime;
@@ -188,6 +242,8 @@ int Reverb_setParameter(ReverbContext* pContext, void* pParam, void* pValue, int
 int Reverb_getParameter(ReverbContext* pContext, void* pParam, uint32_t* pValueSize, void* pValue);
 int Reverb_LoadPreset(ReverbContext* pContext);
 int Reverb_paramValueSize(int32_t param);
+LVREV_ReturnStatus_en Reverb_setControlParameters(ReverbContext* pContext,
+                                                  LVREV_ControlParams_st* pParams);
 
 /* Effect Library Interface Implementation */
 
@@ -221,6 +277,14 @@ extern "C" int EffectCreate(const effect_uuid_t* uuid, int32_t /* sessionId __un
 
     pContext->itfe = &gReverbInterface;
     pContext->hInstance = NULL;
+    pContext->pConvolution = NULL;
+
+    pContext->convolution = false;
+    if (desc == &gAuxEnvConvReverbDescriptor || desc == &gInsertEnvConvReverbDescriptor ||
+        desc == &gAuxPresetConvReverbDescriptor || desc == &gInsertPresetConvReverbDescriptor) {
+        pContext->convolution = true;
+        ALOGV("\tEffectCreate - CONVOLUTION");
+    }
 
     pContext->auxiliary = false;
     if ((desc->flags & EFFECT_FLAG_TYPE_MASK) == EFFECT_FLAG_TYPE_AUXILIARY) {
@@ -396,10 +460,15 @@ int process(effect_buffer_t* pIn, effect_buffer_t* pOut, int frameCount, ReverbC
         }
 
         /* Process the samples, producing a stereo output */
-        LvmStatus = LVREV_Process(pContext->hInstance, /* Instance handle */
-                                  pContext->InFrames,  /* Input buffer */
-                                  pContext->OutFrames, /* Output buffer */
-                                  frameCount);         /* Number of samples to read */
+        if (pContext->convolution) {
+            LvmStatus = pContext->pConvolution->process(pContext->InFrames, pContext->OutFrames,
+                                                        frameCount);
+        } else {
+            LvmStatus = LVREV_Process(pContext->hInstance, /* Instance handle */
+                                      pContext->InFrames,  /* Input buffer */
+                                      pContext->OutFrames, /* Output buffer */
+                                      frameCount);         /* Number of samples to read */
+        }
     }
 
     LVM_ERROR_CHECK(LvmStatus, "LVREV_Process", "process")
@@ -519,8 +588,34 @@ void Reverb_free(ReverbContext* pContext) {
 
     LvmStatus = LVREV_FreeInstance(pContext->hInstance);
     LVM_ERROR_CHECK(LvmStatus, "LVREV_FreeInstance", "Reverb_free")
+
+    delete pContext->pConvolution;
+    pContext->pConvolution = NULL;
 } /* end Reverb_free */
 
+//----------------------------------------------------------------------------
+// Reverb_setControlParameters()
+//----------------------------------------------------------------------------
+// Purpose: Set the control parameters of the LVREV instance, and of the
+// convolution engine for the convolution reverbs.
+//
+// Inputs:
+//  pContext:   effect engine context
+//  pParams:    new control parameters
+//
+// Outputs:
+//
+//----------------------------------------------------------------------------
+
+LVREV_ReturnStatus_en Reverb_setControlParameters(ReverbContext* pContext,
+                                                  LVREV_ControlParams_st* pParams) {
+    LVREV_ReturnStatus_en LvmStatus = LVREV_SetControlParameters(pContext->hInstance, pParams);
+    if (LvmStatus == LVREV_SUCCESS && pContext->convolution) {
+        LvmStatus = pContext->pConvolution->setControlParameters(pParams);
+    }
+    return LvmStatus;
+} /* end Reverb_setControlParameters */
+
 //----------------------------------------------------------------------------
 // Reverb_setConfig()
 //----------------------------------------------------------------------------
@@ -575,7 +670,7 @@ int Reverb_setConfig(ReverbContext* pContext, effect_config_t* pConfig) {
 
         ActiveParams.SampleRate = SampleRate;
 
-        LvmStatus = LVREV_SetControlParameters(pContext->hInstance, &ActiveParams);
+        LvmStatus = Reverb_setControlParameters(pContext, &ActiveParams);
 
         LVM_ERROR_CHECK(LvmStatus, "LVREV_SetControlParameters", "Reverb_setConfig")
         if (LvmStatus != LVREV_SUCCESS) return -EINVAL;
@@ -675,6 +770,10 @@ int Reverb_init(ReverbContext* pContext) {
 
     ALOGV("\tReverb_init CreateInstance Successfully called LVM_GetInstanceHandle\n");
 
+    if (pContext->convolution) {
+        pContext->pConvolution = new ConvolutionReverb();
+    }
+
     /* Set the initial process parameters */
     /* General parameters */
     params.OperatingMode = LVM_MODE_ON;
@@ -715,7 +814,7 @@ int Reverb_init(ReverbContext* pContext) {
     pContext->SavedReverbLevel = -6000;
 
     /* Activate the initial settings */
-    LvmStatus = LVREV_SetControlParameters(pContext->hInstance, &params);
+    LvmStatus = Reverb_setControlParameters(pContext, &params);
 
     LVM_ERROR_CHECK(LvmStatus, "LVREV_SetControlParameters", "Reverb_init")
     if (LvmStatus != LVREV_SUCCESS) return -EINVAL;
@@ -822,7 +921,7 @@ void ReverbSetRoomHfLevel(ReverbContext* pContext, int16_t level) {
     ActiveParams.LPF = ReverbConvertHfLevel(level);
 
     /* Activate the initial settings */
-    LvmStatus = LVREV_SetControlParameters(pContext->hInstance, &ActiveParams);
+    LvmStatus = Reverb_setControlParameters(pContext, &ActiveParams);
     LVM_ERROR_CHECK(LvmStatus, "LVREV_SetControlParameters", "ReverbSetRoomHfLevel")
     // ALOGV("\tReverbSetRoomhfLevel() just Set -> %d\n", ActiveParams.LPF);
     pContext->SavedHfLevel = level;
@@ -904,7 +1003,7 @@ void ReverbSetReverbLevel(ReverbContext* pContext, int16_t level) {
     // ALOGV("\tReverbSetReverbLevel() Trying to set -> %d\n", ActiveParams.Level);
 
     /* Activate the initial settings */
-    LvmStatus = LVREV_SetControlParameters(pContext->hInstance, &ActiveParams);
+    LvmStatus = Reverb_setControlParameters(pContext, &ActiveParams);
     LVM_ERROR_CHECK(LvmStatus, "LVREV_SetControlParameters", "ReverbSetReverbLevel")
     // ALOGV("\tReverbSetReverbLevel() just Set -> %d\n", ActiveParams.Level);
 
@@ -993,7 +1092,7 @@ void ReverbSetRoomLevel(ReverbContext* pContext, int16_t level) {
     ActiveParams.Level = ReverbConvertLevel(CombinedLevel);
 
     /* Activate the initial settings */
-    LvmStatus = LVREV_SetControlParameters(pContext->hInstance, &ActiveParams);
+    LvmStatus = Reverb_setControlParameters(pContext, &ActiveParams);
     LVM_ERROR_CHECK(LvmStatus, "LVREV_SetControlParameters", "ReverbSetRoomLevel")
     // ALOGV("\tReverbSetRoomLevel() just Set -> %d\n", ActiveParams.Level);
 
@@ -1077,7 +1176,7 @@ void ReverbSetDecayTime(ReverbContext* pContext, uint32_t time) {
     }
 
     /* Activate the initial settings */
-    LvmStatus = LVREV_SetControlParameters(pContext->hInstance, &ActiveParams);
+    LvmStatus = Reverb_setControlParameters(pContext, &ActiveParams);
     LVM_ERROR_CHECK(LvmStatus, "LVREV_SetControlParameters", "ReverbSetDecayTime")
     // ALOGV("\tReverbSetDecayTime() just Set -> %d\n", ActiveParams.T60);
 
@@ -1150,7 +1249,7 @@ void ReverbSetDecayHfRatio(ReverbContext* pContext, int16_t ratio) {
     ActiveParams.Damping = (LVM_INT16)(ratio / 20);
 
     /* Activate the initial settings */
-    LvmStatus = LVREV_SetControlParameters(pContext->hInstance, &ActiveParams);
+    LvmStatus = Reverb_setControlParameters(pContext, &ActiveParams);
     LVM_ERROR_CHECK(LvmStatus, "LVREV_SetControlParameters", "ReverbSetDecayHfRatio")
     // ALOGV("\tReverbSetDecayHfRatio() just Set -> %d\n", ActiveParams.Damping);
 
@@ -1218,7 +1317,7 @@ void ReverbSetDiffusion(ReverbContext* pContext, int16_t level) {
     ActiveParams.Density = (LVM_INT16)(level / 10);
 
     /* Activate the initial settings */
-    LvmStatus = LVREV_SetControlParameters(pContext->hInstance, &ActiveParams);
+    LvmStatus = Reverb_setControlParameters(pContext, &ActiveParams);
     LVM_ERROR_CHECK(LvmStatus, "LVREV_SetControlParameters", "ReverbSetDiffusion")
     // ALOGV("\tReverbSetDiffusion() just Set -> %d\n", ActiveParams.Density);
 
@@ -1288,7 +1387,7 @@ void ReverbSetDensity(ReverbContext* pContext, int16_t level) {
     ActiveParams.RoomSize = (LVM_INT16)(((level * 99) / 1000) + 1);
 
     /* Activate the initial settings */
-    LvmStatus = LVREV_SetControlParameters(pContext->hInstance, &ActiveParams);
+    LvmStatus = Reverb_setControlParameters(pContext, &ActiveParams);
     LVM_ERROR_CHECK(LvmStatus, "LVREV_SetControlParameters", "ReverbSetDensity")
     // ALOGV("\tReverbSetDensity just Set -> %d\n", ActiveParams.RoomSize);
 
@@ -27,6 +27,10 @@
 #define LVREV_MAX_FRAME_SIZE 2560
 #define LVREV_CUP_LOAD_ARM9E 470                            // Expressed in 0.1 MIPS
 #define LVREV_MEM_USAGE (71 + (LVREV_MAX_FRAME_SIZE >> 7))  // Expressed in kB
+// The convolution reverbs also hold an LVREV instance for the control parameters. Their own
+// memory is the impulse response spectra and the input delay line of CONVREV_MAX_PARTITIONS.
+#define CONVREV_CPU_LOAD_ARM9E 250                          // Expressed in 0.1 MIPS
+#define CONVREV_MEM_USAGE (LVREV_MEM_USAGE + 220)           // Expressed in kB
 
 typedef struct _LPFPair_t {
     int16_t Room_HF;
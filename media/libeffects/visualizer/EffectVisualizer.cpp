@@ -30,8 +30,11 @@
 #include <log/log.h>
 
 #include <audio_effects/effect_visualizer.h>
+#include <audio_effects/effect_visualizer_analysis.h>
 #include <audio_utils/primitives.h>
 
+#include "VisualizerAnalyzer.h"
+
 #ifdef BUILD_FLOAT
 
 static constexpr audio_format_t kProcessFormat = AUDIO_FORMAT_PCM_FLOAT;
@@ -102,6 +105,8 @@ struct VisualizerContext {
     uint8_t mMeasurementWindowSizeInBuffers;
     uint8_t mMeasurementBufferIdx;
     BufferStats mPastMeasurements[MEASUREMENT_WINDOW_MAX_SIZE_IN_BUFFERS];
+    // for the spectrum analysis
+    VisualizerAnalyzer mAnalyzer;
 };
 
 //
@@ -132,6 +137,13 @@ void Visualizer_reset(VisualizerContext *pContext)
     pContext->mBufferUpdateTime.tv_sec = 0;
     pContext->mLatency = 0;
     memset(pContext->mCaptureBuf, 0x80, CAPTURE_BUF_SIZE);
+    pContext->mAnalyzer.reset();
+}
+
+// The analysis FFT size is the capture size rounded down to a power of 2.
+uint32_t Visualizer_getFftSize(uint32_t captureSize) {
+    captureSize = std::max(captureSize, (uint32_t)VISUALIZER_CAPTURE_SIZE_MIN);
+    return 1u << (31 - __builtin_clz(captureSize));
 }
 
 //----------------------------------------------------------------------------
@@ -167,6 +179,8 @@ int Visualizer_setConfig(VisualizerContext *pContext, effect_config_t *pConfig)
 
     pContext->mConfig = *pConfig;
 
+    pContext->mAnalyzer.configure(pConfig->inputCfg.samplingRate,
+            Visualizer_getFftSize(pContext->mCaptureSize));
     Visualizer_reset(pContext);
 
     return 0;
@@ -240,6 +254,9 @@ int Visualizer_init(VisualizerContext *pContext)
         pContext->mPastMeasurements[i].mRmsSquared = 0;
     }
 
+    // analysis initialization
+    pContext->mAnalyzer.setPeriodMs(0);
+
     Visualizer_setConfig(pContext, &pContext->mConfig);
 
     return 0;
@@ -342,11 +359,8 @@ int Visualizer_process(
         float rmsSqAcc = 0;
 
 #ifdef BUILD_FLOAT
-        float maxSample = 0.f;
-        for (size_t inIdx = 0; inIdx < sampleLen; ++inIdx) {
-            maxSample = fmax(maxSample, fabs(inBuffer->f32[inIdx]));
-            rmsSqAcc += inBuffer->f32[inIdx] * inBuffer->f32[inIdx];
-        }
+        float maxSample;
+        VisualizerAnalyzer::measurePeakRms(inBuffer->f32, sampleLen, &maxSample, &rmsSqAcc);
         maxSample *= 1 << 15; // scale to int16_t, with exactly 1 << 15 representing positive num.
         rmsSqAcc *= 1 << 30; // scale to int16_t * 2
 #else
@@ -427,6 +441,14 @@ int Visualizer_process(
 #endif // BUILD_FLOAT
     }
 
+    // the analysis is fed the average of the channels, at the level played
+    const bool analyze = pContext->mAnalyzer.isEnabled();
+#ifdef BUILD_FLOAT
+    const float analysisScale = 1.f / pContext->mChannelCount;
+#else
+    const float analysisScale = 1.f / (FCC_2 << 15);
+#endif // BUILD_FLOAT
+
     uint32_t captIdx;
     uint32_t inIdx;
     uint8_t *buf = pContext->mCaptureBuf;
@@ -442,10 +464,21 @@ int Visualizer_process(
         }
         buf[captIdx] = clamp8_from_float(smp * fscale);
 #else
-        const int32_t smp = (inBuffer->s16[inIdx] + inBuffer->s16[inIdx + 1]) >> shift;
+        const int32_t sum = inBuffer->s16[inIdx] + inBuffer->s16[inIdx + 1];
+        const int32_t smp = sum >> shift;
         inIdx += FCC_2;  // integer supports stereo only.
         buf[captIdx] = ((uint8_t)smp)^0x80;
 #endif // BUILD_FLOAT
+        if (analyze) {
+#ifdef BUILD_FLOAT
+            pContext->mAnalyzer.write(smp * analysisScale);
+#else
+            pContext->mAnalyzer.write(sum * analysisScale);
+#endif // BUILD_FLOAT
+        }
+    }
+    if (analyze) {
+        pContext->mAnalyzer.onFramesWritten(inBuffer->frameCount);
     }
 
     // XXX the following two should really be atomic, though it probably doesn't
@@ -573,6 +606,12 @@ int Visualizer_command(effect_handle_t self, uint32_t cmdCode, uint32_t cmdSize,
             p->vsize = sizeof(uint32_t);
             *replySize += sizeof(uint32_t);
             break;
+        case VISUALIZER_PARAM_ANALYSIS_PERIOD_MS:
+            ALOGV("get analysis period = %" PRIu32, pContext->mAnalyzer.getPeriodMs());
+            *((uint32_t *)p->data + 1) = pContext->mAnalyzer.getPeriodMs();
+            p->vsize = sizeof(uint32_t);
+            *replySize += sizeof(uint32_t);
+            break;
         default:
             p->status = -EINVAL;
         }
@@ -598,6 +637,8 @@ int Visualizer_command(effect_handle_t self, uint32_t cmdCode, uint32_t cmdSize,
                 ALOGW("set mCaptureSize = %u > %u", captureSize, VISUALIZER_CAPTURE_SIZE_MAX);
             } else {
                 pContext->mCaptureSize = captureSize;
+                pContext->mAnalyzer.configure(pContext->mConfig.inputCfg.samplingRate,
+                        Visualizer_getFftSize(captureSize));
                 ALOGV("set mCaptureSize = %u", captureSize);
             }
             } break;
@@ -617,6 +658,16 @@ int Visualizer_command(effect_handle_t self, uint32_t cmdCode, uint32_t cmdSize,
             pContext->mMeasurementMode = *((uint32_t *)p->data + 1);
             ALOGV("set mMeasurementMode = %" PRIu32, pContext->mMeasurementMode);
             break;
+        case VISUALIZER_PARAM_ANALYSIS_PERIOD_MS: {
+            const uint32_t periodMs = *((uint32_t *)p->data + 1);
+            if (periodMs > MAX_STALL_TIME_MS) {
+                *(int32_t *)pReplyData = -EINVAL;
+                ALOGW("set analysis period = %u > %u", periodMs, MAX_STALL_TIME_MS);
+            } else {
+                pContext->mAnalyzer.setPeriodMs(periodMs);
+                ALOGV("set analysis period = %u", periodMs);
+            }
+            } break;
         default:
             *(int32_t *)pReplyData = -EINVAL;
         }
@@ -750,6 +801,24 @@ int Visualizer_command(effect_handle_t self, uint32_t cmdCode, uint32_t cmdSize,
         }
         break;
 
+    case VISUALIZER_CMD_GET_FFT_MAGNITUDE: {
+        const VisualizerAnalyzer &analyzer = pContext->mAnalyzer;
+        const uint32_t size = analyzer.getBinCount() * sizeof(float);
+        if (pReplyData == NULL || replySize == NULL || *replySize != size) {
+            ALOGV("VISUALIZER_CMD_GET_FFT_MAGNITUDE() error *replySize %" PRIu32
+                    " size %" PRIu32, replySize == NULL ? 0 : *replySize, size);
+            return -EINVAL;
+        }
+        // return silence when disabled, or when the framework stopped playing audio
+        if (pContext->mState != VISUALIZER_STATE_ACTIVE || !analyzer.isEnabled() ||
+                pContext->mBufferUpdateTime.tv_sec == 0 ||
+                Visualizer_getDeltaTimeMsFromUpdatedTime(pContext) > MAX_STALL_TIME_MS) {
+            memset(pReplyData, 0, size);
+        } else {
+            memcpy(pReplyData, analyzer.getMagnitudes(), size);
+        }
+        } break;
+
     default:
         ALOGW("Visualizer_command invalid command %" PRIu32, cmdCode);
         return -EINVAL;
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "VisualizerAnalyzer"
+//#define LOG_NDEBUG 0
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include <log/log.h>
+
+#include "VisualizerAnalyzer.h"
+
+namespace {
+
+// Four consecutive samples.
+typedef float float4 __attribute__((vector_size(4 * sizeof(float))));
+typedef int32_t int4 __attribute__((vector_size(4 * sizeof(int32_t))));
+
+inline float4 load4(const float *p) {
+    float4 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+} // namespace
+
+VisualizerAnalyzer::VisualizerAnalyzer()
+    : mHistory(kHistorySize, 0.f) {
+}
+
+void VisualizerAnalyzer::configure(uint32_t sampleRate, uint32_t fftSize) {
+    ALOGV("configure sampleRate %u fftSize %u", sampleRate, fftSize);
+    ALOG_ASSERT(fftSize >= 4 && fftSize <= kHistorySize && (fftSize & (fftSize - 1)) == 0,
+            "invalid fftSize %u", fftSize);
+    mSampleRate = sampleRate;
+    setPeriodMs(mPeriodMs);
+    if (fftSize == mFftSize) {
+        reset();
+        return;
+    }
+    mFftSize = fftSize;
+
+    // periodic Hann window, its sum is fftSize / 2
+    mWindow.resize(fftSize);
+    for (uint32_t n = 0; n < fftSize; n++) {
+        mWindow[n] = 0.5f - 0.5f * cos(2 * M_PI * n / fftSize);
+    }
+    // a sine of amplitude A centered on a bin has a magnitude of A * fftSize / 4
+    mMagnitudeScale = 4.f / fftSize;
+
+    mFft.configure(fftSize);
+    mWindowed.resize(fftSize);
+    mRe.resize(getBinCount());
+    mIm.resize(getBinCount());
+    mMagnitudes.resize(getBinCount());
+    reset();
+}
+
+void VisualizerAnalyzer::reset() {
+    std::fill(mHistory.begin(), mHistory.end(), 0.f);
+    mHistoryIdx = 0;
+    std::fill(mMagnitudes.begin(), mMagnitudes.end(), 0.f);
+    mFramesSinceAnalysis = 0;
+}
+
+void VisualizerAnalyzer::setPeriodMs(uint32_t periodMs) {
+    mPeriodMs = periodMs;
+    mPeriodFrames = std::max((size_t)1, (size_t)mSampleRate * periodMs / 1000);
+    mFramesSinceAnalysis = 0;
+}
+
+void VisualizerAnalyzer::onFramesWritten(size_t frameCount) {
+    mFramesSinceAnalysis += frameCount;
+    if (mFramesSinceAnalysis < mPeriodFrames) {
+        return;
+    }
+    // when several periods elapsed during the buffer, only the last one can be read
+    mFramesSinceAnalysis %= mPeriodFrames;
+    analyze();
+}
+
+void VisualizerAnalyzer::analyze() {
+    // window the last fftSize samples
+    uint32_t idx = (mHistoryIdx - mFftSize) & (kHistorySize - 1);
+    for (uint32_t n = 0; n < mFftSize; n++) {
+        mWindowed[n] = mHistory[idx] * mWindow[n];
+        idx = (idx + 1) & (kHistorySize - 1);
+    }
+    mFft.forward(mWindowed.data(), mRe.data(), mIm.data());
+
+    for (uint32_t k = 0; k < getBinCount(); k++) {
+        mMagnitudes[k] = sqrtf(mRe[k] * mRe[k] + mIm[k] * mIm[k]) * mMagnitudeScale;
+    }
+    mAnalysisCount++;
+}
+
+// static
+void VisualizerAnalyzer::measurePeakRms(
+        const float *in, size_t count, float *peak, float *sumSquares) {
+    // the bit patterns of non-negative floats sort like integers, so the absolute values are
+    // compared as integers, which does not need a vector select instruction
+    const int4 absMask = {0x7fffffff, 0x7fffffff, 0x7fffffff, 0x7fffffff};
+    int4 peak4 = {};
+    float4 sum4 = {};
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const float4 v = load4(in + i);
+        const int4 bits = (int4)v & absMask;
+        const int4 greater = bits > peak4;
+        peak4 = (bits & greater) | (peak4 & ~greater);
+        sum4 += v * v;
+    }
+    int32_t peakBits = std::max(std::max(peak4[0], peak4[1]), std::max(peak4[2], peak4[3]));
+    float peakValue;
+    memcpy(&peakValue, &peakBits, sizeof(peakValue));
+    float sum = (sum4[0] + sum4[1]) + (sum4[2] + sum4[3]);
+    for (; i < count; i++) {
+        peakValue = std::max(peakValue, fabsf(in[i]));
+        sum += in[i] * in[i];
+    }
+    *peak = peakValue;
+    *sumSquares = sum;
+}
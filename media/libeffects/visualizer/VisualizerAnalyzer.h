@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_VISUALIZER_ANALYZER_H_
+#define ANDROID_VISUALIZER_ANALYZER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include <effects/RadixTwoFft.h>
+
+// Spectrum analysis of the visualized signal, done in the effect as the audio is processed.
+//
+// Every period, the last fftSize samples of the mono mix are windowed and transformed, and
+// the magnitudes are kept until the next period. All the clients of the effect read the same
+// magnitudes, so the cost does not grow with the number of clients, and the clients no longer
+// transform captured waveforms themselves.
+class VisualizerAnalyzer {
+public:
+    VisualizerAnalyzer();
+
+    // fftSize must be a power of 2 from VISUALIZER_CAPTURE_SIZE_MIN to
+    // VISUALIZER_CAPTURE_SIZE_MAX. Clears the history and the magnitudes.
+    void configure(uint32_t sampleRate, uint32_t fftSize);
+    void reset();
+
+    // 0 disables the analysis.
+    void setPeriodMs(uint32_t periodMs);
+    uint32_t getPeriodMs() const { return mPeriodMs; }
+    bool isEnabled() const { return mPeriodMs != 0; }
+
+    uint32_t getFftSize() const { return mFftSize; }
+    // Bins from DC to Nyquist included.
+    uint32_t getBinCount() const { return mFftSize / 2 + 1; }
+
+    // Appends one sample of the mono mix. Called for every frame while enabled.
+    void write(float sample) {
+        mHistory[mHistoryIdx] = sample;
+        mHistoryIdx = (mHistoryIdx + 1) & (kHistorySize - 1);
+    }
+    // Runs the analysis if a period has elapsed. Called after the frames of a buffer are written.
+    void onFramesWritten(size_t frameCount);
+
+    // Magnitude of each bin, 1.0 for a full scale sine wave centered on the bin.
+    const float *getMagnitudes() const { return mMagnitudes.data(); }
+    // Number of transforms done, for clients to tell whether the magnitudes changed.
+    uint32_t getAnalysisCount() const { return mAnalysisCount; }
+
+    // Peak of the absolute values and sum of the squares of count samples.
+    static void measurePeakRms(const float *in, size_t count, float *peak, float *sumSquares);
+
+private:
+    static constexpr uint32_t kHistorySize = 1024; // VISUALIZER_CAPTURE_SIZE_MAX
+
+    void analyze();
+
+    uint32_t mSampleRate = 0;
+    uint32_t mFftSize = 0;
+    uint32_t mPeriodMs = 0;
+    size_t mPeriodFrames = 0;
+    size_t mFramesSinceAnalysis = 0;
+    uint32_t mAnalysisCount = 0;
+
+    std::vector<float> mHistory;
+    uint32_t mHistoryIdx = 0;
+
+    std::vector<float> mWindow;
+    float mMagnitudeScale = 0.f;
+    android::effects::RealFft<float> mFft;
+    std::vector<float> mWindowed;   // input of the transform
+    std::vector<float> mRe;         // bins of the transform
+    std::vector<float> mIm;
+    std::vector<float> mMagnitudes;
+};
+
+#endif // ANDROID_VISUALIZER_ANALYZER_H_
@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_EFFECT_VISUALIZER_ANALYSIS_H_
+#define ANDROID_EFFECT_VISUALIZER_ANALYSIS_H_
+
+#include <audio_effects/effect_visualizer.h>
+
+// Extensions of effect_visualizer.h for the spectrum analysis done in the effect.
+// The magnitudes are computed once per period on the playback thread and served to all the
+// clients of the effect, instead of each client transforming captured waveforms.
+
+// Period of the analysis in ms, 0 (the default) disables it. At most 1000 ms.
+#define VISUALIZER_PARAM_ANALYSIS_PERIOD_MS (VISUALIZER_PARAM_MEASUREMENT_MODE + 1)
+
+// Returns the magnitudes of the last analysis as floats, from DC to Nyquist, 1.0 being full
+// scale. The FFT size is the capture size rounded down to a power of 2, at least
+// VISUALIZER_CAPTURE_SIZE_MIN, and *replySize must be
+// (FFT size / 2 + 1) * sizeof(float). The magnitudes are not delayed by
+// VISUALIZER_PARAM_LATENCY.
+#define VISUALIZER_CMD_GET_FFT_MAGNITUDE (VISUALIZER_CMD_MEASURE + 1)
+
+#endif  // ANDROID_EFFECT_VISUALIZER_ANALYSIS_H_
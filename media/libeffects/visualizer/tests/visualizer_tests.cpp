@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+
+#include <vector>
+
+#include <audio_effects/effect_visualizer.h>
+#include <audio_effects/effect_visualizer_analysis.h>
+#include <gtest/gtest.h>
+#include <hardware/audio_effect.h>
+
+extern audio_effect_library_t AUDIO_EFFECT_LIBRARY_INFO_SYM;
+
+// Google Visualizer UUID: d069d9e0-8329-11df-9168-0002a5d5c51b
+static constexpr effect_uuid_t kVisualizerUuid =
+        {0xd069d9e0, 0x8329, 0x11df, 0x9168, {0x00, 0x02, 0xa5, 0xd5, 0xc5, 0x1b}};
+
+// The default configuration of the effect.
+static constexpr uint32_t kSampleRate = 44100;
+static constexpr uint32_t kChannelCount = 2;
+// The default capture size, and so the analysis FFT size.
+static constexpr uint32_t kFftSize = VISUALIZER_CAPTURE_SIZE_MAX;
+static constexpr uint32_t kBinCount = kFftSize / 2 + 1;
+
+class VisualizerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_EQ(0, AUDIO_EFFECT_LIBRARY_INFO_SYM.create_effect(
+                &kVisualizerUuid, 1 /* sessionId */, 1 /* ioId */, &mHandle));
+        ASSERT_NE(nullptr, mHandle);
+    }
+
+    void TearDown() override {
+        if (mHandle != nullptr) {
+            EXPECT_EQ(0, AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(mHandle));
+        }
+    }
+
+    int command(uint32_t cmdCode, uint32_t cmdSize, void *pCmdData,
+            uint32_t *replySize, void *pReplyData) {
+        return (*mHandle)->command(mHandle, cmdCode, cmdSize, pCmdData, replySize, pReplyData);
+    }
+
+    int32_t setParam(uint32_t param, uint32_t value) {
+        uint32_t cmd[sizeof(effect_param_t) / sizeof(uint32_t) + 2];
+        effect_param_t *p = (effect_param_t *)cmd;
+        p->psize = sizeof(uint32_t);
+        p->vsize = sizeof(uint32_t);
+        *(uint32_t *)p->data = param;
+        *((uint32_t *)p->data + 1) = value;
+        int32_t reply = 0;
+        uint32_t replySize = sizeof(reply);
+        EXPECT_EQ(0, command(EFFECT_CMD_SET_PARAM, sizeof(cmd), cmd, &replySize, &reply));
+        return reply;
+    }
+
+    int32_t getParam(uint32_t param, uint32_t *value) {
+        uint32_t cmd[sizeof(effect_param_t) / sizeof(uint32_t) + 1];
+        effect_param_t *p = (effect_param_t *)cmd;
+        p->psize = sizeof(uint32_t);
+        p->vsize = sizeof(uint32_t);
+        *(uint32_t *)p->data = param;
+        uint32_t reply[sizeof(effect_param_t) / sizeof(uint32_t) + 2];
+        uint32_t replySize = sizeof(reply);
+        EXPECT_EQ(0, command(EFFECT_CMD_GET_PARAM, sizeof(cmd), cmd, &replySize, reply));
+        const effect_param_t *r = (const effect_param_t *)reply;
+        *value = *((const uint32_t *)r->data + 1);
+        return r->status;
+    }
+
+    void enable() {
+        int32_t reply = 0;
+        uint32_t replySize = sizeof(reply);
+        ASSERT_EQ(0, command(EFFECT_CMD_ENABLE, 0, nullptr, &replySize, &reply));
+        ASSERT_EQ(0, reply);
+    }
+
+    // Processes a stereo sine with the same samples on both channels.
+    void processSine(float frequency, float amplitude, size_t frameCount) {
+        std::vector<float> in(frameCount * kChannelCount);
+        for (size_t i = 0; i < frameCount; i++) {
+            const float sample = amplitude * sinf(2 * M_PI * frequency * i / kSampleRate);
+            for (size_t c = 0; c < kChannelCount; c++) {
+                in[i * kChannelCount + c] = sample;
+            }
+        }
+        std::vector<float> out(in.size());
+        audio_buffer_t inBuffer = {.frameCount = frameCount, .f32 = in.data()};
+        audio_buffer_t outBuffer = {.frameCount = frameCount, .f32 = out.data()};
+        ASSERT_EQ(0, (*mHandle)->process(mHandle, &inBuffer, &outBuffer));
+    }
+
+    int getMagnitudes(std::vector<float> *magnitudes, uint32_t replySize) {
+        magnitudes->assign(kBinCount, -1.f);
+        return command(VISUALIZER_CMD_GET_FFT_MAGNITUDE, 0, nullptr, &replySize,
+                magnitudes->data());
+    }
+
+    effect_handle_t mHandle = nullptr;
+};
+
+TEST_F(VisualizerTest, AnalysisPeriodParam) {
+    uint32_t periodMs = 1;
+    EXPECT_EQ(0, getParam(VISUALIZER_PARAM_ANALYSIS_PERIOD_MS, &periodMs));
+    EXPECT_EQ(0u, periodMs);  // disabled by default
+
+    EXPECT_EQ(0, setParam(VISUALIZER_PARAM_ANALYSIS_PERIOD_MS, 50));
+    EXPECT_EQ(0, getParam(VISUALIZER_PARAM_ANALYSIS_PERIOD_MS, &periodMs));
+    EXPECT_EQ(50u, periodMs);
+
+    // longer than the stall time of the effect
+    EXPECT_EQ(-EINVAL, setParam(VISUALIZER_PARAM_ANALYSIS_PERIOD_MS, 1001));
+    EXPECT_EQ(0, getParam(VISUALIZER_PARAM_ANALYSIS_PERIOD_MS, &periodMs));
+    EXPECT_EQ(50u, periodMs);
+}
+
+TEST_F(VisualizerTest, FftMagnitudeReplySize) {
+    std::vector<float> magnitudes;
+    EXPECT_EQ(-EINVAL, getMagnitudes(&magnitudes, (kBinCount - 1) * sizeof(float)));
+    EXPECT_EQ(-EINVAL, getMagnitudes(&magnitudes, (kBinCount + 1) * sizeof(float)));
+    EXPECT_EQ(0, getMagnitudes(&magnitudes, kBinCount * sizeof(float)));
+}
+
+TEST_F(VisualizerTest, FftMagnitudeDisabled) {
+    ASSERT_NO_FATAL_FAILURE(enable());
+    ASSERT_NO_FATAL_FAILURE(processSine(1000.f, 0.5f, kSampleRate / 10));
+
+    std::vector<float> magnitudes;
+    ASSERT_EQ(0, getMagnitudes(&magnitudes, kBinCount * sizeof(float)));
+    for (uint32_t k = 0; k < kBinCount; k++) {
+        EXPECT_EQ(0.f, magnitudes[k]) << "bin " << k;
+    }
+}
+
+TEST_F(VisualizerTest, FftMagnitudeOfSine) {
+    constexpr uint32_t kBin = 32;
+    constexpr float kAmplitude = 0.5f;
+    ASSERT_NO_FATAL_FAILURE(enable());
+    ASSERT_EQ(0, setParam(VISUALIZER_PARAM_ANALYSIS_PERIOD_MS, 20));
+    ASSERT_NO_FATAL_FAILURE(processSine((float)kBin * kSampleRate / kFftSize, kAmplitude,
+            kSampleRate / 10));
+
+    std::vector<float> magnitudes;
+    ASSERT_EQ(0, getMagnitudes(&magnitudes, kBinCount * sizeof(float)));
+    // a full scale sine centered on a bin has a magnitude of 1, and the Hann window spreads
+    // half of it on each neighbour
+    EXPECT_NEAR(kAmplitude, magnitudes[kBin], 1e-3);
+    EXPECT_NEAR(kAmplitude / 2, magnitudes[kBin - 1], 1e-3);
+    EXPECT_NEAR(kAmplitude / 2, magnitudes[kBin + 1], 1e-3);
+    for (uint32_t k = 0; k < kBinCount; k++) {
+        if (k + 1 < kBin || k > kBin + 1) {
+            EXPECT_NEAR(0.f, magnitudes[k], 1e-3) << "bin " << k;
+        }
+    }
+}
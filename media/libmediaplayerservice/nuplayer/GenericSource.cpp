@@ -52,6 +52,14 @@ static const int kInitialMarkMs        = 5000;  // 5secs
 //static const int kPausePlaybackMarkMs  = 2000;  // 2secs
 static const int kResumePlaybackMarkMs = 15000;  // 15secs
 
+// Video buffers lent to the decoder at most, which bounds the memory held by the decoder
+// input queue.
+static const int32_t kMaxLentBuffers = 16;
+// Of those, buffers in shared memory from the extractor service at most. The service and the
+// extractors pool up to IMediaSource::kBinderMediaBuffers of them, so holding a few still
+// leaves reading ahead of the decoder.
+static const int32_t kMaxLentSharedBuffers = 2;
+
 NuPlayer::GenericSource::GenericSource(
         const sp<AMessage> &notify,
         bool uidValid,
@@ -71,13 +79,16 @@ NuPlayer::GenericSource::GenericSource(
       mFetchTimedTextDataGeneration(0),
       mDurationUs(-1LL),
       mAudioIsVorbis(false),
+      mVideoReadsNonblocking(false),
       mIsSecure(false),
       mIsStreaming(false),
       mUIDValid(uidValid),
       mUID(uid),
       mMediaClock(mediaClock),
       mBitrate(-1LL),
-      mPendingReadBufferTypes(0) {
+      mPendingReadBufferTypes(0),
+      mLentBuffers(0),
+      mLentSharedBuffers(0) {
     ALOGV("GenericSource");
     CHECK(mediaClock != NULL);
 
@@ -247,6 +258,7 @@ status_t NuPlayer::GenericSource::initFromDataSource() {
                 mVideoTrack.mSource = track;
                 mVideoTrack.mPackets =
                     new AnotherPacketSource(mVideoTrack.mSource->getFormat());
+                mVideoReadsNonblocking = mVideoTrack.mSource->supportNonblockingRead();
 
                 // video always at the beginning
                 mMimes.insertAt(String8(mime), 0);
@@ -1212,12 +1224,37 @@ sp<ABuffer> NuPlayer::GenericSource::mediaBufferToABuffer(
         // Extra increment (since we want to keep mb alive and attached to ab beyond this function
         // call. This is to counter the effect of mb->release() towards the end.
         mb->add_ref();
+        ++mLentBuffers;
+        if (mb->remoteRefcount() > 0) {
+            ++mLentSharedBuffers;
+        }
+
+    } else if (trackType == MEDIA_TRACK_TYPE_VIDEO && mb->localRefcount() == 0
+            && mLentBuffers < kMaxLentBuffers
+            && (mb->remoteRefcount() == 0
+                    || (mVideoReadsNonblocking && mLentSharedBuffers < kMaxLentSharedBuffers))) {
+        // Lend the extractor buffer to the decoder, which copies it straight into the
+        // codec input buffer. Only buffers without a MediaBufferGroup are lent: the
+        // observer is taken over, as for Modular DRM above.
+        // A buffer in shared memory from the extractor service, as large samples are, has
+        // a remote reference until it is released, and the service blocks reading once all
+        // of its pool is held. So only a few of them are lent, and only by a source that
+        // reads without blocking, which returns WOULD_BLOCK rather than waiting on them.
+        ab = new ABuffer((uint8_t *)mb->data() + mb->range_offset(), mb->range_length());
+        ab->meta()->setObject("mediaBufferHolder", new MediaBufferHolder(mb));
+        mb->setObserver(this);
+        mb->add_ref();
+        ++mLentBuffers;
+        if (mb->remoteRefcount() > 0) {
+            ++mLentSharedBuffers;
+        }
 
     } else {
         ab = new ABuffer(outLength);
         memcpy(ab->data(),
                (const uint8_t *)mb->data() + mb->range_offset(),
                mb->range_length());
+        ab->meta()->setInt32("source-copied", true);
     }
 
     if (audio && mAudioIsVorbis) {
@@ -1718,8 +1755,13 @@ void NuPlayer::GenericSource::signalBufferReturned(MediaBufferBase *buffer)
 {
     //ALOGV("signalBufferReturned %p  refCount: %d", buffer, buffer->localRefcount());
 
+    // the remote reference is dropped when the buffer is deleted
+    if (buffer->remoteRefcount() > 0) {
+        --mLentSharedBuffers;
+    }
     buffer->setObserver(NULL);
     buffer->release(); // this leads to delete since that there is no observor
+    --mLentBuffers;
 }
 
 }  // namespace android
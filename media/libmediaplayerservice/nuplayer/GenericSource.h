@@ -23,6 +23,8 @@
 
 #include "ATSParser.h"
 
+#include <atomic>
+
 #include <android-base/unique_fd.h>
 #include <media/mediaplayer.h>
 #include <media/stagefright/MediaBuffer.h>
@@ -146,6 +148,8 @@ private:
     int32_t mFetchTimedTextDataGeneration;
     int64_t mDurationUs;
     bool mAudioIsVorbis;
+    // The video source does not block reading when its buffers are held.
+    bool mVideoReadsNonblocking;
     // Secure codec is required.
     bool mIsSecure;
     bool mIsStreaming;
@@ -168,6 +172,11 @@ private:
     bool mPreparing;
     int64_t mBitrate;
     uint32_t mPendingReadBufferTypes;
+    // MediaBuffers held by the decoder input instead of copied, returned through
+    // signalBufferReturned() from the decoder thread.
+    std::atomic<int32_t> mLentBuffers;
+    // Those of mLentBuffers in shared memory from the extractor service.
+    std::atomic<int32_t> mLentSharedBuffers;
     sp<ABuffer> mGlobalTimedText;
 
     mutable Mutex mLock;
@@ -77,6 +77,10 @@ NuPlayer::Decoder::Decoder(
       mNumFramesTotal(0LL),
       mNumInputFramesDropped(0LL),
       mNumOutputFramesDropped(0LL),
+      mNumInputBytesCopied(0LL),
+      mInputBytesCopiedPerSec(0LL),
+      mInputCopyWindowBytes(0LL),
+      mInputCopyWindowStartUs(-1LL),
       mVideoWidth(0),
       mVideoHeight(0),
       mIsAudio(true),
@@ -116,6 +120,8 @@ sp<AMessage> NuPlayer::Decoder::getStats() {
     mStats->setInt64("frames-dropped-input", mNumInputFramesDropped);
     mStats->setInt64("frames-dropped-output", mNumOutputFramesDropped);
     mStats->setFloat("frame-rate-total", mFrameRateTotal);
+    mStats->setInt64("input-bytes-copied", mNumInputBytesCopied);
+    mStats->setInt64("input-bytes-copied-per-sec", mInputBytesCopiedPerSec);
 
     // make our own copy, so we aren't victim to any later changes.
     sp<AMessage> copiedStats = mStats->dup();
@@ -1029,6 +1035,23 @@ status_t NuPlayer::Decoder::fetchInputData(sp<AMessage> &reply) {
     return OK;
 }
 
+// Counts the compressed bytes copied on the way to the codec, by the source and by
+// onInputBufferFetched(). The rate is refreshed about every second.
+void NuPlayer::Decoder::countInputBytesCopied(size_t bytes) {
+    const int64_t nowUs = ALooper::GetNowUs();
+    Mutex::Autolock autolock(mStatsLock);
+    mNumInputBytesCopied += bytes;
+    mInputCopyWindowBytes += bytes;
+    if (mInputCopyWindowStartUs < 0) {
+        mInputCopyWindowStartUs = nowUs;
+    } else if (nowUs - mInputCopyWindowStartUs >= 1000000LL) {
+        mInputBytesCopiedPerSec =
+                mInputCopyWindowBytes * 1000000LL / (nowUs - mInputCopyWindowStartUs);
+        mInputCopyWindowBytes = 0;
+        mInputCopyWindowStartUs = nowUs;
+    }
+}
+
 bool NuPlayer::Decoder::onInputBufferFetched(const sp<AMessage> &msg) {
     if (mCodec == NULL) {
         ALOGE("[%s] onInputBufferFetched without a valid codec", mComponentName.c_str());
@@ -1137,6 +1160,9 @@ bool NuPlayer::Decoder::onInputBufferFetched(const sp<AMessage> &msg) {
             if (buffer->data() != NULL) {
                 codecBuffer->setRange(0, buffer->size());
                 memcpy(codecBuffer->data(), buffer->data(), buffer->size());
+                int32_t sourceCopied = 0;
+                buffer->meta()->findInt32("source-copied", &sourceCopied);
+                countInputBytesCopied(buffer->size() * (sourceCopied ? 2 : 1));
             } else { // No buffer->data()
                 //Modular DRM
                 sp<RefBase> holder;
@@ -1153,6 +1179,7 @@ bool NuPlayer::Decoder::onInputBufferFetched(const sp<AMessage> &msg) {
 
                     codecBuffer->setRange(0, mediaBuf->size());
                     memcpy(codecBuffer->data(), mediaBuf->data(), mediaBuf->size());
+                    countInputBytesCopied(mediaBuf->size());
 
                     MetaDataBase &meta_data = mediaBuf->meta_data();
                     cryptInfo = NuPlayerDrm::getSampleCryptoInfo(meta_data);
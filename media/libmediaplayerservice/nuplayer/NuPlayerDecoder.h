@@ -93,6 +93,10 @@ protected:
     int64_t mNumFramesTotal;
     int64_t mNumInputFramesDropped;
     int64_t mNumOutputFramesDropped;
+    int64_t mNumInputBytesCopied;
+    int64_t mInputBytesCopiedPerSec;
+    int64_t mInputCopyWindowBytes;
+    int64_t mInputCopyWindowStartUs;
     int32_t mVideoWidth;
     int32_t mVideoHeight;
     bool mIsAudio;
@@ -131,6 +135,7 @@ protected:
     void doFlush(bool notifyComplete);
     status_t fetchInputData(sp<AMessage> &reply);
     bool onInputBufferFetched(const sp<AMessage> &msg);
+    void countInputBytesCopied(size_t bytes);
     void onRenderBuffer(const sp<AMessage> &msg);
 
     bool supportsSeamlessFormatChange(const sp<AMessage> &to) const;
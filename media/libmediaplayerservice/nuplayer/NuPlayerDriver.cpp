@@ -1002,6 +1002,14 @@ status_t NuPlayerDriver::dump(
                             ? 0.0 : (double)(numFramesDropped * 100) / numFramesTotal);
             logString.append(buf);
         }
+
+        int64_t bytesCopied, bytesCopiedPerSec;
+        if (stats->findInt64("input-bytes-copied", &bytesCopied)
+                && stats->findInt64("input-bytes-copied-per-sec", &bytesCopiedPerSec)) {
+            snprintf(buf, sizeof(buf), "    inputBytesCopied(%lld), inputBytesCopiedPerSec(%lld)\n",
+                     (long long)bytesCopied, (long long)bytesCopiedPerSec);
+            logString.append(buf);
+        }
     }
 
     ALOGI("%s", logString.c_str());
@@ -18,6 +18,7 @@
 #define LOG_TAG "TranscodingResourcePolicy"
 
 #include <aidl/android/media/BnResourceObserver.h>
+#include <aidl/android/media/IResourceManagerService.h>
 #include <aidl/android/media/IResourceObserverService.h>
 #include <android/binder_manager.h>
 #include <android/binder_process.h>
@@ -28,11 +29,15 @@ namespace android {
 
 using Status = ::ndk::ScopedAStatus;
 using ::aidl::android::media::BnResourceObserver;
+using ::aidl::android::media::IResourceManagerService;
 using ::aidl::android::media::IResourceObserverService;
 using ::aidl::android::media::MediaObservableEvent;
 using ::aidl::android::media::MediaObservableFilter;
 using ::aidl::android::media::MediaObservableParcel;
 using ::aidl::android::media::MediaObservableType;
+using ::aidl::android::media::MediaResourceParcel;
+using ::aidl::android::media::MediaResourceSubType;
+using ::aidl::android::media::MediaResourceType;
 
 static std::string toString(const MediaObservableParcel& observable) {
     return "{" + ::aidl::android::media::toString(observable.type) + ", " +
@@ -50,22 +55,52 @@ struct TranscodingResourcePolicy::ResourceObserver : public BnResourceObserver {
               ::aidl::android::media::toString(event).c_str(), uid, pid,
               toString(observables[0]).c_str());
 
-        // Only report kIdle event.
-        if (((uint64_t)event & (uint64_t)MediaObservableEvent::kIdle) != 0) {
-            for (auto& observable : observables) {
-                if (observable.type == MediaObservableType::kVideoSecureCodec ||
-                    observable.type == MediaObservableType::kVideoNonSecureCodec) {
-                    mOwner->onResourceAvailable(pid);
-                    break;
-                }
+        bool videoCodecs = false;
+        int64_t nonSecureVideoCodecs = 0;
+        for (auto& observable : observables) {
+            if (observable.type == MediaObservableType::kVideoSecureCodec ||
+                observable.type == MediaObservableType::kVideoNonSecureCodec) {
+                videoCodecs = true;
+            }
+            if (observable.type == MediaObservableType::kVideoNonSecureCodec) {
+                nonSecureVideoCodecs += observable.value;
             }
         }
+        if (!videoCodecs) {
+            return ::ndk::ScopedAStatus::ok();
+        }
+
+        // The codec headroom changes either way, but only kIdle event is reported as
+        // resource available.
+        bool busy = ((uint64_t)event & (uint64_t)MediaObservableEvent::kBusy) != 0;
+        mOwner->onCodecsChanged(pid, busy ? nonSecureVideoCodecs : 0);
+        if (((uint64_t)event & (uint64_t)MediaObservableEvent::kIdle) != 0) {
+            mOwner->onResourceAvailable(pid);
+        }
         return ::ndk::ScopedAStatus::ok();
     }
 
     TranscodingResourcePolicy* mOwner;
 };
 
+// A session runs a video decoder and a video encoder.
+static constexpr int64_t kSessionCodecs = 2;
+
+// Returns the number of non-secure video codecs that can be added, or -1 if unbounded.
+static int64_t getVideoCodecHeadroom(const std::shared_ptr<IResourceManagerService>& service) {
+    if (service == nullptr) {
+        return 0;
+    }
+    int64_t headroom = 0;
+    Status status = service->getCodecHeadroom(MediaResourceType::kNonSecureCodec,
+                                              MediaResourceSubType::kVideoCodec, &headroom);
+    if (!status.isOk()) {
+        ALOGE("getCodecHeadroom failed: error %d", status.getServiceSpecificError());
+        return 0;
+    }
+    return headroom;
+}
+
 // static
 void TranscodingResourcePolicy::BinderDiedCallback(void* cookie) {
     TranscodingResourcePolicy* owner = reinterpret_cast<TranscodingResourcePolicy*>(cookie);
@@ -83,6 +118,8 @@ void TranscodingResourcePolicy::BinderDiedCallback(void* cookie) {
 TranscodingResourcePolicy::TranscodingResourcePolicy()
       : mRegistered(false),
         mResourceLostPid(-1),
+        mCodecHeadroom(0),
+        mAdmissionRefused(false),
         mDeathRecipient(AIBinder_DeathRecipient_new(BinderDiedCallback)) {
     registerSelf();
 }
@@ -95,6 +132,7 @@ void TranscodingResourcePolicy::registerSelf() {
     ALOGI("TranscodingResourcePolicy: registerSelf");
 
     ::ndk::SpAIBinder binder(AServiceManager_getService("media.resource_observer"));
+    ::ndk::SpAIBinder resourceManagerBinder(AServiceManager_getService("media.resource_manager"));
 
     std::scoped_lock lock{mRegisteredLock};
 
@@ -109,9 +147,12 @@ void TranscodingResourcePolicy::registerSelf() {
         return;
     }
 
-    // Only register filters for codec resource available.
+    // Only register filters for video codecs, busy ones to track the codec headroom
+    // and idle ones for resource available.
     mObserver = ::ndk::SharedRefBase::make<ResourceObserver>(this);
     std::vector<MediaObservableFilter> filters = {
+            {MediaObservableType::kVideoSecureCodec, MediaObservableEvent::kBusy},
+            {MediaObservableType::kVideoNonSecureCodec, MediaObservableEvent::kBusy},
             {MediaObservableType::kVideoSecureCodec, MediaObservableEvent::kIdle},
             {MediaObservableType::kVideoNonSecureCodec, MediaObservableEvent::kIdle}};
 
@@ -125,6 +166,19 @@ void TranscodingResourcePolicy::registerSelf() {
 
     AIBinder_linkToDeath(binder.get(), mDeathRecipient.get(), reinterpret_cast<void*>(this));
 
+    // The resource manager lives in the same process as the observer service, so the
+    // death of the latter covers both. Without it, no session is admitted next to the
+    // running one.
+    mResourceManager = IResourceManagerService::fromBinder(resourceManagerBinder);
+    if (mResourceManager == nullptr) {
+        ALOGE("Failed to get IResourceManagerService");
+    }
+    int64_t headroom = getVideoCodecHeadroom(mResourceManager);
+    {
+        std::scoped_lock admissionLock{mAdmissionLock};
+        mCodecHeadroom = headroom;
+    }
+
     ALOGD("@@@ registered observer");
     mRegistered = true;
 }
@@ -145,6 +199,7 @@ void TranscodingResourcePolicy::unregisterSelf() {
     }
 
     mService = nullptr;
+    mResourceManager = nullptr;
     mObserver = nullptr;
     mRegistered = false;
 }
@@ -160,6 +215,81 @@ void TranscodingResourcePolicy::setPidResourceLost(pid_t pid) {
     mResourceLostPid = pid;
 }
 
+bool TranscodingResourcePolicy::hasHeadroom_l() const {
+    if (mCodecHeadroom == -1) {
+        return true;
+    }
+    int64_t reserved = 0;
+    for (const auto& [pid, codecs] : mReservedCodecs) {
+        reserved += codecs;
+    }
+    return mCodecHeadroom - reserved >= kSessionCodecs;
+}
+
+bool TranscodingResourcePolicy::admitSession(pid_t pid) {
+    std::scoped_lock lock{mAdmissionLock};
+
+    if (!hasHeadroom_l()) {
+        ALOGV("%s: pid %d not admitted, headroom %lld", __FUNCTION__, pid,
+              (long long)mCodecHeadroom);
+        mAdmissionRefused = true;
+        return false;
+    }
+    mReservedCodecs[pid] += kSessionCodecs;
+    ALOGV("%s: pid %d admitted, headroom %lld", __FUNCTION__, pid, (long long)mCodecHeadroom);
+    return true;
+}
+
+void TranscodingResourcePolicy::releaseSession(pid_t pid) {
+    std::scoped_lock lock{mAdmissionLock};
+
+    auto it = mReservedCodecs.find(pid);
+    if (it == mReservedCodecs.end()) {
+        return;
+    }
+    it->second -= kSessionCodecs;
+    if (it->second <= 0) {
+        mReservedCodecs.erase(it);
+    }
+}
+
+void TranscodingResourcePolicy::onCodecsChanged(pid_t pid, int64_t codecsRegistered) {
+    std::shared_ptr<IResourceManagerService> resourceManager;
+    {
+        std::scoped_lock lock{mRegisteredLock};
+        resourceManager = mResourceManager;
+    }
+    // Query before taking mAdmissionLock, so that admission never waits on a binder call.
+    int64_t headroom = getVideoCodecHeadroom(resourceManager);
+
+    bool retryAdmission = false;
+    {
+        std::scoped_lock lock{mAdmissionLock};
+        // The registered codecs are now counted by the headroom instead of the reservation.
+        auto it = mReservedCodecs.find(pid);
+        if (it != mReservedCodecs.end() && codecsRegistered > 0) {
+            it->second -= codecsRegistered;
+            if (it->second <= 0) {
+                mReservedCodecs.erase(it);
+            }
+        }
+        mCodecHeadroom = headroom;
+        if (mAdmissionRefused && hasHeadroom_l()) {
+            mAdmissionRefused = false;
+            retryAdmission = true;
+        }
+    }
+
+    std::shared_ptr<ResourcePolicyCallbackInterface> cb;
+    if (retryAdmission) {
+        std::scoped_lock lock{mCallbackLock};
+        cb = mResourcePolicyCallback.lock();
+    }
+    if (cb != nullptr) {
+        cb->onResourceAvailable();
+    }
+}
+
 void TranscodingResourcePolicy::onResourceAvailable(pid_t pid) {
     std::shared_ptr<ResourcePolicyCallbackInterface> cb;
     {
@@ -26,6 +26,7 @@
 #include <utils/AndroidThreads.h>
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <thread>
 #include <utility>
 
@@ -209,7 +210,7 @@ private:
     int32_t mBurstTimeQuotaSec;
 
     struct UidHistoryEntry {
-        bool sessionActive = false;
+        int32_t activeSessionCount = 0;
         int32_t burstCount = 0;
         std::chrono::steady_clock::duration burstDuration{0};
         std::chrono::steady_clock::time_point lastCompletedTime;
@@ -258,10 +259,11 @@ bool TranscodingSessionController::Pacer::onSessionStarted(uid_t uid, uid_t call
         return true;
     }
 
-    // If uid doesn't exist, only insert the entry and mark session active. Skip quota checking.
+    // If uid doesn't exist, only insert the entry and count the session active. Skip quota
+    // checking.
     if (mUidHistoryMap.find(uid) == mUidHistoryMap.end()) {
         mUidHistoryMap.emplace(uid, UidHistoryEntry{});
-        mUidHistoryMap[uid].sessionActive = true;
+        mUidHistoryMap[uid].activeSessionCount = 1;
         ALOGV("Pacer::onSessionStarted: uid %d: new", uid);
         return true;
     }
@@ -292,7 +294,7 @@ bool TranscodingSessionController::Pacer::onSessionStarted(uid_t uid, uid_t call
               (long long)mUidHistoryMap[uid].burstDuration.count() / 1000000);
     }
 
-    mUidHistoryMap[uid].sessionActive = true;
+    mUidHistoryMap[uid].activeSessionCount++;
     return true;
 }
 
@@ -300,12 +302,13 @@ void TranscodingSessionController::Pacer::onSessionCompleted(
         uid_t uid, std::chrono::microseconds runningTime) {
     // Skip quota update if this uid missed the start. (Could happen if the uid is added via
     // addClientUid() after the session start.)
-    if (mUidHistoryMap.find(uid) == mUidHistoryMap.end() || !mUidHistoryMap[uid].sessionActive) {
+    if (mUidHistoryMap.find(uid) == mUidHistoryMap.end() ||
+        mUidHistoryMap[uid].activeSessionCount == 0) {
         ALOGV("Pacer::onSessionCompleted: uid %d: not started", uid);
         return;
     }
     ALOGV("Pacer::onSessionCompleted: uid %d: runningTime %lld", uid, runningTime.count() / 1000);
-    mUidHistoryMap[uid].sessionActive = false;
+    mUidHistoryMap[uid].activeSessionCount--;
     mUidHistoryMap[uid].burstCount++;
     mUidHistoryMap[uid].burstDuration += runningTime;
     mUidHistoryMap[uid].lastCompletedTime = std::chrono::steady_clock::now();
@@ -320,7 +323,9 @@ void TranscodingSessionController::Pacer::onSessionCancelled(uid_t uid) {
     // or the original submitting client was gone but session was kept for offline use).
     // Since the uid is going to miss the onSessionCompleted(), we can't track this
     // session, and have to check back at next onSessionStarted().
-    mUidHistoryMap[uid].sessionActive = false;
+    if (mUidHistoryMap[uid].activeSessionCount > 0) {
+        mUidHistoryMap[uid].activeSessionCount--;
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -335,7 +340,6 @@ TranscodingSessionController::TranscodingSessionController(
         mUidPolicy(uidPolicy),
         mResourcePolicy(resourcePolicy),
         mThermalPolicy(thermalPolicy),
-        mCurrentSession(nullptr),
         mResourceLost(false) {
     // Only push empty offline queue initially. Realtime queues are added when requests come in.
     mUidSortedList.push_back(OFFLINE_UID);
@@ -346,10 +350,14 @@ TranscodingSessionController::TranscodingSessionController(
     if (config != nullptr) {
         mConfig = *config;
     }
+    if (mConfig.maxConcurrentSessions < 1) {
+        mConfig.maxConcurrentSessions = 1;
+    }
     mPacer.reset(new Pacer(mConfig));
-    ALOGD("@@@ watchdog %lld, burst count %d, burst time %d, burst threshold %d",
+    ALOGD("@@@ watchdog %lld, burst count %d, burst time %d, burst threshold %d, concurrency %d",
           (long long)mConfig.watchdogTimeoutUs, mConfig.pacerBurstCountQuota,
-          mConfig.pacerBurstTimeQuotaSeconds, mConfig.pacerBurstThresholdMs);
+          mConfig.pacerBurstTimeQuotaSeconds, mConfig.pacerBurstThresholdMs,
+          mConfig.maxConcurrentSessions);
 }
 
 TranscodingSessionController::~TranscodingSessionController() {}
@@ -389,6 +397,9 @@ void TranscodingSessionController::dumpAllSessions(int fd, const Vector<String16
     result.append(buffer);
     snprintf(buffer, SIZE, "  Total num of Sessions: %zu\n", mSessionMap.size());
     result.append(buffer);
+    snprintf(buffer, SIZE, "  Running sessions: %d, concurrency limit: %d\n",
+             getRunningSessionCount_l(), getConcurrencyLimit_l());
+    result.append(buffer);
 
     std::vector<int32_t> uids(mUidSortedList.begin(), mUidSortedList.end());
 
@@ -425,31 +436,107 @@ void TranscodingSessionController::dumpAllSessions(int fd, const Vector<String16
 }
 
 /*
- * Returns nullptr if there is no session, or we're paused globally (due to resource lost,
- * thermal throttling, etc.). Otherwise, return the session that should be run next.
+ * Returns the maximum number of sessions that can run at the same time. This is 0 if we're
+ * paused globally (due to resource lost, thermal throttling, etc.). Whether more than one
+ * session actually runs is up to the codec admission, see admitSession_l().
  */
-TranscodingSessionController::Session* TranscodingSessionController::getTopSession_l() {
-    if (mSessionMap.empty()) {
-        return nullptr;
-    }
-
-    // Return nullptr if we're paused globally due to resource lost or thermal throttling.
+int32_t TranscodingSessionController::getConcurrencyLimit_l() const {
     if (((mResourcePolicy != nullptr && mResourceLost) ||
          (mThermalPolicy != nullptr && mThermalThrottling))) {
-        return nullptr;
+        return 0;
     }
+    return mConfig.maxConcurrentSessions;
+}
 
-    uid_t topUid = *mUidSortedList.begin();
-    // If the current session is running, and it's in the topUid's queue, let it continue
-    // to run even if it's not the earliest in that uid's queue.
-    // For example, uid(B) is added to a session while it's pending in uid(A)'s queue, then
-    // B is brought to front which caused the session to run, then user switches back to A.
-    if (mCurrentSession != nullptr && mCurrentSession->getState() == Session::RUNNING &&
-        mCurrentSession->allClientUids.count(topUid) > 0) {
-        return mCurrentSession;
+int32_t TranscodingSessionController::getRunningSessionCount_l() const {
+    int32_t runningSessions = 0;
+    for (const TranscoderSlot& slot : mTranscoderSlots) {
+        if (slot.session != nullptr && slot.session->getState() == Session::RUNNING) {
+            runningSessions++;
+        }
+    }
+    return runningSessions;
+}
+
+/*
+ * Returns true if |session| can be started or resumed next to the running sessions.
+ * The first session always runs (as it did before concurrency was supported); any
+ * further session needs the resource policy to admit its codecs, which reserves them
+ * until the session registers them or stops running.
+ */
+bool TranscodingSessionController::admitSession_l(Session* session) {
+    if (mResourcePolicy == nullptr || getRunningSessionCount_l() == 0) {
+        return true;
+    }
+    session->codecsReserved = mResourcePolicy->admitSession(session->request.clientPid);
+    return session->codecsReserved;
+}
+
+/*
+ * Fills |sessions| with up to |limit| sessions that should be running, in priority order.
+ * The list is empty if there is no session, or we're paused globally. Sessions parked after
+ * a resource loss are skipped.
+ *
+ * Sessions are picked round-robin over the uids in mUidSortedList, so that every uid with
+ * pending sessions gets one running session before any uid gets a second one, and the
+ * earlier uids win when there are not enough slots. Within a uid's queue, sessions that
+ * are already running go first so that they're not interrupted. For example, uid(B) is
+ * added to a session while it's pending in uid(A)'s queue, then B is brought to front
+ * which caused the session to run, then user switches back to A.
+ */
+void TranscodingSessionController::getTopSessions_l(std::vector<Session*>* sessions,
+                                                    size_t limit) {
+    sessions->clear();
+
+    if (mSessionMap.empty() || limit == 0) {
+        return;
+    }
+
+    std::vector<std::vector<Session*>> candidates;
+    for (uid_t uid : mUidSortedList) {
+        std::vector<Session*> uidCandidates;
+        for (const SessionKeyType& sessionKey : mSessionQueues[uid]) {
+            if (mSessionMap[sessionKey].getState() == Session::RUNNING) {
+                uidCandidates.push_back(&mSessionMap[sessionKey]);
+            }
+        }
+        for (const SessionKeyType& sessionKey : mSessionQueues[uid]) {
+            if (mSessionMap[sessionKey].getState() != Session::RUNNING &&
+                !mSessionMap[sessionKey].resourceLost) {
+                uidCandidates.push_back(&mSessionMap[sessionKey]);
+            }
+        }
+        if (!uidCandidates.empty()) {
+            candidates.push_back(std::move(uidCandidates));
+        }
+    }
+
+    // A started session can only run on the slot holding its state, so two of them
+    // sharing a slot can't both be picked.
+    std::vector<bool> slotTaken(mTranscoderSlots.size(), false);
+    for (size_t round = 0; sessions->size() < limit; ++round) {
+        bool hasMore = false;
+        for (size_t i = 0; i < candidates.size() && sessions->size() < limit; ++i) {
+            if (round >= candidates[i].size()) {
+                continue;
+            }
+            hasMore = true;
+            Session* session = candidates[i][round];
+            if (std::find(sessions->begin(), sessions->end(), session) != sessions->end()) {
+                continue;
+            }
+            if (session->slot >= 0) {
+                if (slotTaken[session->slot]) {
+                    continue;
+                }
+                slotTaken[session->slot] = true;
+            }
+            sessions->push_back(session);
+        }
+        if (!hasMore) {
+            break;
+        }
     }
-    SessionKeyType topSessionKey = *mSessionQueues[topUid].begin();
-    return &mSessionMap[topSessionKey];
 }
 
 void TranscodingSessionController::setSessionState_l(Session* session, Session::State state) {
@@ -457,18 +544,27 @@ void TranscodingSessionController::setSessionState_l(Session* session, Session::
     session->setState(state);
     bool isRunning = (session->getState() == Session::RUNNING);
 
+    // Codecs admitted for the session that it didn't register are free again.
+    if (!isRunning && session->codecsReserved) {
+        mResourcePolicy->releaseSession(session->request.clientPid);
+        session->codecsReserved = false;
+    }
+
     if (wasRunning == isRunning) {
         return;
     }
 
-    // Currently we only have 1 running session, and we always put the previous
-    // session in non-running state before we run the new session, so it's okay
-    // to start/stop the watchdog here. If this assumption changes, we need to
-    // track the number of running sessions and start/stop watchdog based on that.
+    // Each slot runs at most 1 session, and we always put the previous session of
+    // a slot in non-running state before we run a new session on it, so it's okay
+    // to start/stop the slot's watchdog here.
+    if (session->slot < 0) {
+        return;
+    }
+    std::shared_ptr<Watchdog> watchdog = mTranscoderSlots[session->slot].watchdog;
     if (isRunning) {
-        mWatchdog->start(session->key);
+        watchdog->start(session->key);
     } else {
-        mWatchdog->stop();
+        watchdog->stop();
     }
 }
 
@@ -501,72 +597,129 @@ void TranscodingSessionController::Session::setState(Session::State newState) {
     state = newState;
 }
 
-void TranscodingSessionController::updateCurrentSession_l() {
-    Session* curSession = mCurrentSession;
-    Session* topSession = nullptr;
-
-    // Delayed init of transcoder and watchdog.
-    if (mTranscoder == nullptr) {
-        mTranscoder = mTranscoderFactory(shared_from_this());
-        mWatchdog = std::make_shared<Watchdog>(this, mConfig.watchdogTimeoutUs);
-    }
-
-    // If we found a different top session, or the top session's running state is not
-    // correct. Take some actions to ensure it's correct.
-    while ((topSession = getTopSession_l()) != curSession ||
-           (topSession != nullptr && !topSession->isRunning())) {
-        ALOGV("updateCurrentSession_l: topSession is %s, curSession is %s",
-              topSession == nullptr ? "null" : sessionToString(topSession->key).c_str(),
-              curSession == nullptr ? "null" : sessionToString(curSession->key).c_str());
-
-        // If current session is running, pause it first. Note this is needed for either
-        // cases: 1) Top session is changing to another session, or 2) Top session is
-        // changing to null (which means we should be globally paused).
-        if (curSession != nullptr && curSession->getState() == Session::RUNNING) {
-            mTranscoder->pause(curSession->key.first, curSession->key.second);
-            setSessionState_l(curSession, Session::PAUSED);
+/*
+ * Returns a slot that has no session selected to run on it, or -1 if there is none.
+ * Sessions paused on a slot can only resume there, so prefer the slot with the fewest
+ * of them to avoid two top sessions competing for the same slot later.
+ */
+int32_t TranscodingSessionController::getFreeSlot_l() {
+    std::vector<int32_t> pausedSessions(mTranscoderSlots.size(), 0);
+    for (auto const& s : mSessionMap) {
+        if (s.second.getState() == Session::PAUSED && s.second.slot >= 0) {
+            pausedSessions[s.second.slot]++;
         }
+    }
+    int32_t freeSlot = -1;
+    for (int32_t i = 0; i < (int32_t)mTranscoderSlots.size(); ++i) {
+        if (mTranscoderSlots[i].session == nullptr &&
+            (freeSlot < 0 || pausedSessions[i] < pausedSessions[freeSlot])) {
+            freeSlot = i;
+        }
+    }
+    return freeSlot;
+}
 
-        if (topSession == nullptr) {
-            // Nothing more to run (either no session or globally paused).
-            break;
+void TranscodingSessionController::updateRunningSessions_l() {
+    // Delayed init of transcoders and watchdogs.
+    if (mTranscoderSlots.empty()) {
+        mTranscoderSlots.resize(mConfig.maxConcurrentSessions);
+        for (TranscoderSlot& slot : mTranscoderSlots) {
+            slot.transcoder = mTranscoderFactory(shared_from_this());
+            slot.watchdog = std::make_shared<Watchdog>(this, mConfig.watchdogTimeoutUs);
         }
+    }
 
-        // Otherwise, ensure topSession is running.
-        if (topSession->getState() == Session::NOT_STARTED) {
-            // Check if at least one client has quota to start the session.
-            bool keepForClient = false;
-            for (uid_t uid : topSession->allClientUids) {
-                if (mPacer->onSessionStarted(uid, topSession->callingUid)) {
-                    keepForClient = true;
-                    // DO NOT break here, because book-keeping still needs to happen
-                    // for the other uids.
-                }
+    std::vector<Session*> topSessions;
+    size_t limit = getConcurrencyLimit_l();
+    while (true) {
+        getTopSessions_l(&topSessions, limit);
+
+        // If a running session is no longer among the top sessions, pause it first. Note
+        // this is needed for either cases: 1) Top sessions are changing to other sessions,
+        // or 2) Top sessions are changing to none (which means we should be globally paused).
+        for (TranscoderSlot& slot : mTranscoderSlots) {
+            Session* session = slot.session;
+            if (session == nullptr ||
+                std::find(topSessions.begin(), topSessions.end(), session) != topSessions.end()) {
+                continue;
+            }
+            ALOGV("updateRunningSessions_l: %s is no longer a top session",
+                  sessionToString(session->key).c_str());
+            if (session->getState() == Session::RUNNING) {
+                slot.transcoder->pause(session->key.first, session->key.second);
+                setSessionState_l(session, Session::PAUSED);
+            }
+            slot.session = nullptr;
+        }
+
+        // Paused sessions can only resume on their own slot, reserve those before
+        // handing the free slots to new sessions.
+        for (Session* session : topSessions) {
+            if (session->slot >= 0) {
+                mTranscoderSlots[session->slot].session = session;
             }
-            if (!keepForClient) {
-                // Unfortunately all uids requesting this session are out of quota.
-                // Drop this session and try the next one.
-                {
-                    auto clientCallback = mSessionMap[topSession->key].callback.lock();
-                    if (clientCallback != nullptr) {
-                        clientCallback->onTranscodingFailed(
-                                topSession->key.second, TranscodingErrorCode::kDroppedByService);
+        }
+
+        // Otherwise, ensure top sessions are running.
+        bool sessionDropped = false;
+        bool sessionNotAdmitted = false;
+        for (Session* session : topSessions) {
+            if ((session->getState() == Session::NOT_STARTED ||
+                 session->getState() == Session::PAUSED) &&
+                !admitSession_l(session)) {
+                // The codecs can't take one more session. Keep the sessions that are
+                // running and pick the top sessions again among them; admission is
+                // checked again when the running sessions change or resource is
+                // available.
+                ALOGV("updateRunningSessions_l: %s not admitted",
+                      sessionToString(session->key).c_str());
+                limit = getRunningSessionCount_l();
+                sessionNotAdmitted = true;
+                break;
+            }
+            if (session->getState() == Session::NOT_STARTED) {
+                // Check if at least one client has quota to start the session.
+                bool keepForClient = false;
+                for (uid_t uid : session->allClientUids) {
+                    if (mPacer->onSessionStarted(uid, session->callingUid)) {
+                        keepForClient = true;
+                        // DO NOT break here, because book-keeping still needs to happen
+                        // for the other uids.
                     }
                 }
-                removeSession_l(topSession->key, Session::DROPPED_BY_PACER);
-                continue;
+                if (!keepForClient) {
+                    // Unfortunately all uids requesting this session are out of quota.
+                    // Drop this session and pick the top sessions again.
+                    {
+                        auto clientCallback = mSessionMap[session->key].callback.lock();
+                        if (clientCallback != nullptr) {
+                            clientCallback->onTranscodingFailed(
+                                    session->key.second, TranscodingErrorCode::kDroppedByService);
+                        }
+                    }
+                    removeSession_l(session->key, Session::DROPPED_BY_PACER);
+                    sessionDropped = true;
+                    break;
+                }
+                session->slot = getFreeSlot_l();
+                LOG_ALWAYS_FATAL_IF(session->slot < 0, "no free transcoder slot for session %s",
+                                    sessionToString(session->key).c_str());
+                TranscoderSlot& slot = mTranscoderSlots[session->slot];
+                slot.session = session;
+                slot.transcoder->start(session->key.first, session->key.second, session->request,
+                                       session->callingUid, session->callback.lock());
+                setSessionState_l(session, Session::RUNNING);
+            } else if (session->getState() == Session::PAUSED) {
+                TranscoderSlot& slot = mTranscoderSlots[session->slot];
+                slot.transcoder->resume(session->key.first, session->key.second, session->request,
+                                        session->callingUid, session->callback.lock());
+                setSessionState_l(session, Session::RUNNING);
             }
-            mTranscoder->start(topSession->key.first, topSession->key.second, topSession->request,
-                               topSession->callingUid, topSession->callback.lock());
-            setSessionState_l(topSession, Session::RUNNING);
-        } else if (topSession->getState() == Session::PAUSED) {
-            mTranscoder->resume(topSession->key.first, topSession->key.second, topSession->request,
-                                topSession->callingUid, topSession->callback.lock());
-            setSessionState_l(topSession, Session::RUNNING);
         }
-        break;
+        if (!sessionDropped && !sessionNotAdmitted) {
+            break;
+        }
     }
-    mCurrentSession = topSession;
 }
 
 void TranscodingSessionController::addUidToSession_l(uid_t clientUid,
@@ -605,6 +758,9 @@ void TranscodingSessionController::removeSession_l(
         return;
     }
 
+    // Only a session that was started is counted active by the pacer.
+    bool sessionStarted = mSessionMap[sessionKey].getState() != Session::NOT_STARTED;
+
     // Remove session from uid's queue.
     bool uidQueueRemoved = false;
     std::unordered_set<uid_t> remainingUids;
@@ -617,7 +773,9 @@ void TranscodingSessionController::removeSession_l(
             // If we have uids to keep, the session is not going to any final
             // state we can't use onSessionCompleted as the running time will
             // not be valid. Only notify pacer to stop tracking this session.
-            mPacer->onSessionCancelled(uid);
+            if (sessionStarted) {
+                mPacer->onSessionCancelled(uid);
+            }
         }
         SessionQueueType& sessionQueue = mSessionQueues[uid];
         auto it = std::find(sessionQueue.begin(), sessionQueue.end(), sessionKey);
@@ -648,17 +806,21 @@ void TranscodingSessionController::removeSession_l(
         return;
     }
 
-    // Clear current session.
-    if (mCurrentSession == &mSessionMap[sessionKey]) {
-        mCurrentSession = nullptr;
+    // Release the session's transcoder slot.
+    for (TranscoderSlot& slot : mTranscoderSlots) {
+        if (slot.session == &mSessionMap[sessionKey]) {
+            slot.session = nullptr;
+        }
     }
 
     setSessionState_l(&mSessionMap[sessionKey], finalState);
 
     // We can use onSessionCompleted() even for CANCELLED, because runningTime is
     // now updated by setSessionState_l().
-    for (uid_t uid : mSessionMap[sessionKey].allClientUids) {
-        mPacer->onSessionCompleted(uid, mSessionMap[sessionKey].runningTime);
+    if (sessionStarted) {
+        for (uid_t uid : mSessionMap[sessionKey].allClientUids) {
+            mPacer->onSessionCompleted(uid, mSessionMap[sessionKey].runningTime);
+        }
     }
 
     mSessionHistory.push_back(mSessionMap[sessionKey]);
@@ -760,7 +922,7 @@ bool TranscodingSessionController::submit(
 
     addUidToSession_l(clientUid, sessionKey);
 
-    updateCurrentSession_l();
+    updateRunningSessions_l();
 
     validateState_l();
     return true;
@@ -801,7 +963,7 @@ bool TranscodingSessionController::cancel(ClientIdType clientId, SessionIdType s
         // the transcoder to discard any states for the session, otherwise the states may
         // never be discarded.
         if (mSessionMap[*it].getState() != Session::NOT_STARTED) {
-            mTranscoder->stop(it->first, it->second);
+            mTranscoderSlots[mSessionMap[*it].slot].transcoder->stop(it->first, it->second);
         }
 
         // Remove the session.
@@ -815,7 +977,7 @@ bool TranscodingSessionController::cancel(ClientIdType clientId, SessionIdType s
     }
 
     // Start next session.
-    updateCurrentSession_l();
+    updateRunningSessions_l();
 
     validateState_l();
     return true;
@@ -840,7 +1002,7 @@ bool TranscodingSessionController::addClientUid(ClientIdType clientId, SessionId
     mSessionMap[sessionKey].allClientUids.insert(clientUid);
     addUidToSession_l(clientUid, sessionKey);
 
-    updateCurrentSession_l();
+    updateRunningSessions_l();
 
     validateState_l();
     return true;
@@ -949,7 +1111,7 @@ void TranscodingSessionController::onFinish(ClientIdType clientId, SessionIdType
         removeSession_l(sessionKey, Session::FINISHED);
 
         // Start next session.
-        updateCurrentSession_l();
+        updateRunningSessions_l();
 
         validateState_l();
     });
@@ -961,10 +1123,11 @@ void TranscodingSessionController::onError(ClientIdType clientId, SessionIdType
         if (err == TranscodingErrorCode::kWatchdogTimeout) {
             // Abandon the transcoder, as its handler thread might be stuck in some call to
             // MediaTranscoder altogether, and may not be able to handle any new tasks.
-            mTranscoder->stop(clientId, sessionId, true /*abandon*/);
+            TranscoderSlot& slot = mTranscoderSlots[mSessionMap[sessionKey].slot];
+            slot.transcoder->stop(clientId, sessionId, true /*abandon*/);
             // Clear the last ref count before we create new transcoder.
-            mTranscoder = nullptr;
-            mTranscoder = mTranscoderFactory(shared_from_this());
+            slot.transcoder = nullptr;
+            slot.transcoder = mTranscoderFactory(shared_from_this());
         }
 
         {
@@ -978,7 +1141,7 @@ void TranscodingSessionController::onError(ClientIdType clientId, SessionIdType
         removeSession_l(sessionKey, Session::ERROR);
 
         // Start next session.
-        updateCurrentSession_l();
+        updateRunningSessions_l();
 
         validateState_l();
     });
@@ -996,8 +1159,9 @@ void TranscodingSessionController::onProgressUpdate(ClientIdType clientId, Sessi
 }
 
 void TranscodingSessionController::onHeartBeat(ClientIdType clientId, SessionIdType sessionId) {
-    notifyClient(clientId, sessionId, "heart-beat",
-                 [=](const SessionKeyType& /*sessionKey*/) { mWatchdog->keepAlive(); });
+    notifyClient(clientId, sessionId, "heart-beat", [=](const SessionKeyType& sessionKey) {
+        mTranscoderSlots[mSessionMap[sessionKey].slot].watchdog->keepAlive();
+    });
 }
 
 void TranscodingSessionController::onResourceLost(ClientIdType clientId, SessionIdType sessionId) {
@@ -1026,7 +1190,16 @@ void TranscodingSessionController::onResourceLost(ClientIdType clientId, Session
         if (mResourcePolicy != nullptr) {
             mResourcePolicy->setPidResourceLost(resourceLostSession->request.clientPid);
         }
-        mResourceLost = true;
+        // Park the session until resource is available, otherwise it would be picked
+        // again as soon as a slot frees up and lose its codecs again. If other sessions
+        // are still running, they hold the codecs this session competed for, so they
+        // continue and any other session has to be admitted. Otherwise pause globally.
+        resourceLostSession->resourceLost = true;
+        if (getRunningSessionCount_l() == 0) {
+            mResourceLost = true;
+        }
+
+        updateRunningSessions_l();
 
         validateState_l();
     });
@@ -1052,7 +1225,7 @@ void TranscodingSessionController::onTopUidsChanged(const std::unordered_set<uid
 
     moveUidsToTop_l(uids, true /*preserveTopUid*/);
 
-    updateCurrentSession_l();
+    updateRunningSessions_l();
 
     validateState_l();
 }
@@ -1082,7 +1255,7 @@ void TranscodingSessionController::onUidGone(uid_t goneUid) {
         // the transcoder to discard any states for the session, otherwise the states may
         // never be discarded.
         if (mSessionMap[*it].getState() != Session::NOT_STARTED) {
-            mTranscoder->stop(it->first, it->second);
+            mTranscoderSlots[mSessionMap[*it].slot].transcoder->stop(it->first, it->second);
         }
 
         {
@@ -1104,7 +1277,7 @@ void TranscodingSessionController::onUidGone(uid_t goneUid) {
     }
 
     // Start next session.
-    updateCurrentSession_l();
+    updateRunningSessions_l();
 
     validateState_l();
 }
@@ -1112,14 +1285,20 @@ void TranscodingSessionController::onUidGone(uid_t goneUid) {
 void TranscodingSessionController::onResourceAvailable() {
     std::scoped_lock lock{mLock};
 
-    if (!mResourceLost) {
-        return;
+    bool sessionParked = false;
+    for (auto& session : mSessionMap) {
+        if (session.second.resourceLost) {
+            session.second.resourceLost = false;
+            sessionParked = true;
+        }
+    }
+    if (mResourceLost || sessionParked) {
+        ALOGI("%s", __FUNCTION__);
     }
 
-    ALOGI("%s", __FUNCTION__);
-
+    // Sessions that were not admitted next to the running ones may fit now as well.
     mResourceLost = false;
-    updateCurrentSession_l();
+    updateRunningSessions_l();
 
     validateState_l();
 }
@@ -1134,7 +1313,7 @@ void TranscodingSessionController::onThrottlingStarted() {
     ALOGI("%s", __FUNCTION__);
 
     mThermalThrottling = true;
-    updateCurrentSession_l();
+    updateRunningSessions_l();
 
     validateState_l();
 }
@@ -1149,7 +1328,7 @@ void TranscodingSessionController::onThrottlingStopped() {
     ALOGI("%s", __FUNCTION__);
 
     mThermalThrottling = false;
-    updateCurrentSession_l();
+    updateRunningSessions_l();
 
     validateState_l();
 }
@@ -1184,6 +1363,19 @@ void TranscodingSessionController::validateState_l() {
                         "session count (including dup) from mSessionQueues doesn't match that from "
                         "mSessionMap, %d vs %d",
                         totalSessions, totalSessionsAlternative);
+
+    int32_t runningSessions = 0;
+    for (auto const& s : mSessionMap) {
+        if (s.second.getState() == Session::RUNNING) {
+            LOG_ALWAYS_FATAL_IF(mTranscoderSlots[s.second.slot].session != &s.second,
+                                "running session %s doesn't own its slot %d",
+                                sessionToString(s.first).c_str(), s.second.slot);
+            runningSessions++;
+        }
+    }
+    LOG_ALWAYS_FATAL_IF(runningSessions > mConfig.maxConcurrentSessions,
+                        "%d sessions running, more than the limit %d", runningSessions,
+                        mConfig.maxConcurrentSessions);
 #endif  // VALIDATE_STATE
 }
 
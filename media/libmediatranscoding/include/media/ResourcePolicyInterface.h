@@ -28,6 +28,14 @@ public:
     // status changes. (Set to nullptr will stop the updates.)
     virtual void setCallback(const std::shared_ptr<ResourcePolicyCallbackInterface>& cb) = 0;
     virtual void setPidResourceLost(pid_t pid) = 0;
+    // Returns true if the codecs needed to run one more session on behalf of |pid| are
+    // expected to be available, without reclaiming them from other processes. The codecs
+    // of an admitted session stay reserved until they're registered by |pid|, so that
+    // they're not admitted twice.
+    virtual bool admitSession(pid_t pid) = 0;
+    // Drops what's left of the reservation of a session admitted on behalf of |pid|,
+    // once the session is no longer running.
+    virtual void releaseSession(pid_t pid) = 0;
 
 protected:
     virtual ~ResourcePolicyInterface() = default;
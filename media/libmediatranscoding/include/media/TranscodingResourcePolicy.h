@@ -21,10 +21,12 @@
 #include <media/ResourcePolicyInterface.h>
 #include <utils/Condition.h>
 
+#include <map>
 #include <mutex>
 namespace aidl {
 namespace android {
 namespace media {
+class IResourceManagerService;
 class IResourceObserverService;
 }
 }  // namespace android
@@ -32,6 +34,7 @@ class IResourceObserverService;
 
 namespace android {
 
+using ::aidl::android::media::IResourceManagerService;
 using ::aidl::android::media::IResourceObserverService;
 
 class TranscodingResourcePolicy : public ResourcePolicyInterface {
@@ -41,14 +44,26 @@ public:
 
     void setCallback(const std::shared_ptr<ResourcePolicyCallbackInterface>& cb) override;
     void setPidResourceLost(pid_t pid) override;
+    bool admitSession(pid_t pid) override;
+    void releaseSession(pid_t pid) override;
 
 private:
     struct ResourceObserver;
     mutable std::mutex mRegisteredLock;
     bool mRegistered GUARDED_BY(mRegisteredLock);
     std::shared_ptr<IResourceObserverService> mService GUARDED_BY(mRegisteredLock);
+    std::shared_ptr<IResourceManagerService> mResourceManager GUARDED_BY(mRegisteredLock);
     std::shared_ptr<ResourceObserver> mObserver;
 
+    // Sessions are admitted against the video codec headroom last queried from the
+    // resource manager, so that admission doesn't make binder calls. The headroom is
+    // queried again whenever video codecs are registered or released.
+    mutable std::mutex mAdmissionLock;
+    int64_t mCodecHeadroom GUARDED_BY(mAdmissionLock);
+    // Codecs of admitted sessions that are not registered yet, by pid.
+    std::map<pid_t, int64_t> mReservedCodecs GUARDED_BY(mAdmissionLock);
+    bool mAdmissionRefused GUARDED_BY(mAdmissionLock);
+
     mutable std::mutex mCallbackLock;
     std::weak_ptr<ResourcePolicyCallbackInterface> mResourcePolicyCallback
             GUARDED_BY(mCallbackLock);
@@ -61,6 +76,8 @@ private:
     void registerSelf();
     void unregisterSelf();
     void onResourceAvailable(pid_t pid);
+    void onCodecsChanged(pid_t pid, int64_t codecsRegistered);
+    bool hasHeadroom_l() const;
 };  // class TranscodingUidPolicy
 
 }  // namespace android
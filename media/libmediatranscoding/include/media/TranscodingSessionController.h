@@ -32,6 +32,7 @@
 #include <list>
 #include <map>
 #include <mutex>
+#include <vector>
 
 namespace android {
 using ::aidl::android::media::TranscodingResultParcel;
@@ -93,6 +94,7 @@ public:
 private:
     friend class MediaTranscodingService;
     friend class TranscodingSessionControllerTest;
+    friend class TranscodingSessionControllerBenchmark;
 
     using SessionKeyType = std::pair<ClientIdType, SessionIdType>;
     using SessionQueueType = std::list<SessionKeyType>;
@@ -108,6 +110,8 @@ private:
         int32_t pacerBurstCountQuota = 10;
         // Maximum allowed back-to-back running time.
         int32_t pacerBurstTimeQuotaSeconds = 120;  // 2-min
+        // Maximum number of sessions allowed to run at the same time.
+        int32_t maxConcurrentSessions = 1;
     };
 
     struct Session {
@@ -132,6 +136,14 @@ private:
         std::chrono::microseconds waitingTime{0};
         std::chrono::microseconds runningTime{0};
         std::chrono::microseconds pausedTime{0};
+        // Transcoder slot the session was started on, or -1 if never started.
+        // A paused session keeps its slot as the transcoder there holds its state.
+        int32_t slot = -1;
+        // Set when the session lost its codecs. It's parked (not picked to run) until
+        // resource is available again, so that it doesn't keep losing them.
+        bool resourceLost = false;
+        // Set while the resource policy holds codecs admitted for the session.
+        bool codecsReserved = false;
 
         TranscodingRequest request;
         std::weak_ptr<ITranscodingClientCallback> callback;
@@ -148,6 +160,14 @@ private:
     struct Watchdog;
     struct Pacer;
 
+    // A transcoder instance with its own watchdog, able to run one session at a time.
+    struct TranscoderSlot {
+        std::shared_ptr<TranscoderInterface> transcoder;
+        std::shared_ptr<Watchdog> watchdog;
+        // Session currently running on (or selected to run on) this slot.
+        Session* session = nullptr;
+    };
+
     ControllerConfig mConfig;
 
     // TODO(chz): call transcoder without global lock.
@@ -166,16 +186,14 @@ private:
     std::map<uid_t, std::string> mUidPackageNames;
 
     TranscoderFactoryType mTranscoderFactory;
-    std::shared_ptr<TranscoderInterface> mTranscoder;
+    std::vector<TranscoderSlot> mTranscoderSlots;
     std::shared_ptr<UidPolicyInterface> mUidPolicy;
     std::shared_ptr<ResourcePolicyInterface> mResourcePolicy;
     std::shared_ptr<ThermalPolicyInterface> mThermalPolicy;
 
-    Session* mCurrentSession;
     bool mResourceLost;
     bool mThermalThrottling;
     std::list<Session> mSessionHistory;
-    std::shared_ptr<Watchdog> mWatchdog;
     std::shared_ptr<Pacer> mPacer;
 
     // Only allow MediaTranscodingService and unit tests to instantiate.
@@ -186,8 +204,12 @@ private:
                                  const ControllerConfig* config = nullptr);
 
     void dumpSession_l(const Session& session, String8& result, bool closedSession = false);
-    Session* getTopSession_l();
-    void updateCurrentSession_l();
+    int32_t getConcurrencyLimit_l() const;
+    void getTopSessions_l(std::vector<Session*>* sessions, size_t limit);
+    int32_t getFreeSlot_l();
+    int32_t getRunningSessionCount_l() const;
+    bool admitSession_l(Session* session);
+    void updateRunningSessions_l();
     void addUidToSession_l(uid_t uid, const SessionKeyType& sessionKey);
     void removeSession_l(const SessionKeyType& sessionKey, Session::State finalState,
                          const std::shared_ptr<std::function<bool(uid_t uid)>>& keepUid = nullptr);
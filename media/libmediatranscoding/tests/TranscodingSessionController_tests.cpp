@@ -90,8 +90,18 @@ public:
     // ResourcePolicyInterface
     void setCallback(const std::shared_ptr<ResourcePolicyCallbackInterface>& /*cb*/) override {}
     void setPidResourceLost(pid_t pid) override { mResourceLostPid = pid; }
+    bool admitSession(pid_t /*pid*/) override {
+        if (mAdmitSessions) {
+            mReservedSessions++;
+        }
+        return mAdmitSessions;
+    }
+    void releaseSession(pid_t /*pid*/) override { mReservedSessions--; }
     // ~ResourcePolicyInterface
 
+    void setAdmitSessions(bool admit) { mAdmitSessions = admit; }
+    int32_t getReservedSessions() const { return mReservedSessions; }
+
     pid_t getPid() {
         pid_t result = mResourceLostPid;
         reset();
@@ -101,6 +111,8 @@ public:
 private:
     void reset() { mResourceLostPid = kInvalidPid; }
     pid_t mResourceLostPid;
+    bool mAdmitSessions = true;
+    int32_t mReservedSessions = 0;
 };
 
 class TestThermalPolicy : public ThermalPolicyInterface {
@@ -1344,4 +1356,101 @@ TEST_F(TranscodingSessionControllerTest, TestTranscoderPacerSelfUid) {
                                12 /*expectedSuccess*/);
 }
 
+/*
+ * Test running multiple sessions at the same time. Sessions should be shared fairly
+ * among uids, and a running session should not be interrupted by top uid changes
+ * as long as it's still among the top sessions.
+ */
+TEST_F(TranscodingSessionControllerTest, TestConcurrentSessions) {
+    ALOGD("TestConcurrentSessions");
+
+    TranscodingSessionController::ControllerConfig config = {
+            .maxConcurrentSessions = 2,
+    };
+    std::shared_ptr<TranscodingSessionController> controller(new TranscodingSessionController(
+            [this](const std::shared_ptr<TranscoderCallbackInterface>& /*cb*/) {
+                // All slots share the test transcoder, so that events are recorded in order.
+                mTranscoder->onCreated();
+                return mTranscoder;
+            },
+            mUidPolicy, mResourcePolicy, mThermalPolicy, &config));
+    mUidPolicy->setCallback(controller);
+
+    // Start with UID(0) on top.
+    mUidPolicy->setTop(UID(0));
+
+    // Submit real-time session to CLIENT(0), should start immediately.
+    controller->submit(CLIENT(0), SESSION(0), UID(0), UID(0), mRealtimeRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(0)));
+
+    // Submit real-time session to CLIENT(1) in UID(1), should start in parallel.
+    controller->submit(CLIENT(1), SESSION(0), UID(1), UID(1), mRealtimeRequest, mClientCallback1);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(1), SESSION(0)));
+
+    // Submit another real-time session to CLIENT(0), should be queued as UID(1) already
+    // holds its fair share.
+    controller->submit(CLIENT(0), SESSION(1), UID(0), UID(0), mRealtimeRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    // Submit offline session, should be queued.
+    controller->submit(CLIENT(2), SESSION(0), UID(2), UID(2), mOfflineRequest, mClientCallback2);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    // Finish CLIENT(0)'s first session, its next session should start.
+    controller->onFinish(CLIENT(0), SESSION(0));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Finished(CLIENT(0), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(1)));
+
+    // Bring UID(1) to top, both running sessions are still top sessions, so no change.
+    mUidPolicy->setTop(UID(1));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    // Thermal throttling should pause all running sessions, and resume them afterwards.
+    controller->onThrottlingStarted();
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Pause(CLIENT(0), SESSION(1)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Pause(CLIENT(1), SESSION(0)));
+    controller->onThrottlingStopped();
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Resume(CLIENT(1), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Resume(CLIENT(0), SESSION(1)));
+
+    // Finish CLIENT(1)'s session, offline session should start.
+    controller->onFinish(CLIENT(1), SESSION(0));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Finished(CLIENT(1), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(2), SESSION(0)));
+
+    // Resource lost on one session should only pause that session.
+    controller->onResourceLost(CLIENT(2), SESSION(0));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    // New sessions shouldn't start next to the running one if the codecs can't admit them.
+    mResourcePolicy->setAdmitSessions(false);
+    controller->submit(CLIENT(3), SESSION(0), UID(3), UID(3), mRealtimeRequest, mClientCallback3);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    // Cancel CLIENT(0)'s session, the new real-time session should start on its own. The
+    // offline session is parked and shouldn't resume until resource is available.
+    controller->cancel(CLIENT(0), SESSION(1));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Stop(CLIENT(0), SESSION(1)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(3), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    // Signal resource available, offline session still can't run in parallel while
+    // admission fails.
+    controller->onResourceAvailable();
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    // Once the codecs admit it, the offline session resumes in parallel on the next
+    // resource available, and holds a codec reservation while it runs.
+    int32_t reservedSessions = mResourcePolicy->getReservedSessions();
+    mResourcePolicy->setAdmitSessions(true);
+    controller->onResourceAvailable();
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Resume(CLIENT(2), SESSION(0)));
+    EXPECT_EQ(mResourcePolicy->getReservedSessions(), reservedSessions + 1);
+
+    // The reservation is released when the session stops running.
+    controller->onFinish(CLIENT(2), SESSION(0));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Finished(CLIENT(2), SESSION(0)));
+    EXPECT_EQ(mResourcePolicy->getReservedSessions(), reservedSessions);
+}
+
 }  // namespace android
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "MediaSampleBufferPool"
+
+#include <android-base/logging.h>
+#include <media/MediaSampleBufferPool.h>
+
+#include <algorithm>
+
+namespace android {
+
+MediaSampleBufferPool::~MediaSampleBufferPool() {
+    for (auto it = mBufferSizeClasses.begin(); it != mBufferSizeClasses.end(); ++it) {
+        delete[] it->first;
+    }
+}
+
+// static
+size_t MediaSampleBufferPool::getSizeClass(size_t size) {
+    size_t sizeClass = 0;
+    while (getSizeClassBufferSize(sizeClass) < size) {
+        ++sizeClass;
+    }
+    return sizeClass;
+}
+
+uint8_t* MediaSampleBufferPool::takeFreeBuffer_l(size_t firstClass, size_t endClass) {
+    for (size_t i = firstClass; i < std::min(endClass, mFreeBuffers.size()); ++i) {
+        if (!mFreeBuffers[i].empty()) {
+            uint8_t* buffer = mFreeBuffers[i].back();
+            mFreeBuffers[i].pop_back();
+            --mFreeBufferCount;
+            return buffer;
+        }
+    }
+    return nullptr;
+}
+
+uint8_t* MediaSampleBufferPool::getBufferWithSize(size_t minimumBufferSize)
+        NO_THREAD_SAFETY_ANALYSIS {
+    std::unique_lock lock(mMutex);
+
+    // Wait if maximum number of buffers are allocated but none are free.
+    while (mBufferSizeClasses.size() >= mMaxBufferCount && mFreeBufferCount == 0 && !mAborted) {
+        mCondition.wait(lock);
+    }
+
+    if (mAborted) {
+        return nullptr;
+    }
+
+    // Reuse a free buffer of the same size class, or of a larger one up to twice the size.
+    const size_t sizeClass = getSizeClass(minimumBufferSize);
+    uint8_t* buffer = takeFreeBuffer_l(sizeClass, sizeClass + kSizeClassesPerOctave + 1);
+    if (buffer != nullptr) {
+        return buffer;
+    }
+
+    // If the maximum buffer count is reached, reuse any larger free buffer rather than allocating,
+    // or else release a smaller one.
+    if (mBufferSizeClasses.size() >= mMaxBufferCount) {
+        buffer = takeFreeBuffer_l(sizeClass, mFreeBuffers.size());
+        if (buffer != nullptr) {
+            return buffer;
+        }
+        buffer = takeFreeBuffer_l(0, sizeClass);
+        mBufferSizeClasses.erase(buffer);
+        delete[] buffer;
+    }
+
+    // Allocate a new buffer.
+    buffer = new (std::nothrow) uint8_t[getSizeClassBufferSize(sizeClass)];
+    if (buffer == nullptr) {
+        LOG(ERROR) << "Unable to allocate new buffer of size: " << minimumBufferSize;
+        return nullptr;
+    }
+
+    // Add the buffer to the tracking map.
+    mBufferSizeClasses.emplace(buffer, sizeClass);
+    return buffer;
+}
+
+void MediaSampleBufferPool::returnBuffer(uint8_t* buffer) {
+    std::scoped_lock lock(mMutex);
+
+    auto it = mBufferSizeClasses.find(buffer);
+    if (buffer == nullptr || it == mBufferSizeClasses.end()) {
+        LOG(WARNING) << "Ignoring untracked buffer " << buffer;
+        return;
+    }
+
+    const size_t sizeClass = it->second;
+    if (sizeClass >= mFreeBuffers.size()) {
+        mFreeBuffers.resize(sizeClass + 1);
+    }
+    mFreeBuffers[sizeClass].push_back(buffer);
+    ++mFreeBufferCount;
+    mCondition.notify_one();
+}
+
+void MediaSampleBufferPool::abort() {
+    std::scoped_lock lock(mMutex);
+    mAborted = true;
+    mCondition.notify_all();
+}
+
+}  // namespace android
@@ -20,6 +20,8 @@
 #include <android-base/logging.h>
 #include <media/MediaSampleQueue.h>
 
+#include <algorithm>
+
 namespace android {
 
 bool MediaSampleQueue::enqueue(const std::shared_ptr<MediaSample>& sample) {
@@ -60,4 +62,93 @@ void MediaSampleQueue::abort() {
     mAborted = true;
     mCondition.notify_all();
 }
-}  // namespace android
\ No newline at end of file
+
+static size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+MediaSampleSpscQueue::MediaSampleSpscQueue(size_t capacity)
+      : mSlots(roundUpToPowerOfTwo(std::max<size_t>(capacity, 1))), mMask(mSlots.size() - 1) {}
+
+// The waiting flags and indices are accessed with sequential consistency so that either the
+// waiting thread sees the updated index, or the other thread sees the waiting flag and wakes it up
+// through the mutex.
+template <typename Predicate>
+void MediaSampleSpscQueue::waitUntil(std::atomic_bool* waiting, Predicate ready)
+        NO_THREAD_SAFETY_ANALYSIS {
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true) {
+        waiting->store(true);
+        if (ready() || mAborted) {
+            break;
+        }
+        mCondition.wait(lock);
+    }
+    waiting->store(false);
+}
+
+void MediaSampleSpscQueue::wake(std::atomic_bool* waiting) {
+    // Clear the flag so that only the first update after the other thread blocked wakes it up.
+    if (waiting->load() && waiting->exchange(false)) {
+        std::scoped_lock<std::mutex> lock(mMutex);
+        mCondition.notify_all();
+    }
+}
+
+bool MediaSampleSpscQueue::enqueue(const std::shared_ptr<MediaSample>& sample) {
+    const size_t tail = mTail.load(std::memory_order_relaxed);
+    auto hasSpace = [this, tail] { return tail - mHead.load() < mSlots.size(); };
+
+    if (!hasSpace() && !mAborted) {
+        waitUntil(&mProducerWaiting, hasSpace);
+    }
+    if (mAborted) {
+        return true;
+    }
+
+    mSlots[tail & mMask] = sample;
+    mTail.store(tail + 1);
+    wake(&mConsumerWaiting);
+    return false;
+}
+
+bool MediaSampleSpscQueue::dequeue(std::shared_ptr<MediaSample>* sample) {
+    const size_t head = mHead.load(std::memory_order_relaxed);
+    auto hasSample = [this, head] { return mTail.load() != head; };
+
+    if (!hasSample() && !mAborted) {
+        waitUntil(&mConsumerWaiting, hasSample);
+    }
+    if (mAborted) {
+        return true;
+    }
+
+    std::shared_ptr<MediaSample>& slot = mSlots[head & mMask];
+    if (sample != nullptr) {
+        *sample = std::move(slot);
+    }
+    slot.reset();
+    mHead.store(head + 1);
+
+    // Let a blocked producer sleep until half of the queue has been drained, so that producer and
+    // consumer don't wake each other up for every sample while the queue is full.
+    if (mTail.load() - (head + 1) <= mSlots.size() / 2) {
+        wake(&mProducerWaiting);
+    }
+    return false;
+}
+
+bool MediaSampleSpscQueue::isEmpty() {
+    return mAborted || mHead.load() == mTail.load();
+}
+
+void MediaSampleSpscQueue::abort() {
+    mAborted = true;
+    std::scoped_lock<std::mutex> lock(mMutex);
+    mCondition.notify_all();
+}
+}  // namespace android
@@ -19,6 +19,8 @@
 
 #include <android-base/logging.h>
 #include <media/MediaSampleReaderNDK.h>
+#include <media/NdkMediaDataSource.h>
+#include <unistd.h>
 
 #include <algorithm>
 #include <cmath>
@@ -49,6 +51,68 @@ std::shared_ptr<MediaSampleReader> MediaSampleReaderNDK::createFromFd(int fd, si
     return sampleReader;
 }
 
+struct MediaSampleReaderNDK::PositionalFdSource {
+    int fd;
+    size_t offset;
+    size_t size;
+
+    PositionalFdSource(int fd, size_t offset, size_t size) : fd(fd), offset(offset), size(size) {}
+    ~PositionalFdSource() { close(fd); }
+
+    static ssize_t readAt(void* userdata, off64_t offset, void* buffer, size_t size) {
+        PositionalFdSource* source = static_cast<PositionalFdSource*>(userdata);
+        if (offset < 0 || static_cast<size_t>(offset) > source->size) {
+            return -1;
+        }
+        size = std::min(size, source->size - static_cast<size_t>(offset));
+        return TEMP_FAILURE_RETRY(pread64(source->fd, buffer, size, source->offset + offset));
+    }
+
+    static ssize_t getSize(void* userdata) {
+        return static_cast<PositionalFdSource*>(userdata)->size;
+    }
+};
+
+// static
+std::shared_ptr<MediaSampleReaderNDK> MediaSampleReaderNDK::createFromFdWithPositionalReads(
+        int fd, size_t offset, size_t size) {
+    int dupFd = dup(fd);
+    if (dupFd < 0) {
+        LOG(ERROR) << "Unable to duplicate fd " << fd;
+        return nullptr;
+    }
+    auto source = std::make_unique<PositionalFdSource>(dupFd, offset, size);
+
+    AMediaDataSource* dataSource = AMediaDataSource_new();
+    if (dataSource == nullptr) {
+        LOG(ERROR) << "Unable to allocate AMediaDataSource";
+        return nullptr;
+    }
+    AMediaDataSource_setUserdata(dataSource, source.get());
+    AMediaDataSource_setReadAt(dataSource, &PositionalFdSource::readAt);
+    AMediaDataSource_setGetSize(dataSource, &PositionalFdSource::getSize);
+
+    AMediaExtractor* extractor = AMediaExtractor_new();
+    if (extractor == nullptr) {
+        LOG(ERROR) << "Unable to allocate AMediaExtractor";
+        AMediaDataSource_delete(dataSource);
+        return nullptr;
+    }
+
+    // The extractor keeps its own copy of the data source callbacks.
+    media_status_t status = AMediaExtractor_setDataSourceCustom(extractor, dataSource);
+    AMediaDataSource_delete(dataSource);
+    if (status != AMEDIA_OK) {
+        LOG(ERROR) << "AMediaExtractor_setDataSourceCustom returned error: " << status;
+        AMediaExtractor_delete(extractor);
+        return nullptr;
+    }
+
+    auto sampleReader = std::shared_ptr<MediaSampleReaderNDK>(new MediaSampleReaderNDK(extractor));
+    sampleReader->mPositionalFdSource = std::move(source);
+    return sampleReader;
+}
+
 MediaSampleReaderNDK::MediaSampleReaderNDK(AMediaExtractor* extractor)
       : mExtractor(extractor), mTrackCount(AMediaExtractor_getTrackCount(mExtractor)) {
     if (mTrackCount > 0) {
@@ -317,6 +381,25 @@ media_status_t MediaSampleReaderNDK::setEnforceSequentialAccess(bool enforce) {
     return AMEDIA_OK;
 }
 
+media_status_t MediaSampleReaderNDK::seekTo(int64_t timeUs) {
+    std::scoped_lock lock(mExtractorMutex);
+
+    if (mTrackSignals.empty()) {
+        LOG(ERROR) << "Tracks must be selected before seeking.";
+        return AMEDIA_ERROR_INVALID_OPERATION;
+    } else if (mExtractorTrackIndex >= 0) {
+        LOG(ERROR) << "seekTo must be called before sample reading begins.";
+        return AMEDIA_ERROR_UNSUPPORTED;
+    }
+
+    media_status_t status = AMediaExtractor_seekTo(mExtractor, std::max(timeUs, (int64_t)0),
+                                                   AMEDIAEXTRACTOR_SEEK_PREVIOUS_SYNC);
+    if (status != AMEDIA_OK) {
+        LOG(ERROR) << "Unable to seek to " << timeUs << ": " << status;
+    }
+    return status;
+}
+
 media_status_t MediaSampleReaderNDK::getEstimatedBitrateForTrack(int trackIndex, int32_t* bitrate) {
     std::scoped_lock lock(mExtractorMutex);
     media_status_t status = AMEDIA_OK;
@@ -24,6 +24,7 @@
 #include <media/MediaTranscoder.h>
 #include <media/NdkCommon.h>
 #include <media/PassthroughTrackTranscoder.h>
+#include <media/SegmentedVideoTrackTranscoder.h>
 #include <media/VideoTrackTranscoder.h>
 #include <sys/prctl.h>
 #include <unistd.h>
@@ -278,6 +279,8 @@ media_status_t MediaTranscoder::configureSource(int fd) {
         mSourceTrackFormats.emplace_back(trackFormat, &AMediaFormat_delete);
     }
 
+    // Keep a duplicate of the source fd as the caller may close it once configured.
+    mSourceFd.reset(dup(fd));
     return AMEDIA_OK;
 }
 
@@ -292,6 +295,19 @@ std::vector<std::shared_ptr<AMediaFormat>> MediaTranscoder::getTrackFormats() co
     return trackFormats;
 }
 
+media_status_t MediaTranscoder::configureVideoSegmentCount(int32_t segmentCount) {
+    if (mSampleReader == nullptr) {
+        LOG(ERROR) << "Source must be configured before the video segment count";
+        return AMEDIA_ERROR_INVALID_OPERATION;
+    } else if (segmentCount < 1) {
+        LOG(ERROR) << "Invalid video segment count: " << segmentCount;
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    }
+
+    mVideoSegmentCount = segmentCount;
+    return AMEDIA_OK;
+}
+
 media_status_t MediaTranscoder::configureTrackFormat(size_t trackIndex,
                                                      AMediaFormat* destinationOptions) {
     if (mSampleReader == nullptr) {
@@ -305,6 +321,7 @@ media_status_t MediaTranscoder::configureTrackFormat(size_t trackIndex,
 
     std::shared_ptr<MediaTrackTranscoder> transcoder;
     std::shared_ptr<AMediaFormat> trackFormat;
+    bool segmented = false;
 
     if (destinationOptions == nullptr) {
         transcoder = std::make_shared<PassthroughTrackTranscoder>(shared_from_this());
@@ -333,7 +350,13 @@ media_status_t MediaTranscoder::configureTrackFormat(size_t trackIndex,
             }
         }
 
-        transcoder = VideoTrackTranscoder::create(shared_from_this(), mPid, mUid);
+        segmented = mVideoSegmentCount > 1 && mSourceFd.get() >= 0;
+        if (segmented) {
+            transcoder = SegmentedVideoTrackTranscoder::create(
+                    shared_from_this(), mSourceFd.get(), mVideoSegmentCount, mPid, mUid);
+        } else {
+            transcoder = VideoTrackTranscoder::create(shared_from_this(), mPid, mUid);
+        }
 
         trackFormat = createVideoTrackFormat(srcTrackFormat, destinationOptions);
         if (trackFormat == nullptr) {
@@ -342,17 +365,24 @@ media_status_t MediaTranscoder::configureTrackFormat(size_t trackIndex,
         }
     }
 
-    media_status_t status = mSampleReader->selectTrack(trackIndex);
-    if (status != AMEDIA_OK) {
-        LOG(ERROR) << "Unable to select track " << trackIndex;
-        return status;
+    // Segmented tracks read the source through their own readers. Selecting the track on the
+    // shared reader would stall the other tracks once sequential access is enforced.
+    media_status_t status = AMEDIA_OK;
+    if (!segmented) {
+        status = mSampleReader->selectTrack(trackIndex);
+        if (status != AMEDIA_OK) {
+            LOG(ERROR) << "Unable to select track " << trackIndex;
+            return status;
+        }
     }
 
     status = transcoder->configure(mSampleReader, trackIndex, trackFormat);
     if (status != AMEDIA_OK) {
         LOG(ERROR) << "Configure track transcoder for track #" << trackIndex << " returned error "
                    << status;
-        mSampleReader->unselectTrack(trackIndex);
+        if (!segmented) {
+            mSampleReader->unselectTrack(trackIndex);
+        }
         return status;
     }
 
@@ -21,72 +21,9 @@
 #include <media/PassthroughTrackTranscoder.h>
 #include <sys/prctl.h>
 
-namespace android {
-
-PassthroughTrackTranscoder::BufferPool::~BufferPool() {
-    for (auto it = mAddressSizeMap.begin(); it != mAddressSizeMap.end(); ++it) {
-        delete[] it->first;
-    }
-}
-
-uint8_t* PassthroughTrackTranscoder::BufferPool::getBufferWithSize(size_t minimumBufferSize)
-        NO_THREAD_SAFETY_ANALYSIS {
-    std::unique_lock lock(mMutex);
-
-    // Wait if maximum number of buffers are allocated but none are free.
-    while (mAddressSizeMap.size() >= mMaxBufferCount && mFreeBufferMap.empty() && !mAborted) {
-        mCondition.wait(lock);
-    }
-
-    if (mAborted) {
-        return nullptr;
-    }
-
-    // Check if the free list contains a large enough buffer.
-    auto it = mFreeBufferMap.lower_bound(minimumBufferSize);
-    if (it != mFreeBufferMap.end()) {
-        uint8_t* buffer = it->second;
-        mFreeBufferMap.erase(it);
-        return buffer;
-    }
-
-    // If the maximum buffer count is reached, remove an existing free buffer.
-    if (mAddressSizeMap.size() >= mMaxBufferCount) {
-        auto it = mFreeBufferMap.begin();
-        mAddressSizeMap.erase(it->second);
-        delete[] it->second;
-        mFreeBufferMap.erase(it);
-    }
-
-    // Allocate a new buffer.
-    uint8_t* buffer = new (std::nothrow) uint8_t[minimumBufferSize];
-    if (buffer == nullptr) {
-        LOG(ERROR) << "Unable to allocate new buffer of size: " << minimumBufferSize;
-        return nullptr;
-    }
+#include <thread>
 
-    // Add the buffer to the tracking set.
-    mAddressSizeMap.emplace(buffer, minimumBufferSize);
-    return buffer;
-}
-
-void PassthroughTrackTranscoder::BufferPool::returnBuffer(uint8_t* buffer) {
-    std::scoped_lock lock(mMutex);
-
-    if (buffer == nullptr || mAddressSizeMap.find(buffer) == mAddressSizeMap.end()) {
-        LOG(WARNING) << "Ignoring untracked buffer " << buffer;
-        return;
-    }
-
-    mFreeBufferMap.emplace(mAddressSizeMap[buffer], buffer);
-    mCondition.notify_one();
-}
-
-void PassthroughTrackTranscoder::BufferPool::abort() {
-    std::scoped_lock lock(mMutex);
-    mAborted = true;
-    mCondition.notify_all();
-}
+namespace android {
 
 media_status_t PassthroughTrackTranscoder::configureDestinationFormat(
         const std::shared_ptr<AMediaFormat>& destinationFormat __unused) {
@@ -94,29 +31,25 @@ media_status_t PassthroughTrackTranscoder::configureDestinationFormat(
     return AMEDIA_OK;
 }
 
-media_status_t PassthroughTrackTranscoder::runTranscodeLoop(bool* stopped) {
-    prctl(PR_SET_NAME, (unsigned long)"PassthruThread", 0, 0, 0);
-
+media_status_t PassthroughTrackTranscoder::readSamples() {
     MediaSampleInfo info;
     std::shared_ptr<MediaSample> sample;
     bool eosReached = false;
 
-    // Notify the track format as soon as we start. It's same as the source format.
-    notifyTrackFormatAvailable();
-
     MediaSample::OnSampleReleasedCallback bufferReleaseCallback =
             [bufferPool = mBufferPool](MediaSample* sample) {
                 bufferPool->returnBuffer(const_cast<uint8_t*>(sample->buffer));
             };
 
-    // Move samples until EOS is reached or transcoding is stopped.
-    while (mStopRequest != STOP_NOW && !eosReached) {
+    // Read samples until EOS is reached, the read-ahead queue is aborted or the transcoder is
+    // stopped. Once stopped, the sample reader may no longer be advanced by the other tracks.
+    while (!eosReached && mStopRequest != STOP_NOW) {
         media_status_t status = mMediaSampleReader->getSampleInfoForTrack(mTrackIndex, &info);
 
         if (status == AMEDIA_OK) {
             uint8_t* buffer = mBufferPool->getBufferWithSize(info.size);
             if (buffer == nullptr) {
-                if (mStopRequest == STOP_NOW) {
+                if (mStopRequest != NONE) {
                     break;
                 }
 
@@ -142,13 +75,60 @@ media_status_t PassthroughTrackTranscoder::runTranscodeLoop(bool* stopped) {
         }
 
         sample->info = info;
+        if (mReadAheadQueue.enqueue(sample)) {
+            break;
+        }
+        sample.reset();
+    }
+
+    return AMEDIA_OK;
+}
+
+media_status_t PassthroughTrackTranscoder::runTranscodeLoop(bool* stopped) {
+    prctl(PR_SET_NAME, (unsigned long)"PassthruThread", 0, 0, 0);
+
+    std::shared_ptr<MediaSample> sample;
+    bool eosReached = false;
+
+    // Notify the track format as soon as we start. It's same as the source format.
+    notifyTrackFormatAvailable();
+
+    media_status_t readStatus = AMEDIA_OK;
+    std::thread readThread([this, &readStatus] {
+        prctl(PR_SET_NAME, (unsigned long)"PassthruReader", 0, 0, 0);
+        readStatus = readSamples();
+        if (readStatus != AMEDIA_OK) {
+            // Wake up the transcode loop.
+            mReadAheadQueue.abort();
+        }
+    });
+
+    // Move samples until EOS is reached or transcoding is stopped.
+    while (mStopRequest != STOP_NOW && !eosReached) {
+        if (mReadAheadQueue.dequeue(&sample)) {
+            break;
+        }
+
+        eosReached = sample->info.flags & SAMPLE_FLAG_END_OF_STREAM;
+        const bool syncSample = sample->info.flags & SAMPLE_FLAG_SYNC_SAMPLE;
         onOutputSampleAvailable(sample);
+        sample.reset();
 
-        if (mStopRequest == STOP_ON_SYNC && info.flags & SAMPLE_FLAG_SYNC_SAMPLE) {
+        if (mStopRequest == STOP_ON_SYNC && syncSample) {
             break;
         }
     }
 
+    // Unblock and stop the read-ahead thread. It may be blocked on a full queue or on the buffer
+    // pool, so both are aborted before joining it. Samples that were read ahead are dropped.
+    mReadAheadQueue.abort();
+    mBufferPool->abort();
+    readThread.join();
+
+    if (mStopRequest == NONE && readStatus != AMEDIA_OK) {
+        return readStatus;
+    }
+
     if (mStopRequest != NONE && !eosReached) {
         *stopped = true;
     }
@@ -157,6 +137,7 @@ media_status_t PassthroughTrackTranscoder::runTranscodeLoop(bool* stopped) {
 
 void PassthroughTrackTranscoder::abortTranscodeLoop() {
     if (mStopRequest == STOP_NOW) {
+        mReadAheadQueue.abort();
         mBufferPool->abort();
     }
 }
@@ -0,0 +1,493 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "SegmentedVideoTrackTranscoder"
+
+#include <android-base/logging.h>
+#include <media/MediaSampleReaderNDK.h>
+#include <media/NdkCommon.h>
+#include <media/SegmentedVideoTrackTranscoder.h>
+#include <media/VideoTrackTranscoder.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace android {
+
+/**
+ * Sample reader for a single segment. Forwards to a reader positioned at the segment's first sync
+ * sample, and reports end of stream once the segment's frames are all read.
+ *
+ * With open GOPs, the frames that follow a sync sample in decode order but display before it
+ * (leading frames) reference the previous GOP. They belong to the previous segment, which reads
+ * on past the next segment's first sync sample (needed as their reference) until the first sample
+ * that displays at or after it. The next segment skips them.
+ */
+class SegmentedVideoTrackTranscoder::SegmentSampleReader : public MediaSampleReader {
+public:
+    SegmentSampleReader(const std::shared_ptr<MediaSampleReaderNDK>& reader, int64_t startTimeUs,
+                        int64_t endTimeUs)
+          : mReader(reader), mStartTimeUs(startTimeUs), mEndTimeUs(endTimeUs) {}
+
+    // Must be called before the segment is started.
+    void setEndTimeUs(int64_t endTimeUs) { mEndTimeUs = endTimeUs; }
+
+    AMediaFormat* getFileFormat() override { return mReader->getFileFormat(); }
+    size_t getTrackCount() const override { return mReader->getTrackCount(); }
+    AMediaFormat* getTrackFormat(int trackIndex) override {
+        return mReader->getTrackFormat(trackIndex);
+    }
+    media_status_t selectTrack(int trackIndex) override { return mReader->selectTrack(trackIndex); }
+    media_status_t unselectTrack(int trackIndex) override {
+        return mReader->unselectTrack(trackIndex);
+    }
+    media_status_t setEnforceSequentialAccess(bool enforce) override {
+        return mReader->setEnforceSequentialAccess(enforce);
+    }
+
+    // The bitrate is estimated once for all segments before they are configured, as estimating it
+    // would move the reader away from the segment start.
+    media_status_t getEstimatedBitrateForTrack(int /*trackIndex*/, int32_t* /*bitrate*/) override {
+        return AMEDIA_ERROR_UNSUPPORTED;
+    }
+
+    media_status_t getSampleInfoForTrack(int trackIndex, MediaSampleInfo* info) override {
+        media_status_t status = mReader->getSampleInfoForTrack(trackIndex, info);
+        // Skip the leading frames of the segment's first GOP, the previous segment has them.
+        while (status == AMEDIA_OK && !(info->flags & SAMPLE_FLAG_SYNC_SAMPLE) &&
+               info->presentationTimeUs < mStartTimeUs) {
+            mReader->advanceTrack(trackIndex);
+            status = mReader->getSampleInfoForTrack(trackIndex, info);
+        }
+        if (status != AMEDIA_OK) {
+            return status;
+        }
+
+        const bool sync = info->flags & SAMPLE_FLAG_SYNC_SAMPLE;
+        if (mPastEnd && (sync || info->presentationTimeUs >= mEndTimeUs)) {
+            info->presentationTimeUs = 0;
+            info->flags = SAMPLE_FLAG_END_OF_STREAM;
+            info->size = 0;
+            return AMEDIA_ERROR_END_OF_STREAM;
+        }
+        // The next segment's first sync sample is still decoded, as a reference for the leading
+        // frames that follow it. Its output is dropped in onSegmentSample().
+        mAtEnd = !mPastEnd && sync && info->presentationTimeUs >= mEndTimeUs;
+        return AMEDIA_OK;
+    }
+
+    media_status_t readSampleDataForTrack(int trackIndex, uint8_t* buffer,
+                                          size_t bufferSize) override {
+        MediaSampleInfo info;
+        media_status_t status = getSampleInfoForTrack(trackIndex, &info);
+        if (status != AMEDIA_OK) {
+            return status;
+        }
+        return mReader->readSampleDataForTrack(trackIndex, buffer, bufferSize);
+    }
+
+    void advanceTrack(int trackIndex) override {
+        if (mAtEnd) {
+            mPastEnd = true;
+            mAtEnd = false;
+        }
+        mReader->advanceTrack(trackIndex);
+    }
+
+private:
+    std::shared_ptr<MediaSampleReaderNDK> mReader;
+    const int64_t mStartTimeUs;
+    int64_t mEndTimeUs;
+    // Whether the current sample is the next segment's first sync sample.
+    bool mAtEnd = false;
+    // Whether the next segment's first sync sample has been read.
+    bool mPastEnd = false;
+};
+
+// Checks that samples encoded with format b can be written to a track created with format a.
+static bool hasSameCodecConfig(AMediaFormat* a, AMediaFormat* b) {
+    for (const char* key : {AMEDIAFORMAT_KEY_CSD_0, AMEDIAFORMAT_KEY_CSD_1}) {
+        void *dataA = nullptr, *dataB = nullptr;
+        size_t sizeA = 0, sizeB = 0;
+        bool hasA = AMediaFormat_getBuffer(a, key, &dataA, &sizeA);
+        bool hasB = AMediaFormat_getBuffer(b, key, &dataB, &sizeB);
+        if (hasA != hasB || (hasA && (sizeA != sizeB || memcmp(dataA, dataB, sizeA) != 0))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Copies a sample out of the codec buffer so that the buffer can be returned to the encoder.
+static std::shared_ptr<MediaSample> copySample(const std::shared_ptr<MediaSample>& sample) {
+    uint8_t* buffer = nullptr;
+    if (sample->info.size > 0) {
+        buffer = new uint8_t[sample->info.size];
+        memcpy(buffer, sample->buffer + sample->dataOffset, sample->info.size);
+    }
+    std::shared_ptr<MediaSample> copy = MediaSample::createWithReleaseCallback(
+            buffer, 0 /* dataOffset */, 0 /* bufferId */,
+            [](MediaSample* copy) { delete[] copy->buffer; });
+    copy->info = sample->info;
+    return copy;
+}
+
+// static
+std::shared_ptr<SegmentedVideoTrackTranscoder> SegmentedVideoTrackTranscoder::create(
+        const std::weak_ptr<MediaTrackTranscoderCallback>& transcoderCallback, int sourceFd,
+        int32_t segmentCount, pid_t pid, uid_t uid) {
+    return std::shared_ptr<SegmentedVideoTrackTranscoder>(
+            new SegmentedVideoTrackTranscoder(transcoderCallback, sourceFd, segmentCount, pid, uid));
+}
+
+media_status_t SegmentedVideoTrackTranscoder::configureDestinationFormat(
+        const std::shared_ptr<AMediaFormat>& destinationFormat) {
+    if (destinationFormat == nullptr) {
+        LOG(ERROR) << "Destination format is null, use passthrough transcoder";
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    }
+
+    struct stat sourceStat;
+    if (mSourceFd < 0 || fstat(mSourceFd, &sourceStat) != 0) {
+        LOG(ERROR) << "Unable to get source size for fd " << mSourceFd;
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    }
+    const size_t sourceSize = sourceStat.st_size;
+
+    int64_t durationUs = 0;
+    if (!AMediaFormat_getInt64(mSourceFormat.get(), AMEDIAFORMAT_KEY_DURATION, &durationUs)) {
+        durationUs = 0;
+    }
+    const int32_t segmentCount = durationUs > 0 ? std::max(mRequestedSegmentCount, 1) : 1;
+
+    std::shared_ptr<AMediaFormat> segmentFormat(AMediaFormat_new(), &AMediaFormat_delete);
+    if (AMediaFormat_copy(segmentFormat.get(), destinationFormat.get()) != AMEDIA_OK) {
+        LOG(ERROR) << "Unable to copy destination format";
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    }
+    // Each segment but the last also encodes the next segment's first frame, which is dropped.
+    // Without B-frames none of the kept frames can reference it.
+    AMediaFormat_setInt32(segmentFormat.get(), TBD_AMEDIACODEC_PARAMETER_KEY_MAX_B_FRAMES, 0);
+
+    // All segments are encoded with the same bitrate, estimated from the whole track.
+    int32_t bitrate;
+    if (!AMediaFormat_getInt32(segmentFormat.get(), AMEDIAFORMAT_KEY_BIT_RATE, &bitrate)) {
+        auto probe = MediaSampleReaderNDK::createFromFdWithPositionalReads(mSourceFd, 0,
+                                                                           sourceSize);
+        if (probe != nullptr && probe->selectTrack(mTrackIndex) == AMEDIA_OK &&
+            probe->getEstimatedBitrateForTrack(mTrackIndex, &bitrate) == AMEDIA_OK) {
+            AMediaFormat_setInt32(segmentFormat.get(), AMEDIAFORMAT_KEY_BIT_RATE, bitrate);
+        }
+    }
+
+    // Find the segment starts by seeking each segment's reader to the sync sample preceding an
+    // equal split of the track duration. Drop segments that land on the same sync sample.
+    std::vector<std::pair<std::shared_ptr<MediaSampleReaderNDK>, int64_t>> segmentStarts;
+    for (int32_t i = 0; i < segmentCount; ++i) {
+        auto reader = MediaSampleReaderNDK::createFromFdWithPositionalReads(mSourceFd, 0,
+                                                                            sourceSize);
+        if (reader == nullptr) {
+            LOG(ERROR) << "Unable to create sample reader for segment " << i;
+            return AMEDIA_ERROR_UNKNOWN;
+        }
+
+        media_status_t status = reader->selectTrack(mTrackIndex);
+        if (status == AMEDIA_OK && i > 0) {
+            status = reader->seekTo(durationUs * i / segmentCount);
+        }
+        MediaSampleInfo info;
+        if (status == AMEDIA_OK) {
+            status = reader->getSampleInfoForTrack(mTrackIndex, &info);
+        }
+        if (status != AMEDIA_OK) {
+            if (i == 0) {
+                LOG(ERROR) << "Unable to read first sample: " << status;
+                return status;
+            }
+            break;
+        }
+
+        if (i > 0 && info.presentationTimeUs <= segmentStarts.back().second) {
+            continue;
+        }
+        segmentStarts.emplace_back(reader, info.presentationTimeUs);
+    }
+
+    std::scoped_lock lock{mSegmentMutex};
+    std::weak_ptr<SegmentedVideoTrackTranscoder> weakThis = shared_from_this();
+    for (size_t i = 0; i < segmentStarts.size(); ++i) {
+        const int64_t endTimeUs = (i + 1 < segmentStarts.size())
+                                          ? segmentStarts[i + 1].second
+                                          : std::numeric_limits<int64_t>::max();
+
+        Segment segment;
+        segment.startTimeUs = segmentStarts[i].second;
+        // The first segment has no previous segment to take its leading frames.
+        segment.reader = std::make_shared<SegmentSampleReader>(
+                segmentStarts[i].first,
+                i > 0 ? segment.startTimeUs : std::numeric_limits<int64_t>::min(), endTimeUs);
+        segment.transcoder = VideoTrackTranscoder::create(weakThis, mPid, mUid);
+
+        media_status_t status =
+                segment.transcoder->configure(segment.reader, mTrackIndex, segmentFormat);
+        if (status != AMEDIA_OK) {
+            if (i == 0) {
+                LOG(ERROR) << "Unable to configure first segment: " << status;
+                return status;
+            }
+            // Most likely out of codec instances, let the previous segment cover the rest.
+            LOG(WARNING) << "Unable to configure segment " << i << " (" << status
+                         << "), using " << i << " segments";
+            mSegments.back().reader->setEndTimeUs(std::numeric_limits<int64_t>::max());
+            break;
+        }
+
+        segment.transcoder->setSampleConsumer(
+                [weakThis, i](const std::shared_ptr<MediaSample>& sample) {
+                    if (auto self = weakThis.lock()) {
+                        self->onSegmentSample(i, sample);
+                    }
+                });
+        mSegments.push_back(std::move(segment));
+    }
+
+    LOG(INFO) << "Transcoding video track in " << mSegments.size() << " segments";
+    return AMEDIA_OK;
+}
+
+media_status_t SegmentedVideoTrackTranscoder::runTranscodeLoop(bool* stopped)
+        NO_THREAD_SAFETY_ANALYSIS {
+    prctl(PR_SET_NAME, (unsigned long)"SegmTranscodTrd", 0, 0, 0);
+
+    std::unique_lock lock{mSegmentMutex};
+    if (!mAborted) {
+        for (Segment& segment : mSegments) {
+            if (!segment.transcoder->start()) {
+                LOG(ERROR) << "Unable to start segment transcoder";
+                mStatus = AMEDIA_ERROR_UNKNOWN;
+                stopSegments_l();
+                break;
+            }
+            segment.started = true;
+            ++mStartedSegments;
+        }
+    }
+
+    while (mDoneSegments < mStartedSegments || mAdvancing) {
+        mSegmentCondition.wait(lock);
+    }
+
+    if (mStatus != AMEDIA_OK) {
+        return mStatus;
+    }
+
+    // Signal if transcoding was stopped before all segments finished.
+    if (mSegmentStopped || mStartedSegments < mSegments.size()) {
+        *stopped = true;
+    }
+    return AMEDIA_OK;
+}
+
+void SegmentedVideoTrackTranscoder::abortTranscodeLoop() {
+    std::scoped_lock lock{mSegmentMutex};
+    // Segments are always stopped right away, as a paused transcoding is restarted from the
+    // beginning when it's resumed.
+    stopSegments_l();
+}
+
+std::shared_ptr<AMediaFormat> SegmentedVideoTrackTranscoder::getOutputFormat() const {
+    std::scoped_lock lock{mSegmentMutex};
+    return mActualOutputFormat;
+}
+
+void SegmentedVideoTrackTranscoder::onTrackFormatAvailable(const MediaTrackTranscoder* transcoder) {
+    bool notify = false;
+    {
+        std::scoped_lock lock{mSegmentMutex};
+        const size_t index = findSegment_l(transcoder);
+        if (index >= mSegments.size()) {
+            return;
+        }
+        mSegments[index].format = transcoder->getOutputFormat();
+
+        std::shared_ptr<AMediaFormat> firstFormat = mSegments[0].format;
+        if (firstFormat == nullptr) {
+            return;
+        }
+
+        bool compatible = true;
+        for (size_t i = 1; i < mSegments.size(); ++i) {
+            if ((index == 0 || index == i) && mSegments[i].format != nullptr &&
+                !hasSameCodecConfig(firstFormat.get(), mSegments[i].format.get())) {
+                LOG(ERROR) << "Segment " << i << " codec config differs from the first segment";
+                compatible = false;
+            }
+        }
+        if (!compatible) {
+            if (mStatus == AMEDIA_OK) {
+                mStatus = AMEDIA_ERROR_UNSUPPORTED;
+            }
+            stopSegments_l();
+            return;
+        }
+
+        if (index == 0) {
+            mActualOutputFormat = firstFormat;
+            notify = true;
+        }
+    }
+
+    if (notify) {
+        notifyTrackFormatAvailable();
+    }
+}
+
+void SegmentedVideoTrackTranscoder::onTrackFinished(const MediaTrackTranscoder* transcoder) {
+    onSegmentDone(transcoder, AMEDIA_OK, false /* stopped */);
+}
+
+void SegmentedVideoTrackTranscoder::onTrackStopped(const MediaTrackTranscoder* transcoder) {
+    onSegmentDone(transcoder, AMEDIA_OK, true /* stopped */);
+}
+
+void SegmentedVideoTrackTranscoder::onTrackError(const MediaTrackTranscoder* transcoder,
+                                                 media_status_t status) {
+    onSegmentDone(transcoder, status, false /* stopped */);
+}
+
+void SegmentedVideoTrackTranscoder::onSegmentSample(size_t index,
+                                                    const std::shared_ptr<MediaSample>& sample)
+        NO_THREAD_SAFETY_ANALYSIS {
+    std::unique_lock lock{mSegmentMutex};
+
+    if (index + 1 < mSegments.size()) {
+        // Only the last segment ends the track.
+        if (sample->info.flags & SAMPLE_FLAG_END_OF_STREAM) {
+            if (sample->info.size == 0) {
+                return;
+            }
+            sample->info.flags &= ~SAMPLE_FLAG_END_OF_STREAM;
+        }
+        // The next segment's first frame was only decoded as a reference for the leading frames.
+        if (!(sample->info.flags & SAMPLE_FLAG_CODEC_CONFIG) &&
+            sample->info.presentationTimeUs >= mSegments[index + 1].startTimeUs) {
+            return;
+        }
+    }
+
+    // The track's codec config comes from the first segment's format.
+    if (index > 0 && (sample->info.flags & SAMPLE_FLAG_CODEC_CONFIG)) {
+        return;
+    }
+
+    while (index != mCurrentSegment && mBufferedBytes >= kMaxBufferedBytes && !mAborted) {
+        mSegmentCondition.wait(lock);
+    }
+
+    // Samples of the current segment are passed on directly. Samples of the next segment are
+    // also held back while the earlier ones are passed on after the current segment finished.
+    if (index == mCurrentSegment) {
+        lock.unlock();
+        onOutputSampleAvailable(sample);
+    } else if (!mAborted) {
+        mSegments[index].pendingSamples.push_back(copySample(sample));
+        mBufferedBytes += sample->info.size;
+    }
+}
+
+void SegmentedVideoTrackTranscoder::onSegmentDone(const MediaTrackTranscoder* transcoder,
+                                                  media_status_t status, bool stopped)
+        NO_THREAD_SAFETY_ANALYSIS {
+    std::unique_lock lock{mSegmentMutex};
+    const size_t index = findSegment_l(transcoder);
+    if (index >= mSegments.size()) {
+        return;
+    }
+    LOG(DEBUG) << "Segment " << index << " done with status " << status << " stopped "
+               << stopped;
+
+    Segment& segment = mSegments[index];
+    segment.done = true;
+    ++mDoneSegments;
+
+    if (status != AMEDIA_OK) {
+        if (mStatus == AMEDIA_OK) {
+            mStatus = status;
+        }
+        stopSegments_l();
+    } else if (stopped) {
+        mSegmentStopped = true;
+    } else {
+        segment.finished = true;
+        advanceCurrentSegment(lock);
+    }
+    mSegmentCondition.notify_all();
+}
+
+size_t SegmentedVideoTrackTranscoder::findSegment_l(const MediaTrackTranscoder* transcoder) {
+    for (size_t i = 0; i < mSegments.size(); ++i) {
+        if (mSegments[i].transcoder.get() == transcoder) {
+            return i;
+        }
+    }
+    LOG(ERROR) << "Unknown segment transcoder " << transcoder;
+    return mSegments.size();
+}
+
+void SegmentedVideoTrackTranscoder::advanceCurrentSegment(std::unique_lock<std::mutex>& lock)
+        NO_THREAD_SAFETY_ANALYSIS {
+    // Only one thread passes on held back samples, the others leave the finished segments to it.
+    if (mAdvancing) {
+        return;
+    }
+    mAdvancing = true;
+    while (mCurrentSegment + 1 < mSegments.size() && mSegments[mCurrentSegment].finished) {
+        // The next segment keeps adding samples while they are passed on without the lock, it
+        // only becomes the current segment once none are left.
+        std::deque<std::shared_ptr<MediaSample>>& pendingSamples =
+                mSegments[mCurrentSegment + 1].pendingSamples;
+        while (!pendingSamples.empty() && !mAborted) {
+            std::shared_ptr<MediaSample> sample = pendingSamples.front();
+            pendingSamples.pop_front();
+            mBufferedBytes -= sample->info.size;
+            lock.unlock();
+            onOutputSampleAvailable(sample);
+            lock.lock();
+        }
+        if (mAborted) {
+            break;
+        }
+        ++mCurrentSegment;
+        mSegmentCondition.notify_all();
+    }
+    mAdvancing = false;
+}
+
+void SegmentedVideoTrackTranscoder::stopSegments_l() {
+    mAborted = true;
+    for (Segment& segment : mSegments) {
+        if (segment.started && !segment.done) {
+            segment.transcoder->stop();
+        }
+    }
+    mSegmentCondition.notify_all();
+}
+
+}  // namespace android
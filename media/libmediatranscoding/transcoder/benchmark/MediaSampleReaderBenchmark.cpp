@@ -34,6 +34,7 @@
 #include <android-base/logging.h>
 #include <benchmark/benchmark.h>
 #include <fcntl.h>
+#include <media/MediaSampleBufferPool.h>
 #include <media/MediaSampleReaderNDK.h>
 #include <unistd.h>
 
@@ -41,8 +42,19 @@
 
 using namespace android;
 
+/** How sample buffers are obtained by the reading threads. */
+typedef enum {
+    kReuseSingleBuffer,
+    kNewBufferPerSample,
+    kPooledBufferPerSample,
+} BufferMode;
+
+// Number of buffers in the pool, matching the passthrough track transcoder.
+static constexpr int kPoolBufferCount = 16;
+
 static void ReadMediaSamples(benchmark::State& state, const std::string& srcFileName,
-                             bool readAudio, bool sequentialAccess = false) {
+                             bool readAudio, bool sequentialAccess = false,
+                             BufferMode bufferMode = kReuseSingleBuffer) {
     // Asset directory.
     static const std::string kAssetDirectory = "/data/local/tmp/TranscodingBenchmark/";
 
@@ -89,12 +101,13 @@ static void ReadMediaSamples(benchmark::State& state, const std::string& srcFile
         // Start threads.
         std::vector<std::thread> trackThreads;
         for (auto trackIndex : trackIndices) {
-            trackThreads.emplace_back([trackIndex, sampleReader, &state] {
+            trackThreads.emplace_back([trackIndex, sampleReader, bufferMode, &state] {
                 LOG(INFO) << "Track " << trackIndex << " started";
                 MediaSampleInfo info;
 
                 size_t bufferSize = 0;
                 std::unique_ptr<uint8_t[]> buffer;
+                MediaSampleBufferPool bufferPool(kPoolBufferCount);
 
                 while (true) {
                     media_status_t status = sampleReader->getSampleInfoForTrack(trackIndex, &info);
@@ -102,13 +115,23 @@ static void ReadMediaSamples(benchmark::State& state, const std::string& srcFile
                         break;
                     }
 
-                    if (info.size > bufferSize) {
+                    uint8_t* sampleBuffer = nullptr;
+                    if (bufferMode == kPooledBufferPerSample) {
                         bufferSize = info.size;
-                        buffer.reset(new uint8_t[bufferSize]);
+                        sampleBuffer = bufferPool.getBufferWithSize(bufferSize);
+                    } else {
+                        if (info.size > bufferSize || bufferMode == kNewBufferPerSample) {
+                            bufferSize = info.size;
+                            buffer.reset(new uint8_t[bufferSize]);
+                        }
+                        sampleBuffer = buffer.get();
                     }
 
-                    status = sampleReader->readSampleDataForTrack(trackIndex, buffer.get(),
+                    status = sampleReader->readSampleDataForTrack(trackIndex, sampleBuffer,
                                                                   bufferSize);
+                    if (bufferMode == kPooledBufferPerSample) {
+                        bufferPool.returnBuffer(sampleBuffer);
+                    }
                     if (status != AMEDIA_OK) {
                         state.SkipWithError("Error reading sample data");
                         break;
@@ -147,8 +170,20 @@ static void BM_MediaSampleReader_Video(benchmark::State& state) {
                      false /* readAudio */);
 }
 
+static void BM_MediaSampleReader_Video_NewBufferPerSample(benchmark::State& state) {
+    ReadMediaSamples(state, "video_1920x1080_3648frame_h264_22Mbps_30fps_aac.mp4",
+                     false /* readAudio */, false /* sequentialAccess */, kNewBufferPerSample);
+}
+
+static void BM_MediaSampleReader_Video_PooledBufferPerSample(benchmark::State& state) {
+    ReadMediaSamples(state, "video_1920x1080_3648frame_h264_22Mbps_30fps_aac.mp4",
+                     false /* readAudio */, false /* sequentialAccess */, kPooledBufferPerSample);
+}
+
 TRANSCODER_BENCHMARK(BM_MediaSampleReader_AudioVideo_Parallel);
 TRANSCODER_BENCHMARK(BM_MediaSampleReader_AudioVideo_Sequential);
 TRANSCODER_BENCHMARK(BM_MediaSampleReader_Video);
+TRANSCODER_BENCHMARK(BM_MediaSampleReader_Video_NewBufferPerSample);
+TRANSCODER_BENCHMARK(BM_MediaSampleReader_Video_PooledBufferPerSample);
 
 BENCHMARK_MAIN();
@@ -36,6 +36,7 @@
 #include <android/binder_process.h>
 #include <benchmark/benchmark.h>
 #include <fcntl.h>
+#include <media/MediaSampleQueue.h>
 #include <media/MediaSampleReader.h>
 #include <media/MediaSampleReaderNDK.h>
 #include <media/MediaTrackTranscoder.h>
@@ -44,6 +45,9 @@
 #include <media/PassthroughTrackTranscoder.h>
 #include <media/VideoTrackTranscoder.h>
 
+#include <functional>
+#include <thread>
+
 using namespace android;
 
 typedef enum {
@@ -344,7 +348,7 @@ static bool ConfigureSampleReader(const std::shared_ptr<MediaTrackTranscoder>& t
 }
 
 static void BenchmarkTranscoder(benchmark::State& state, const std::string& srcFileName,
-                                bool mockReader, MediaType mediaType,
+                                bool mockReader, MediaType mediaType, bool passthrough = false,
                                 const TrackFormatEditCallback& formatEditor = nullptr) {
     static pthread_once_t once = PTHREAD_ONCE_INIT;
     pthread_once(&once, ABinderProcess_startThreadPool);
@@ -354,7 +358,7 @@ static void BenchmarkTranscoder(benchmark::State& state, const std::string& srcF
                 std::make_shared<TrackTranscoderCallbacks>();
         std::shared_ptr<MediaTrackTranscoder> transcoder;
 
-        if (mediaType == kVideo) {
+        if (mediaType == kVideo && !passthrough) {
             transcoder = VideoTrackTranscoder::create(callbacks);
         } else {
             transcoder = std::make_shared<PassthroughTrackTranscoder>(callbacks);
@@ -405,7 +409,7 @@ static void BenchmarkTranscoderWithOperatingRate(benchmark::State& state,
             AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_PRIORITY, priority);
         };
     }
-    BenchmarkTranscoder(state, srcFile, mockReader, mediaType, editor);
+    BenchmarkTranscoder(state, srcFile, mockReader, mediaType, false /* passthrough */, editor);
 }
 
 //-------------------------------- AVC to AVC Benchmarks -------------------------------------------
@@ -432,6 +436,70 @@ static void BM_VideoTranscode_HEVC2AVC_NoExtractor(benchmark::State& state) {
     BenchmarkTranscoderWithOperatingRate(state, srcFile, true /* mockReader */, kVideo);
 }
 
+//-------------------------------- Passthrough Benchmarks -----------------------------------------
+
+static void BM_Passthrough_Video(benchmark::State& state) {
+    const char* srcFile = "video_1920x1080_3648frame_h264_22Mbps_30fps_aac.mp4";
+    BenchmarkTranscoder(state, srcFile, false /* mockReader */, kVideo, true /* passthrough */);
+}
+
+static void BM_Passthrough_Video_NoExtractor(benchmark::State& state) {
+    const char* srcFile = "video_1920x1080_3648frame_h264_22Mbps_30fps_aac.mp4";
+    BenchmarkTranscoder(state, srcFile, true /* mockReader */, kVideo, true /* passthrough */);
+}
+
+static void BM_Passthrough_Audio(benchmark::State& state) {
+    const char* srcFile = "video_1920x1080_3648frame_h264_22Mbps_30fps_aac.mp4";
+    BenchmarkTranscoder(state, srcFile, false /* mockReader */, kAudio, true /* passthrough */);
+}
+
+static void BM_Passthrough_Audio_NoExtractor(benchmark::State& state) {
+    const char* srcFile = "video_1920x1080_3648frame_h264_22Mbps_30fps_aac.mp4";
+    BenchmarkTranscoder(state, srcFile, true /* mockReader */, kAudio, true /* passthrough */);
+}
+
+//-------------------------------- Sample Queue Benchmarks ----------------------------------------
+
+/**
+ * Passes samples from a producer thread to the benchmark thread through a sample queue, the way
+ * samples are handed over between track transcoder threads.
+ */
+template <typename QueueType>
+static void BenchmarkSampleQueueHandoff(benchmark::State& state,
+                                        const std::function<std::unique_ptr<QueueType>()>& create) {
+    static constexpr int kSampleCount = 10000;
+    std::shared_ptr<MediaSample> sourceSample = std::make_shared<MediaSample>();
+
+    for (auto _ : state) {
+        std::unique_ptr<QueueType> queue = create();
+        std::thread producer([&queue, &sourceSample] {
+            for (int i = 0; i < kSampleCount; ++i) {
+                queue->enqueue(sourceSample);
+            }
+        });
+
+        std::shared_ptr<MediaSample> sample;
+        for (int i = 0; i < kSampleCount; ++i) {
+            queue->dequeue(&sample);
+        }
+        producer.join();
+    }
+
+    state.counters["SampleRate"] = benchmark::Counter(
+            (double)kSampleCount * state.iterations(), benchmark::Counter::kIsRate);
+}
+
+static void BM_SampleQueueHandoff_Mutex(benchmark::State& state) {
+    BenchmarkSampleQueueHandoff<MediaSampleQueue>(
+            state, [] { return std::make_unique<MediaSampleQueue>(); });
+}
+
+static void BM_SampleQueueHandoff_Spsc(benchmark::State& state) {
+    const size_t capacity = state.range(0);
+    BenchmarkSampleQueueHandoff<MediaSampleSpscQueue>(
+            state, [capacity] { return std::make_unique<MediaSampleSpscQueue>(capacity); });
+}
+
 //-------------------------------- Benchmark Registration ------------------------------------------
 
 // Benchmark registration wrapper for transcoding.
@@ -453,4 +521,16 @@ TRANSCODER_OPERATING_RATE_BENCHMARK(BM_VideoTranscode_AVC2AVC_NoExtractor);
 TRANSCODER_OPERATING_RATE_BENCHMARK(BM_VideoTranscode_HEVC2AVC);
 TRANSCODER_OPERATING_RATE_BENCHMARK(BM_VideoTranscode_HEVC2AVC_NoExtractor);
 
+TRANSCODER_BENCHMARK(BM_Passthrough_Video);
+TRANSCODER_BENCHMARK(BM_Passthrough_Video_NoExtractor);
+TRANSCODER_BENCHMARK(BM_Passthrough_Audio);
+TRANSCODER_BENCHMARK(BM_Passthrough_Audio_NoExtractor);
+
+BENCHMARK(BM_SampleQueueHandoff_Mutex)->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SampleQueueHandoff_Spsc)
+        ->UseRealTime()
+        ->Unit(benchmark::kMicrosecond)
+        ->Arg(16)
+        ->Arg(256);
+
 BENCHMARK_MAIN();
@@ -105,7 +105,8 @@ using TrackSelectionCallback = std::function<bool(const char* mime, AMediaFormat
 
 static void TranscodeMediaFile(benchmark::State& state, const std::string& srcFileName,
                                const std::string& dstFileName,
-                               TrackSelectionCallback trackSelectionCallback) {
+                               TrackSelectionCallback trackSelectionCallback,
+                               int32_t videoSegmentCount = 1) {
     // Write-only, create file if non-existent.
     static constexpr int kDstOpenFlags = O_WRONLY | O_CREAT;
     // User R+W permission.
@@ -150,6 +151,14 @@ static void TranscodeMediaFile(benchmark::State& state, const std::string& srcFi
             goto exit;
         }
 
+        if (videoSegmentCount > 1) {
+            status = transcoder->configureVideoSegmentCount(videoSegmentCount);
+            if (status != AMEDIA_OK) {
+                state.SkipWithError("Unable to configure video segment count");
+                goto exit;
+            }
+        }
+
         status = transcoder->configureDestination(dstFd);
         if (status != AMEDIA_OK) {
             state.SkipWithError("Unable to configure transcoder destination");
@@ -527,6 +536,24 @@ static void BM_3840x2160_Hevc42Mbps2Avc20Mbps(benchmark::State& state) {
                        });
 }
 
+// Transcodes the video track in state.range(0) segments in parallel.
+static void BM_1920x1080_Avc15Mbps2Avc8MbpsSegmented(benchmark::State& state) {
+    const int32_t segmentCount = static_cast<int32_t>(state.range(0));
+    TranscodeMediaFile(
+            state, "tx_bm_1920_1080_30fps_h264_15Mbps.mp4",
+            "tx_bm_1920_1080_30fps_h264_15Mbps_transcoded_h264_8Mbps_segmented.mp4",
+            [](const char* mime, AMediaFormat** dstFormatOut) -> bool {
+                *dstFormatOut = nullptr;
+                if (strncmp(mime, "video/", 6) == 0) {
+                    *dstFormatOut = CreateDefaultVideoFormat();
+                    SetMimeBitrate(*dstFormatOut, "video/avc", 8000000);
+                    return true;
+                }
+                return false;
+            },
+            segmentCount);
+}
+
 //-------------------------------- Benchmark Registration ------------------------------------------
 
 // Benchmark registration wrapper for transcoding.
@@ -574,6 +601,12 @@ TRANSCODER_BENCHMARK(BM_720x1280_Avc10Mbps2Avc4Mbps);
 
 TRANSCODER_BENCHMARK(BM_3840x2160_Hevc42Mbps2Avc20Mbps);
 
+TRANSCODER_BENCHMARK(BM_1920x1080_Avc15Mbps2Avc8MbpsSegmented)
+        ->ArgName("segments")
+        ->Arg(1)
+        ->Arg(2)
+        ->Arg(4);
+
 class CustomCsvReporter : public benchmark::BenchmarkReporter {
 public:
     CustomCsvReporter() : mPrintedHeader(false) {}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_MEDIA_SAMPLE_BUFFER_POOL_H
+#define ANDROID_MEDIA_SAMPLE_BUFFER_POOL_H
+
+#include <utils/Mutex.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace android {
+
+/**
+ * Pool of reusable buffers for media sample data. Buffers are allocated on demand in size classes
+ * a quarter octave apart, so a buffer is at most 25% larger than the size it was allocated for.
+ * Buffers are recycled through a free list per size class, so getting and returning a buffer
+ * doesn't search the free buffers and steady state operation doesn't allocate. A free buffer is
+ * only reused for sizes down to half its own, unless the pool is full. The pool holds at most a
+ * maximum number of buffers. When that many are in use, getting a new buffer blocks until one is
+ * returned.
+ */
+class MediaSampleBufferPool {
+public:
+    /** Size of the smallest size class. */
+    static constexpr size_t kMinBufferSize = 4 * 1024;
+    /** Number of size classes per doubling of the buffer size. */
+    static constexpr size_t kSizeClassesPerOctave = 4;
+
+    explicit MediaSampleBufferPool(size_t maxBufferCount) : mMaxBufferCount(maxBufferCount){};
+    ~MediaSampleBufferPool();
+
+    /**
+     * Retrieve a buffer from the pool. Buffers are allocated on demand. This method will block
+     * if the maximum number of buffers is reached and there are no free buffers available.
+     * @param minimumBufferSize The minimum size of the buffer.
+     * @return The buffer or nullptr if allocation failed or the pool was aborted.
+     */
+    uint8_t* getBufferWithSize(size_t minimumBufferSize);
+
+    /**
+     * Return a buffer to the pool.
+     * @param buffer The buffer to return.
+     */
+    void returnBuffer(uint8_t* buffer);
+
+    /** Wakes up threads waiting on buffers and prevents new buffers from being returned. */
+    void abort();
+
+private:
+    // Returns the index of the smallest size class that fits the specified size.
+    static size_t getSizeClass(size_t size);
+    static size_t getSizeClassBufferSize(size_t sizeClass) {
+        const size_t octaveSize = kMinBufferSize << (sizeClass / kSizeClassesPerOctave);
+        return octaveSize + octaveSize / kSizeClassesPerOctave * (sizeClass % kSizeClassesPerOctave);
+    }
+
+    // Removes a free buffer from the smallest size class in [firstClass, endClass). Returns
+    // nullptr if there is none.
+    uint8_t* takeFreeBuffer_l(size_t firstClass, size_t endClass) REQUIRES(mMutex);
+
+    // Maximum number of active buffers at a time.
+    const size_t mMaxBufferCount;
+
+    // Map containing all tracked buffers and their size class.
+    std::unordered_map<uint8_t*, size_t> mBufferSizeClasses GUARDED_BY(mMutex);
+
+    // Free buffers, indexed by size class.
+    std::vector<std::vector<uint8_t*>> mFreeBuffers GUARDED_BY(mMutex);
+    size_t mFreeBufferCount GUARDED_BY(mMutex) = 0;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mAborted GUARDED_BY(mMutex) = false;
+};
+
+}  // namespace android
+#endif  // ANDROID_MEDIA_SAMPLE_BUFFER_POOL_H
@@ -20,9 +20,11 @@
 #include <media/MediaSample.h>
 #include <utils/Mutex.h>
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <vector>
 
 namespace android {
 
@@ -68,5 +70,73 @@ private:
     bool mAborted GUARDED_BY(mMutex) = false;
 };
 
+/**
+ * Bounded variant of MediaSampleQueue for exactly one producer thread and one consumer thread.
+ * Samples are passed through a fixed size ring without taking a lock. The mutex is only used to
+ * block the consumer while the queue is empty and the producer while the queue is full. The queue
+ * can be aborted from any thread, but samples still in the queue are not released until the
+ * queue is destroyed.
+ */
+class MediaSampleSpscQueue {
+public:
+    /**
+     * Creates a new queue.
+     * @param capacity The maximum number of samples in the queue. It is rounded up to the next
+     *                 power of two.
+     */
+    explicit MediaSampleSpscQueue(size_t capacity);
+
+    /**
+     * Enqueues a media sample at the end of the queue and notifies a potentially waiting consumer.
+     * Blocks while the queue is full. If the queue has been aborted this method does nothing.
+     * Must only be called from the producer thread.
+     * @param sample The media sample to enqueue.
+     * @return True if the queue has been aborted.
+     */
+    bool enqueue(const std::shared_ptr<MediaSample>& sample);
+
+    /**
+     * Removes the next media sample from the queue and returns it. Blocks while the queue is
+     * empty. If the queue has been aborted this method returns null. Must only be called from the
+     * consumer thread.
+     * @param[out] sample The next media sample in the queue.
+     * @return True if the queue has been aborted.
+     */
+    bool dequeue(std::shared_ptr<MediaSample>* sample /* nonnull */);
+
+    /**
+     * Checks if the queue currently holds any media samples.
+     * @return True if the queue is empty or has been aborted. False otherwise.
+     */
+    bool isEmpty();
+
+    /**
+     * Aborts the queue operation and wakes up the producer and consumer. After the queue has been
+     * aborted it is not possible to enqueue more samples, and dequeue will return null.
+     */
+    void abort();
+
+private:
+    // Blocks the calling thread until ready returns true or the queue is aborted.
+    template <typename Predicate>
+    void waitUntil(std::atomic_bool* waiting, Predicate ready);
+    // Wakes up the other thread if it is blocked.
+    void wake(std::atomic_bool* waiting);
+
+    std::vector<std::shared_ptr<MediaSample>> mSlots;
+    const size_t mMask;
+
+    // Index of the next sample to dequeue, only written by the consumer.
+    alignas(64) std::atomic_size_t mHead = 0;
+    // Index of the next sample to enqueue, only written by the producer.
+    alignas(64) std::atomic_size_t mTail = 0;
+
+    alignas(64) std::atomic_bool mAborted = false;
+    std::atomic_bool mConsumerWaiting = false;
+    std::atomic_bool mProducerWaiting = false;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+};
+
 }  // namespace android
 #endif  // ANDROID_MEDIA_SAMPLE_QUEUE_H
@@ -44,6 +44,30 @@ public:
      */
     static std::shared_ptr<MediaSampleReader> createFromFd(int fd, size_t offset, size_t size);
 
+    /**
+     * Creates a new MediaSampleReaderNDK instance that reads the source through positional reads
+     * on its own duplicate of the file descriptor. Unlike readers created by createFromFd, which
+     * share the file offset of the descriptor, any number of these readers can read from the same
+     * file concurrently.
+     * @param fd Source file descriptor. The caller is responsible for closing the fd and it is safe
+     *           to do so when this method returns.
+     * @param offset Source data offset.
+     * @param size Source data size.
+     * @return A shared pointer referencing the new MediaSampleReaderNDK instance on success, or an
+     *         empty shared pointer if an error occurred.
+     */
+    static std::shared_ptr<MediaSampleReaderNDK> createFromFdWithPositionalReads(int fd,
+                                                                                 size_t offset,
+                                                                                 size_t size);
+
+    /**
+     * Moves the reader to the sync sample at or before the specified time. Tracks must be selected
+     * before seeking, and seeking is only supported before sample reading begins.
+     * @param timeUs The time to seek to.
+     * @return AMEDIA_OK on success.
+     */
+    media_status_t seekTo(int64_t timeUs);
+
     AMediaFormat* getFileFormat() override;
     size_t getTrackCount() const override;
     AMediaFormat* getTrackFormat(int trackIndex) override;
@@ -89,6 +113,9 @@ private:
         SamplePosition next;
     };
 
+    /** Positional read data source backing readers created by createFromFdWithPositionalReads. */
+    struct PositionalFdSource;
+
     /**
      * Creates a new MediaSampleReaderNDK object from an AMediaExtractor. The extractor needs to be
      * initialized with a valid data source before attempting to create a MediaSampleReaderNDK.
@@ -121,6 +148,8 @@ private:
     media_status_t primeExtractorForTrack_l(int trackIndex, std::unique_lock<std::mutex>& lockHeld);
 
     AMediaExtractor* mExtractor = nullptr;
+    // Must outlive mExtractor, which reads through it.
+    std::unique_ptr<PositionalFdSource> mPositionalFdSource;
     std::mutex mExtractorMutex;
     const size_t mTrackCount;
 
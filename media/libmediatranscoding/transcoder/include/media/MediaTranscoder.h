@@ -83,6 +83,15 @@ public:
     /** Gets the media formats of all tracks in the file. */
     std::vector<std::shared_ptr<AMediaFormat>> getTrackFormats() const;
 
+    /**
+     * Configures the number of segments that transcoded video tracks are split into. Segments are
+     * transcoded in parallel with separate codec instances and written in order, which speeds up
+     * transcoding of long videos on devices with spare codec capacity. The track may be split
+     * into fewer segments than requested. Must be called after the source has been configured
+     * and before configureTrackFormat. Defaults to 1, which disables segmenting.
+     */
+    media_status_t configureVideoSegmentCount(int32_t segmentCount);
+
     /**
      * Configures transcoding of a track. Tracks that are not configured will not present in the
      * final transcoded file, i.e. tracks will be dropped by default. Passing nullptr for
@@ -147,6 +156,9 @@ private:
 
     std::shared_ptr<CallbackInterface> mCallbacks;
     std::shared_ptr<MediaSampleReader> mSampleReader;
+    // Duplicate of the source fd, used to open additional readers for video segments.
+    ::ndk::ScopedFileDescriptor mSourceFd;
+    int32_t mVideoSegmentCount = 1;
     std::shared_ptr<MediaSampleWriter> mSampleWriter;
     std::vector<std::shared_ptr<AMediaFormat>> mSourceTrackFormats;
     std::vector<std::shared_ptr<MediaTrackTranscoder>> mTrackTranscoders;
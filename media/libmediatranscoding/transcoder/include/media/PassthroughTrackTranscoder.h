@@ -17,14 +17,11 @@
 #ifndef ANDROID_PASSTHROUGH_TRACK_TRANSCODER_H
 #define ANDROID_PASSTHROUGH_TRACK_TRANSCODER_H
 
+#include <media/MediaSampleBufferPool.h>
+#include <media/MediaSampleQueue.h>
 #include <media/MediaTrackTranscoder.h>
 #include <media/NdkMediaFormat.h>
 
-#include <condition_variable>
-#include <map>
-#include <mutex>
-#include <unordered_map>
-
 namespace android {
 
 /**
@@ -32,6 +29,8 @@ namespace android {
  * from source file to destination file. This track transcoder uses an internal pool of buffers.
  * When the maximum number of buffers are allocated and all of them are waiting on the output queue
  * the transcoder will stall until samples are dequeued from the output queue and released.
+ * Samples are read ahead on a separate thread so that reading from the source overlaps with
+ * handing samples to the consumer.
  */
 class PassthroughTrackTranscoder : public MediaTrackTranscoder {
 public:
@@ -45,45 +44,11 @@ public:
     virtual ~PassthroughTrackTranscoder() override = default;
 
 private:
-    friend class BufferPoolTests;
-
-    /** Class to pool and reuse buffers. */
-    class BufferPool {
-    public:
-        explicit BufferPool(int maxBufferCount) : mMaxBufferCount(maxBufferCount){};
-        ~BufferPool();
-
-        /**
-         * Retrieve a buffer from the pool. Buffers are allocated on demand. This method will block
-         * if the maximum number of buffers is reached and there are no free buffers available.
-         * @param minimumBufferSize The minimum size of the buffer.
-         * @return The buffer or nullptr if allocation failed or the pool was aborted.
-         */
-        uint8_t* getBufferWithSize(size_t minimumBufferSize);
-
-        /**
-         * Return a buffer to the pool.
-         * @param buffer The buffer to return.
-         */
-        void returnBuffer(uint8_t* buffer);
-
-        /** Wakes up threads waiting on buffers and prevents new buffers from being returned. */
-        void abort();
-
-    private:
-        // Maximum number of active buffers at a time.
-        const int mMaxBufferCount;
-
-        // Map containing all tracked buffers.
-        std::unordered_map<uint8_t*, size_t> mAddressSizeMap GUARDED_BY(mMutex);
-
-        // Map containing the currently free buffers.
-        std::multimap<size_t, uint8_t*> mFreeBufferMap GUARDED_BY(mMutex);
+    using BufferPool = MediaSampleBufferPool;
 
-        std::mutex mMutex;
-        std::condition_variable mCondition;
-        bool mAborted GUARDED_BY(mMutex) = false;
-    };
+    // Reads samples from the sample reader into pooled buffers and enqueues them on the read-ahead
+    // queue. Runs on a separate thread while runTranscodeLoop outputs the samples.
+    media_status_t readSamples();
 
     // MediaTrackTranscoder
     media_status_t runTranscodeLoop(bool* stopped) override;
@@ -94,6 +59,7 @@ private:
     // ~MediaTrackTranscoder
 
     std::shared_ptr<BufferPool> mBufferPool;
+    MediaSampleSpscQueue mReadAheadQueue{kMaxBufferCountDefault};
 };
 
 }  // namespace android
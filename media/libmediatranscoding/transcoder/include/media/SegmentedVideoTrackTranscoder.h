@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SEGMENTED_VIDEO_TRACK_TRANSCODER_H
+#define ANDROID_SEGMENTED_VIDEO_TRACK_TRANSCODER_H
+
+#include <media/MediaTrackTranscoder.h>
+#include <media/MediaTrackTranscoderCallback.h>
+#include <media/NdkMediaCodecPlatform.h>
+#include <media/NdkMediaFormat.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace android {
+
+class VideoTrackTranscoder;
+
+/**
+ * Track transcoder for long video tracks that splits the track at sync samples into segments and
+ * transcodes the segments in parallel, each with its own VideoTrackTranscoder and codec instances.
+ * Each segment reads the source through its own MediaSampleReader, so the sample reader passed to
+ * configure is only used for the track format and the segments are read from the source file
+ * descriptor instead.
+ *
+ * Encoded samples are delivered in presentation order: samples of the first unfinished segment
+ * are passed on directly, while samples of later segments are copied and held back until all
+ * previous segments are done. Once kMaxBufferedBytes are held back, later segments stall until
+ * the earlier ones catch up. Frames that display before the first sync sample of a segment
+ * (leading frames of an open GOP) can't be decoded without the previous GOP, so they are
+ * transcoded by the previous segment instead. Samples are never passed on with the segment lock
+ * held.
+ *
+ * All segments must produce the same codec configuration, which is the case when the encoders
+ * are configured identically. Transcoding fails otherwise.
+ */
+class SegmentedVideoTrackTranscoder
+      : public std::enable_shared_from_this<SegmentedVideoTrackTranscoder>,
+        public MediaTrackTranscoder,
+        public MediaTrackTranscoderCallback {
+public:
+    /** Maximum size of encoded samples held back for segments waiting to be written. */
+    static constexpr size_t kMaxBufferedBytes = 64 * 1024 * 1024;
+
+    /**
+     * Creates a new segmented video track transcoder.
+     * @param transcoderCallback The track transcoder callback.
+     * @param sourceFd The source file descriptor. It only needs to stay valid until configure
+     *                 returns.
+     * @param segmentCount The number of segments to split the track into. The track may be split
+     *                     into fewer segments if it has too few sync samples or if codec instances
+     *                     for all segments are not available.
+     */
+    static std::shared_ptr<SegmentedVideoTrackTranscoder> create(
+            const std::weak_ptr<MediaTrackTranscoderCallback>& transcoderCallback, int sourceFd,
+            int32_t segmentCount, pid_t pid = AMEDIACODEC_CALLING_PID,
+            uid_t uid = AMEDIACODEC_CALLING_UID);
+
+    virtual ~SegmentedVideoTrackTranscoder() override = default;
+
+private:
+    class SegmentSampleReader;
+
+    struct Segment {
+        std::shared_ptr<VideoTrackTranscoder> transcoder;
+        std::shared_ptr<SegmentSampleReader> reader;
+        // Presentation time of the segment's first (sync) sample.
+        int64_t startTimeUs = 0;
+        std::shared_ptr<AMediaFormat> format;
+        // Copies of samples waiting for the previous segments to finish.
+        std::deque<std::shared_ptr<MediaSample>> pendingSamples;
+        bool started = false;
+        bool done = false;
+        bool finished = false;
+    };
+
+    SegmentedVideoTrackTranscoder(
+            const std::weak_ptr<MediaTrackTranscoderCallback>& transcoderCallback, int sourceFd,
+            int32_t segmentCount, pid_t pid, uid_t uid)
+          : MediaTrackTranscoder(transcoderCallback),
+            mSourceFd(sourceFd),
+            mRequestedSegmentCount(segmentCount),
+            mPid(pid),
+            mUid(uid){};
+
+    // MediaTrackTranscoder
+    media_status_t runTranscodeLoop(bool* stopped) override;
+    void abortTranscodeLoop() override;
+    media_status_t configureDestinationFormat(
+            const std::shared_ptr<AMediaFormat>& destinationFormat) override;
+    std::shared_ptr<AMediaFormat> getOutputFormat() const override;
+    // ~MediaTrackTranscoder
+
+    // MediaTrackTranscoderCallback
+    void onTrackFormatAvailable(const MediaTrackTranscoder* transcoder) override;
+    void onTrackFinished(const MediaTrackTranscoder* transcoder) override;
+    void onTrackStopped(const MediaTrackTranscoder* transcoder) override;
+    void onTrackError(const MediaTrackTranscoder* transcoder, media_status_t status) override;
+    // ~MediaTrackTranscoderCallback
+
+    // Receives an encoded sample from the segment at the specified index.
+    void onSegmentSample(size_t index, const std::shared_ptr<MediaSample>& sample);
+
+    // Records that a segment transcoder is done and moves on to the next segment if possible.
+    void onSegmentDone(const MediaTrackTranscoder* transcoder, media_status_t status,
+                       bool stopped);
+
+    size_t findSegment_l(const MediaTrackTranscoder* transcoder) REQUIRES(mSegmentMutex);
+    // Passes on the samples held back for the segments following the finished ones. |lock| holds
+    // mSegmentMutex and is released while samples are passed on.
+    void advanceCurrentSegment(std::unique_lock<std::mutex>& lock);
+    void stopSegments_l() REQUIRES(mSegmentMutex);
+
+    const int mSourceFd;
+    const int32_t mRequestedSegmentCount;
+    const pid_t mPid;
+    const uid_t mUid;
+
+    mutable std::mutex mSegmentMutex;
+    std::condition_variable mSegmentCondition;
+    std::vector<Segment> mSegments GUARDED_BY(mSegmentMutex);
+    // Index of the first unfinished segment, whose samples are passed on directly.
+    size_t mCurrentSegment GUARDED_BY(mSegmentMutex) = 0;
+    size_t mBufferedBytes GUARDED_BY(mSegmentMutex) = 0;
+    size_t mStartedSegments GUARDED_BY(mSegmentMutex) = 0;
+    size_t mDoneSegments GUARDED_BY(mSegmentMutex) = 0;
+    // Whether a thread is passing on held back samples in advanceCurrentSegment().
+    bool mAdvancing GUARDED_BY(mSegmentMutex) = false;
+    media_status_t mStatus GUARDED_BY(mSegmentMutex) = AMEDIA_OK;
+    bool mSegmentStopped GUARDED_BY(mSegmentMutex) = false;
+    bool mAborted GUARDED_BY(mSegmentMutex) = false;
+    std::shared_ptr<AMediaFormat> mActualOutputFormat GUARDED_BY(mSegmentMutex);
+};
+
+}  // namespace android
+#endif  // ANDROID_SEGMENTED_VIDEO_TRACK_TRANSCODER_H
@@ -229,6 +229,82 @@ TEST_F(MediaSampleQueueTests, TestBlockingAbort) {
     abortingThread.join();
 }
 
+TEST_F(MediaSampleQueueTests, TestSpscDequeueOrder) {
+    LOG(DEBUG) << "TestSpscDequeueOrder Starts";
+
+    static constexpr int kNumSamples = 4;
+    MediaSampleSpscQueue sampleQueue(kNumSamples);
+    EXPECT_TRUE(sampleQueue.isEmpty());
+
+    // Wrap around the ring a couple of times.
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < kNumSamples; ++i) {
+            bool aborted = sampleQueue.enqueue(newSample(i));
+            EXPECT_FALSE(aborted);
+            EXPECT_FALSE(sampleQueue.isEmpty());
+        }
+
+        for (int i = 0; i < kNumSamples; ++i) {
+            std::shared_ptr<MediaSample> sample;
+            bool aborted = sampleQueue.dequeue(&sample);
+            EXPECT_NE(sample, nullptr);
+            EXPECT_EQ(sample->bufferId, i);
+            EXPECT_FALSE(aborted);
+        }
+        EXPECT_TRUE(sampleQueue.isEmpty());
+    }
+}
+
+TEST_F(MediaSampleQueueTests, TestSpscBlockingEnqueue) {
+    LOG(DEBUG) << "TestSpscBlockingEnqueue Starts";
+
+    static constexpr int kCapacity = 2;
+    static constexpr int kNumSamples = 1000;
+    MediaSampleSpscQueue sampleQueue(kCapacity);
+
+    // The producer blocks whenever it gets kCapacity samples ahead of the consumer.
+    std::thread enqueueThread([&sampleQueue] {
+        for (int i = 0; i < kNumSamples; ++i) {
+            EXPECT_FALSE(sampleQueue.enqueue(newSample(i)));
+        }
+    });
+
+    for (int i = 0; i < kNumSamples; ++i) {
+        std::shared_ptr<MediaSample> sample;
+        bool aborted = sampleQueue.dequeue(&sample);
+        ASSERT_NE(sample, nullptr);
+        EXPECT_EQ(sample->bufferId, i);
+        EXPECT_FALSE(aborted);
+    }
+
+    enqueueThread.join();
+    EXPECT_TRUE(sampleQueue.isEmpty());
+}
+
+TEST_F(MediaSampleQueueTests, TestSpscBlockingAbort) {
+    LOG(DEBUG) << "TestSpscBlockingAbort Starts";
+
+    MediaSampleSpscQueue sampleQueue(1);
+    EXPECT_FALSE(sampleQueue.enqueue(newSample(1)));
+
+    std::thread abortingThread([&sampleQueue] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(kThreadDelayDurationMs));
+        sampleQueue.abort();
+    });
+
+    // The queue is full so enqueue blocks until the queue is aborted.
+    bool aborted = sampleQueue.enqueue(newSample(2));
+    EXPECT_TRUE(aborted);
+
+    std::shared_ptr<MediaSample> sample;
+    aborted = sampleQueue.dequeue(&sample);
+    EXPECT_TRUE(aborted);
+    EXPECT_EQ(sample, nullptr);
+    EXPECT_TRUE(sampleQueue.isEmpty());
+
+    abortingThread.join();
+}
+
 }  // namespace android
 
 int main(int argc, char** argv) {
@@ -102,12 +102,16 @@ public:
     media_status_t transcodeHelper(const char* srcPath, const char* destPath,
                                    FormatConfigurationCallback formatCallback,
                                    TranscodeExecutionControl executionControl = kRunToCompletion,
-                                   int64_t heartBeatIntervalUs = -1) {
+                                   int64_t heartBeatIntervalUs = -1,
+                                   int32_t videoSegmentCount = 1) {
         auto transcoder = MediaTranscoder::create(mCallbacks, heartBeatIntervalUs);
         EXPECT_NE(transcoder, nullptr);
 
         const int srcFd = open(srcPath, O_RDONLY);
         EXPECT_EQ(transcoder->configureSource(srcFd), AMEDIA_OK);
+        if (videoSegmentCount > 1) {
+            EXPECT_EQ(transcoder->configureVideoSegmentCount(videoSegmentCount), AMEDIA_OK);
+        }
 
         std::vector<std::shared_ptr<AMediaFormat>> trackFormats = transcoder->getTrackFormats();
         EXPECT_GT(trackFormats.size(), 0);
@@ -175,7 +179,7 @@ public:
     }
 
     void testTranscodeVideo(const char* srcPath, const char* destPath, const char* dstMime,
-                            int32_t bitrate = 0) {
+                            int32_t bitrate = 0, int32_t videoSegmentCount = 1) {
         EXPECT_EQ(transcodeHelper(srcPath, destPath,
                                   [dstMime, bitrate](AMediaFormat* sourceFormat) {
                                       AMediaFormat* format = nullptr;
@@ -198,7 +202,9 @@ public:
                                           }
                                       }
                                       return format;
-                                  }),
+                                  },
+                                  kRunToCompletion, -1 /* heartBeatIntervalUs */,
+                                  videoSegmentCount),
                   AMEDIA_OK);
 
         if (dstMime != nullptr) {
@@ -296,6 +302,13 @@ TEST_F(MediaTranscoderTests, TestVideoTranscode_HevcToAvc_Rotation) {
     testTranscodeVideo(srcPath, destPath, AMEDIA_MIMETYPE_VIDEO_AVC);
 }
 
+TEST_F(MediaTranscoderTests, TestVideoTranscode_Segmented) {
+    const char* srcPath = "/data/local/tmp/TranscodingTestAssets/jets_hevc_1280x720_20Mbps.mp4";
+    const char* destPath = "/data/local/tmp/MediaTranscoder_VideoTranscode_Segmented.MP4";
+    testTranscodeVideo(srcPath, destPath, AMEDIA_MIMETYPE_VIDEO_AVC, 0 /* bitrate */,
+                       2 /* videoSegmentCount */);
+}
+
 TEST_F(MediaTranscoderTests, TestVideoTranscode_4K) {
 #if defined(__i386__) || defined(__x86_64__)
     LOG(WARNING) << "Skipping 4K test on x86 as SW encoder does not support 4K.";
@@ -22,6 +22,7 @@
 #include <android-base/logging.h>
 #include <fcntl.h>
 #include <gtest/gtest.h>
+#include <media/MediaSampleBufferPool.h>
 #include <media/MediaSampleReaderNDK.h>
 #include <media/NdkMediaExtractor.h>
 #include <media/PassthroughTrackTranscoder.h>
@@ -185,14 +186,15 @@ TEST_F(PassthroughTrackTranscoderTests, SampleEquality) {
     EXPECT_EQ(sampleCount, sampleChecksums.size());
 }
 
-/** Class for testing PassthroughTrackTranscoder's built in buffer pool. */
+/** Class for testing the buffer pool used by PassthroughTrackTranscoder. */
 class BufferPoolTests : public ::testing::Test {
 public:
     static constexpr int kMaxBuffers = 5;
+    static constexpr size_t kMinSize = MediaSampleBufferPool::kMinBufferSize;
 
     void SetUp() override {
         LOG(DEBUG) << "BufferPoolTests set up";
-        mBufferPool = std::make_shared<PassthroughTrackTranscoder::BufferPool>(kMaxBuffers);
+        mBufferPool = std::make_shared<MediaSampleBufferPool>(kMaxBuffers);
     }
 
     void TearDown() override {
@@ -200,7 +202,7 @@ public:
         mBufferPool.reset();
     }
 
-    std::shared_ptr<PassthroughTrackTranscoder::BufferPool> mBufferPool;
+    std::shared_ptr<MediaSampleBufferPool> mBufferPool;
 };
 
 TEST_F(BufferPoolTests, BufferReuse) {
@@ -228,17 +230,18 @@ TEST_F(BufferPoolTests, BufferReuse) {
     EXPECT_EQ(buffer4, buffer2);
 }
 
-TEST_F(BufferPoolTests, SmallestAvailableBuffer) {
-    LOG(DEBUG) << "Testing SmallestAvailableBuffer";
+TEST_F(BufferPoolTests, SizeClassReuse) {
+    LOG(DEBUG) << "Testing SizeClassReuse";
 
+    // Buffers in three different size classes.
     uint8_t* buffer1 = mBufferPool->getBufferWithSize(10);
     EXPECT_NE(buffer1, nullptr);
 
-    uint8_t* buffer2 = mBufferPool->getBufferWithSize(15);
+    uint8_t* buffer2 = mBufferPool->getBufferWithSize(kMinSize + 1);
     EXPECT_NE(buffer2, nullptr);
     EXPECT_NE(buffer2, buffer1);
 
-    uint8_t* buffer3 = mBufferPool->getBufferWithSize(20);
+    uint8_t* buffer3 = mBufferPool->getBufferWithSize(kMinSize * 2 + 1);
     EXPECT_NE(buffer3, nullptr);
     EXPECT_NE(buffer3, buffer1);
     EXPECT_NE(buffer3, buffer2);
@@ -247,13 +250,37 @@ TEST_F(BufferPoolTests, SmallestAvailableBuffer) {
     mBufferPool->returnBuffer(buffer2);
     mBufferPool->returnBuffer(buffer3);
 
-    uint8_t* buffer4 = mBufferPool->getBufferWithSize(11);
-    EXPECT_NE(buffer4, nullptr);
+    // Sizes in the same size class get the same buffer.
+    uint8_t* buffer4 = mBufferPool->getBufferWithSize(kMinSize + kMinSize / 4);
     EXPECT_EQ(buffer4, buffer2);
 
-    uint8_t* buffer5 = mBufferPool->getBufferWithSize(11);
-    EXPECT_NE(buffer5, nullptr);
-    EXPECT_EQ(buffer5, buffer3);
+    uint8_t* buffer5 = mBufferPool->getBufferWithSize(kMinSize);
+    EXPECT_EQ(buffer5, buffer1);
+
+    // A free buffer of a larger size class, up to twice the size, is used before allocating a
+    // new one.
+    uint8_t* buffer6 = mBufferPool->getBufferWithSize(kMinSize * 2);
+    EXPECT_EQ(buffer6, buffer3);
+}
+
+TEST_F(BufferPoolTests, SizeClassSpacing) {
+    LOG(DEBUG) << "Testing SizeClassSpacing";
+
+    // Size classes are a quarter octave apart, so sizes just past a size class don't share its
+    // buffer.
+    uint8_t* buffer1 = mBufferPool->getBufferWithSize(kMinSize * 2 + kMinSize / 2);
+    EXPECT_NE(buffer1, nullptr);
+    mBufferPool->returnBuffer(buffer1);
+
+    uint8_t* buffer2 = mBufferPool->getBufferWithSize(kMinSize * 2 + kMinSize / 2 + 1);
+    EXPECT_NE(buffer2, nullptr);
+    EXPECT_NE(buffer2, buffer1);
+    mBufferPool->returnBuffer(buffer2);
+
+    // Buffers more than twice the requested size are not used while the pool isn't full.
+    uint8_t* buffer3 = mBufferPool->getBufferWithSize(kMinSize);
+    EXPECT_NE(buffer3, buffer1);
+    EXPECT_NE(buffer3, buffer2);
 }
 
 TEST_F(BufferPoolTests, AddAfterAbort) {
@@ -271,32 +298,25 @@ TEST_F(BufferPoolTests, AddAfterAbort) {
 TEST_F(BufferPoolTests, MaximumBuffers) {
     LOG(DEBUG) << "Testing MaximumBuffers";
 
-    static constexpr size_t kBufferBaseSize = 10;
-    std::unordered_map<uint8_t*, size_t> addressSizeMap;
-
-    // Get kMaxBuffers * 2 new buffers with increasing size.
-    // (Note: Once kMaxBuffers have been allocated, the pool will delete old buffers to accommodate
-    // new ones making the deleted buffers free to be reused by the system's heap memory allocator.
-    // So we cannot test that each new pointer is unique here.)
-    for (int i = 0; i < kMaxBuffers * 2; i++) {
-        size_t size = kBufferBaseSize + i;
-        uint8_t* buffer = mBufferPool->getBufferWithSize(size);
+    // Get kMaxBuffers buffers in increasing size classes and return them.
+    std::vector<uint8_t*> buffers;
+    for (int i = 0; i < kMaxBuffers; i++) {
+        uint8_t* buffer = mBufferPool->getBufferWithSize(kMinSize << i);
         EXPECT_NE(buffer, nullptr);
-        addressSizeMap[buffer] = size;
+        buffers.push_back(buffer);
+    }
+    for (uint8_t* buffer : buffers) {
         mBufferPool->returnBuffer(buffer);
     }
 
-    // Verify that the pool now contains the kMaxBuffers largest buffers allocated above and that
-    // the buffer of matching size is returned.
-    for (int i = kMaxBuffers; i < kMaxBuffers * 2; i++) {
-        size_t size = kBufferBaseSize + i;
-        uint8_t* buffer = mBufferPool->getBufferWithSize(size);
-        EXPECT_NE(buffer, nullptr);
+    // Once kMaxBuffers have been allocated, a buffer larger than all free buffers replaces the
+    // smallest free buffer. The other buffers are still available.
+    uint8_t* largeBuffer = mBufferPool->getBufferWithSize(kMinSize << kMaxBuffers);
+    EXPECT_NE(largeBuffer, nullptr);
 
-        auto it = addressSizeMap.find(buffer);
-        ASSERT_NE(it, addressSizeMap.end());
-        EXPECT_EQ(it->second, size);
-        mBufferPool->returnBuffer(buffer);
+    for (int i = 1; i < kMaxBuffers; i++) {
+        uint8_t* buffer = mBufferPool->getBufferWithSize(kMinSize << i);
+        EXPECT_EQ(buffer, buffers[i]);
     }
 }
 
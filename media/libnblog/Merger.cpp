@@ -156,20 +156,24 @@ void MergeReader::processSnapshot(Snapshot &snapshot, int author)
         case EVENT_LATENCY: {
             const double latencyMs = it.payload<double>();
             data.latencyHist.add(latencyMs);
+            data.latencyMs.add(latencyMs);
         } break;
         case EVENT_WORK_TIME: {
             const int64_t monotonicNs = it.payload<int64_t>();
             const double monotonicMs = monotonicNs * 1e-6;
             data.workHist.add(monotonicMs);
             data.active += monotonicNs;
+            data.glitches.onCycle(monotonicNs);
         } break;
         case EVENT_WARMUP_TIME: {
             const double timeMs = it.payload<double>();
             data.warmupHist.add(timeMs);
+            data.warmupMs.add(timeMs);
         } break;
         case EVENT_UNDERRUN: {
             const int64_t ts = it.payload<int64_t>();
             data.underruns++;
+            data.glitches.onUnderrun(ts);
             data.snapshots.emplace_front(EVENT_UNDERRUN, ts);
             // TODO have a data structure to automatically handle resizing
             if (data.snapshots.size() > ReportPerformance::PerformanceData::kMaxSnapshotsToStore) {
@@ -185,6 +189,10 @@ void MergeReader::processSnapshot(Snapshot &snapshot, int author)
                 data.snapshots.pop_back();
             }
         } break;
+        case EVENT_CPU_LOAD: {
+            const cpu_load_t load = it.payload<cpu_load_t>();
+            data.glitches.onCpuLoad(load);
+        } break;
         case EVENT_RESERVED:
         case EVENT_UPPER_BOUND:
             ALOGW("warning: unexpected event %d", it->type);
@@ -155,6 +155,201 @@ std::string Histogram::asciiArtString(size_t indent) const {
 
 //------------------------------------------------------------------------------
 
+StreamingQuantile::StreamingQuantile(double quantile)
+    : mQuantile(std::max(0., std::min(1., quantile)))
+{
+    clear();
+}
+
+void StreamingQuantile::clear()
+{
+    mCount = 0;
+    const double q = mQuantile;
+    const double desired[kMarkers] = {1., 1. + 2. * q, 1. + 4. * q, 3. + 2. * q, 5.};
+    const double increments[kMarkers] = {0., q / 2., q, (1. + q) / 2., 1.};
+    for (size_t i = 0; i < kMarkers; i++) {
+        mHeights[i] = 0.;
+        mPositions[i] = i + 1;
+        mDesired[i] = desired[i];
+        mIncrements[i] = increments[i];
+    }
+}
+
+void StreamingQuantile::add(double value)
+{
+    // Store the first data points, then sort them to initialize the markers.
+    if (mCount < kMarkers) {
+        mHeights[mCount++] = value;
+        if (mCount == kMarkers) {
+            std::sort(mHeights, mHeights + kMarkers);
+        }
+        return;
+    }
+
+    // Find the cell k such that mHeights[k] <= value < mHeights[k + 1],
+    // adjusting the extreme markers if value is outside of the range.
+    size_t k;
+    if (value < mHeights[0]) {
+        mHeights[0] = value;
+        k = 0;
+    } else if (value >= mHeights[kMarkers - 1]) {
+        mHeights[kMarkers - 1] = value;
+        k = kMarkers - 2;
+    } else {
+        k = std::upper_bound(mHeights + 1, mHeights + kMarkers, value) - mHeights - 1;
+    }
+    for (size_t i = k + 1; i < kMarkers; i++) {
+        mPositions[i]++;
+    }
+    for (size_t i = 0; i < kMarkers; i++) {
+        mDesired[i] += mIncrements[i];
+    }
+    mCount++;
+
+    // Move the middle markers towards their desired positions if they are off by one or more.
+    for (size_t i = 1; i < kMarkers - 1; i++) {
+        const double delta = mDesired[i] - mPositions[i];
+        if ((delta >= 1. && mPositions[i + 1] - mPositions[i] > 1.)
+                || (delta <= -1. && mPositions[i - 1] - mPositions[i] < -1.)) {
+            const double d = delta > 0 ? 1. : -1.;
+            const double height = parabolic(i, d);
+            if (mHeights[i - 1] < height && height < mHeights[i + 1]) {
+                mHeights[i] = height;
+            } else {
+                // the parabolic prediction is not monotonic, use a linear one
+                const size_t j = d > 0 ? i + 1 : i - 1;
+                mHeights[i] += d * (mHeights[j] - mHeights[i]) / (mPositions[j] - mPositions[i]);
+            }
+            mPositions[i] += d;
+        }
+    }
+}
+
+double StreamingQuantile::parabolic(size_t i, double d) const
+{
+    const double *n = mPositions;
+    const double *q = mHeights;
+    return q[i] + d / (n[i + 1] - n[i - 1])
+            * ((n[i] - n[i - 1] + d) * (q[i + 1] - q[i]) / (n[i + 1] - n[i])
+            + (n[i + 1] - n[i] - d) * (q[i] - q[i - 1]) / (n[i] - n[i - 1]));
+}
+
+double StreamingQuantile::value() const
+{
+    if (mCount == 0) {
+        return 0.;
+    }
+    if (mCount < kMarkers) {
+        double sorted[kMarkers];
+        std::copy(mHeights, mHeights + mCount, sorted);
+        std::sort(sorted, sorted + mCount);
+        return sorted[lround(mQuantile * (mCount - 1))];
+    }
+    return mHeights[kMarkers / 2];
+}
+
+std::string Percentiles::toString() const
+{
+    std::stringstream ss;
+    ss << p50.value() << "," << p90.value() << "," << p99.value();
+    return ss.str();
+}
+
+//------------------------------------------------------------------------------
+
+// static
+const char *GlitchAnalysis::causeToString(Cause cause)
+{
+    switch (cause) {
+    case CAUSE_CPU_FREQUENCY:
+        return "cpuFrequency";
+    case CAUSE_CPU_LOAD:
+        return "cpuLoad";
+    case CAUSE_SCHEDULING:
+        return "scheduling";
+    case CAUSE_UNKNOWN:
+    default:
+        return "unknown";
+    }
+}
+
+void GlitchAnalysis::onUnderrun(int64_t ts)
+{
+    if (mPendingUnderrun) {
+        // the previous underrun did not get the load of its cycle
+        attribute(CAUSE_UNKNOWN);
+    }
+    mPendingUnderrun = true;
+
+    if (mBurstUnderruns > 0 && ts - mLastUnderrunTs <= kBurstGapNs) {
+        if (++mBurstUnderruns == 2) {
+            mBursts++;
+        }
+    } else {
+        mBurstUnderruns = 1;
+    }
+    mMaxBurstUnderruns = std::max(mMaxBurstUnderruns, mBurstUnderruns);
+    mLastUnderrunTs = ts;
+}
+
+void GlitchAnalysis::onCycle(int64_t periodNs)
+{
+    mLastPeriodNs = periodNs;
+}
+
+void GlitchAnalysis::onCpuLoad(const NBLog::cpu_load_t &load)
+{
+    if (mLastPeriodNs < 0) {
+        return;
+    }
+    const double periodMs = mLastPeriodNs * 1e-6;
+    const double loadMs = load.loadNs * 1e-6;
+    mLastPeriodNs = -1;
+
+    if (mPendingUnderrun) {
+        // Compare the late cycle with the typical cycle, before it is added to the statistics.
+        if (mPeriodMs.count() == 0) {
+            attribute(CAUSE_UNKNOWN);
+        } else {
+            const double lateMs = periodMs - mPeriodMs.p50.value();
+            const double extraLoadMs = loadMs - mLoadMs.p50.value();
+            if (extraLoadMs < lateMs / 2) {
+                attribute(CAUSE_SCHEDULING);
+            } else if (load.cpukHz != 0 && mCpukHz.count() > 0
+                    && load.cpukHz < 0.75 * mCpukHz.value()) {
+                attribute(CAUSE_CPU_FREQUENCY);
+            } else {
+                attribute(CAUSE_CPU_LOAD);
+            }
+        }
+    }
+
+    mPeriodMs.add(periodMs);
+    mLoadMs.add(loadMs);
+    if (load.cpukHz != 0) {
+        mCpukHz.add(load.cpukHz);
+    }
+}
+
+void GlitchAnalysis::attribute(Cause cause)
+{
+    mUnderruns[cause]++;
+    mPendingUnderrun = false;
+}
+
+void GlitchAnalysis::reset()
+{
+    // A pending underrun and the current burst carry over into the new counts.
+    mPeriodMs.clear();
+    mLoadMs.clear();
+    mCpukHz.clear();
+    std::fill(std::begin(mUnderruns), std::end(mUnderruns), 0);
+    mBursts = 0;
+    mMaxBurstUnderruns = 0;
+}
+
+//------------------------------------------------------------------------------
+
 // Given an audio processing wakeup timestamp, buckets the time interval
 // since the previous timestamp into a histogram, searches for
 // outliers, analyzes the outlier series for unexpectedly
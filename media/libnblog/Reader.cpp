@@ -271,6 +271,10 @@ void DumpReader::dump(int fd, size_t indent)
             const thread_params_t params = it.payload<thread_params_t>();
             body.appendFormat("EVENT_THREAD_PARAMS,%zu,%u", params.frameCount, params.sampleRate);
         } break;
+        case EVENT_CPU_LOAD: {
+            const cpu_load_t load = it.payload<cpu_load_t>();
+            body.appendFormat("EVENT_CPU_LOAD,%u,%u", load.loadNs, load.cpukHz);
+        } break;
         case EVENT_FMT_END:
         case EVENT_RESERVED:
         case EVENT_UPPER_BOUND:
@@ -51,7 +51,21 @@ static std::unique_ptr<Json::Value> dumpToJson(const PerformanceData& data)
     root["workMsHist"] = data.workHist.toString();
     root["latencyMsHist"] = data.latencyHist.toString();
     root["warmupMsHist"] = data.warmupHist.toString();
+    root["workMsPercentiles"] = data.glitches.periodMs().toString();
+    root["loadMsPercentiles"] = data.glitches.loadMs().toString();
+    root["latencyMsPercentiles"] = data.latencyMs.toString();
+    root["warmupMsPercentiles"] = data.warmupMs.toString();
     root["underruns"] = (Json::Value::Int64)data.underruns;
+    for (int i = 0; i < GlitchAnalysis::CAUSE_COUNT; i++) {
+        const auto cause = static_cast<GlitchAnalysis::Cause>(i);
+        if (!data.glitches.isReported(cause)) {
+            continue;
+        }
+        root["underrunCauses"][GlitchAnalysis::causeToString(cause)] =
+                (Json::Value::Int64)data.glitches.underruns(cause);
+    }
+    root["underrunBursts"] = (Json::Value::Int64)data.glitches.bursts();
+    root["maxBurstUnderruns"] = (Json::Value::Int64)data.glitches.maxBurstUnderruns();
     root["overruns"] = (Json::Value::Int64)data.overruns;
     root["activeMs"] = (Json::Value::Int64)ns2ms(data.active);
     root["durationMs"] = (Json::Value::Int64)ns2ms(systemTime() - data.start);
@@ -69,6 +83,23 @@ static std::string dumpHistogramsToString(const PerformanceData& data)
     ss << "  Thread work times in ms:\n" << data.workHist.asciiArtString(4 /*indent*/);
     ss << "  Thread latencies in ms:\n" << data.latencyHist.asciiArtString(4 /*indent*/);
     ss << "  Thread warmup times in ms:\n" << data.warmupHist.asciiArtString(4 /*indent*/);
+    const GlitchAnalysis& glitches = data.glitches;
+    ss << "  Percentiles p50,p90,p99 in ms: work=" << glitches.periodMs().toString()
+            << " load=" << glitches.loadMs().toString()
+            << " latency=" << data.latencyMs.toString()
+            << " warmup=" << data.warmupMs.toString() << "\n";
+    ss << "  Underruns: " << data.underruns << " (";
+    const char *separator = "";
+    for (int i = 0; i < GlitchAnalysis::CAUSE_COUNT; i++) {
+        const auto cause = static_cast<GlitchAnalysis::Cause>(i);
+        if (glitches.isReported(cause)) {
+            ss << separator << GlitchAnalysis::causeToString(cause) << "="
+                    << glitches.underruns(cause);
+            separator = " ";
+        }
+    }
+    ss << ") bursts=" << glitches.bursts()
+            << " maxBurstUnderruns=" << glitches.maxBurstUnderruns() << "\n";
     return ss.str();
 }
 
@@ -162,6 +193,13 @@ bool sendToMediaMetrics(const PerformanceData& data)
     static constexpr char kThreadOverruns[] = "android.media.audiothread.overruns";
     static constexpr char kThreadActive[] = "android.media.audiothread.activeMs";
     static constexpr char kThreadDuration[] = "android.media.audiothread.durationMs";
+    static constexpr char kThreadWorkPercentiles[] = "android.media.audiothread.workMs.pct";
+    static constexpr char kThreadLoadPercentiles[] = "android.media.audiothread.loadMs.pct";
+    static constexpr char kThreadLatencyPercentiles[] = "android.media.audiothread.latencyMs.pct";
+    static constexpr char kThreadUnderrunBursts[] = "android.media.audiothread.underrunBursts";
+    static constexpr char kThreadMaxBurstUnderruns[] =
+            "android.media.audiothread.maxBurstUnderruns";
+    static constexpr char kThreadUnderrunCausePrefix[] = "android.media.audiothread.underruns.";
 
     // Currently, we only allow FastMixer thread data to be sent to Media Metrics.
     if (data.threadInfo.type != NBLog::FASTMIXER) {
@@ -185,8 +223,32 @@ bool sendToMediaMetrics(const PerformanceData& data)
         item->setCString(kThreadWarmupHist, warmupHist.toString().c_str());
     }
 
+    // Percentiles are serialized as "p50,p90,p99".
+    const GlitchAnalysis &glitches = data.glitches;
+    if (glitches.periodMs().count() > 0) {
+        item->setCString(kThreadWorkPercentiles, glitches.periodMs().toString().c_str());
+        item->setCString(kThreadLoadPercentiles, glitches.loadMs().toString().c_str());
+    }
+
+    if (data.latencyMs.count() > 0) {
+        item->setCString(kThreadLatencyPercentiles, data.latencyMs.toString().c_str());
+    }
+
     if (data.underruns > 0) {
         item->setInt64(kThreadUnderruns, data.underruns);
+        for (int i = 0; i < GlitchAnalysis::CAUSE_COUNT; i++) {
+            const auto cause = static_cast<GlitchAnalysis::Cause>(i);
+            if (glitches.underruns(cause) > 0) {
+                const std::string key = std::string(kThreadUnderrunCausePrefix)
+                        + GlitchAnalysis::causeToString(cause);
+                item->setInt64(key.c_str(), glitches.underruns(cause));
+            }
+        }
+    }
+
+    if (glitches.bursts() > 0) {
+        item->setInt64(kThreadUnderrunBursts, glitches.bursts());
+        item->setInt64(kThreadMaxBurstUnderruns, glitches.maxBurstUnderruns());
     }
 
     if (data.overruns > 0) {
@@ -68,6 +68,7 @@ enum Event : uint8_t {
     EVENT_WARMUP_TIME,          // thread warmup time
     EVENT_WORK_TIME,            // the time a thread takes to do work, e.g. read, write, etc.
     EVENT_THREAD_PARAMS,        // see thread_params_t below
+    EVENT_CPU_LOAD,             // see cpu_load_t below
 
     EVENT_UPPER_BOUND,          // to check for invalid events
 };
@@ -132,6 +133,13 @@ struct thread_params_t {
     unsigned sampleRate = 0;        // in frames per second
 };
 
+// mapped from EVENT_CPU_LOAD
+// Logged each cycle after EVENT_WORK_TIME, for the same interval.
+struct cpu_load_t {
+    uint32_t loadNs = 0;            // CPU time used by the thread during the cycle
+    uint32_t cpukHz = 0;            // CPU clock frequency at the end of the cycle, 0 if unknown
+};
+
 template <Event E> struct get_mapped;
 #define MAP_EVENT_TO_TYPE(E, T) \
 template<> struct get_mapped<E> { \
@@ -149,6 +157,7 @@ MAP_EVENT_TO_TYPE(EVENT_UNDERRUN, int64_t);
 MAP_EVENT_TO_TYPE(EVENT_WARMUP_TIME, double);
 MAP_EVENT_TO_TYPE(EVENT_WORK_TIME, int64_t);
 MAP_EVENT_TO_TYPE(EVENT_THREAD_PARAMS, thread_params_t);
+MAP_EVENT_TO_TYPE(EVENT_CPU_LOAD, cpu_load_t);
 
 }   // namespace NBLog
 }   // namespace android
@@ -133,6 +133,156 @@ private:
     uint64_t mTotalCount = 0;       // Total number of values recorded
 };
 
+/*
+ * StreamingQuantile estimates a quantile of a data stream in constant memory and time per
+ * data point, with the P-square algorithm (Jain and Chlamtac, 1985): five markers track the
+ * minimum, the maximum, the quantile and the two quantiles halfway to it, and are moved along
+ * a piecewise parabolic approximation of the cumulative distribution.
+ * The estimate is exact until 5 data points have been added.
+ *
+ * This class is not thread-safe.
+ */
+class StreamingQuantile {
+public:
+    /**
+     * \brief Creates a StreamingQuantile object.
+     *
+     * \param quantile the quantile to estimate, between 0 and 1, e.g. 0.99 for P99.
+     */
+    explicit StreamingQuantile(double quantile);
+
+    /**
+     * \brief Adds a data point.
+     *
+     * \param value the value of the data point to add.
+     */
+    void add(double value);
+
+    /**
+     * \brief Removes all data points.
+     */
+    void clear();
+
+    /**
+     * \brief Returns the number of data points added.
+     */
+    uint64_t count() const { return mCount; }
+
+    /**
+     * \brief Returns the estimated quantile, or 0 if no data point was added.
+     */
+    double value() const;
+
+private:
+    static constexpr size_t kMarkers = 5;
+
+    // Returns the height of marker i moved by d (-1 or 1) position with the parabolic formula.
+    double parabolic(size_t i, double d) const;
+
+    const double mQuantile;
+    uint64_t mCount = 0;
+    double mHeights[kMarkers];      // marker heights, the first mCount are the data when < 5
+    double mPositions[kMarkers];    // actual marker positions
+    double mDesired[kMarkers];      // desired marker positions
+    double mIncrements[kMarkers];   // increments of the desired positions per data point
+};
+
+/*
+ * Percentiles holds the streaming P50, P90 and P99 of a metric.
+ */
+struct Percentiles {
+    StreamingQuantile p50{0.5};
+    StreamingQuantile p90{0.9};
+    StreamingQuantile p99{0.99};
+
+    void add(double value) {
+        p50.add(value);
+        p90.add(value);
+        p99.add(value);
+    }
+
+    void clear() {
+        p50.clear();
+        p90.clear();
+        p99.clear();
+    }
+
+    uint64_t count() const { return p50.count(); }
+
+    // Serializes as "p50,p90,p99".
+    std::string toString() const;
+};
+
+/*
+ * GlitchAnalysis groups the underruns of a fast thread into bursts, and attributes each
+ * underrun to a cause, from the cycle period and the CPU load logged for the late cycle.
+ * The time the late cycle exceeded the typical period by is compared to the time its CPU
+ * load exceeded the typical load by:
+ * - if the extra CPU time accounts for most of the delay, the thread had too much work for
+ *   the CPU, at a lower clock frequency than usual (CAUSE_CPU_FREQUENCY) or not (CAUSE_CPU_LOAD).
+ * - otherwise the thread was not running, because it was preempted or its wakeup was late
+ *   (CAUSE_SCHEDULING).
+ * Underruns without CPU load data, e.g. when FAST_THREAD_STATISTICS is not defined,
+ * are CAUSE_UNKNOWN. The fast threads only log the clock frequency if
+ * CPU_FREQUENCY_STATISTICS is defined. Without it, the underruns of too much work are all
+ * CAUSE_CPU_LOAD and CAUSE_CPU_FREQUENCY is not reported, see isReported().
+ *
+ * This class is not thread-safe.
+ */
+class GlitchAnalysis {
+public:
+    enum Cause {
+        CAUSE_CPU_FREQUENCY,
+        CAUSE_CPU_LOAD,
+        CAUSE_SCHEDULING,
+        CAUSE_UNKNOWN,
+        CAUSE_COUNT,
+    };
+
+    static const char *causeToString(Cause cause);
+
+    // Underruns closer than this belong to the same burst.
+    static constexpr nsecs_t kBurstGapNs = 500 * 1000000LL; // 500 ms
+
+    // Called for EVENT_UNDERRUN, ts is the underrun timestamp.
+    void onUnderrun(int64_t ts);
+
+    // Called for EVENT_WORK_TIME, the period of the cycle.
+    void onCycle(int64_t periodNs);
+
+    // Called for EVENT_CPU_LOAD, logged after EVENT_WORK_TIME for the same cycle.
+    void onCpuLoad(const NBLog::cpu_load_t &load);
+
+    void reset();
+
+    int64_t underruns(Cause cause) const { return mUnderruns[cause]; }
+    // Returns false for a cause that cannot be attributed with the logged data.
+    bool isReported(Cause cause) const {
+        return cause != CAUSE_CPU_FREQUENCY || mCpukHz.count() > 0;
+    }
+    int64_t bursts() const { return mBursts; }
+    int64_t maxBurstUnderruns() const { return mMaxBurstUnderruns; }
+    const Percentiles &periodMs() const { return mPeriodMs; }
+    const Percentiles &loadMs() const { return mLoadMs; }
+
+private:
+    void attribute(Cause cause);
+
+    // typical cycle, to compare the late cycle with
+    Percentiles mPeriodMs;
+    Percentiles mLoadMs;
+    StreamingQuantile mCpukHz{0.5};
+
+    int64_t mLastPeriodNs = -1;         // period of the current cycle, -1 if not logged
+    bool    mPendingUnderrun = false;   // an underrun waits for the load of its cycle
+
+    int64_t mLastUnderrunTs = 0;
+    int64_t mBurstUnderruns = 0;        // underruns in the current burst
+    int64_t mBursts = 0;                // bursts of at least 2 underruns
+    int64_t mMaxBurstUnderruns = 0;
+    int64_t mUnderruns[CAUSE_COUNT] = {};
+};
+
 // This is essentially the same as class PerformanceAnalysis, but PerformanceAnalysis
 // also does some additional analyzing of data, while the purpose of this struct is
 // to hold data.
@@ -159,6 +309,9 @@ struct PerformanceData {
     Histogram workHist{kWorkConfig};
     Histogram latencyHist{kLatencyConfig};
     Histogram warmupHist{kWarmupConfig};
+    Percentiles latencyMs;
+    Percentiles warmupMs;
+    GlitchAnalysis glitches;
     int64_t underruns = 0;
     static constexpr size_t kMaxSnapshotsToStore = 256;
     std::deque<std::pair<NBLog::Event, int64_t /*timestamp*/>> snapshots;
@@ -173,6 +326,9 @@ struct PerformanceData {
         workHist.clear();
         latencyHist.clear();
         warmupHist.clear();
+        latencyMs.clear();
+        warmupMs.clear();
+        glitches.reset();
         underruns = 0;
         overruns = 0;
         active = 0;
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "performance_analysis_tests"
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <media/nblog/PerformanceAnalysis.h>
+
+using namespace android;
+using namespace android::ReportPerformance;
+
+// Returns the quantile of the sorted values, by linear interpolation between the closest ranks.
+static double exactQuantile(const std::vector<double> &sorted, double quantile) {
+    const double rank = quantile * (sorted.size() - 1);
+    const size_t below = (size_t)rank;
+    const size_t above = std::min(below + 1, sorted.size() - 1);
+    return sorted[below] + (rank - below) * (sorted[above] - sorted[below]);
+}
+
+// Checks the estimates of the quantiles of values against the exact quantiles, within
+// tolerance times the interquartile range of the values.
+static void checkQuantiles(std::vector<double> values, double tolerance) {
+    constexpr double kQuantiles[] = {0.1, 0.5, 0.9, 0.99};
+    StreamingQuantile estimates[] = {
+        StreamingQuantile(kQuantiles[0]), StreamingQuantile(kQuantiles[1]),
+        StreamingQuantile(kQuantiles[2]), StreamingQuantile(kQuantiles[3])};
+    for (const double value : values) {
+        for (auto &estimate : estimates) {
+            estimate.add(value);
+        }
+    }
+    std::sort(values.begin(), values.end());
+    const double range = exactQuantile(values, 0.75) - exactQuantile(values, 0.25);
+    for (size_t i = 0; i < std::size(kQuantiles); i++) {
+        EXPECT_EQ(values.size(), estimates[i].count());
+        EXPECT_NEAR(exactQuantile(values, kQuantiles[i]), estimates[i].value(),
+                tolerance * range) << "quantile " << kQuantiles[i];
+    }
+}
+
+TEST(StreamingQuantile, ExactForFewValues) {
+    StreamingQuantile median(0.5);
+    EXPECT_EQ(0., median.value());
+    for (const double value : {3., 1., 2.}) {
+        median.add(value);
+    }
+    EXPECT_EQ(2., median.value());
+    median.clear();
+    EXPECT_EQ(0u, median.count());
+    EXPECT_EQ(0., median.value());
+}
+
+TEST(StreamingQuantile, Uniform) {
+    std::minstd_rand gen(42);
+    std::uniform_real_distribution<double> distribution(0., 10.);
+    std::vector<double> values(100000);
+    std::generate(values.begin(), values.end(), [&] { return distribution(gen); });
+    checkQuantiles(values, 0.01);
+}
+
+TEST(StreamingQuantile, Normal) {
+    std::minstd_rand gen(42);
+    std::normal_distribution<double> distribution(5., 1.);
+    std::vector<double> values(100000);
+    std::generate(values.begin(), values.end(), [&] { return distribution(gen); });
+    checkQuantiles(values, 0.02);
+}
+
+TEST(StreamingQuantile, Exponential) {
+    // long tailed, like the cycle times of a fast thread
+    std::minstd_rand gen(42);
+    std::exponential_distribution<double> distribution(1.);
+    std::vector<double> values(100000);
+    std::generate(values.begin(), values.end(), [&] { return distribution(gen); });
+    checkQuantiles(values, 0.05);
+}
+
+TEST(GlitchAnalysis, CpuFrequencyNeedsFrequency) {
+    GlitchAnalysis glitches;
+    NBLog::cpu_load_t load;
+    load.loadNs = 1000000;
+    glitches.onCycle(5000000);
+    glitches.onCpuLoad(load);
+    EXPECT_FALSE(glitches.isReported(GlitchAnalysis::CAUSE_CPU_FREQUENCY));
+    EXPECT_TRUE(glitches.isReported(GlitchAnalysis::CAUSE_CPU_LOAD));
+
+    load.cpukHz = 1800000;
+    glitches.onCycle(5000000);
+    glitches.onCpuLoad(load);
+    EXPECT_TRUE(glitches.isReported(GlitchAnalysis::CAUSE_CPU_FREQUENCY));
+}
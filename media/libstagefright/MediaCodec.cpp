@@ -263,6 +263,7 @@ struct MediaCodec::ResourceManagerServiceProxy : public RefBase {
     void removeClient();
     void markClientForPendingRemoval();
     bool reclaimResource(const std::vector<MediaResourceParcel> &resources);
+    bool admitResource(const std::vector<MediaResourceParcel> &resources);
 
 private:
     Mutex mLock;
@@ -395,6 +396,17 @@ bool MediaCodec::ResourceManagerServiceProxy::reclaimResource(
     return status.isOk() && success;
 }
 
+bool MediaCodec::ResourceManagerServiceProxy::admitResource(
+        const std::vector<MediaResourceParcel> &resources) {
+    Mutex::Autolock _l(mLock);
+    if (mService == NULL) {
+        return false;
+    }
+    bool success;
+    Status status = mService->admitResource(mPid, resources, &success);
+    return status.isOk() && success;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 MediaCodec::BufferInfo::BufferInfo() : mOwnedByClient(false) {}
@@ -1459,6 +1471,15 @@ status_t MediaCodec::init(const AString &name, bool nameIsType) {
     status_t err;
     std::vector<MediaResourceParcel> resources;
     resources.push_back(MediaResource::CodecResource(secureCodec, mIsVideo));
+    if (mCodecInfo != nullptr
+            && !(mCodecInfo->getAttributes() & MediaCodecInfo::kFlagIsSoftwareOnly)) {
+        // Hardware codecs are capacity limited, make room before allocating
+        // rather than after the allocation fails. The retry loop below still
+        // handles the case where the capacity estimate was too optimistic.
+        if (!mResourceManagerProxy->admitResource(resources)) {
+            ALOGD("codec capacity model predicts %s may not be admitted", name.c_str());
+        }
+    }
     for (int i = 0; i <= kMaxRetry; ++i) {
         if (i > 0) {
             // Don't try to reclaim resource for the first time.
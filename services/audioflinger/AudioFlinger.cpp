@@ -56,6 +56,7 @@
 #include <audiomanager/AudioManager.h>
 
 #include "AudioFlinger.h"
+#include "AudioTrace.h"
 #include "NBAIO_Tee.h"
 
 #include <media/AudioResamplerPublic.h>
@@ -632,6 +633,9 @@ status_t AudioFlinger::dump(int fd, const Vector<String16>& args)
 {
     if (!dumpAllowed()) {
         dumpPermissionDenial(fd, args);
+    } else if (args.size() > 0 && args[0] == String16("--trace")) {
+        // only the timeline of the audio threads, as a Chrome JSON trace, no locks taken
+        AudioTrace::dumpAll(fd);
     } else {
         // get state of hardware lock
         bool hardwareLocked = dumpTryLock(mHardwareLock);
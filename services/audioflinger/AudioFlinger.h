@@ -19,6 +19,7 @@
 #define ANDROID_AUDIO_FLINGER_H
 
 #include "Configuration.h"
+#include <array>
 #include <atomic>
 #include <mutex>
 #include <chrono>
@@ -81,6 +82,7 @@
 #include <audio_utils/FdToString.h>
 #include <audio_utils/LinearMap.h>
 #include <audio_utils/SimpleLog.h>
+#include <audio_utils/Statistics.h>
 #include <audio_utils/TimestampVerifier.h>
 
 #include "FastCapture.h"
@@ -93,6 +93,17 @@ public:
     virtual status_t flush();
     virtual status_t standby();
 
+    /**
+     * Writes to the HAL the data held back by the wrapper, if any, for when the thread
+     * drains, pauses or stops the stream.
+     */
+    virtual status_t writeHeldData() { return NO_ERROR; }
+
+    /**
+     * Dumps the state of the wrapper, the HAL stream is dumped separately.
+     */
+    virtual void dump(int fd __unused) const { }
+
 protected:
     uint64_t             mRenderPosition; // reset by flush or standby
     int                  mRateMultiplier;
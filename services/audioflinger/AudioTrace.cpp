@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "AudioTrace"
+//#define LOG_NDEBUG 0
+
+#include <algorithm>
+#include <mutex>
+#include <set>
+#include <unistd.h>
+
+#include <cutils/properties.h>
+#include <utils/Log.h>
+
+#include "AudioTrace.h"
+
+namespace android {
+
+thread_local AudioTrace *tlAudioTrace;
+
+namespace {
+
+// 64 KiB per thread, about a second of FastMixer activity.
+constexpr int32_t kDefaultEntries = 4096;
+
+constexpr const char *kEventNames[AudioTrace::EVENT_COUNT] = {
+    "mix",
+    "effects",
+    "hal_write",
+    "hal_read",
+    "underrun",
+    "state_push",
+    "state_poll",
+};
+
+constexpr char kPhases[] = {'B', 'E', 'i'};
+
+std::mutex &tracesLock() {
+    static std::mutex lock;
+    return lock;
+}
+
+std::set<const AudioTrace *> &traces() {
+    static std::set<const AudioTrace *> traces;
+    return traces;
+}
+
+} // namespace
+
+// static
+std::unique_ptr<AudioTrace> AudioTrace::create(const char *threadName)
+{
+    static const int32_t entries = property_get_int32("af.trace.entries", kDefaultEntries);
+    if (entries <= 0) {
+        return nullptr;
+    }
+    // round up to a power of 2 for the mask
+    size_t size = 1;
+    while (size < (size_t)entries) {
+        size <<= 1;
+    }
+    return std::unique_ptr<AudioTrace>(new AudioTrace(threadName, size));
+}
+
+AudioTrace::AudioTrace(const char *threadName, size_t entries)
+    : mThreadName(threadName),
+      mTid(gettid()),
+      mMask(entries - 1),
+      mEntries(entries)
+{
+    std::lock_guard<std::mutex> _l(tracesLock());
+    traces().insert(this);
+}
+
+AudioTrace::~AudioTrace()
+{
+    std::lock_guard<std::mutex> _l(tracesLock());
+    traces().erase(this);
+}
+
+// static
+void AudioTrace::dumpAll(int fd)
+{
+    const pid_t pid = getpid();
+    // The traced threads never take the lock, it only delays the destruction of a trace.
+    // The rings are copied under the lock and written after, so that a slow reader of the
+    // dump does not block the exit of a traced thread.
+    std::vector<Snapshot> snapshots;
+    {
+        std::lock_guard<std::mutex> _l(tracesLock());
+        snapshots.reserve(traces().size());
+        for (const AudioTrace *trace : traces()) {
+            snapshots.push_back(trace->snapshot());
+        }
+    }
+    dprintf(fd, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    bool first = true;
+    for (const Snapshot &snapshot : snapshots) {
+        dump(fd, pid, snapshot, &first);
+    }
+    dprintf(fd, "\n]}\n");
+}
+
+AudioTrace::Snapshot AudioTrace::snapshot() const
+{
+    // Copy the ring, then drop the entries the thread may have overwritten during the copy.
+    const uint64_t size = mMask + 1;
+    const uint64_t rear = mRear.load(std::memory_order_acquire);
+    const uint64_t front = rear > size ? rear - size : 0;
+    Snapshot snapshot{mThreadName, mTid, std::vector<Entry>(rear - front)};
+    for (uint64_t i = front; i < rear; i++) {
+        snapshot.mEntries[i - front] = mEntries[i & mMask];
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t rearAfter = mRear.load(std::memory_order_relaxed);
+    // the entry at rearAfter may be partially written too
+    const uint64_t valid = rearAfter + 1 > size ? rearAfter + 1 - size : 0;
+    const uint64_t skipped = std::min(valid > front ? valid - front : 0, rear - front);
+    snapshot.mEntries.erase(snapshot.mEntries.begin(), snapshot.mEntries.begin() + skipped);
+    return snapshot;
+}
+
+// static
+void AudioTrace::dump(int fd, pid_t pid, const Snapshot &snapshot, bool *first)
+{
+    dprintf(fd, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+            "\"args\":{\"name\":\"%s\"}}",
+            *first ? "" : ",", pid, snapshot.mTid, snapshot.mThreadName.c_str());
+    *first = false;
+    for (const Entry &entry : snapshot.mEntries) {
+        if (entry.mEvent >= EVENT_COUNT || entry.mPhase > PHASE_INSTANT) {
+            continue;
+        }
+        dprintf(fd, ",\n{\"name\":\"%s\",\"ph\":\"%c\",%s\"ts\":%lld.%03lld,"
+                "\"pid\":%d,\"tid\":%d,\"args\":{\"arg\":%d}}",
+                kEventNames[entry.mEvent], kPhases[entry.mPhase],
+                entry.mPhase == PHASE_INSTANT ? "\"s\":\"t\"," : "",
+                (long long)(entry.mTimeNs / 1000), (long long)(entry.mTimeNs % 1000),
+                pid, snapshot.mTid, entry.mArg);
+    }
+}
+
+} // namespace android
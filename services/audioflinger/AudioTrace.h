@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_TRACE_H
+#define ANDROID_AUDIO_TRACE_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+#include <utils/Timers.h>
+
+namespace android {
+
+/**
+ * The AudioTrace records the timeline of an audio thread in a ring of binary events,
+ * so that glitches can be related to the mix, effect, HAL and state queue activity
+ * of all the threads at the time, on production builds.
+ *
+ * Each traced thread owns its AudioTrace, created at the start of its threadLoop() and
+ * reached through tlAudioTrace by the AUDIO_TRACE_* macros. write() is wait-free: it reads
+ * the monotonic clock and stores one entry, without locks, allocations or system calls,
+ * so it can be called from the FastMixer and the FastCapture.
+ *
+ * dumpAll() exports the rings of all the threads as a Chrome JSON trace, which the Perfetto
+ * UI and chrome://tracing open:
+ *   adb shell dumpsys media.audio_flinger --trace > audio_trace.json
+ *
+ * The af.trace.entries property sets the number of entries of each ring, 0 disables tracing.
+ */
+class AudioTrace {
+public:
+    enum Event : uint16_t {
+        EVENT_MIX,          // mixing the tracks, arg: frames
+        EVENT_EFFECTS,      // processing the effect chains, arg: chains
+        EVENT_HAL_WRITE,    // writing to the HAL stream or sink, arg: frames
+        EVENT_HAL_READ,     // reading from the HAL stream or source, arg: frames
+        EVENT_UNDERRUN,     // a track has no frames to mix, arg: track id or fast index
+        EVENT_STATE_PUSH,   // a state pushed to the fast thread queue, arg: 0
+        EVENT_STATE_POLL,   // a new state polled from the fast thread queue, arg: command
+        EVENT_COUNT,
+    };
+
+    enum Phase : uint16_t {
+        PHASE_BEGIN,
+        PHASE_END,
+        PHASE_INSTANT,
+    };
+
+    // Returns nullptr when tracing is disabled. Called by the traced thread.
+    static std::unique_ptr<AudioTrace> create(const char *threadName);
+    ~AudioTrace();
+
+    // Called by the traced thread only.
+    void write(Event event, Phase phase, int32_t arg) {
+        const uint64_t rear = mRear.load(std::memory_order_relaxed);
+        Entry &entry = mEntries[rear & mMask];
+        entry.mTimeNs = systemTime();
+        entry.mEvent = event;
+        entry.mPhase = phase;
+        entry.mArg = arg;
+        mRear.store(rear + 1, std::memory_order_release);
+    }
+
+    // Writes the entries of all the AudioTraces as a Chrome JSON trace.
+    // Safe to call at any time from any thread.
+    static void dumpAll(int fd);
+
+private:
+    struct Entry {
+        int64_t  mTimeNs;
+        uint16_t mEvent;
+        uint16_t mPhase;
+        int32_t  mArg;
+    };
+
+    // A copy of the valid entries of a trace, written to the dump without the lock.
+    struct Snapshot {
+        std::string        mThreadName;
+        pid_t              mTid;
+        std::vector<Entry> mEntries;
+    };
+
+    AudioTrace(const char *threadName, size_t entries);
+
+    Snapshot snapshot() const;
+
+    // Appends the events of a snapshot, with a comma before each event unless *first.
+    static void dump(int fd, pid_t pid, const Snapshot &snapshot, bool *first);
+
+    const std::string     mThreadName;
+    const pid_t           mTid;
+    const uint64_t        mMask;
+    std::vector<Entry>    mEntries;
+    std::atomic<uint64_t> mRear{0};   // entries written, never wraps
+};
+
+// The AudioTrace of the current thread, or nullptr if the thread is not traced.
+extern thread_local AudioTrace *tlAudioTrace;
+
+#define AUDIO_TRACE_BEGIN(event, arg) do { AudioTrace *t = tlAudioTrace; if (t != nullptr) \
+        t->write(AudioTrace::event, AudioTrace::PHASE_BEGIN, (arg)); } while (0)
+
+#define AUDIO_TRACE_END(event, arg) do { AudioTrace *t = tlAudioTrace; if (t != nullptr) \
+        t->write(AudioTrace::event, AudioTrace::PHASE_END, (arg)); } while (0)
+
+#define AUDIO_TRACE_INSTANT(event, arg) do { AudioTrace *t = tlAudioTrace; if (t != nullptr) \
+        t->write(AudioTrace::event, AudioTrace::PHASE_INSTANT, (arg)); } while (0)
+
+} // namespace android
+
+#endif // ANDROID_AUDIO_TRACE_H
@@ -703,7 +703,7 @@ void AudioFlinger::EffectModule::process()
 
     if (isProcessEnabled()) {
         int ret;
-        if (isProcessImplemented()) {
+        if (isProcessImplemented() && !mCpuBypassed) {
             if (auxType) {
                 // We overwrite the aux input buffer here and clear after processing.
                 // aux input is always mono.
@@ -783,7 +783,9 @@ void AudioFlinger::EffectModule::process()
                 }
             }
 #endif
+            const nsecs_t processStartNs = systemTime();
             ret = mEffectInterface->process();
+            addProcessTime_l(systemTime() - processStartNs);
 #ifdef FLOAT_EFFECT_CHAIN
             if (!mSupportsFloat) { // convert output int16_t back to float.
                 sp<EffectBufferHalInterface> target =
@@ -849,6 +851,13 @@ void AudioFlinger::EffectModule::process()
     }
 }
 
+void AudioFlinger::EffectModule::addProcessTime_l(nsecs_t processNs)
+{
+    mProcessNs.add(processNs);
+    mProcessNsHistory[mProcessNsCount++ % kProcessNsHistorySize] = processNs;
+    mRecentProcessNs += kRecentProcessNsWeight * (processNs - mRecentProcessNs);
+}
+
 void AudioFlinger::EffectModule::reset_l()
 {
     if (mStatus != NO_ERROR || mEffectInterface == 0) {
@@ -1024,6 +1033,10 @@ status_t AudioFlinger::EffectModule::configure()
         setInBuffer(mInBuffer);
         setOutBuffer(mOutBuffer);
 
+        // the buffer duration, and thus the effect CPU budget, may have changed
+        mCpuBypassed = false;
+        mRecentProcessNs = 0.;
+
         // Update visualizer latency
         if (memcmp(&mDescriptor.type, SL_IID_VISUALIZATION, sizeof(effect_uuid_t)) == 0) {
             uint32_t buf32[sizeof(effect_param_t) / sizeof(uint32_t) + 2];
@@ -1124,6 +1137,8 @@ status_t AudioFlinger::EffectModule::start_l()
     }
     if (status == 0) {
         addEffectToHal_l();
+        mCpuBypassed = false;
+        mRecentProcessNs = 0.;
     }
     return status;
 }
@@ -1686,6 +1701,20 @@ void AudioFlinger::EffectModule::dump(int fd, const Vector<String16>& args)
             dumpInOutBuffer(false /* isInput */, mOutConversionBuffer).c_str());
 #endif
 
+    if (mProcessNs.getN() > 0) {
+        result.appendFormat("\t\t- Process time ns: %s\n", mProcessNs.toString().c_str());
+        const size_t count = std::min(mProcessNsCount, (uint64_t)kProcessNsHistorySize);
+        std::array<int64_t, kProcessNsHistorySize> sorted = mProcessNsHistory;
+        std::sort(sorted.begin(), sorted.begin() + count);
+        result.appendFormat("\t\t  last %zu buffers: p50 %lld p90 %lld p99 %lld max %lld\n",
+                count,
+                (long long)sorted[count * 50 / 100], (long long)sorted[count * 90 / 100],
+                (long long)sorted[count * 99 / 100], (long long)sorted[count - 1]);
+    }
+    if (mCpuBypassed) {
+        result.append("\t\t- Bypassed: over the effect CPU budget of the thread\n");
+    }
+
     write(fd, result.string(), result.length());
 
     if (mEffectInterface != 0) {
@@ -2163,6 +2192,7 @@ void AudioFlinger::EffectChain::process_l()
         // Only the input and output buffers of the chain can be external,
         // and 'update' / 'commit' do nothing for allocated buffers, thus
         // it's not needed to consider any other buffers here.
+        const nsecs_t processStartNs = systemTime();
         mInBuffer->update();
         if (mInBuffer->audioBuffer()->raw != mOutBuffer->audioBuffer()->raw) {
             mOutBuffer->update();
@@ -2174,6 +2204,9 @@ void AudioFlinger::EffectChain::process_l()
         if (mInBuffer->audioBuffer()->raw != mOutBuffer->audioBuffer()->raw) {
             mOutBuffer->commit();
         }
+        mLastProcessNs = systemTime() - processStartNs;
+    } else {
+        mLastProcessNs = 0;
     }
     bool doResetVolume = false;
     for (size_t i = 0; i < size; i++) {
@@ -2184,6 +2217,22 @@ void AudioFlinger::EffectChain::process_l()
     }
 }
 
+// Must be called with EffectChain::mLock locked, on the thread processing the chain
+sp<AudioFlinger::EffectModule> AudioFlinger::EffectChain::getCostliestEffect_l() const
+{
+    sp<EffectModule> costliest;
+    for (const auto& effect : mEffects) {
+        if (!effect->isProcessEnabled() || effect->isCpuBypassed()
+                || effect->recentProcessNs() == 0.) {
+            continue;
+        }
+        if (costliest == nullptr || effect->recentProcessNs() > costliest->recentProcessNs()) {
+            costliest = effect;
+        }
+    }
+    return costliest;
+}
+
 // createEffect_l() must be called with ThreadBase::mLock held
 status_t AudioFlinger::EffectChain::createEffect_l(sp<EffectModule>& effect,
                                                    effect_descriptor_t *desc,
@@ -263,6 +263,14 @@ public:
 
     void             dump(int fd, const Vector<String16>& args);
 
+    // An effect exceeding the effect CPU budget of its thread can be bypassed: its engine is
+    // not called until the effect is restarted or reconfigured.
+    void             setCpuBypassed(bool bypassed) { mCpuBypassed = bypassed; }
+    bool             isCpuBypassed() const { return mCpuBypassed; }
+    // Time spent in the engine per buffer over the last buffers, in ns.
+    // Must be called on the thread processing the effect.
+    double           recentProcessNs() const { return mRecentProcessNs; }
+
 private:
     friend class AudioFlinger;      // for mHandles
 
@@ -275,6 +283,7 @@ private:
     status_t stop_l();
     status_t removeEffectFromHal_l();
     status_t sendSetAudioDevicesCommand(const AudioDeviceTypeAddrVector &devices, uint32_t cmdCode);
+    void addProcessTime_l(nsecs_t processNs);
 
     effect_config_t     mConfig;    // input and output audio configuration
     sp<EffectHalInterface> mEffectInterface; // Effect module HAL
@@ -296,6 +305,15 @@ private:
     uint32_t mOutChannelCountRequested;
 #endif
 
+    // Wall clock time spent in the engine per processed buffer, in ns.
+    static constexpr size_t kProcessNsHistorySize = 256; // buffers kept for the percentiles
+    static constexpr double kRecentProcessNsWeight = 1. / 16;
+    audio_utils::Statistics<double> mProcessNs;
+    std::array<int64_t, kProcessNsHistorySize> mProcessNsHistory{};
+    uint64_t mProcessNsCount = 0;   // total buffers measured
+    double   mRecentProcessNs = 0.; // exponentially weighted mean of the last buffers
+    std::atomic<bool> mCpuBypassed{false};
+
     class AutoLockReentrant {
     public:
         AutoLockReentrant(Mutex& mutex, pid_t allowedTid)
@@ -414,6 +432,10 @@ public:
     static const int        kProcessTailDurationMs = 1000;
 
     void process_l();
+    // Time spent in process_l() for the last buffer, in ns.
+    nsecs_t lastProcessNs_l() const { return mLastProcessNs; }
+    // The processed and not bypassed effect with the highest recent process time, if any.
+    sp<EffectModule> getCostliestEffect_l() const;
 
     void lock() {
         mLock.lock();
@@ -624,6 +646,7 @@ private:
 
              int32_t mTailBufferCount;   // current effect tail buffer count
              int32_t mMaxTailBuffers;    // maximum effect tail buffers
+             nsecs_t mLastProcessNs = 0; // time spent in process_l() for the last buffer
              int mVolumeCtrlIdx;         // index of insert effect having control over volume
              uint32_t mLeftVolume;       // previous volume on left channel
              uint32_t mRightVolume;      // previous volume on right channel
@@ -24,6 +24,7 @@
 #include <linux/futex.h>
 #include <sys/syscall.h>
 #include <media/AudioBufferProvider.h>
+#include <media/PcmConversion.h>
 #include <utils/Log.h>
 #include <utils/Trace.h>
 #include "FastCapture.h"
@@ -32,7 +33,7 @@ namespace android {
 
 /*static*/ const FastCaptureState FastCapture::sInitial;
 
-FastCapture::FastCapture() : FastThread("cycleC_ms", "loadC_us"),
+FastCapture::FastCapture() : FastThread("cycleC_ms", "loadC_us", "FastCapture"),
     mInputSource(NULL), mInputSourceGen(0), mPipeSink(NULL), mPipeSinkGen(0),
     mReadBuffer(NULL), mReadBufferState(-1), mFormat(Format_Invalid), mSampleRate(0),
     // mDummyDumpState
@@ -183,7 +184,9 @@ void FastCapture::onWork()
         ALOG_ASSERT(mReadBuffer != NULL);
         dumpState->mReadSequence++;
         ATRACE_BEGIN("read");
+        AUDIO_TRACE_BEGIN(EVENT_HAL_READ, frameCount);
         ssize_t framesRead = mInputSource->read(mReadBuffer, frameCount);
+        AUDIO_TRACE_END(EVENT_HAL_READ, framesRead);
         ATRACE_END();
         dumpState->mReadSequence++;
         if (framesRead >= 0) {
@@ -216,7 +219,7 @@ void FastCapture::onWork()
             if (fastPatchRecordBufferProvider != 0) {
                 // This indicates the fast track is a patch record, update the cblk by
                 // calling releaseBuffer().
-                memcpy_by_audio_format(patchBuffer.raw, current->mFastPatchRecordFormat,
+                convertPcm(patchBuffer.raw, current->mFastPatchRecordFormat,
                         mReadBuffer, mFormat.mFormat, framesWritten * mFormat.mChannelCount);
                 patchBuffer.frameCount = framesWritten;
                 fastPatchRecordBufferProvider->releaseBuffer(&patchBuffer);
@@ -41,6 +41,7 @@
 #include <audio_utils/mono_blend.h>
 #include <cutils/bitops.h>
 #include <media/AudioMixer.h>
+#include <media/PcmConversion.h>
 #include "FastMixer.h"
 #include "TypedLogger.h"
 
@@ -58,7 +59,7 @@ static audio_channel_mask_t getChannelMaskFromCount(size_t count) {
 }
 
 FastMixer::FastMixer(audio_io_handle_t parentIoHandle)
-    : FastThread("cycle_ms", "load_us"),
+    : FastThread("cycle_ms", "load_us", "FastMixer"),
     // mFastTrackNames
     // mGenerations
     mOutputSink(NULL),
@@ -429,6 +430,7 @@ void FastMixer::onWork()
             FastTrackDump *ftDump = &dumpState->mTracks[i];
             FastTrackUnderruns underruns = ftDump->mUnderruns;
             if (framesReady < frameCount) {
+                AUDIO_TRACE_INSTANT(EVENT_UNDERRUN, i);
                 if (framesReady == 0) {
                     underruns.mBitFields.mEmpty++;
                     underruns.mBitFields.mMostRecent = UNDERRUN_EMPTY;
@@ -453,7 +455,9 @@ void FastMixer::onWork()
 
         if (anyEnabledTracks) {
             // process() is CPU-bound
+            AUDIO_TRACE_BEGIN(EVENT_MIX, frameCount);
             mMixer->process();
+            AUDIO_TRACE_END(EVENT_MIX, frameCount);
             mMixerBufferState = MIXED;
         } else if (mMixerBufferState != ZEROED) {
             mMixerBufferState = UNDEFINED;
@@ -482,7 +486,7 @@ void FastMixer::onWork()
         // prepare the buffer used to write to sink
         void *buffer = mSinkBuffer != NULL ? mSinkBuffer : mMixerBuffer;
         if (mFormat.mFormat != mMixerBufferFormat) { // sink format not the same as mixer format
-            memcpy_by_audio_format(buffer, mFormat.mFormat, mMixerBuffer, mMixerBufferFormat,
+            convertPcm(buffer, mFormat.mFormat, mMixerBuffer, mMixerBufferFormat,
                     frameCount * Format_channelCount(mFormat));
         }
         if (mSinkChannelMask & AUDIO_CHANNEL_HAPTIC_ALL) {
@@ -500,7 +504,9 @@ void FastMixer::onWork()
         //       but this code should be modified to handle both non-blocking and blocking sinks
         dumpState->mWriteSequence++;
         ATRACE_BEGIN("write");
+        AUDIO_TRACE_BEGIN(EVENT_HAL_WRITE, frameCount);
         ssize_t framesWritten = mOutputSink->write(buffer, frameCount);
+        AUDIO_TRACE_END(EVENT_HAL_WRITE, framesWritten);
         ATRACE_END();
         dumpState->mWriteSequence++;
         if (framesWritten >= 0) {
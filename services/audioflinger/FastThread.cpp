@@ -38,7 +38,8 @@
 
 namespace android {
 
-FastThread::FastThread(const char *cycleMs, const char *loadUs) : Thread(false /*canCallJava*/),
+FastThread::FastThread(const char *cycleMs, const char *loadUs, const char *traceName)
+    : Thread(false /*canCallJava*/),
     // re-initialized to &sInitial by subclass constructor
     mPrevious(NULL), mCurrent(NULL),
     /* mOldTs({0, 0}), */
@@ -72,9 +73,10 @@ FastThread::FastThread(const char *cycleMs, const char *loadUs) : Thread(false /
 #if 0
     frameCount(0),
 #endif
-    mAttemptedWrite(false)
+    mAttemptedWrite(false),
     // mCycleMs(cycleMs)
     // mLoadUs(loadUs)
+    mTraceName(traceName)
 {
     mOldTs.tv_sec = 0;
     mOldTs.tv_nsec = 0;
@@ -93,6 +95,8 @@ bool FastThread::threadLoop()
     // LOGT now works even if tlNBLogWriter is nullptr, but we're considering changing that,
     // so this initialization permits a future change to remove the check for nullptr.
     tlNBLogWriter = mDummyNBLogWriter.get();
+    mAudioTrace = AudioTrace::create(mTraceName);
+    tlAudioTrace = mAudioTrace.get();
     for (;;) {
 
         // either nanosleep, sched_yield, or busy wait
@@ -119,6 +123,7 @@ bool FastThread::threadLoop()
 
         mCommand = next->mCommand;
         if (next != mCurrent) {
+            AUDIO_TRACE_INSTANT(EVENT_STATE_POLL, mCommand);
 
             // As soon as possible of learning of a new dump area, start using it
             mDumpState = next->mDumpState != NULL ? next->mDumpState : mDummyDumpState;
@@ -197,6 +202,8 @@ bool FastThread::threadLoop()
             continue;
         case FastThreadState::EXIT:
             onExit();
+            tlAudioTrace = nullptr;
+            mAudioTrace.reset();
             return false;
         default:
             LOG_ALWAYS_FATAL_IF(!isSubClassCommand(mCommand));
@@ -345,9 +352,13 @@ bool FastThread::threadLoop()
                     mDumpState->mMonotonicNs[i] = monotonicNs;
                     LOG_WORK_TIME(monotonicNs);
                     mDumpState->mLoadNs[i] = loadNs;
+                    NBLog::cpu_load_t cpuLoad;
+                    cpuLoad.loadNs = loadNs;
 #ifdef CPU_FREQUENCY_STATISTICS
                     mDumpState->mCpukHz[i] = kHz;
+                    cpuLoad.cpukHz = kHz >> 4;
 #endif
+                    LOG_CPU_LOAD(cpuLoad);
                     // this store #4 is not atomic with respect to stores #1, #2, #3 above, but
                     // the newest open & oldest closed halves are atomic with respect to each other
                     mDumpState->mBounds = mBounds;
@@ -17,11 +17,14 @@
 #ifndef ANDROID_AUDIO_FAST_THREAD_H
 #define ANDROID_AUDIO_FAST_THREAD_H
 
+#include <memory>
+
 #include "Configuration.h"
 #ifdef CPU_FREQUENCY_STATISTICS
 #include <cpustats/ThreadCpuUsage.h>
 #endif
 #include <utils/Thread.h>
+#include "AudioTrace.h"
 #include "FastThreadState.h"
 
 namespace android {
@@ -30,7 +33,7 @@ namespace android {
 class FastThread : public Thread {
 
 public:
-            FastThread(const char *cycleMs, const char *loadUs);
+            FastThread(const char *cycleMs, const char *loadUs, const char *traceName);
     virtual ~FastThread();
 
 private:
@@ -89,6 +92,8 @@ protected:
 
     char            mCycleMs[16];   // cycle_ms + suffix
     char            mLoadUs[16];    // load_us + suffix
+    const char*     mTraceName;     // thread name in the AudioTrace
+    std::unique_ptr<AudioTrace> mAudioTrace;   // created by threadLoop(), nullptr if disabled
 
 };  // class FastThread
 
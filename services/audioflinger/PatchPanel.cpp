@@ -527,8 +527,26 @@ status_t AudioFlinger::PatchPanel::Patch::createConnections(PatchPanel *panel)
     }
 
     sp<RecordThread::PatchRecord> tempRecordTrack;
+    // When the capture data needs no conversion, the PlaybackThread reads the input HAL stream
+    // straight into the patch buffer, which saves the RecordThread buffer, its copy and a
+    // period of latency. The read blocks the PlaybackThread in getNextBuffer(), so this is
+    // not done when the sink is a mixer, whose other tracks would be stalled. The PatchRecord
+    // also becomes the source of the RecordThread, so the input must have no other client.
+    // Off unless af.patch.zero_copy is set.
+    const ThreadBase::type_t playbackType = mPlayback.thread()->type();
+    const bool isZeroCopyCompatible =
+            streamType == AUDIO_STREAM_PATCH &&
+            playbackType != ThreadBase::MIXER &&
+            playbackType != ThreadBase::DUPLICATING &&
+            sampleRate == mRecord.thread()->sampleRate() &&
+            inChannelMask == mRecord.thread()->channelMask() &&
+            format == inputFormat &&
+            !mRecord.thread()->hasFastCapture() &&
+            !mRecord.thread()->hasTracks() &&
+            property_get_bool("af.patch.zero_copy", false /* default_value */);
     const bool usePassthruPatchRecord =
-            (inputFlags & AUDIO_INPUT_FLAG_DIRECT) && (outputFlags & AUDIO_OUTPUT_FLAG_DIRECT);
+            ((inputFlags & AUDIO_INPUT_FLAG_DIRECT) && (outputFlags & AUDIO_OUTPUT_FLAG_DIRECT)) ||
+            isZeroCopyCompatible;
     const size_t playbackFrameCount = mPlayback.thread()->frameCount();
     const size_t recordFrameCount = mRecord.thread()->frameCount();
     size_t frameCount = 0;
@@ -699,6 +717,25 @@ String8 AudioFlinger::PatchPanel::Patch::dump(audio_patch_handle_t myHandle) con
     if (getLatencyMs(&latencyMs) == OK) {
         result.appendFormat("  latency: %.2lf ms", latencyMs);
     }
+
+    auto recordTrack = mRecord.const_track();
+    auto playbackTrack = mPlayback.const_track();
+    if (recordTrack != nullptr && playbackTrack != nullptr) {
+        result.appendFormat("\n  xruns: record %u playback %u",
+                recordTrack->getXrunCount(), playbackTrack->getXrunCount());
+        if (recordTrack->producesBufferOnDemand()) {
+            auto passthru =
+                    static_cast<const RecordThread::PassthruPatchRecord*>(recordTrack.get());
+            result.appendFormat("  zero-copy reads: %llu copied reads: %llu",
+                    (unsigned long long)passthru->getDirectReadCount(),
+                    (unsigned long long)passthru->getCopiedReadCount());
+        } else {
+            const double msPerFrame = 1e3 / playbackTrack->sampleRate();
+            result.appendFormat("  buffered: %.2lf ms max %.2lf ms",
+                    playbackTrack->getBufferedFrames() * msPerFrame,
+                    playbackTrack->getBufferedFramesMax() * msPerFrame);
+        }
+    }
     return result;
 }
 
@@ -445,6 +445,18 @@ public:
                                      const struct timespec *timeOut = NULL);
     virtual void        releaseBuffer(Proxy::Buffer* buffer);
 
+            // Frames buffered between the PatchRecord and the PatchTrack, sampled when the
+            // PlaybackThread reads the track, for dumpsys.
+            size_t      getBufferedFrames() const {
+                            return mBufferedFrames.load(std::memory_order_relaxed);
+                        }
+            size_t      getBufferedFramesMax() const {
+                            return mBufferedFramesMax.load(std::memory_order_relaxed);
+                        }
+
 private:
             void restartIfDisabled();
+
+    std::atomic<size_t> mBufferedFrames{0};
+    std::atomic<size_t> mBufferedFramesMax{0};
 };  // end of PatchTrack
@@ -114,6 +114,15 @@ private:
 
             // used by the record thread to convert frames to proper destination format
             RecordBufferConverter              *mRecordBufferConverter;
+            // used instead of mRecordBufferConverter when sharing the conversion with other
+            // RecordTracks, and read position in the converted data
+            sp<SharedConversion>                mSharedConversion;
+            int64_t                             mSharedConversionFront = 0;
+            // allocated by RecordThread::start() for the threadLoop() to share
+            sp<SharedConversion>                mSpareSharedConversion;
+            // set by RecordThread::start() until the next threadLoop(), while the track may join
+            // a shared conversion whatever its sample rate
+            bool                                mSharedConversionStarting = false;
             audio_input_flags_t                mFlags;
 
             bool                               mSilenced;
@@ -188,6 +197,15 @@ public:
     status_t obtainBuffer(Proxy::Buffer *buffer, const struct timespec *timeOut = nullptr) override;
     void releaseBuffer(Proxy::Buffer *buffer) override;
 
+    // HAL reads done straight into the patch buffer, and through mSinkBuffer because the
+    // patch buffer wrapped around, for dumpsys.
+    uint64_t getDirectReadCount() const {
+        return mDirectReadCount.load(std::memory_order_relaxed);
+    }
+    uint64_t getCopiedReadCount() const {
+        return mCopiedReadCount.load(std::memory_order_relaxed);
+    }
+
 private:
     // This is to use with PatchRecord::writeFrames
     struct PatchRecordAudioBufferProvider : public AudioBufferProvider {
@@ -214,4 +232,6 @@ private:
     size_t mReadBytes = 0; // GUARDED_BY(mReadLock)
     status_t mReadError = NO_ERROR; // GUARDED_BY(mReadLock)
     int64_t mLastReadFrames = 0;  // accessed on RecordThread only
+    std::atomic<uint64_t> mDirectReadCount{0};
+    std::atomic<uint64_t> mCopiedReadCount{0};
 };
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SPDIF_BURST_COALESCER_H
+#define ANDROID_SPDIF_BURST_COALESCER_H
+
+#include <functional>
+#include <stdint.h>
+#include <sys/types.h>
+#include <utility>
+#include <vector>
+
+#include <utils/Errors.h>
+#include <utils/Timers.h>
+
+namespace android {
+
+/**
+ * Holds IEC61937 data bursts and writes them to the HAL together, so that HDMI passthrough
+ * does not wake up the output thread for every encoded frame.
+ *
+ * The held bursts are written once maxFrames HAL frames are held, or once the oldest one has
+ * been held for maxDelayNs, whichever comes first. The stream also writes them with
+ * writeHeld() before the HAL drains, pauses or stops, as no more data will come to push
+ * them out. The held bursts have not reached the HAL, so they are not part of its
+ * presentation position.
+ *
+ * Not thread-safe, it is used by the output thread only.
+ */
+class SpdifBurstCoalescer {
+public:
+    // Writes to the HAL, returns the bytes written or a negative status_t.
+    using Writer = std::function<ssize_t(const void* buffer, size_t bytes)>;
+
+    SpdifBurstCoalescer(Writer writer, size_t frameSize, size_t maxFrames, nsecs_t maxDelayNs)
+        : mWriter(std::move(writer))
+        , mFrameSize(frameSize)
+        , mMaxBytes(maxFrames * frameSize)
+        , mMaxDelayNs(maxDelayNs)
+    {
+        // one more burst may be appended before the bound is reached
+        mBuffer.reserve(2 * mMaxBytes);
+    }
+
+    /**
+     * Holds a data burst, and writes the held bursts if a bound is reached.
+     * A failed HAL write is retried with the next burst.
+     * @return bytes once the burst is held, even if the HAL write failed. Otherwise the HAL
+     *         refused the previous write and still refuses it, and the burst is not held:
+     *         0 or a negative status_t from the HAL.
+     */
+    ssize_t write(const void* burst, size_t bytes, nsecs_t nowNs) {
+        if (!mBuffer.empty() && mBuffer.size() >= mMaxBytes) {
+            const status_t status = writeHeld();
+            if (status != NO_ERROR) {
+                return status == WOULD_BLOCK ? 0 : status;
+            }
+        }
+        if (mBuffer.empty()) {
+            mOldestNs = nowNs;
+        }
+        const uint8_t* data = static_cast<const uint8_t*>(burst);
+        mBuffer.insert(mBuffer.end(), data, data + bytes);
+        if (mBuffer.size() >= mMaxBytes || nowNs - mOldestNs >= mMaxDelayNs) {
+            (void)writeHeld();
+        }
+        return bytes;
+    }
+
+    /**
+     * Writes the held bursts to the HAL.
+     * @return NO_ERROR once all were written, WOULD_BLOCK if the HAL took part of them,
+     *         or the error of the HAL. The rest stays held.
+     */
+    status_t writeHeld() {
+        size_t offset = 0;
+        status_t status = NO_ERROR;
+        while (offset < mBuffer.size()) {
+            const ssize_t written = mWriter(mBuffer.data() + offset, mBuffer.size() - offset);
+            if (written <= 0) {
+                status = written == 0 ? WOULD_BLOCK : (status_t)written;
+                break;
+            }
+            offset += written;
+        }
+        mBuffer.erase(mBuffer.begin(), mBuffer.begin() + offset);
+        mHalFramesWritten += offset / mFrameSize;
+        return status;
+    }
+
+    // Drops the held bursts, on flush.
+    void drop() { mBuffer.clear(); }
+
+    // Restarts the count of HAL frames written, when the HAL position resets on flush.
+    void resetPosition() { mHalFramesWritten = 0; }
+
+    size_t   getHeldBytes() const { return mBuffer.size(); }
+    size_t   getMaxFrames() const { return mMaxBytes / mFrameSize; }
+
+    // HAL frames written since resetPosition(), which bounds the presentation position.
+    uint64_t getHalFramesWritten() const { return mHalFramesWritten; }
+
+private:
+    const Writer         mWriter;
+    const size_t         mFrameSize;
+    const size_t         mMaxBytes;
+    const nsecs_t        mMaxDelayNs;
+    std::vector<uint8_t> mBuffer;
+    nsecs_t              mOldestNs = 0;
+    uint64_t             mHalFramesWritten = 0;
+};
+
+} // namespace android
+
+#endif // ANDROID_SPDIF_BURST_COALESCER_H
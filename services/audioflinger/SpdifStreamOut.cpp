@@ -17,6 +17,10 @@
 
 #define LOG_TAG "AudioFlinger"
 //#define LOG_NDEBUG 0
+#include <algorithm>
+#include <stdio.h>
+
+#include <cutils/properties.h>
 #include <system/audio.h>
 #include <utils/Log.h>
 
@@ -40,6 +44,10 @@ SpdifStreamOut::SpdifStreamOut(AudioHwDevice *dev,
         , mApplicationFormat(AUDIO_FORMAT_DEFAULT)
         , mApplicationSampleRate(0)
         , mApplicationChannelMask(AUDIO_CHANNEL_NONE)
+        , mBurstCount(0)
+        , mHalWriteCount(0)
+        , mFirstHalWriteNs(0)
+        , mLastHalWriteNs(0)
 {
 }
 
@@ -99,26 +107,86 @@ status_t SpdifStreamOut::open(
 
     ALOGI("SpdifStreamOut::open() status = %d", status);
 
+    if (status == NO_ERROR) {
+        const int32_t coalesceMs = property_get_int32("af.spdif.coalesce_ms", 0);
+        if (coalesceMs > 0) {
+            mCoalescer = std::make_unique<SpdifBurstCoalescer>(
+                    [this](const void* buffer, size_t bytes) { return writeHal(buffer, bytes); },
+                    mHalFrameSize,
+                    (size_t)coalesceMs * customConfig.sample_rate / 1000,
+                    milliseconds(coalesceMs));
+            ALOGI("SpdifStreamOut::open() coalescing data bursts up to %d ms", coalesceMs);
+        }
+    }
+
+    return status;
+}
+
+status_t SpdifStreamOut::getPresentationPosition(uint64_t *frames, struct timespec *timestamp)
+{
+    status_t status = AudioStreamOut::getPresentationPosition(frames, timestamp);
+    if (status == NO_ERROR && mCoalescer != nullptr) {
+        *frames = std::min(*frames, mCoalescer->getHalFramesWritten() / mRateMultiplier);
+    }
     return status;
 }
 
 int SpdifStreamOut::flush()
 {
     mSpdifEncoder.reset();
+    if (mCoalescer != nullptr) {
+        mCoalescer->drop();
+        mCoalescer->resetPosition();
+    }
     return AudioStreamOut::flush();
 }
 
 int SpdifStreamOut::standby()
 {
     mSpdifEncoder.reset();
+    if (mCoalescer != nullptr) {
+        // The thread counted the held bursts as written, write them before the HAL stops.
+        (void)mCoalescer->writeHeld();
+        mCoalescer->drop();
+    }
     return AudioStreamOut::standby();
 }
 
-ssize_t SpdifStreamOut::writeDataBurst(const void* buffer, size_t bytes)
+status_t SpdifStreamOut::writeHeldData()
 {
+    return mCoalescer != nullptr ? mCoalescer->writeHeld() : NO_ERROR;
+}
+
+void SpdifStreamOut::dump(int fd) const
+{
+    const nsecs_t elapsedNs = mLastHalWriteNs - mFirstHalWriteNs;
+    dprintf(fd, "  Spdif data bursts: %llu  HAL writes: %llu (%.1f/s)"
+            "  Coalescing: %zu frames (%zu held bytes)\n",
+            (unsigned long long)mBurstCount, (unsigned long long)mHalWriteCount,
+            elapsedNs > 0 ? (mHalWriteCount - 1) * 1e9 / elapsedNs : 0.,
+            mCoalescer != nullptr ? mCoalescer->getMaxFrames() : 0,
+            mCoalescer != nullptr ? mCoalescer->getHeldBytes() : 0);
+}
+
+ssize_t SpdifStreamOut::writeHal(const void* buffer, size_t bytes)
+{
+    const nsecs_t now = systemTime();
+    if (mHalWriteCount++ == 0) {
+        mFirstHalWriteNs = now;
+    }
+    mLastHalWriteNs = now;
     return AudioStreamOut::write(buffer, bytes);
 }
 
+ssize_t SpdifStreamOut::writeDataBurst(const void* buffer, size_t bytes)
+{
+    mBurstCount++;
+    if (mCoalescer == nullptr) {
+        return writeHal(buffer, bytes);
+    }
+    return mCoalescer->write(buffer, bytes, systemTime());
+}
+
 ssize_t SpdifStreamOut::write(const void* buffer, size_t numBytes)
 {
     // Write to SPDIF wrapper. It will call back to writeDataBurst().
@@ -18,12 +18,15 @@
 #ifndef ANDROID_SPDIF_STREAM_OUT_H
 #define ANDROID_SPDIF_STREAM_OUT_H
 
+#include <memory>
 #include <stdint.h>
 #include <sys/types.h>
 
 #include <system/audio.h>
+#include <utils/Timers.h>
 
 #include "AudioStreamOut.h"
+#include "SpdifBurstCoalescer.h"
 
 #include <audio_utils/spdif/SPDIFEncoder.h>
 
@@ -84,8 +87,17 @@ public:
      */
     virtual audio_channel_mask_t getChannelMask() const { return mApplicationChannelMask; }
 
+    /**
+     * The HAL position is bounded by the frames written to the HAL, so that a position
+     * extrapolated by the HAL does not count the data bursts held back.
+     */
+    virtual status_t getPresentationPosition(uint64_t *frames, struct timespec *timestamp);
+
     virtual status_t flush();
     virtual status_t standby();
+    virtual status_t writeHeldData();
+
+    virtual void dump(int fd) const;
 
 private:
 
@@ -111,8 +123,21 @@ private:
     uint32_t             mApplicationSampleRate;
     audio_channel_mask_t mApplicationChannelMask;
 
+    // Data bursts may be held and written to the HAL together, for at most the duration set
+    // by the property af.spdif.coalesce_ms. Null when it is 0, the default.
+    // The held bursts are written on standby, drain, pause and stop, and dropped on flush
+    // together with the frames counted by the thread.
+    std::unique_ptr<SpdifBurstCoalescer> mCoalescer;
+
+    // Statistics for dump(), the HAL writes per second are the wakeups of the thread.
+    uint64_t             mBurstCount;
+    uint64_t             mHalWriteCount;
+    nsecs_t              mFirstHalWriteNs;
+    nsecs_t              mLastHalWriteNs;
+
     ssize_t  writeDataBurst(const void* data, size_t bytes);
     ssize_t  writeInternal(const void* buffer, size_t bytes);
+    ssize_t  writeHal(const void* buffer, size_t bytes);
 
 };
 
@@ -21,6 +21,7 @@
 #include <time.h>
 #include <cutils/atomic.h>
 #include <utils/Log.h>
+#include "AudioTrace.h"
 #include "StateQueue.h"
 
 namespace android {
@@ -144,6 +145,7 @@ template<typename T> bool StateQueue<T>::push(StateQueue<T>::block_t block)
         // publish
         atomic_store_explicit(&mNext, (uintptr_t)mMutating, memory_order_release);
         mExpecting = mMutating;
+        AUDIO_TRACE_INSTANT(EVENT_STATE_PUSH, 0);
 
         // copy with circular wraparound
         if (++mMutating >= &mStates[kN]) {
@@ -23,6 +23,7 @@
 #include "Configuration.h"
 #include <math.h>
 #include <fcntl.h>
+#include <algorithm>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -35,6 +36,7 @@
 #include <media/AudioDeviceTypeAddr.h>
 #include <media/AudioParameter.h>
 #include <media/AudioResamplerPublic.h>
+#include <media/PcmConversion.h>
 #include <media/RecordBufferConverter.h>
 #include <media/TypeConverter.h>
 #include <utils/Log.h>
@@ -89,6 +91,7 @@
 #include "AutoPark.h"
 
 #include <pthread.h>
+#include "AudioTrace.h"
 #include "TypedLogger.h"
 
 // ----------------------------------------------------------------------------
@@ -2113,12 +2116,74 @@ void AudioFlinger::PlaybackThread::dumpInternals_l(int fd, const Vector<String16
     if (mPipeSink.get() != nullptr) {
         dprintf(fd, "  PipeSink frames written: %lld\n", (long long)mPipeSink->framesWritten());
     }
+    if (mEffectProcessNs.getN() > 0) {
+        dprintf(fd, "  Effect process time ns stats: %s\n", mEffectProcessNs.toString().c_str());
+    }
+    if (mEffectBudgetNs > 0) {
+        dprintf(fd, "  Effect budget: %u%% (%lld ns) %s, buffers over budget: %llu,"
+                " effects bypassed: %u\n",
+                mEffectBudgetPercent, (long long)mEffectBudgetNs,
+                mEffectBudgetBypass ? "bypass" : "warn",
+                (unsigned long long)mEffectOverBudgetTotal, mEffectBypassedCount);
+    }
     if (output != nullptr) {
+        output->dump(fd);
         dprintf(fd, "  Hal stream dump:\n");
         (void)output->stream->dump(fd);
     }
 }
 
+void AudioFlinger::PlaybackThread::checkEffectBudget(
+        const Vector< sp<EffectChain> >& effectChains)
+{
+    nsecs_t processNs = 0;
+    for (const auto& chain : effectChains) {
+        processNs += chain->lastProcessNs_l();
+    }
+    if (processNs == 0) {
+        return; // no effect processed
+    }
+    mEffectProcessNs.add(processNs);
+    if (mEffectBudgetNs == 0 || processNs <= mEffectBudgetNs) {
+        mEffectOverBudgetCount = 0;
+        return;
+    }
+    mEffectOverBudgetTotal++;
+    if (++mEffectOverBudgetCount < kEffectOverBudgetBuffers) {
+        return;
+    }
+    mEffectOverBudgetCount = 0;
+
+    sp<EffectModule> costliest;
+    for (const auto& chain : effectChains) {
+        sp<EffectModule> effect = chain->getCostliestEffect_l();
+        if (effect != nullptr && (costliest == nullptr
+                || effect->recentProcessNs() > costliest->recentProcessNs())) {
+            costliest = effect;
+        }
+    }
+    if (costliest == nullptr) {
+        return;
+    }
+    if (mEffectBudgetBypass) {
+        ALOGW("%s: bypassing effect %s id %d session %d taking %.0f ns of %lld ns per buffer",
+                __func__, costliest->desc().name, costliest->id(), costliest->sessionId(),
+                costliest->recentProcessNs(), (long long)processNs);
+        costliest->setCpuBypassed(true);
+        mEffectBypassedCount++;
+        return;
+    }
+    const nsecs_t now = systemTime();
+    if (now - mEffectBudgetWarnNs >= kEffectBudgetWarnIntervalNs) {
+        ALOGW("%s: effects take %lld ns per buffer, over the budget of %lld ns;"
+                " effect %s id %d session %d takes %.0f ns",
+                __func__, (long long)processNs, (long long)mEffectBudgetNs,
+                costliest->desc().name, costliest->id(), costliest->sessionId(),
+                costliest->recentProcessNs());
+        mEffectBudgetWarnNs = now;
+    }
+}
+
 // PlaybackThread::createTrack_l() must be called with AudioFlinger::mLock held
 sp<AudioFlinger::PlaybackThread::Track> AudioFlinger::PlaybackThread::createTrack_l(
         const sp<AudioFlinger::Client>& client,
@@ -2932,6 +2997,12 @@ void AudioFlinger::PlaybackThread::readOutputParameters_l()
     mThreadThrottleEndMs = 0;
     mHalfBufferMs = mNormalFrameCount * 1000 / (2 * mSampleRate);
 
+    mEffectBudgetPercent = property_get_int32("af.effect.budget_percent", 0 /* default_value */);
+    mEffectBudgetBypass = property_get_bool("af.effect.budget_bypass", false /* default_value */);
+    mEffectBudgetNs = (nsecs_t)mNormalFrameCount * NANOS_PER_SECOND / mSampleRate
+            * mEffectBudgetPercent / 100;
+    mEffectOverBudgetCount = 0;
+
     // mSinkBuffer is the sink buffer.  Size is always multiple-of-16 frames.
     // Originally this was int16_t[] array, need to remove legacy implications.
     free(mSinkBuffer);
@@ -3253,6 +3324,7 @@ ssize_t AudioFlinger::PlaybackThread::threadLoop_write()
 
 void AudioFlinger::PlaybackThread::threadLoop_drain()
 {
+    (void)mOutput->writeHeldData();
     bool supportsDrain = false;
     if (mOutput->stream->supportsDrain(&supportsDrain) == OK && supportsDrain) {
         ALOGV("draining %s", (mMixerStatus == MIXER_DRAIN_TRACK) ? "early" : "full");
@@ -3509,6 +3581,8 @@ void AudioFlinger::PlaybackThread::detachAuxEffect_l(int effectId)
 bool AudioFlinger::PlaybackThread::threadLoop()
 {
     tlNBLogWriter = mNBLogWriter.get();
+    const std::unique_ptr<AudioTrace> audioTrace = AudioTrace::create(mThreadName);
+    tlAudioTrace = audioTrace.get();
 
     Vector< sp<Track> > tracksToRemove;
 
@@ -3744,7 +3818,9 @@ bool AudioFlinger::PlaybackThread::threadLoop()
             mCurrentWriteLength = 0;
             if (mMixerStatus == MIXER_TRACKS_READY) {
                 // threadLoop_mix() sets mCurrentWriteLength
+                AUDIO_TRACE_BEGIN(EVENT_MIX, mNormalFrameCount);
                 threadLoop_mix();
+                AUDIO_TRACE_END(EVENT_MIX, mCurrentWriteLength / mFrameSize);
             } else if ((mMixerStatus != MIXER_DRAIN_TRACK)
                         && (mMixerStatus != MIXER_DRAIN_ALL)) {
                 // threadLoop_sleepTime sets mSleepTimeUs to 0 if data
@@ -3763,6 +3839,7 @@ bool AudioFlinger::PlaybackThread::threadLoop()
                                     __func__, track->id(), track->getTrackStateAsString(),
                                     mNormalFrameCount);
                             track->mAudioTrackServerProxy->tallyUnderrunFrames(mNormalFrameCount);
+                            AUDIO_TRACE_INSTANT(EVENT_UNDERRUN, track->id());
                         }
                     }
                 }
@@ -3796,7 +3873,7 @@ bool AudioFlinger::PlaybackThread::threadLoop()
                     mBalance.process((float *)mMixerBuffer, mNormalFrameCount);
                 }
 
-                memcpy_by_audio_format(buffer, format, mMixerBuffer, mMixerBufferFormat,
+                convertPcm(buffer, format, mMixerBuffer, mMixerBufferFormat,
                         mNormalFrameCount * (mChannelCount + mHapticChannelCount));
 
                 // If we're going directly to the sink and there are haptic channels,
@@ -3823,6 +3900,7 @@ bool AudioFlinger::PlaybackThread::threadLoop()
 
             // only process effects if we're going to write
             if (mSleepTimeUs == 0 && mType != OFFLOAD && mType != DIRECT) {
+                AUDIO_TRACE_BEGIN(EVENT_EFFECTS, effectChains.size());
                 for (size_t i = 0; i < effectChains.size(); i ++) {
                     effectChains[i]->process_l();
                     // TODO: Write haptic data directly to sink buffer when mixing.
@@ -3839,6 +3917,8 @@ bool AudioFlinger::PlaybackThread::threadLoop()
                                 EFFECT_BUFFER_FORMAT, mNormalFrameCount * mHapticChannelCount);
                     }
                 }
+                AUDIO_TRACE_END(EVENT_EFFECTS, effectChains.size());
+                checkEffectBudget(effectChains);
             }
         }
         // Process effect chains for offloaded thread even if no audio
@@ -3846,9 +3926,12 @@ bool AudioFlinger::PlaybackThread::threadLoop()
         // and thus does have to be synchronized with audio writes but may have
         // to be called while waiting for async write callback
         if (mType == OFFLOAD || mType == DIRECT) {
+            AUDIO_TRACE_BEGIN(EVENT_EFFECTS, effectChains.size());
             for (size_t i = 0; i < effectChains.size(); i ++) {
                 effectChains[i]->process_l();
             }
+            AUDIO_TRACE_END(EVENT_EFFECTS, effectChains.size());
+            checkEffectBudget(effectChains);
         }
 
         // Only if the Effects buffer is enabled and there is data in the
@@ -3871,7 +3954,7 @@ bool AudioFlinger::PlaybackThread::threadLoop()
                 mBalance.process((float *)mEffectBuffer, mNormalFrameCount);
             }
 
-            memcpy_by_audio_format(mSinkBuffer, mFormat, mEffectBuffer, mEffectBufferFormat,
+            convertPcm(mSinkBuffer, mFormat, mEffectBuffer, mEffectBufferFormat,
                     mNormalFrameCount * (mChannelCount + mHapticChannelCount));
             // The sample data is partially interleaved when haptic channels exist,
             // we need to adjust channels here.
@@ -3895,7 +3978,9 @@ bool AudioFlinger::PlaybackThread::threadLoop()
                 if (mBytesRemaining) {
                     // FIXME rewrite to reduce number of system calls
                     const int64_t lastIoBeginNs = systemTime();
+                    AUDIO_TRACE_BEGIN(EVENT_HAL_WRITE, mBytesRemaining / mFrameSize);
                     ret = threadLoop_write();
+                    AUDIO_TRACE_END(EVENT_HAL_WRITE, ret > 0 ? ret / mFrameSize : ret);
                     const int64_t lastIoEndNs = systemTime();
                     if (ret < 0) {
                         mBytesRemaining = 0;
@@ -4075,6 +4160,7 @@ bool AudioFlinger::PlaybackThread::threadLoop()
 
     releaseWakeLock();
 
+    tlAudioTrace = nullptr;
     ALOGV("Thread %p type %d exiting", this, mType);
     return false;
 }
@@ -4974,6 +5060,7 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
             if (*mMixerStatus == MIXER_TRACKS_READY && mUnderrunFrames.size() > 0) {
                 for (const auto &underrun : mUnderrunFrames) {
                     underrun.first->tallyUnderrunFrames(underrun.second);
+                    AUDIO_TRACE_INSTANT(EVENT_UNDERRUN, underrun.first->id());
                     maxUnderrunFrames = max(underrun.second, maxUnderrunFrames);
                 }
             }
@@ -5766,6 +5853,7 @@ void AudioFlinger::MixerThread::dumpInternals_l(int fd, const Vector<String16>&
     PlaybackThread::dumpInternals_l(fd, args);
     dprintf(fd, "  Thread throttle time (msecs): %u\n", mThreadThrottleTimeMs);
     dprintf(fd, "  AudioMixer tracks: %s\n", mAudioMixer->trackNames().c_str());
+    dprintf(fd, "  AudioMixer skipped silent frames: %s\n", mAudioMixer->skippedFrames().c_str());
     dprintf(fd, "  Master mono: %s\n", mMasterMono ? "on" : "off");
     dprintf(fd, "  Master balance: %f (%s)\n", mMasterBalance.load(),
             (hasFastMixer() ? std::to_string(mFastMixer->getMasterBalance())
@@ -6138,6 +6226,9 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::DirectOutputThread::prep
     // if resume is received before pause is executed.
     if (mHwSupportsPause && !mStandby &&
             (doHwPause || (mFlushPending && !mHwPaused && (count != 0)))) {
+        if (!mFlushPending) {
+            (void)mOutput->writeHeldData();
+        }
         status_t result = mOutput->stream->pause();
         ALOGE_IF(result != OK, "Error when pausing output stream: %d", result);
     }
@@ -6188,6 +6279,8 @@ void AudioFlinger::DirectOutputThread::threadLoop_sleepTime()
         mSleepTimeUs = mIdleSleepTimeUs;
         return;
     }
+    // no data to write this time, as the track underruns or stops
+    (void)mOutput->writeHeldData();
     if (mMixerStatus == MIXER_TRACKS_ENABLED) {
         mSleepTimeUs = mActiveSleepTimeUs;
     } else {
@@ -7291,6 +7384,8 @@ void AudioFlinger::RecordThread::preExit()
 bool AudioFlinger::RecordThread::threadLoop()
 {
     nsecs_t lastWarning = 0;
+    const std::unique_ptr<AudioTrace> audioTrace = AudioTrace::create(mThreadName);
+    tlAudioTrace = audioTrace.get();
 
     inputStandBy();
 
@@ -7467,6 +7562,8 @@ reacquire_wakelock:
             }
             sleepUs = 0;
 
+            updateSharedConversions_l(activeTracks);
+
             lockEffectChains_l(effectChains);
         }
 
@@ -7591,6 +7688,7 @@ reacquire_wakelock:
         // otherwise use the HAL / AudioStreamIn directly
         } else {
             ATRACE_BEGIN("read");
+            AUDIO_TRACE_BEGIN(EVENT_HAL_READ, mBufferSize / mFrameSize);
             size_t bytesRead;
             status_t result = mSource->read(
                     (uint8_t*)mRsmpInBuffer + rear * mFrameSize, mBufferSize, &bytesRead);
@@ -7600,6 +7698,7 @@ reacquire_wakelock:
             } else {
                 framesRead = bytesRead / mFrameSize;
             }
+            AUDIO_TRACE_END(EVENT_HAL_READ, framesRead);
         }
 
         const int64_t lastIoEndNs = systemTime(); // end IO timing
@@ -7682,6 +7781,11 @@ reacquire_wakelock:
         }
         mRsmpInRear = audio_utils::safe_add_overflow(mRsmpInRear, (int32_t)framesRead);
 
+        // convert once for the tracks sharing a conversion
+        for (const auto& conversion : mSharedConversions) {
+            conversion->convert();
+        }
+
         size = activeTracks.size();
 
         // loop over each active track
@@ -7714,7 +7818,16 @@ reacquire_wakelock:
                 // if the record track isn't draining fast enough.
                 bool hasOverrun;
                 size_t framesIn;
-                activeTrack->mResamplerBufferProvider->sync(&framesIn, &hasOverrun);
+                const sp<SharedConversion>& sharedConversion = activeTrack->mSharedConversion;
+                if (sharedConversion != nullptr) {
+                    sharedConversion->sync(
+                            &activeTrack->mSharedConversionFront, &framesIn, &hasOverrun);
+                    // keep the data of the track in the RecordThread buffer, see
+                    // getOldestFront_l()
+                    activeTrack->mResamplerBufferProvider->setFront(sharedConversion->getFront());
+                } else {
+                    activeTrack->mResamplerBufferProvider->sync(&framesIn, &hasOverrun);
+                }
                 if (hasOverrun) {
                     overrun = OVERRUN_TRUE;
                 }
@@ -7722,15 +7835,25 @@ reacquire_wakelock:
                     break;
                 }
 
-                // Don't allow framesOut to be larger than what is possible with resampling
-                // from framesIn.
-                // This isn't strictly necessary but helps limit buffer resizing in
-                // RecordBufferConverter.  TODO: remove when no longer needed.
-                framesOut = min(framesOut,
-                        destinationFramesPossible(
-                                framesIn, mSampleRate, activeTrack->mSampleRate));
+                if (sharedConversion != nullptr) {
+                    // framesIn is already at the track sample rate
+                    framesOut = min(framesOut, framesIn);
+                } else {
+                    // Don't allow framesOut to be larger than what is possible with resampling
+                    // from framesIn.
+                    // This isn't strictly necessary but helps limit buffer resizing in
+                    // RecordBufferConverter.  TODO: remove when no longer needed.
+                    framesOut = min(framesOut,
+                            destinationFramesPossible(
+                                    framesIn, mSampleRate, activeTrack->mSampleRate));
+                }
 
-                if (activeTrack->isDirect()) {
+                if (sharedConversion != nullptr) {
+                    // the data is already converted, copy it to the RecordTrack buffer
+                    framesOut = sharedConversion->read(
+                            &activeTrack->mSharedConversionFront, activeTrack->mSink.raw,
+                            framesOut);
+                } else if (activeTrack->isDirect()) {
                     // No RecordBufferConverter used for direct streams. Pass
                     // straight from RecordThread buffer to RecordTrack buffer.
                     AudioBufferProvider::Buffer buffer;
@@ -7861,6 +7984,7 @@ unlock:
 
     releaseWakeLock();
 
+    tlAudioTrace = nullptr;
     ALOGV("RecordThread %p exiting", this);
     return false;
 }
@@ -8216,6 +8340,7 @@ status_t AudioFlinger::RecordThread::start(RecordThread::RecordTrack* recordTrac
             // clear any converter state as new data will be discontinuous
             recordTrack->mRecordBufferConverter->reset();
         }
+        prepareSharedConversion_l(recordTrack);
         recordTrack->mState = TrackBase::STARTING_2;
         // signal thread to start
         mWaitWorkCV.broadcast();
@@ -8449,6 +8574,8 @@ void AudioFlinger::RecordThread::dumpInternals_l(int fd, const Vector<String16>&
 
     dprintf(fd, "  Fast capture thread: %s\n", hasFastCapture() ? "yes" : "no");
     dprintf(fd, "  Fast track available: %s\n", mFastTrackAvail ? "yes" : "no");
+    dprintf(fd, "  Shared conversions: %zu, tracks joined: %llu\n",
+            mSharedConversions.size(), (unsigned long long)mSharedConversionTracks);
 
     // Make a non-atomic copy of fast capture dump state so it won't change underneath us
     // while we are dumping it.  It may be inconsistent, but it won't mutate!
@@ -8514,14 +8641,24 @@ void AudioFlinger::RecordThread::setRecordSilenced(audio_port_handle_t portId, b
     }
 }
 
+sp<AudioFlinger::ThreadBase>
+AudioFlinger::RecordThread::ResamplerBufferProvider::promoteThread() const
+{
+    if (mRecordTrack == nullptr) {
+        // the RecordThread owns the SharedConversion owning this provider
+        return mRecordThread;
+    }
+    return mRecordTrack->mThread.promote();
+}
+
 void AudioFlinger::RecordThread::ResamplerBufferProvider::reset()
 {
-    sp<ThreadBase> threadBase = mRecordTrack->mThread.promote();
+    sp<ThreadBase> threadBase = promoteThread();
     RecordThread *recordThread = (RecordThread *) threadBase.get();
     mRsmpInUnrel = 0;
     const int32_t rear = recordThread->mRsmpInRear;
     ssize_t deltaFrames = 0;
-    if (mRecordTrack->startFrames() >= 0) {
+    if (mRecordTrack != nullptr && mRecordTrack->startFrames() >= 0) {
         int32_t startFrames = mRecordTrack->startFrames();
         // Accept a recent wraparound of mRsmpInRear
         if (startFrames <= rear) {
@@ -8540,7 +8677,7 @@ void AudioFlinger::RecordThread::ResamplerBufferProvider::reset()
 void AudioFlinger::RecordThread::ResamplerBufferProvider::sync(
         size_t *framesAvailable, bool *hasOverrun)
 {
-    sp<ThreadBase> threadBase = mRecordTrack->mThread.promote();
+    sp<ThreadBase> threadBase = promoteThread();
     RecordThread *recordThread = (RecordThread *) threadBase.get();
     const int32_t rear = recordThread->mRsmpInRear;
     const int32_t front = mRsmpInFront;
@@ -8574,7 +8711,7 @@ void AudioFlinger::RecordThread::ResamplerBufferProvider::sync(
 status_t AudioFlinger::RecordThread::ResamplerBufferProvider::getNextBuffer(
         AudioBufferProvider::Buffer* buffer)
 {
-    sp<ThreadBase> threadBase = mRecordTrack->mThread.promote();
+    sp<ThreadBase> threadBase = promoteThread();
     if (threadBase == 0) {
         buffer->frameCount = 0;
         buffer->raw = NULL;
@@ -8628,6 +8765,230 @@ void AudioFlinger::RecordThread::ResamplerBufferProvider::releaseBuffer(
     buffer->frameCount = 0;
 }
 
+AudioFlinger::RecordThread::SharedConversion::SharedConversion(RecordThread* recordThread,
+        RecordBufferConverter* converter, audio_channel_mask_t channelMask,
+        audio_format_t format, uint32_t sampleRate, size_t frameSize)
+    : mRecordThread(recordThread),
+      mProvider(recordThread),
+      mConverter(converter),
+      mChannelMask(channelMask),
+      mFormat(format),
+      mSampleRate(sampleRate),
+      mFrameSize(frameSize),
+      // twice what can be converted from a full RecordThread buffer, so that a RecordTrack
+      // overruns no earlier than with its own conversion
+      mFrameCount(2 * destinationFramesPossible(
+              recordThread->mRsmpInFrames, recordThread->mSampleRate, sampleRate)),
+      mBuffer(mFrameCount * frameSize)
+{
+}
+
+AudioFlinger::RecordThread::SharedConversion::~SharedConversion()
+{
+    delete mConverter;
+}
+
+void AudioFlinger::RecordThread::SharedConversion::convert()
+{
+    size_t framesIn;
+    mProvider.sync(&framesIn, &mOverrun);
+    // the RecordThread buffer may have grown since the construction
+    size_t framesOut = std::min(
+            destinationFramesPossible(framesIn, mRecordThread->mSampleRate, mSampleRate),
+            mFrameCount / 2);
+    while (framesOut > 0) {
+        const size_t offset = mRear % mFrameCount;
+        const size_t converted = mConverter->convert(mBuffer.data() + offset * mFrameSize,
+                &mProvider, std::min(framesOut, mFrameCount - offset));
+        if (converted == 0) {
+            break;
+        }
+        mRear += converted;
+        framesOut -= converted;
+    }
+}
+
+void AudioFlinger::RecordThread::SharedConversion::sync(
+        int64_t* front, size_t* framesAvailable, bool* hasOverrun) const
+{
+    bool overrun = mOverrun;
+    int64_t filled = mRear - *front;
+    if (filled < 0) {
+        // should not happen, but treat like a massive overrun and re-sync
+        filled = 0;
+        *front = mRear;
+        overrun = true;
+    } else if (filled > (int64_t)mFrameCount) {
+        // client is not keeping up with server, but give it latest data
+        filled = mFrameCount;
+        *front = mRear - filled;
+        overrun = true;
+    }
+    *framesAvailable = (size_t)filled;
+    *hasOverrun = overrun;
+}
+
+size_t AudioFlinger::RecordThread::SharedConversion::read(
+        int64_t* front, void* dst, size_t frameCount) const
+{
+    frameCount = std::min(frameCount, (size_t)(mRear - *front));
+    const size_t offset = *front % mFrameCount;
+    const size_t part1 = std::min(frameCount, mFrameCount - offset);
+    memcpy(dst, mBuffer.data() + offset * mFrameSize, part1 * mFrameSize);
+    memcpy((uint8_t*)dst + part1 * mFrameSize, mBuffer.data(), (frameCount - part1) * mFrameSize);
+    *front += frameCount;
+    return frameCount;
+}
+
+void AudioFlinger::RecordThread::SharedConversion::reset(int32_t front)
+{
+    mProvider.setFront(front);
+    mConverter->reset();
+    mOverrun = false;
+}
+
+// static
+bool AudioFlinger::RecordThread::canShareConversion(const sp<RecordTrack>& track)
+{
+    return !track->isFastTrack() && !track->isDirect() && track->mRecordBufferConverter != nullptr
+            && !track->isInvalid();
+}
+
+// Must be called with mLock held, by start() only
+void AudioFlinger::RecordThread::prepareSharedConversion_l(const sp<RecordTrack>& recordTrack)
+{
+    if (!canShareConversion(recordTrack)) {
+        return;
+    }
+    // Allocate here rather than in the threadLoop(), which only hands the conversions out.
+    if (recordTrack->mSpareSharedConversion == nullptr) {
+        recordTrack->mSpareSharedConversion = new SharedConversion(this,
+                new RecordBufferConverter(mChannelMask, mFormat, mSampleRate,
+                        recordTrack->mChannelMask, recordTrack->mFormat,
+                        recordTrack->mSampleRate),
+                recordTrack->mChannelMask, recordTrack->mFormat, recordTrack->mSampleRate,
+                recordTrack->frameSize());
+    }
+    recordTrack->mSharedConversionStarting = true;
+    // at most one conversion per active track
+    mSharedConversions.reserve(mActiveTracks.size());
+}
+
+// Must be called with mLock held, by the threadLoop() only
+void AudioFlinger::RecordThread::updateSharedConversions_l(
+        const Vector< sp<RecordTrack> >& activeTracks)
+{
+    // A conversion no longer used by a track is kept as its spare if it has none, so that it
+    // is not freed here.
+    const auto leave = [](const sp<RecordTrack>& track) {
+        if (track->mSpareSharedConversion == nullptr) {
+            track->mSpareSharedConversion = track->mSharedConversion;
+        }
+        track->mSharedConversion.clear();
+    };
+
+    // Tracks no longer active leave their conversion, and so do tracks restarted since the
+    // last loop, as start() reset their read position.
+    for (size_t i = 0; i < mTracks.size(); i++) {
+        const sp<RecordTrack>& track = mTracks[i];
+        if (track->mSharedConversion != nullptr
+                && (activeTracks.indexOf(track) < 0 || track->mSharedConversionStarting)) {
+            leave(track);
+        }
+    }
+
+    // Tracks share a conversion when they read the same position of the RecordThread data
+    // with the same destination configuration. A resampling RecordBufferConverter keeps the
+    // history of its input, so a track can only switch between its own converter and a shared
+    // conversion when it starts, or without resampling where the converter keeps no state.
+    const auto canSwitch = [this](const sp<RecordTrack>& track) {
+        return track->mSharedConversionStarting || track->mSampleRate == mSampleRate;
+    };
+    const auto canShare = [&canSwitch](const sp<RecordTrack>& track) {
+        return canShareConversion(track) && canSwitch(track);
+    };
+    const auto join = [this](const sp<RecordTrack>& track,
+            const sp<SharedConversion>& conversion) {
+        track->mSharedConversion = conversion;
+        track->mSharedConversionFront = conversion->rear();
+        mSharedConversionTracks++;
+    };
+    for (const sp<RecordTrack>& track : activeTracks) {
+        if (track->mSharedConversion != nullptr || !canShare(track)) {
+            continue;
+        }
+        // A starting track has no data yet, so it may join a conversion from its current
+        // position whatever the position it reads from.
+        const int32_t front = track->mResamplerBufferProvider->getFront();
+        for (const auto& conversion : mSharedConversions) {
+            if (conversion->matches(track->mChannelMask, track->mFormat, track->mSampleRate)
+                    && (track->mSharedConversionStarting || conversion->getFront() == front)) {
+                join(track, conversion);
+                break;
+            }
+        }
+        // A spare taken from a conversion which other tracks still use is not available yet.
+        if (track->mSharedConversion != nullptr || track->mSpareSharedConversion == nullptr
+                || std::find(mSharedConversions.begin(), mSharedConversions.end(),
+                        track->mSpareSharedConversion) != mSharedConversions.end()) {
+            continue;
+        }
+        for (const sp<RecordTrack>& other : activeTracks) {
+            if (other == track || other->mSharedConversion != nullptr || !canShare(other)
+                    || other->mChannelMask != track->mChannelMask
+                    || other->mFormat != track->mFormat
+                    || other->mSampleRate != track->mSampleRate
+                    || other->mResamplerBufferProvider->getFront() != front) {
+                continue;
+            }
+            // The spare conversion of the track was allocated by start(). Its converter
+            // starts from the same state as the converters of both tracks.
+            sp<SharedConversion> conversion = track->mSpareSharedConversion;
+            track->mSpareSharedConversion.clear();
+            conversion->reset(front);
+            mSharedConversions.push_back(conversion);
+            join(track, conversion);
+            join(other, conversion);
+            ALOGV("%s: tracks %d and %d share a conversion", __func__, track->id(), other->id());
+            break;
+        }
+    }
+
+    for (const sp<RecordTrack>& track : activeTracks) {
+        track->mSharedConversionStarting = false;
+    }
+
+    for (const auto& conversion : mSharedConversions) {
+        conversion->mTrackCount = 0;
+    }
+    for (const sp<RecordTrack>& track : activeTracks) {
+        if (track->mSharedConversion != nullptr) {
+            track->mSharedConversion->mTrackCount++;
+        }
+    }
+    // A track left alone on a conversion goes back to its own converter once it has read all
+    // the converted data, if it can switch. Otherwise it keeps the conversion until it stops.
+    for (auto it = mSharedConversions.begin(); it != mSharedConversions.end(); ) {
+        const sp<SharedConversion>& conversion = *it;
+        if (conversion->mTrackCount == 1) {
+            for (const sp<RecordTrack>& track : activeTracks) {
+                if (track->mSharedConversion == conversion && canSwitch(track)
+                        && track->mSharedConversionFront == conversion->rear()) {
+                    track->mResamplerBufferProvider->setFront(conversion->getFront());
+                    leave(track);
+                    conversion->mTrackCount = 0;
+                    break;
+                }
+            }
+        }
+        if (conversion->mTrackCount == 0) {
+            it = mSharedConversions.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
 void AudioFlinger::RecordThread::checkBtNrec()
 {
     Mutex::Autolock _l(mLock);
@@ -9018,6 +9379,9 @@ void AudioFlinger::RecordThread::updateFronts_l(int32_t offset)
         front = audio_utils::safe_sub_overflow(front, offset);
         mTracks[i]->mResamplerBufferProvider->setFront(front);
     }
+    for (const auto& conversion : mSharedConversions) {
+        conversion->setFront(audio_utils::safe_sub_overflow(conversion->getFront(), offset));
+    }
 }
 
 void AudioFlinger::RecordThread::resizeInputBuffer_l(int32_t maxSharedAudioHistoryMs)
@@ -1025,6 +1025,26 @@ protected:
     uint32_t                        mThreadThrottleEndMs;  // notify once per throttling
     uint32_t                        mHalfBufferMs;       // half the buffer size in milliseconds
 
+    // Effect CPU budget: time the effect chains may take per buffer, in percent of the normal
+    // buffer duration (property af.effect.budget_percent), 0 to disable it. When over budget
+    // for kEffectOverBudgetBuffers buffers in a row, the costliest effect is bypassed if
+    // property af.effect.budget_bypass is set, otherwise a warning is logged.
+    static constexpr uint32_t       kEffectOverBudgetBuffers = 8;
+    static constexpr nsecs_t        kEffectBudgetWarnIntervalNs = 10 * NANOS_PER_SECOND;
+    uint32_t                        mEffectBudgetPercent = 0;
+    bool                            mEffectBudgetBypass = false;
+    nsecs_t                         mEffectBudgetNs = 0;
+    uint32_t                        mEffectOverBudgetCount = 0; // consecutive buffers over budget
+    uint64_t                        mEffectOverBudgetTotal = 0; // buffers over budget
+    uint32_t                        mEffectBypassedCount = 0;   // effects bypassed over budget
+    nsecs_t                         mEffectBudgetWarnNs = 0;    // time of the last warning
+    // time spent in the effect chains per buffer, in ns
+    audio_utils::Statistics<double> mEffectProcessNs;
+
+    // Accounts the time spent in the effect chains for the last buffer, and enforces the
+    // effect CPU budget. Called by the thread loop with the effect chains locked.
+                void        checkEffectBudget(const Vector< sp<EffectChain> >& effectChains);
+
     void*                           mSinkBuffer;         // frame size aligned sink buffer
 
     // TODO:
@@ -1635,7 +1655,11 @@ public:
     {
     public:
         explicit ResamplerBufferProvider(RecordTrack* recordTrack) :
-            mRecordTrack(recordTrack),
+            mRecordTrack(recordTrack), mRecordThread(nullptr),
+            mRsmpInUnrel(0), mRsmpInFront(0) { }
+        // for a SharedConversion owned by the RecordThread
+        explicit ResamplerBufferProvider(RecordThread* recordThread) :
+            mRecordTrack(nullptr), mRecordThread(recordThread),
             mRsmpInUnrel(0), mRsmpInFront(0) { }
         virtual ~ResamplerBufferProvider() { }
 
@@ -1663,7 +1687,10 @@ public:
                 int32_t     getFront() const { return mRsmpInFront; }
                 void        setFront(int32_t front) { mRsmpInFront = front; }
     private:
+        sp<ThreadBase>      promoteThread() const;
+
         RecordTrack * const mRecordTrack;
+        RecordThread * const mRecordThread;
         size_t              mRsmpInUnrel;   // unreleased frames remaining from
                                             // most recent getNextBuffer
                                             // for debug only
@@ -1671,6 +1698,61 @@ public:
                                             // rolling counter that is never cleared
     };
 
+    /* The SharedConversion converts the RecordThread data once for all the RecordTracks
+     * with the same format, channel mask and sample rate, which read the same position of the
+     * RecordThread data. The converted data is kept in a circular buffer, from which each
+     * RecordTrack copies with its own read position.
+     */
+    class SharedConversion : public RefBase
+    {
+    public:
+        // Takes ownership of converter, which converts the RecordThread data to frames of
+        // frameSize bytes at sampleRate.
+        SharedConversion(RecordThread* recordThread, RecordBufferConverter* converter,
+                audio_channel_mask_t channelMask, audio_format_t format,
+                uint32_t sampleRate, size_t frameSize);
+        ~SharedConversion() override;
+
+                bool        matches(audio_channel_mask_t channelMask, audio_format_t format,
+                                    uint32_t sampleRate) const {
+                                return channelMask == mChannelMask && format == mFormat
+                                        && sampleRate == mSampleRate;
+                            }
+
+        // Converts the RecordThread data available, called once per thread loop.
+                void        convert();
+
+        /* Synchronizes the read position of a RecordTrack with the converted data, like
+         * ResamplerBufferProvider::sync(), in frames at the RecordTrack sample rate.
+         */
+                void        sync(int64_t* front, size_t* framesAvailable, bool* hasOverrun) const;
+
+        // Copies up to frameCount frames from front to dst, returns the frames copied.
+                size_t      read(int64_t* front, void* dst, size_t frameCount) const;
+
+        // Restarts the conversion from position front of the RecordThread data, with a fresh
+        // converter state.
+                void        reset(int32_t front);
+
+                int64_t     rear() const { return mRear; }
+                int32_t     getFront() const { return mProvider.getFront(); }
+                void        setFront(int32_t front) { mProvider.setFront(front); }
+
+                size_t      mTrackCount = 0;    // RecordTracks sharing the conversion
+    private:
+        RecordThread * const        mRecordThread;
+        ResamplerBufferProvider     mProvider;
+        RecordBufferConverter      *mConverter;
+        const audio_channel_mask_t  mChannelMask;
+        const audio_format_t        mFormat;
+        const uint32_t              mSampleRate;
+        const size_t                mFrameSize;
+        const size_t                mFrameCount;    // size of mBuffer in frames
+        std::vector<uint8_t>        mBuffer;
+        int64_t                     mRear = 0;      // frames converted, never wraps
+        bool                        mOverrun = false; // source overrun on the last convert()
+    };
+
 #include "RecordTracks.h"
 
             RecordThread(const sp<AudioFlinger>& audioFlinger,
@@ -1786,6 +1868,12 @@ public:
 
             bool        fastTrackAvailable() const { return mFastTrackAvail; }
 
+            // Whether any client or patch track is attached to the thread.
+            bool        hasTracks() const {
+                            Mutex::Autolock _l(mLock);
+                            return !mTracks.isEmpty();
+                        }
+
             bool        isTimestampCorrectionEnabled() const override {
                             // checks popcount for exactly one device.
                             return audio_is_input_device(mTimestampCorrectedDevice)
@@ -1819,6 +1907,12 @@ private:
 
             int32_t getOldestFront_l();
             void    updateFronts_l(int32_t offset);
+            // Whether the track converts through a RecordBufferConverter it could share.
+    static  bool    canShareConversion(const sp<RecordTrack>& track);
+            // Allocates the spare conversion of a starting RecordTrack which can share one.
+            void    prepareSharedConversion_l(const sp<RecordTrack>& recordTrack);
+            // Groups the active RecordTracks which can share a conversion.
+            void    updateSharedConversions_l(const Vector< sp<RecordTrack> >& activeTracks);
 
             AudioStreamIn                       *mInput;
             Source                              *mSource;
@@ -1838,6 +1932,10 @@ private:
             // rolling index that is never cleared
             int32_t                             mRsmpInRear;    // last filled frame + 1
 
+            // modified by the threadLoop() with mLock held
+            std::vector< sp<SharedConversion> > mSharedConversions;
+            uint64_t                            mSharedConversionTracks = 0; // total joined
+
             // For dumpsys
             const sp<MemoryDealer>              mReadOnlyHeap;
 
@@ -440,10 +440,19 @@ public:
 
             bool        producesBufferOnDemand() const override { return false; }
 
+            // Number of times the peer had no frames to read (PatchTrack) or no room to write
+            // (PatchRecord), for dumpsys.
+            uint32_t    getXrunCount() const {
+                            return mXrunCount.load(std::memory_order_relaxed);
+                        }
+
 protected:
+            void        countXrun() { mXrunCount.fetch_add(1, std::memory_order_relaxed); }
+
     const sp<ClientProxy>       mProxy;
     sp<RefBase>                 mPeerReferenceHold;   // keeps mPeerProxy alive during access.
     PatchProxyBufferProvider*   mPeerProxy = nullptr;
     struct timespec             mPeerTimeout{};
+    std::atomic<uint32_t>       mXrunCount{0};
 
 };
@@ -2211,6 +2211,14 @@ status_t AudioFlinger::PlaybackThread::PatchTrack::getNextBuffer(
         AudioBufferProvider::Buffer* buffer)
 {
     ALOG_ASSERT(mPeerProxy != 0, "%s(%d): called without peer proxy", __func__, mId);
+    if (!mPeerProxy->producesBufferOnDemand()) {
+        // only the PlaybackThread updates these
+        const size_t bufferedFrames = Track::framesReady();
+        mBufferedFrames.store(bufferedFrames, std::memory_order_relaxed);
+        if (bufferedFrames > mBufferedFramesMax.load(std::memory_order_relaxed)) {
+            mBufferedFramesMax.store(bufferedFrames, std::memory_order_relaxed);
+        }
+    }
     Proxy::Buffer buf;
     buf.mFrameCount = buffer->frameCount;
     if (ATRACE_ENABLED()) {
@@ -2227,6 +2235,7 @@ status_t AudioFlinger::PlaybackThread::PatchTrack::getNextBuffer(
         ATRACE_INT(traceName.c_str(), buf.mFrameCount);
     }
     if (buf.mFrameCount == 0) {
+        countXrun();
         return WOULD_BLOCK;
     }
     status = Track::getNextBuffer(buffer);
@@ -2803,6 +2812,7 @@ status_t AudioFlinger::RecordThread::PatchRecord::getNextBuffer(
         ATRACE_INT(traceName.c_str(), buf.mFrameCount);
     }
     if (buf.mFrameCount == 0) {
+        countXrun();
         return WOULD_BLOCK;
     }
     status = RecordTrack::getNextBuffer(buffer);
@@ -2891,11 +2901,28 @@ status_t AudioFlinger::RecordThread::PassthruPatchRecord::obtainBuffer(
 
     status_t result = NO_ERROR;
     size_t bytesRead = 0;
+    // Read from HAL straight into the patch buffer when the frames fit before its end,
+    // otherwise into mSinkBuffer, from which writeFrames handles the wraparound.
+    AudioBufferProvider::Buffer patchBuffer;
+    patchBuffer.frameCount = framesToRead;
+    if (mPatchRecordAudioBufferProvider.getNextBuffer(&patchBuffer) != NO_ERROR) {
+        patchBuffer.raw = nullptr;
+    } else if (patchBuffer.frameCount < framesToRead) {
+        patchBuffer.frameCount = 0;
+        mPatchRecordAudioBufferProvider.releaseBuffer(&patchBuffer);
+    }
     {
         ATRACE_NAME("read");
-        result = stream->read(mSinkBuffer.get(), framesToRead * mFrameSize, &bytesRead);
-        if (result != NO_ERROR) goto stream_error;
-        if (bytesRead == 0) return NO_ERROR;
+        void *readBuffer = patchBuffer.raw != nullptr ? patchBuffer.raw : mSinkBuffer.get();
+        result = stream->read(readBuffer, framesToRead * mFrameSize, &bytesRead);
+        if (result != NO_ERROR || bytesRead == 0) {
+            if (patchBuffer.raw != nullptr) {
+                patchBuffer.frameCount = 0;
+                mPatchRecordAudioBufferProvider.releaseBuffer(&patchBuffer);
+            }
+            if (result != NO_ERROR) goto stream_error;
+            return NO_ERROR;
+        }
     }
 
     {
@@ -2904,13 +2931,22 @@ status_t AudioFlinger::RecordThread::PassthruPatchRecord::obtainBuffer(
         mReadError = NO_ERROR;
     }
     mReadCV.notify_one();
-    // writeFrames handles wraparound and should write all the provided frames.
-    // If it couldn't, there is something wrong with the client/server buffer of the software patch.
-    buffer->mFrameCount = writeFrames(
-            &mPatchRecordAudioBufferProvider,
-            mSinkBuffer.get(), bytesRead / mFrameSize, mFrameSize);
-    ALOGW_IF(buffer->mFrameCount < bytesRead / mFrameSize,
-            "Lost %zu frames obtained from HAL", bytesRead / mFrameSize - buffer->mFrameCount);
+    if (patchBuffer.raw != nullptr) {
+        patchBuffer.frameCount = bytesRead / mFrameSize;
+        mPatchRecordAudioBufferProvider.releaseBuffer(&patchBuffer);
+        buffer->mFrameCount = bytesRead / mFrameSize;
+        mDirectReadCount.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        // writeFrames handles wraparound and should write all the provided frames.
+        // If it couldn't, there is something wrong with the client/server buffer of the
+        // software patch.
+        buffer->mFrameCount = writeFrames(
+                &mPatchRecordAudioBufferProvider,
+                mSinkBuffer.get(), bytesRead / mFrameSize, mFrameSize);
+        ALOGW_IF(buffer->mFrameCount < bytesRead / mFrameSize,
+                "Lost %zu frames obtained from HAL", bytesRead / mFrameSize - buffer->mFrameCount);
+        mCopiedReadCount.fetch_add(1, std::memory_order_relaxed);
+    }
     mUnconsumedFrames = buffer->mFrameCount;
     struct timespec newTimeOut;
     if (startTimeNs) {
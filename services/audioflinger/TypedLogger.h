@@ -122,6 +122,11 @@ constexpr uint64_t hash(const char (&file)[n], uint32_t line) {
 #define LOG_WARMUP_TIME(ms) do { NBLog::Writer *x = tlNBLogWriter; if (x != nullptr) \
         x->log<NBLog::EVENT_WARMUP_TIME>(ms); } while (0)
 
+// Record the CPU time used by a thread during its last cycle, and the CPU clock frequency.
+// Parameter load is of type cpu_load_t as defined in Events.h.
+#define LOG_CPU_LOAD(load) do { NBLog::Writer *x = tlNBLogWriter; if (x != nullptr) \
+        x->log<NBLog::EVENT_CPU_LOAD>(load); } while (0)
+
 // Record a typed entry that represents a thread's work time in nanoseconds.
 // Parameter ns should be of type uint32_t.
 #define LOG_WORK_TIME(ns) do { NBLog::Writer *x = tlNBLogWriter; if (x != nullptr) \
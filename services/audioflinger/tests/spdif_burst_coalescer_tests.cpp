@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <time.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../SpdifBurstCoalescer.h"
+
+using namespace android;
+
+namespace {
+
+// AC3 data bursts of 1536 stereo 16 bit frames at 48 kHz, one every 32 ms.
+constexpr size_t kFrameSize = 4;
+constexpr size_t kBurstFrames = 1536;
+constexpr size_t kBurstBytes = kBurstFrames * kFrameSize;
+constexpr nsecs_t kBurstPeriodNs = kBurstFrames * 1000000000LL / 48000;
+
+// Stands for the HAL stream, keeps the data written and counts the writes.
+struct StubHal {
+    std::vector<uint8_t> data;
+    size_t writeCount = 0;
+    int failingWrites = 0;   // number of next writes which fail
+
+    ssize_t write(const void* buffer, size_t bytes) {
+        writeCount++;
+        if (failingWrites > 0) {
+            failingWrites--;
+            return -EIO;
+        }
+        const uint8_t* src = static_cast<const uint8_t*>(buffer);
+        data.insert(data.end(), src, src + bytes);
+        return bytes;
+    }
+};
+
+std::vector<uint8_t> makeBurst(size_t index) {
+    return std::vector<uint8_t>(kBurstBytes, static_cast<uint8_t>(index));
+}
+
+SpdifBurstCoalescer makeCoalescer(StubHal* hal, size_t maxFrames, nsecs_t maxDelayNs) {
+    return SpdifBurstCoalescer(
+            [hal](const void* buffer, size_t bytes) { return hal->write(buffer, bytes); },
+            kFrameSize, maxFrames, maxDelayNs);
+}
+
+nsecs_t threadCpuTimeNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+} // namespace
+
+// Measures the HAL writes per second, the wakeups of the output thread, and the CPU time
+// spent per second of playback, without and with coalescing.
+TEST(SpdifBurstCoalescerTest, WakeupsPerSecond) {
+    constexpr size_t kBursts = 10 * 1000000000LL / kBurstPeriodNs; // 10 s
+    double writesPerSecond[2];
+    for (int coalesce = 0; coalesce < 2; ++coalesce) {
+        StubHal hal;
+        const size_t maxFrames = coalesce ? 48000 * 128 / 1000 : 0;
+        SpdifBurstCoalescer coalescer = makeCoalescer(&hal, maxFrames, milliseconds(128));
+        const std::vector<uint8_t> burst = makeBurst(0);
+        const nsecs_t cpuStartNs = threadCpuTimeNs();
+        for (size_t i = 0; i < kBursts; ++i) {
+            ASSERT_EQ((ssize_t)kBurstBytes,
+                    coalescer.write(burst.data(), burst.size(), i * kBurstPeriodNs));
+        }
+        const double seconds = kBursts * kBurstPeriodNs * 1e-9;
+        const double cpuUsPerSecond = (threadCpuTimeNs() - cpuStartNs) * 1e-3 / seconds;
+        writesPerSecond[coalesce] = hal.writeCount / seconds;
+        RecordProperty(coalesce ? "coalesced_writes_per_second" : "writes_per_second",
+                std::to_string(writesPerSecond[coalesce]));
+        RecordProperty(coalesce ? "coalesced_cpu_us_per_second" : "cpu_us_per_second",
+                std::to_string(cpuUsPerSecond));
+    }
+    EXPECT_NEAR(1e9 / kBurstPeriodNs, writesPerSecond[0], 0.1);
+    // 4 bursts of 32 ms per write for 128 ms
+    EXPECT_NEAR(writesPerSecond[0] / 4, writesPerSecond[1], 0.1);
+}
+
+TEST(SpdifBurstCoalescerTest, WritesHeldBurstsOnDeadline) {
+    StubHal hal;
+    // the size bound is not reached, only the 50 ms deadline
+    SpdifBurstCoalescer coalescer = makeCoalescer(&hal, 48000, milliseconds(50));
+    const std::vector<uint8_t> burst = makeBurst(0);
+    coalescer.write(burst.data(), burst.size(), 0);
+    coalescer.write(burst.data(), burst.size(), kBurstPeriodNs);
+    EXPECT_EQ(0u, hal.writeCount);
+    EXPECT_EQ(2 * kBurstBytes, coalescer.getHeldBytes());
+    coalescer.write(burst.data(), burst.size(), 2 * kBurstPeriodNs);
+    EXPECT_EQ(1u, hal.writeCount);
+    EXPECT_EQ(3 * kBurstBytes, hal.data.size());
+    EXPECT_EQ(0u, coalescer.getHeldBytes());
+}
+
+TEST(SpdifBurstCoalescerTest, WriteHeldWritesAllBursts) {
+    StubHal hal;
+    SpdifBurstCoalescer coalescer = makeCoalescer(&hal, 48000, seconds(1));
+    const std::vector<uint8_t> burst = makeBurst(0);
+    coalescer.write(burst.data(), burst.size(), 0);
+    EXPECT_EQ(0u, hal.writeCount);
+    // as on drain, pause or stop
+    EXPECT_EQ(NO_ERROR, coalescer.writeHeld());
+    EXPECT_EQ(kBurstBytes, hal.data.size());
+    EXPECT_EQ(0u, coalescer.getHeldBytes());
+    EXPECT_EQ(NO_ERROR, coalescer.writeHeld());
+    EXPECT_EQ(1u, hal.writeCount);
+}
+
+TEST(SpdifBurstCoalescerTest, FailedHalWriteKeepsHeldBursts) {
+    StubHal hal;
+    SpdifBurstCoalescer coalescer = makeCoalescer(&hal, 2 * kBurstFrames, seconds(1));
+    std::vector<uint8_t> expected;
+    for (size_t i = 0; i < 2; ++i) {
+        const std::vector<uint8_t> burst = makeBurst(i);
+        expected.insert(expected.end(), burst.begin(), burst.end());
+        if (i == 1) {
+            hal.failingWrites = 1;
+        }
+        // the burst is held although the HAL write fails
+        EXPECT_EQ((ssize_t)kBurstBytes, coalescer.write(burst.data(), burst.size(), 0));
+    }
+    EXPECT_TRUE(hal.data.empty());
+    EXPECT_EQ(2 * kBurstBytes, coalescer.getHeldBytes());
+
+    // the next burst retries the write
+    const std::vector<uint8_t> burst = makeBurst(2);
+    expected.insert(expected.end(), burst.begin(), burst.end());
+    EXPECT_EQ((ssize_t)kBurstBytes, coalescer.write(burst.data(), burst.size(), 0));
+    EXPECT_EQ(NO_ERROR, coalescer.writeHeld());
+    EXPECT_EQ(expected, hal.data);
+}
+
+TEST(SpdifBurstCoalescerTest, RefusesBurstWhileHalFails) {
+    StubHal hal;
+    SpdifBurstCoalescer coalescer = makeCoalescer(&hal, kBurstFrames, seconds(1));
+    const std::vector<uint8_t> burst = makeBurst(0);
+    hal.failingWrites = 2;
+    EXPECT_EQ((ssize_t)kBurstBytes, coalescer.write(burst.data(), burst.size(), 0));
+    // the held bursts are at the bound and the HAL still fails, so this one is not held
+    EXPECT_EQ(-EIO, coalescer.write(burst.data(), burst.size(), 0));
+    EXPECT_EQ(kBurstBytes, coalescer.getHeldBytes());
+}
+
+TEST(SpdifBurstCoalescerTest, PositionExcludesHeldBursts) {
+    StubHal hal;
+    SpdifBurstCoalescer coalescer = makeCoalescer(&hal, 2 * kBurstFrames, seconds(1));
+    const std::vector<uint8_t> burst = makeBurst(0);
+    coalescer.write(burst.data(), burst.size(), 0);
+    EXPECT_EQ(0u, coalescer.getHalFramesWritten());
+    coalescer.write(burst.data(), burst.size(), kBurstPeriodNs);
+    EXPECT_EQ(2 * kBurstFrames, coalescer.getHalFramesWritten());
+    coalescer.write(burst.data(), burst.size(), 2 * kBurstPeriodNs);
+    EXPECT_EQ(2 * kBurstFrames, coalescer.getHalFramesWritten());
+
+    // as on flush
+    coalescer.drop();
+    coalescer.resetPosition();
+    EXPECT_EQ(0u, coalescer.getHeldBytes());
+    EXPECT_EQ(0u, coalescer.getHalFramesWritten());
+    EXPECT_EQ(2 * kBurstBytes, hal.data.size());
+}
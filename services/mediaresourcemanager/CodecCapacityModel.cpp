@@ -0,0 +1,217 @@
+/*
+**
+** Copyright 2021, The Android Open Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "CodecCapacityModel"
+#include <utils/Log.h>
+
+#include <algorithm>
+
+#include <media/IMediaCodecList.h>
+#include <media/MediaCodecInfo.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <media/stagefright/foundation/AString.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "CodecCapacityModel.h"
+
+namespace android {
+
+static const char *kPerformancePointPrefix = "performance-point-";
+
+// Parses a "performance-point-<w>x<h>-range" detail with value "<min>-<max>"
+// into macroblocks per second. Returns 0 if the entry is not a performance point.
+static int64_t parsePerformancePoint(const char *name, const AString &value) {
+    if (strncmp(name, kPerformancePointPrefix, strlen(kPerformancePointPrefix)) != 0) {
+        return 0;
+    }
+    int32_t width, height;
+    if (sscanf(name + strlen(kPerformancePointPrefix), "%dx%d", &width, &height) != 2
+            || width <= 0 || height <= 0) {
+        return 0;
+    }
+    int32_t minRate, maxRate;
+    int n = sscanf(value.c_str(), "%d-%d", &minRate, &maxRate);
+    if (n < 1) {
+        return 0;
+    }
+    int64_t rate = (n == 2) ? maxRate : minRate;
+    if (rate <= 0) {
+        return 0;
+    }
+    return (int64_t)((width + 15) / 16) * ((height + 15) / 16) * rate;
+}
+
+static int64_t parseConcurrentInstances(const sp<AMessage> &details) {
+    AString value;
+    int32_t instances;
+    if (details->findString("max-concurrent-instances", &value)
+            && sscanf(value.c_str(), "%d", &instances) == 1 && instances > 0) {
+        return instances;
+    }
+    if (details->findInt32("max-concurrent-instances", &instances) && instances > 0) {
+        return instances;
+    }
+    return 0;
+}
+
+//static
+std::shared_ptr<CodecCapacityModel> CodecCapacityModel::CreateFromCodecList(
+        const sp<IMediaCodecList> &codecList) {
+    std::shared_ptr<CodecCapacityModel> model = std::make_shared<CodecCapacityModel>();
+    if (codecList == nullptr) {
+        return model;
+    }
+    for (size_t i = 0; i < codecList->countCodecs(); ++i) {
+        sp<MediaCodecInfo> info = codecList->getCodecInfo(i);
+        if (info != nullptr) {
+            model->addCodecInfo(info);
+        }
+    }
+    return model;
+}
+
+void CodecCapacityModel::addCodecInfo(const sp<MediaCodecInfo> &info) {
+    if (info->getAttributes() & MediaCodecInfo::kFlagIsSoftwareOnly) {
+        return;
+    }
+    const char *name = info->getCodecName();
+    size_t nameLen = strlen(name);
+    bool secure = nameLen > 7 && !strcmp(name + nameLen - 7, ".secure");
+
+    Vector<AString> mediaTypes;
+    info->getSupportedMediaTypes(&mediaTypes);
+
+    bool video = false;
+    int64_t instances = 0;
+    int64_t maxMbps = 0;
+    for (size_t i = 0; i < mediaTypes.size(); ++i) {
+        if (mediaTypes[i].startsWithIgnoreCase("video/")) {
+            video = true;
+        }
+        const sp<MediaCodecInfo::Capabilities> caps =
+                info->getCapabilitiesFor(mediaTypes[i].c_str());
+        if (caps == nullptr) {
+            continue;
+        }
+        const sp<AMessage> details = caps->getDetails();
+        if (details == nullptr) {
+            continue;
+        }
+        // The limits apply to the codec as a whole, so take the largest
+        // value advertised for any of its media types.
+        instances = std::max(instances, parseConcurrentInstances(details));
+        for (size_t j = 0; j < details->countEntries(); ++j) {
+            AMessage::Type type;
+            const char *entryName = details->getEntryNameAt(j, &type);
+            AString value;
+            if (type != AMessage::kTypeString || !details->findString(entryName, &value)) {
+                continue;
+            }
+            maxMbps = std::max(maxMbps, parsePerformancePoint(entryName, value));
+        }
+    }
+
+    ClassKey key(secure ? MediaResource::Type::kSecureCodec
+                        : MediaResource::Type::kNonSecureCodec,
+                 video ? MediaResource::SubType::kVideoCodec
+                       : MediaResource::SubType::kAudioCodec);
+    if (instances == 0 && maxMbps > 0) {
+        instances = std::max((int64_t)1, maxMbps / kReferenceMacroblocksPerSec);
+    }
+    ALOGV("codec %s: %s, instances %lld, max mb/s %lld", name,
+            info->isEncoder() ? "encoder" : "decoder", (long long)instances, (long long)maxMbps);
+
+    // The codecs of a class usually share one hardware block, so the limits of the encoders,
+    // or of the decoders, do not add up: the largest one applies.
+    CodecLimit &limit = mLimits[key][info->isEncoder() ? kEncoder : kDecoder];
+    limit.maxMacroblocksPerSec = std::max(limit.maxMacroblocksPerSec, maxMbps);
+    if (instances == 0) {
+        limit.unbounded = true;
+    } else {
+        limit.instances = std::max(limit.instances, instances);
+    }
+    if (mOverridden.count(key) == 0) {
+        updateCapacity(key);
+    }
+}
+
+void CodecCapacityModel::updateCapacity(const ClassKey &key) {
+    // The registered instances of a class are not told apart as encoders or decoders,
+    // so each of them may use up the more limited of the two.
+    int64_t capacity = kUnbounded;
+    for (const CodecLimit &limit : mLimits[key]) {
+        if (!limit.unbounded && limit.instances > 0
+                && (capacity == kUnbounded || limit.instances < capacity)) {
+            capacity = limit.instances;
+        }
+    }
+    if (capacity == kUnbounded) {
+        mCapacity.erase(key);
+    } else {
+        mCapacity[key] = capacity;
+    }
+}
+
+void CodecCapacityModel::setCapacity(MediaResource::Type type,
+        MediaResource::SubType subType, int64_t maxInstances) {
+    ClassKey key(type, subType);
+    mOverridden.insert(key);
+    if (maxInstances < 0) {
+        mCapacity.erase(key);
+    } else {
+        mCapacity[key] = maxInstances;
+    }
+}
+
+int64_t CodecCapacityModel::getCapacity(
+        MediaResource::Type type, MediaResource::SubType subType) const {
+    auto it = mCapacity.find(ClassKey(type, subType));
+    if (it == mCapacity.end()) {
+        return kUnbounded;
+    }
+    return it->second;
+}
+
+String8 CodecCapacityModel::toString(const char *linePrefix) const {
+    String8 result;
+    for (auto it = mCapacity.begin(); it != mCapacity.end(); ++it) {
+        result.appendFormat("%s%s/%s: %lld instances", linePrefix, asString(it->first.first),
+                asString(it->first.second), (long long)it->second);
+        auto limitsIt = mLimits.find(it->first);
+        if (limitsIt != mLimits.end()) {
+            static const char * const kNames[] = {"decoders", "encoders"};
+            for (size_t i = 0; i < limitsIt->second.size(); ++i) {
+                const CodecLimit &limit = limitsIt->second[i];
+                if (limit.unbounded) {
+                    result.appendFormat(", %s unbounded", kNames[i]);
+                } else if (limit.instances > 0) {
+                    result.appendFormat(", %s %lld max %lld mb/s", kNames[i],
+                            (long long)limit.instances, (long long)limit.maxMacroblocksPerSec);
+                }
+            }
+        }
+        result.append("\n");
+    }
+    if (mCapacity.empty()) {
+        result.appendFormat("%s<no codec capacity limits>\n", linePrefix);
+    }
+    return result;
+}
+
+} // namespace android
@@ -0,0 +1,105 @@
+/*
+**
+** Copyright 2021, The Android Open Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef ANDROID_MEDIA_CODECCAPACITYMODEL_H
+#define ANDROID_MEDIA_CODECCAPACITYMODEL_H
+
+#include <array>
+#include <map>
+#include <memory>
+#include <set>
+
+#include <media/MediaResource.h>
+#include <utils/String8.h>
+#include <utils/StrongPointer.h>
+
+namespace android {
+
+struct IMediaCodecList;
+struct MediaCodecInfo;
+
+/*
+ * Estimates how many concurrent codec instances the device can host for each
+ * codec resource class (secure/non-secure, audio/video).
+ *
+ * The capacity of a codec comes from its "concurrent-instances" limit when the
+ * vendor provides one, otherwise it is derived from its advertised performance
+ * points, counted in units of a 1080p30 reference session. Codecs that declare
+ * neither leave the encoders or decoders of their class unbounded.
+ *
+ * The codecs of a class share their hardware, so the decoders of a class are
+ * limited by the largest decoder limit, not the sum, and the same for encoders.
+ * As registered instances are not told apart as encoders or decoders, the
+ * capacity of the class is the smaller of the two limits that are known.
+ */
+class CodecCapacityModel {
+public:
+    // Sentinel returned by getCapacity() for classes without a known limit.
+    static constexpr int64_t kUnbounded = -1;
+
+    // Macroblocks per second of a 1920x1080@30 session.
+    static constexpr int64_t kReferenceMacroblocksPerSec = 120 * 68 * 30;
+
+    CodecCapacityModel() = default;
+
+    // Builds a model from all hardware codecs published by |codecList|.
+    static std::shared_ptr<CodecCapacityModel> CreateFromCodecList(
+            const sp<IMediaCodecList> &codecList);
+
+    // Adds the capacity contributed by |info|. Software-only codecs are skipped
+    // as their instance count is not bounded by a hardware block.
+    void addCodecInfo(const sp<MediaCodecInfo> &info);
+
+    // Overrides the capacity of a resource class, e.g. from policy or in tests.
+    void setCapacity(MediaResource::Type type, MediaResource::SubType subType,
+            int64_t maxInstances);
+
+    // Returns the number of concurrent instances of the class, or kUnbounded.
+    int64_t getCapacity(MediaResource::Type type, MediaResource::SubType subType) const;
+
+    bool isCodecResource(const MediaResourceParcel &resource) const {
+        return resource.type == MediaResource::Type::kSecureCodec
+                || resource.type == MediaResource::Type::kNonSecureCodec;
+    }
+
+    String8 toString(const char *linePrefix) const;
+
+private:
+    typedef std::pair<MediaResource::Type, MediaResource::SubType> ClassKey;
+
+    enum { kDecoder, kEncoder };
+
+    // Limit of the decoders or the encoders of a class.
+    struct CodecLimit {
+        int64_t instances = 0;              // largest limit of the codecs
+        bool unbounded = false;             // a codec has no known limit
+        int64_t maxMacroblocksPerSec = 0;   // largest performance point, for dumpsys
+    };
+
+    void updateCapacity(const ClassKey &key);
+
+    // Capacity in instances per class; absent classes are unbounded.
+    std::map<ClassKey, int64_t> mCapacity;
+    // Decoder and encoder limits per class, from the codec infos.
+    std::map<ClassKey, std::array<CodecLimit, 2>> mLimits;
+    // Classes whose capacity was set with setCapacity().
+    std::set<ClassKey> mOverridden;
+};
+
+} // namespace android
+
+#endif // ANDROID_MEDIA_CODECCAPACITYMODEL_H
@@ -19,12 +19,16 @@
 #define LOG_TAG "ResourceManagerService"
 #include <utils/Log.h>
 
+#include <algorithm>
+
 #include <android/binder_manager.h>
 #include <android/binder_process.h>
 #include <binder/IPCThreadState.h>
 #include <binder/IServiceManager.h>
 #include <cutils/sched_policy.h>
 #include <dirent.h>
+#include <media/IMediaCodecList.h>
+#include <media/IMediaPlayerService.h>
 #include <media/MediaResourcePolicy.h>
 #include <media/stagefright/ProcessInfo.h>
 #include <mediautils/BatteryNotifier.h>
@@ -148,6 +152,26 @@ static bool hasResourceType(MediaResource::Type type, const ResourceInfos& infos
     return false;
 }
 
+static bool hasResourceType(MediaResource::Type type, const PidResourceInfosMap& map) {
+    for (size_t i = 0; i < map.size(); ++i) {
+        if (hasResourceType(type, map.valueAt(i))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int64_t getResourceValue(MediaResource::Type type, MediaResource::SubType subType,
+        const ResourceList& resources) {
+    int64_t value = 0;
+    for (auto it = resources.begin(); it != resources.end(); it++) {
+        if (it->second.type == type && it->second.subType == subType) {
+            value += it->second.value;
+        }
+    }
+    return value;
+}
+
 static ResourceInfos& getResourceInfosForEdit(
         int pid,
         PidResourceInfosMap& map) {
@@ -214,10 +238,12 @@ binder_status_t ResourceManagerService::dump(
     bool supportsMultipleSecureCodecs;
     bool supportsSecureWithNonSecureCodec;
     std::map<int, int> overridePidMapCopy;
+    std::shared_ptr<CodecCapacityModel> capacityModel;
     String8 serviceLog;
     {
         Mutex::Autolock lock(mLock);
         mapCopy = mMap;  // Shadow copy, real copy will happen on write.
+        capacityModel = mCapacityModel;
         supportsMultipleSecureCodecs = mSupportsMultipleSecureCodecs;
         supportsSecureWithNonSecureCodec = mSupportsSecureWithNonSecureCodec;
         serviceLog = mServiceLog->toString("    " /* linePrefix */);
@@ -235,6 +261,13 @@ binder_status_t ResourceManagerService::dump(
             supportsSecureWithNonSecureCodec);
     result.append(buffer);
 
+    result.append("  Codec capacity:\n");
+    if (capacityModel != nullptr) {
+        result.append(capacityModel->toString("    " /* linePrefix */));
+    } else {
+        result.append("    <not loaded>\n");
+    }
+
     result.append("  Processes:\n");
     for (size_t i = 0; i < mapCopy.size(); ++i) {
         snprintf(buffer, SIZE, "    Pid: %d\n", mapCopy.keyAt(i));
@@ -345,6 +378,42 @@ void ResourceManagerService::setObserverService(
     mObserverService = observerService;
 }
 
+void ResourceManagerService::setCodecCapacityModel(
+        const std::shared_ptr<CodecCapacityModel>& capacityModel) {
+    Mutex::Autolock lock(mLock);
+    mCapacityModel = capacityModel;
+}
+
+std::shared_ptr<CodecCapacityModel> ResourceManagerService::getCodecCapacityModel() {
+    {
+        Mutex::Autolock lock(mLock);
+        if (mCapacityModel != nullptr) {
+            return mCapacityModel;
+        }
+    }
+
+    // The codec list is served by media.player, query it without holding mLock.
+    sp<IMediaCodecList> codecList;
+    sp<IBinder> binder = defaultServiceManager()->checkService(String16("media.player"));
+    sp<IMediaPlayerService> service = interface_cast<IMediaPlayerService>(binder);
+    if (service != nullptr) {
+        codecList = service->getCodecList();
+    }
+    if (codecList == nullptr) {
+        // Don't cache the empty model so that the next call tries again.
+        ALOGW("getCodecCapacityModel: codec list is not available yet");
+        return std::make_shared<CodecCapacityModel>();
+    }
+    std::shared_ptr<CodecCapacityModel> model =
+            CodecCapacityModel::CreateFromCodecList(codecList);
+
+    Mutex::Autolock lock(mLock);
+    if (mCapacityModel == nullptr) {
+        mCapacityModel = model;
+    }
+    return mCapacityModel;
+}
+
 Status ResourceManagerService::config(const std::vector<MediaResourcePolicyParcel>& policies) {
     String8 log = String8::format("config(%s)", getString(policies).string());
     mServiceLog->add(log);
@@ -685,6 +754,213 @@ Status ResourceManagerService::reclaimResource(
     return Status::ok();
 }
 
+Status ResourceManagerService::admitResource(
+        int32_t callingPid,
+        const std::vector<MediaResourceParcel>& resources,
+        bool* _aidl_return) {
+    String8 log = String8::format("admitResource(callingPid %d, resources %s)",
+            callingPid, getString(resources).string());
+    mServiceLog->add(log);
+    *_aidl_return = false;
+
+    std::shared_ptr<CodecCapacityModel> model = getCodecCapacityModel();
+    Vector<std::shared_ptr<IResourceManagerClient>> clients;
+    {
+        Mutex::Autolock lock(mLock);
+        if (!mProcessInfo->isValidPid(callingPid)) {
+            pid_t actualCallingPid = IPCThreadState::self()->getCallingPid();
+            ALOGW("%s called with untrusted pid %d, using actual calling pid %d", __FUNCTION__,
+                    callingPid, actualCallingPid);
+            callingPid = actualCallingPid;
+        }
+        if (canAdmit_l(*model, resources)) {
+            *_aidl_return = true;
+            return Status::ok();
+        }
+        if (!getReclaimPlan_l(callingPid, *model, resources, &clients)) {
+            return Status::ok();
+        }
+    }
+
+    *_aidl_return = reclaimInternal(clients);
+    return Status::ok();
+}
+
+Status ResourceManagerService::getCodecHeadroom(
+        MediaResource::Type type,
+        MediaResource::SubType subType,
+        int64_t* _aidl_return) {
+    String8 log = String8::format("getCodecHeadroom(type %s, subType %s)",
+            asString(type), asString(subType));
+    mServiceLog->add(log);
+
+    std::shared_ptr<CodecCapacityModel> model = getCodecCapacityModel();
+    Mutex::Autolock lock(mLock);
+    *_aidl_return = getCodecHeadroom_l(*model, type, subType);
+    return Status::ok();
+}
+
+int64_t ResourceManagerService::getCodecUsage_l(
+        MediaResource::Type type, MediaResource::SubType subType) {
+    int64_t usage = 0;
+    for (size_t i = 0; i < mMap.size(); ++i) {
+        const ResourceInfos &infos = mMap.valueAt(i);
+        for (size_t j = 0; j < infos.size(); ++j) {
+            usage += getResourceValue(type, subType, infos[j].resources);
+        }
+    }
+    return usage;
+}
+
+int64_t ResourceManagerService::getCodecHeadroom_l(const CodecCapacityModel &model,
+        MediaResource::Type type, MediaResource::SubType subType) {
+    if (type == MediaResource::Type::kSecureCodec) {
+        if (!mSupportsSecureWithNonSecureCodec
+                && hasResourceType(MediaResource::Type::kNonSecureCodec, mMap)) {
+            return 0;
+        }
+    } else if (!mSupportsSecureWithNonSecureCodec
+            && hasResourceType(MediaResource::Type::kSecureCodec, mMap)) {
+        return 0;
+    }
+    int64_t headroom = model.getCapacity(type, subType);
+    if (headroom != CodecCapacityModel::kUnbounded) {
+        headroom = std::max(headroom - getCodecUsage_l(type, subType), (int64_t)0);
+    }
+    if (type == MediaResource::Type::kSecureCodec && !mSupportsMultipleSecureCodecs) {
+        int64_t single = hasResourceType(MediaResource::Type::kSecureCodec, mMap) ? 0 : 1;
+        headroom = headroom == CodecCapacityModel::kUnbounded ? single
+                                                              : std::min(headroom, single);
+    }
+    return headroom;
+}
+
+bool ResourceManagerService::canAdmit_l(const CodecCapacityModel &model,
+        const std::vector<MediaResourceParcel> &resources) {
+    for (size_t i = 0; i < resources.size(); ++i) {
+        const MediaResourceParcel &res = resources[i];
+        if (!model.isCodecResource(res)) {
+            continue;
+        }
+        int64_t headroom = getCodecHeadroom_l(model, res.type, res.subType);
+        if (headroom != CodecCapacityModel::kUnbounded && res.value > headroom) {
+            ALOGV("canAdmit_l: %s over headroom %lld", toString(res).string(),
+                    (long long)headroom);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ResourceManagerService::getReclaimPlan_l(
+        int callingPid, const CodecCapacityModel &model,
+        const std::vector<MediaResourceParcel> &resources,
+        Vector<std::shared_ptr<IResourceManagerClient>> *clients) {
+    Vector<std::shared_ptr<IResourceManagerClient>> plan;
+    auto inPlan = [&plan](const std::shared_ptr<IResourceManagerClient> &client) {
+        for (size_t i = 0; i < plan.size(); ++i) {
+            if (plan[i] == client) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // First resolve secure/non-secure codec conflicts, as reclaimResource does.
+    for (size_t i = 0; i < resources.size(); ++i) {
+        const MediaResourceParcel &res = resources[i];
+        if (!model.isCodecResource(res)) {
+            continue;
+        }
+        Vector<std::shared_ptr<IResourceManagerClient>> conflicts;
+        if (res.type == MediaResource::Type::kSecureCodec) {
+            if (!mSupportsMultipleSecureCodecs && !getAllClients_l(
+                    callingPid, MediaResource::Type::kSecureCodec, &conflicts)) {
+                return false;
+            }
+            if (!mSupportsSecureWithNonSecureCodec && !getAllClients_l(
+                    callingPid, MediaResource::Type::kNonSecureCodec, &conflicts)) {
+                return false;
+            }
+        } else if (!mSupportsSecureWithNonSecureCodec && !getAllClients_l(
+                callingPid, MediaResource::Type::kSecureCodec, &conflicts)) {
+            return false;
+        }
+        for (size_t j = 0; j < conflicts.size(); ++j) {
+            if (!inPlan(conflicts[j])) {
+                plan.push_back(conflicts[j]);
+            }
+        }
+    }
+
+    // Then free enough instances of each class that is over capacity.
+    struct Candidate {
+        bool pendingRemoval;
+        int priority;
+        int64_t value;
+        std::shared_ptr<IResourceManagerClient> client;
+    };
+    for (size_t i = 0; i < resources.size(); ++i) {
+        const MediaResourceParcel &res = resources[i];
+        if (!model.isCodecResource(res)) {
+            continue;
+        }
+        int64_t capacity = model.getCapacity(res.type, res.subType);
+        if (capacity == CodecCapacityModel::kUnbounded) {
+            continue;
+        }
+        int64_t deficit = getCodecUsage_l(res.type, res.subType) + res.value - capacity;
+
+        std::vector<Candidate> candidates;
+        for (size_t j = 0; j < mMap.size() && deficit > 0; ++j) {
+            int pid = mMap.keyAt(j);
+            const ResourceInfos &infos = mMap.valueAt(j);
+            int priority = -1;
+            bool lowerPriority = isCallingPriorityHigher_l(callingPid, pid)
+                    && getPriority_l(pid, &priority);
+            for (size_t k = 0; k < infos.size(); ++k) {
+                int64_t value = getResourceValue(res.type, res.subType, infos[k].resources);
+                if (value <= 0) {
+                    continue;
+                }
+                if (inPlan(infos[k].client)) {
+                    // Already going away to resolve a conflict.
+                    deficit -= value;
+                    continue;
+                }
+                bool pendingRemoval = (pid == callingPid && infos[k].pendingRemoval);
+                if (pendingRemoval || lowerPriority) {
+                    candidates.push_back({pendingRemoval, priority, value, infos[k].client});
+                }
+            }
+        }
+        // Clients pending removal in the calling process go first, then the
+        // biggest clients of the lowest priority processes.
+        std::sort(candidates.begin(), candidates.end(),
+                [](const Candidate &a, const Candidate &b) {
+                    if (a.pendingRemoval != b.pendingRemoval) {
+                        return a.pendingRemoval;
+                    }
+                    if (a.priority != b.priority) {
+                        return a.priority > b.priority;
+                    }
+                    return a.value > b.value;
+                });
+        for (size_t j = 0; j < candidates.size() && deficit > 0; ++j) {
+            plan.push_back(candidates[j].client);
+            deficit -= candidates[j].value;
+        }
+        if (deficit > 0) {
+            ALOGE("getReclaimPlan_l: can't free %lld instances of %s for pid %d",
+                    (long long)deficit, toString(res).string(), callingPid);
+            return false;
+        }
+    }
+
+    clients->appendVector(plan);
+    return true;
+}
+
 bool ResourceManagerService::reclaimInternal(
         const Vector<std::shared_ptr<IResourceManagerClient>> &clients) {
     if (clients.size() == 0) {
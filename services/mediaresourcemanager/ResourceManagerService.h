@@ -30,6 +30,8 @@
 #include <utils/threads.h>
 #include <utils/Vector.h>
 
+#include "CodecCapacityModel.h"
+
 namespace android {
 
 class DeathNotifier;
@@ -83,6 +85,7 @@ public:
     virtual ~ResourceManagerService();
     void setObserverService(
             const std::shared_ptr<ResourceObserverService>& observerService);
+    void setCodecCapacityModel(const std::shared_ptr<CodecCapacityModel>& capacityModel);
 
     // IResourceManagerService interface
     Status config(const std::vector<MediaResourcePolicyParcel>& policies) override;
@@ -109,6 +112,21 @@ public:
             const std::vector<MediaResourceParcel>& resources,
             bool* _aidl_return) override;
 
+    // Checks the requested codec resources against the codec capacity model and,
+    // if they don't fit, pre-emptively reclaims from lower priority processes.
+    // Returns true if the resources are expected to be admitted.
+    Status admitResource(
+            int32_t callingPid,
+            const std::vector<MediaResourceParcel>& resources,
+            bool* _aidl_return) override;
+
+    // Returns the number of codec instances of |type|/|subType| that can be added without
+    // reclaiming, or CodecCapacityModel::kUnbounded.
+    Status getCodecHeadroom(
+            MediaResource::Type type,
+            MediaResource::SubType subType,
+            int64_t* _aidl_return) override;
+
     Status overridePid(
             int originalPid,
             int newPid) override;
@@ -159,6 +177,30 @@ private:
 
     bool isCallingPriorityHigher_l(int callingPid, int pid);
 
+    // Returns the codec capacity model, building it from the codec list on first use.
+    std::shared_ptr<CodecCapacityModel> getCodecCapacityModel();
+
+    // Gets the number of codec instances of |type|/|subType| currently registered.
+    int64_t getCodecUsage_l(MediaResource::Type type, MediaResource::SubType subType);
+
+    // Gets the number of codec instances of |type|/|subType| that fit into the capacity
+    // model and don't conflict with the secure codec policies, or kUnbounded.
+    int64_t getCodecHeadroom_l(const CodecCapacityModel &model,
+            MediaResource::Type type, MediaResource::SubType subType);
+
+    // Returns true if |resources| fit into the capacity model and don't conflict with
+    // the secure codec policies, without reclaiming anything.
+    bool canAdmit_l(const CodecCapacityModel &model,
+            const std::vector<MediaResourceParcel> &resources);
+
+    // Gets the clients to reclaim so that |resources| can be admitted, preferring
+    // clients pending removal in the calling process, then the lowest priority
+    // processes. Returns false if no such set exists. The clients will remain
+    // unchanged if returns false.
+    bool getReclaimPlan_l(int callingPid, const CodecCapacityModel &model,
+            const std::vector<MediaResourceParcel> &resources,
+            Vector<std::shared_ptr<IResourceManagerClient>> *clients);
+
     // A helper function basically calls getLowestPriorityBiggestClient_l and add
     // the result client to the given Vector.
     void getClientForResource_l(int callingPid, const MediaResourceParcel *res,
@@ -199,6 +241,7 @@ private:
     static std::map<uintptr_t, sp<DeathNotifier> > sCookieToDeathNotifierMap
             GUARDED_BY(sCookieLock);
     std::shared_ptr<ResourceObserverService> mObserverService;
+    std::shared_ptr<CodecCapacityModel> mCapacityModel;
 };
 
 // ----------------------------------------------------------------------------
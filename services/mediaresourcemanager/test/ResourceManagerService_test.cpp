@@ -593,6 +593,106 @@ public:
         }
     }
 
+    void testAdmitResource() {
+        bool result;
+        std::vector<MediaResourceParcel> resources;
+        resources.push_back(MediaResource(MediaResource::Type::kSecureCodec, 1));
+
+        std::shared_ptr<CodecCapacityModel> model = std::make_shared<CodecCapacityModel>();
+        mService->setCodecCapacityModel(model);
+
+        // ### capacity not exceeded, admit without reclaiming ###
+        {
+            addResource();
+
+            // unknown capacity
+            CHECK_STATUS_TRUE(mService->admitResource(kLowPriorityPid, resources, &result));
+            verifyClients(false /* c1 */, false /* c2 */, false /* c3 */);
+
+            // room for one more secure codec
+            model->setCapacity(MediaResource::Type::kSecureCodec,
+                    MediaResource::SubType::kUnspecifiedSubType, 3);
+            CHECK_STATUS_TRUE(mService->admitResource(kLowPriorityPid, resources, &result));
+            verifyClients(false /* c1 */, false /* c2 */, false /* c3 */);
+
+            // resources without a capacity are always admitted
+            std::vector<MediaResourceParcel> graphicMemory;
+            graphicMemory.push_back(MediaResource(MediaResource::Type::kGraphicMemory, 100));
+            model->setCapacity(MediaResource::Type::kSecureCodec,
+                    MediaResource::SubType::kUnspecifiedSubType, 1);
+            CHECK_STATUS_TRUE(mService->admitResource(kLowPriorityPid, graphicMemory, &result));
+            verifyClients(false /* c1 */, false /* c2 */, false /* c3 */);
+        }
+
+        // ### capacity exceeded, reclaim from lower priority processes ###
+        {
+            // only mTestClient1 has lower priority, not enough to free 2 instances
+            CHECK_STATUS_FALSE(mService->admitResource(kMidPriorityPid, resources, &result));
+            verifyClients(false /* c1 */, false /* c2 */, false /* c3 */);
+
+            // free both secure codecs, the non-secure codec is left alone
+            CHECK_STATUS_TRUE(mService->admitResource(kHighPriorityPid, resources, &result));
+            verifyClients(true /* c1 */, false /* c2 */, true /* c3 */);
+            EXPECT_EQ(0, mService->getCodecUsage_l(MediaResource::Type::kSecureCodec,
+                    MediaResource::SubType::kUnspecifiedSubType));
+
+            // non-secure class is tracked separately
+            std::vector<MediaResourceParcel> nonSecure;
+            nonSecure.push_back(MediaResource(MediaResource::Type::kNonSecureCodec, 1));
+            model->setCapacity(MediaResource::Type::kNonSecureCodec,
+                    MediaResource::SubType::kUnspecifiedSubType, 1);
+            CHECK_STATUS_FALSE(mService->admitResource(kLowPriorityPid, nonSecure, &result));
+            verifyClients(false /* c1 */, false /* c2 */, false /* c3 */);
+            CHECK_STATUS_TRUE(mService->admitResource(kHighPriorityPid, nonSecure, &result));
+            verifyClients(false /* c1 */, true /* c2 */, false /* c3 */);
+        }
+
+        // ### secure codec can't coexist, reclaim plan resolves the conflict ###
+        {
+            addResource();
+            model->setCapacity(MediaResource::Type::kSecureCodec,
+                    MediaResource::SubType::kUnspecifiedSubType, CodecCapacityModel::kUnbounded);
+            mService->mSupportsMultipleSecureCodecs = false;
+            CHECK_STATUS_FALSE(mService->admitResource(kMidPriorityPid, resources, &result));
+            verifyClients(false /* c1 */, false /* c2 */, false /* c3 */);
+            CHECK_STATUS_TRUE(mService->admitResource(kHighPriorityPid, resources, &result));
+            verifyClients(true /* c1 */, false /* c2 */, true /* c3 */);
+            mService->mSupportsMultipleSecureCodecs = true;
+        }
+    }
+
+    void testGetCodecHeadroom() {
+        int64_t headroom;
+        std::shared_ptr<CodecCapacityModel> model = std::make_shared<CodecCapacityModel>();
+        mService->setCodecCapacityModel(model);
+        addResource();
+
+        // unknown capacity
+        CHECK_STATUS_TRUE(mService->getCodecHeadroom(MediaResource::Type::kSecureCodec,
+                MediaResource::SubType::kUnspecifiedSubType, &headroom));
+        EXPECT_EQ(CodecCapacityModel::kUnbounded, headroom);
+
+        // two secure codecs registered, the query doesn't reclaim them
+        model->setCapacity(MediaResource::Type::kSecureCodec,
+                MediaResource::SubType::kUnspecifiedSubType, 3);
+        CHECK_STATUS_TRUE(mService->getCodecHeadroom(MediaResource::Type::kSecureCodec,
+                MediaResource::SubType::kUnspecifiedSubType, &headroom));
+        EXPECT_EQ(1, headroom);
+        model->setCapacity(MediaResource::Type::kSecureCodec,
+                MediaResource::SubType::kUnspecifiedSubType, 1);
+        CHECK_STATUS_TRUE(mService->getCodecHeadroom(MediaResource::Type::kSecureCodec,
+                MediaResource::SubType::kUnspecifiedSubType, &headroom));
+        EXPECT_EQ(0, headroom);
+        verifyClients(false /* c1 */, false /* c2 */, false /* c3 */);
+
+        // no room next to a secure codec that can't coexist
+        mService->mSupportsSecureWithNonSecureCodec = false;
+        CHECK_STATUS_TRUE(mService->getCodecHeadroom(MediaResource::Type::kNonSecureCodec,
+                MediaResource::SubType::kUnspecifiedSubType, &headroom));
+        EXPECT_EQ(0, headroom);
+        mService->mSupportsSecureWithNonSecureCodec = true;
+    }
+
     void testGetLowestPriorityBiggestClient() {
         MediaResource::Type type = MediaResource::Type::kGraphicMemory;
         std::shared_ptr<IResourceManagerClient> client;
@@ -756,6 +856,14 @@ TEST_F(ResourceManagerServiceTest, reclaimResource) {
     testReclaimResourceNonSecure();
 }
 
+TEST_F(ResourceManagerServiceTest, admitResource) {
+    testAdmitResource();
+}
+
+TEST_F(ResourceManagerServiceTest, getCodecHeadroom) {
+    testGetCodecHeadroom();
+}
+
 TEST_F(ResourceManagerServiceTest, getAllClients_l) {
     testGetAllClients();
 }
@@ -44,6 +44,9 @@ namespace android {
             String8::format("%s:%d: " errorString, __FUNCTION__, __LINE__, ##__VA_ARGS__))
 
 static constexpr int64_t kTranscoderHeartBeatIntervalUs = 1000000LL;
+// Upper bound of sessions running at the same time with the real transcoder. How many
+// actually run is decided by the codec admission of the resource manager.
+static constexpr int32_t kMaxConcurrentSessions = 4;
 
 MediaTranscodingService::MediaTranscodingService()
       : mUidPolicy(new TranscodingUidPolicy()),
@@ -52,6 +55,8 @@ MediaTranscodingService::MediaTranscodingService()
         mLogger(new TranscodingLogger()) {
     ALOGV("MediaTranscodingService is created");
     bool simulated = property_get_bool("debug.transcoding.simulated_transcoder", false);
+    int32_t maxConcurrentSessions =
+            property_get_int32("persist.transcoding.max_concurrent_sessions", -1);
     if (simulated) {
         // Overrid default config params with shorter values for testing.
         TranscodingSessionController::ControllerConfig config = {
@@ -59,6 +64,9 @@ MediaTranscodingService::MediaTranscodingService()
                 .pacerBurstCountQuota = 10,
                 .pacerBurstTimeQuotaSeconds = 3,
         };
+        if (maxConcurrentSessions > 0) {
+            config.maxConcurrentSessions = maxConcurrentSessions;
+        }
         mSessionController.reset(new TranscodingSessionController(
                 [](const std::shared_ptr<TranscoderCallbackInterface>& cb)
                         -> std::shared_ptr<TranscoderInterface> {
@@ -71,13 +79,18 @@ MediaTranscodingService::MediaTranscodingService()
         int32_t pacerBurstTimeQuotaSeconds =
                 property_get_int32("persist.transcoding.burst_time_quota_seconds", -1);
         // Override default config params with properties if present.
-        TranscodingSessionController::ControllerConfig config;
+        TranscodingSessionController::ControllerConfig config = {
+                .maxConcurrentSessions = kMaxConcurrentSessions,
+        };
         if (overrideBurstCountQuota > 0) {
             config.pacerBurstCountQuota = overrideBurstCountQuota;
         }
         if (pacerBurstTimeQuotaSeconds > 0) {
             config.pacerBurstTimeQuotaSeconds = pacerBurstTimeQuotaSeconds;
         }
+        if (maxConcurrentSessions > 0) {
+            config.maxConcurrentSessions = maxConcurrentSessions;
+        }
         mSessionController.reset(new TranscodingSessionController(
                 [logger = mLogger](const std::shared_ptr<TranscoderCallbackInterface>& cb)
                         -> std::shared_ptr<TranscoderInterface> {
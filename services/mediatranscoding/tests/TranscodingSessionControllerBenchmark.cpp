@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Benchmark measuring the time TranscodingSessionController takes to drain a queue of
+ * sessions from multiple uids, with different limits on the number of concurrent
+ * sessions. Sessions are run by SimulatedTranscoder, so the numbers show the
+ * scheduling behavior rather than the codec throughput.
+ *
+ * To run the benchmark:
+ *   adb shell /data/nativetest64/TranscodingSessionControllerBenchmark/\
+ *       TranscodingSessionControllerBenchmark
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "TranscodingSessionControllerBenchmark"
+
+#include <aidl/android/media/BnTranscodingClientCallback.h>
+#include <benchmark/benchmark.h>
+#include <media/TranscodingSessionController.h>
+#include <utils/Log.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <unordered_set>
+
+#include "SimulatedTranscoder.h"
+
+namespace android {
+
+using Status = ::ndk::ScopedAStatus;
+using aidl::android::media::BnTranscodingClientCallback;
+using aidl::android::media::TranscodingErrorCode;
+using aidl::android::media::TranscodingRequestParcel;
+using aidl::android::media::TranscodingResultParcel;
+using aidl::android::media::TranscodingSessionPriority;
+using aidl::android::media::TranscodingTestConfig;
+
+// Processing time of each simulated session.
+static constexpr int32_t kSessionProcessingTimeMs = 50;
+// Sessions submitted by each uid.
+static constexpr int32_t kSessionsPerUid = 4;
+// First uid used by the benchmark clients.
+static constexpr uid_t kFirstClientUid = 10000;
+
+class BenchmarkUidPolicy : public UidPolicyInterface {
+public:
+    void registerMonitorUid(uid_t /*uid*/) override {}
+    void unregisterMonitorUid(uid_t /*uid*/) override {}
+    bool isUidOnTop(uid_t uid) override { return uid == kFirstClientUid; }
+    std::unordered_set<uid_t> getTopUids() const override { return {kFirstClientUid}; }
+    void setCallback(const std::shared_ptr<UidPolicyCallbackInterface>& /*cb*/) override {}
+};
+
+class BenchmarkResourcePolicy : public ResourcePolicyInterface {
+public:
+    void setCallback(const std::shared_ptr<ResourcePolicyCallbackInterface>& /*cb*/) override {}
+    void setPidResourceLost(pid_t /*pid*/) override {}
+    bool admitSession(pid_t /*pid*/) override { return true; }
+    void releaseSession(pid_t /*pid*/) override {}
+};
+
+class BenchmarkThermalPolicy : public ThermalPolicyInterface {
+public:
+    void setCallback(const std::shared_ptr<ThermalPolicyCallbackInterface>& /*cb*/) override {}
+    bool getThrottlingStatus() override { return false; }
+};
+
+// Counts finished sessions and wakes up the benchmark when all of them are done.
+class BenchmarkClientCallback : public BnTranscodingClientCallback {
+public:
+    Status openFileDescriptor(const std::string& /*in_fileUri*/, const std::string& /*in_mode*/,
+                              ::ndk::ScopedFileDescriptor* /*_aidl_return*/) override {
+        return Status::ok();
+    }
+    Status onTranscodingStarted(int32_t /*in_sessionId*/) override { return Status::ok(); }
+    Status onTranscodingPaused(int32_t /*in_sessionId*/) override { return Status::ok(); }
+    Status onTranscodingResumed(int32_t /*in_sessionId*/) override { return Status::ok(); }
+    Status onTranscodingFinished(int32_t /*in_sessionId*/,
+                                 const TranscodingResultParcel& /*in_result*/) override {
+        onSessionDone();
+        return Status::ok();
+    }
+    Status onTranscodingFailed(int32_t in_sessionId, TranscodingErrorCode in_errorCode) override {
+        ALOGE("session %d failed: %d", in_sessionId, (int32_t)in_errorCode);
+        onSessionDone();
+        return Status::ok();
+    }
+    Status onAwaitNumberOfSessionsChanged(int32_t /*in_sessionId*/,
+                                          int32_t /*in_oldAwaitNumber*/,
+                                          int32_t /*in_newAwaitNumber*/) override {
+        return Status::ok();
+    }
+    Status onProgressUpdate(int32_t /*in_sessionId*/, int32_t /*in_progress*/) override {
+        return Status::ok();
+    }
+
+    void waitForSessions(int32_t count) {
+        std::unique_lock lock(mLock);
+        mCondition.wait(lock, [&] { return mDoneSessions >= count; });
+        mDoneSessions -= count;
+    }
+
+private:
+    void onSessionDone() {
+        std::scoped_lock lock(mLock);
+        mDoneSessions++;
+        mCondition.notify_all();
+    }
+
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    int32_t mDoneSessions = 0;
+};
+
+// Has access to the private constructor of TranscodingSessionController.
+class TranscodingSessionControllerBenchmark {
+public:
+    static std::shared_ptr<TranscodingSessionController> createController(
+            int32_t maxConcurrentSessions) {
+        TranscodingSessionController::ControllerConfig config;
+        config.maxConcurrentSessions = maxConcurrentSessions;
+        return std::shared_ptr<TranscodingSessionController>(new TranscodingSessionController(
+                [](const std::shared_ptr<TranscoderCallbackInterface>& cb)
+                        -> std::shared_ptr<TranscoderInterface> {
+                    return std::make_shared<SimulatedTranscoder>(cb);
+                },
+                std::make_shared<BenchmarkUidPolicy>(),
+                std::make_shared<BenchmarkResourcePolicy>(),
+                std::make_shared<BenchmarkThermalPolicy>(), &config));
+    }
+};
+
+static void BM_DrainSessionQueue(benchmark::State& state) {
+    const int32_t maxConcurrentSessions = state.range(0);
+    const int32_t numUids = state.range(1);
+    const int32_t numSessions = numUids * kSessionsPerUid;
+
+    std::shared_ptr<TranscodingSessionController> controller =
+            TranscodingSessionControllerBenchmark::createController(maxConcurrentSessions);
+    std::shared_ptr<BenchmarkClientCallback> callback =
+            ::ndk::SharedRefBase::make<BenchmarkClientCallback>();
+
+    TranscodingRequestParcel request;
+    request.priority = TranscodingSessionPriority::kHigh;
+    request.testConfig = TranscodingTestConfig();
+    request.testConfig->processingTotalTimeMs = kSessionProcessingTimeMs;
+
+    SessionIdType sessionId = 0;
+    for (auto _ : state) {
+        // Submit in rounds so that sessions of all uids are interleaved in submission order.
+        for (int32_t i = 0; i < kSessionsPerUid; ++i) {
+            for (int32_t uid = 0; uid < numUids; ++uid) {
+                // Use the client uid as calling uid so that the pacer doesn't drop sessions.
+                uid_t clientUid = kFirstClientUid + uid;
+                controller->submit(uid /*clientId*/, sessionId++, clientUid, clientUid, request,
+                                   callback);
+            }
+        }
+        callback->waitForSessions(numSessions);
+    }
+
+    state.counters["SessionsPerSec"] = benchmark::Counter(
+            (double)numSessions * state.iterations(), benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_DrainSessionQueue)
+        ->ArgNames({"concurrency", "uids"})
+        ->ArgsProduct({{1, 2, 4}, {1, 4}})
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+
+}  // namespace android
+
+BENCHMARK_MAIN();
@@ -20,6 +20,7 @@
 
 #define ATRACE_TAG ATRACE_TAG_AUDIO
 
+#include <algorithm>
 #include <cstring>
 #include <utils/Trace.h>
 
@@ -29,6 +30,17 @@
 #define AAUDIO_MIXER_ATRACE_ENABLED    1
 #endif
 
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#ifndef USE_NEON
+#define USE_NEON (true)
+#endif
+#else
+#define USE_NEON (false)
+#endif
+#if USE_NEON
+#include <arm_neon.h>
+#endif
+
 using android::WrappingBuffer;
 using android::FifoBuffer;
 using android::fifo_frames_t;
@@ -39,13 +51,15 @@ void AAudioMixer::allocate(int32_t samplesPerFrame, int32_t framesPerBurst) {
     int32_t samplesPerBuffer = samplesPerFrame * framesPerBurst;
     mOutputBuffer = std::make_unique<float[]>(samplesPerBuffer);
     mBufferSizeInBytes = samplesPerBuffer * sizeof(float);
+    mOutputCleared = false;
 }
 
 void AAudioMixer::clear() {
-    memset(mOutputBuffer.get(), 0, mBufferSizeInBytes);
+    mOutputCleared = false;
 }
 
-int32_t AAudioMixer::mix(int streamIndex, std::shared_ptr<FifoBuffer> fifo, bool allowUnderflow) {
+int32_t AAudioMixer::mix(int streamIndex, std::shared_ptr<FifoBuffer> fifo, bool allowUnderflow,
+                         float gain, float *previousGain) {
     WrappingBuffer wrappingBuffer;
     float *destination = mOutputBuffer.get();
 
@@ -63,7 +77,7 @@ int32_t AAudioMixer::mix(int streamIndex, std::shared_ptr<FifoBuffer> fifo, bool
         ATRACE_INT(rdyText, fullFrames);
     }
 #else /* MIXER_ATRACE_ENABLED */
-    (void) trackIndex;
+    (void) streamIndex;
 #endif /* AAUDIO_MIXER_ATRACE_ENABLED */
 
     // If allowUnderflow then always advance by one burst even if we do not have the data.
@@ -77,6 +91,22 @@ int32_t AAudioMixer::mix(int streamIndex, std::shared_ptr<FifoBuffer> fifo, bool
         framesDesired = fullFrames; // just use what is available then stop
     }
 
+    // Ramp the gain over the frames actually mixed, continuing across the FIFO wrap. If there
+    // are none, the ramp is left for the next burst.
+    const fifo_frames_t framesToMix = std::min(framesDesired, fullFrames);
+    float partGain = gain;
+    float gainIncrement = 0.0f;
+    if (previousGain != nullptr && framesToMix > 0) {
+        if (*previousGain != gain) {
+            partGain = *previousGain;
+            gainIncrement = (gain - partGain) / framesToMix;
+        }
+        *previousGain = gain;
+    }
+
+    // The first stream in a burst writes the output instead of adding to it.
+    const bool accumulate = mOutputCleared;
+
     // Mix data in one or two parts.
     int partIndex = 0;
     int32_t framesLeft = framesDesired;
@@ -87,16 +117,24 @@ int32_t AAudioMixer::mix(int streamIndex, std::shared_ptr<FifoBuffer> fifo, bool
             if (framesToMixFromPart > framesAvailableFromPart) {
                 framesToMixFromPart = framesAvailableFromPart;
             }
-            mixPart(destination, (float *)wrappingBuffer.data[partIndex],
-                    framesToMixFromPart);
+            mixPart(destination, (const float *)wrappingBuffer.data[partIndex],
+                    framesToMixFromPart, partGain, gainIncrement, accumulate);
 
             destination += framesToMixFromPart * mSamplesPerFrame;
             framesLeft -= framesToMixFromPart;
+            partGain += gainIncrement * framesToMixFromPart;
         }
         partIndex++;
     }
     fifo->advanceReadIndex(framesDesired);
 
+    if (!accumulate) {
+        // Clear the part of the burst that this stream did not write.
+        float *end = mOutputBuffer.get() + mFramesPerBurst * mSamplesPerFrame;
+        memset(destination, 0, (end - destination) * sizeof(float));
+        mOutputCleared = true;
+    }
+
 #if AAUDIO_MIXER_ATRACE_ENABLED
     ATRACE_END();
 #endif /* AAUDIO_MIXER_ATRACE_ENABLED */
@@ -104,14 +142,54 @@ int32_t AAudioMixer::mix(int streamIndex, std::shared_ptr<FifoBuffer> fifo, bool
     return (framesDesired - framesLeft); // framesRead
 }
 
-void AAudioMixer::mixPart(float *destination, float *source, int32_t numFrames) {
+void AAudioMixer::mixPart(float *destination, const float *source, int32_t numFrames,
+                          float gain, float gainIncrement, bool accumulate) {
     int32_t numSamples = numFrames * mSamplesPerFrame;
-    // TODO maybe optimize using SIMD
-    for (int sampleIndex = 0; sampleIndex < numSamples; sampleIndex++) {
-        *destination++ += *source++;
+
+    if (gainIncrement != 0.0f) {
+        // Ramps only happen in the burst where the gain changes so keep this simple.
+        if (!accumulate) {
+            memset(destination, 0, numSamples * sizeof(float));
+        }
+        for (int32_t frameIndex = 0; frameIndex < numFrames; frameIndex++) {
+            for (int32_t channel = 0; channel < mSamplesPerFrame; channel++) {
+                *destination++ += *source++ * gain;
+            }
+            gain += gainIncrement;
+        }
+        return;
+    }
+
+    int32_t sampleIndex = 0;
+#if USE_NEON
+    const float32x4_t gains = vdupq_n_f32(gain);
+    for (; sampleIndex + 8 <= numSamples; sampleIndex += 8) {
+        float32x4_t s0 = vmulq_f32(vld1q_f32(source + sampleIndex), gains);
+        float32x4_t s1 = vmulq_f32(vld1q_f32(source + sampleIndex + 4), gains);
+        if (accumulate) {
+            s0 = vaddq_f32(vld1q_f32(destination + sampleIndex), s0);
+            s1 = vaddq_f32(vld1q_f32(destination + sampleIndex + 4), s1);
+        }
+        vst1q_f32(destination + sampleIndex, s0);
+        vst1q_f32(destination + sampleIndex + 4, s1);
+    }
+#endif // USE_NEON
+    // Separate loops without branches so that the compiler can vectorize them.
+    if (accumulate) {
+        for (; sampleIndex < numSamples; sampleIndex++) {
+            destination[sampleIndex] += source[sampleIndex] * gain;
+        }
+    } else {
+        for (; sampleIndex < numSamples; sampleIndex++) {
+            destination[sampleIndex] = source[sampleIndex] * gain;
+        }
     }
 }
 
 float *AAudioMixer::getOutputBuffer() {
+    if (!mOutputCleared) {
+        memset(mOutputBuffer.get(), 0, mBufferSizeInBytes);
+        mOutputCleared = true;
+    }
     return mOutputBuffer.get();
 }
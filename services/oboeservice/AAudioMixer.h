@@ -28,6 +28,10 @@ public:
 
     void allocate(int32_t samplesPerFrame, int32_t framesPerBurst);
 
+    /**
+     * Start a new burst. The output buffer is cleared lazily, either by the first stream
+     * mixed into it or by getOutputBuffer() if no stream is mixed.
+     */
     void clear();
 
     /**
@@ -35,21 +39,37 @@ public:
      * @param streamIndex for marking stream variables in systrace
      * @param fifo to read from
      * @param allowUnderflow if true then allow mixer to advance read index past the write index
+     * @param gain to apply to this stream
+     * @param previousGain if not null, the gain applied in the previous burst.
+     *        The gain is ramped from it to gain over the frames mixed from this burst and it
+     *        is then set to gain. It is left unchanged if no frames are mixed.
      * @return frames read from this stream
      */
-    int32_t mix(int streamIndex, std::shared_ptr<android::FifoBuffer> fifo, bool allowUnderflow);
+    int32_t mix(int streamIndex, std::shared_ptr<android::FifoBuffer> fifo, bool allowUnderflow,
+                float gain = 1.0f, float *previousGain = nullptr);
 
     float *getOutputBuffer();
 
     int32_t getFramesPerBurst() const { return mFramesPerBurst; }
 
 private:
-    void mixPart(float *destination, float *source, int32_t numFrames);
+    /**
+     * Mix or copy one contiguous part of the FIFO into the output with a gain ramp.
+     * @param destination in the output buffer
+     * @param source in the FIFO
+     * @param numFrames to mix
+     * @param gain applied to the first frame
+     * @param gainIncrement added to the gain for each following frame
+     * @param accumulate if true add to the destination, otherwise overwrite it
+     */
+    void mixPart(float *destination, const float *source, int32_t numFrames,
+                 float gain, float gainIncrement, bool accumulate);
 
     std::unique_ptr<float[]> mOutputBuffer;
     int32_t  mSamplesPerFrame = 0;
     int32_t  mFramesPerBurst = 0;
     int32_t  mBufferSizeInBytes = 0;
+    bool     mOutputCleared = false; // true if the output buffer holds data for this burst
 };
 
 #endif //AAUDIO_AAUDIO_MIXER_H
@@ -21,12 +21,14 @@
 #include <assert.h>
 #include <map>
 #include <mutex>
+#include <sstream>
 #include <utils/Singleton.h>
 
 #include "AAudioEndpointManager.h"
 #include "AAudioServiceEndpoint.h"
 
 #include "core/AudioStreamBuilder.h"
+#include "utility/AudioClock.h"
 #include "AAudioServiceEndpoint.h"
 #include "AAudioServiceStreamShared.h"
 #include "AAudioServiceEndpointCapture.h"
@@ -40,16 +42,44 @@ AAudioServiceEndpointCapture::AAudioServiceEndpointCapture(AAudioService& audioS
                 new AudioStreamInternalCapture(audioService.asAAudioServiceInterface(), true)) {
 }
 
+std::string AAudioServiceEndpointCapture::dump() const {
+    std::stringstream result;
+    result << "  CAPTURE: readers = " << mCaptureRing.getReaderCount()
+           << ", bursts = " << mCaptureRing.getBurstsPublished()
+           << ", distribution usec last = " << (mLastDistributionNanos.load() / 1000)
+           << ", max = " << (mMaxDistributionNanos.load() / 1000) << "\n";
+    result << AAudioServiceEndpointShared::dump();
+    return result.str();
+}
+
 aaudio_result_t AAudioServiceEndpointCapture::open(const aaudio::AAudioStreamRequest &request) {
     aaudio_result_t result = AAudioServiceEndpointShared::open(request);
     if (result == AAUDIO_OK) {
-        int distributionBufferSizeBytes = getStreamInternal()->getFramesPerBurst()
-                                          * getStreamInternal()->getBytesPerFrame();
-        mDistributionBuffer = std::make_unique<uint8_t[]>(distributionBufferSizeBytes);
+        result = mCaptureRing.allocate(getStreamInternal()->getBytesPerFrame(),
+                                       getStreamInternal()->getFramesPerBurst());
     }
     return result;
 }
 
+aaudio_result_t AAudioServiceEndpointCapture::registerStream(sp<AAudioServiceStreamBase> stream) {
+    // Only shared streams are registered with a shared endpoint.
+    sp<AAudioServiceStreamShared> streamShared =
+            static_cast<AAudioServiceStreamShared *>(stream.get());
+    aaudio_result_t result = mCaptureRing.addReader(streamShared);
+    if (result != AAUDIO_OK) {
+        return result;
+    }
+    return AAudioServiceEndpointShared::registerStream(stream);
+}
+
+aaudio_result_t AAudioServiceEndpointCapture::unregisterStream(
+        sp<AAudioServiceStreamBase> stream) {
+    sp<AAudioServiceStreamShared> streamShared =
+            static_cast<AAudioServiceStreamShared *>(stream.get());
+    mCaptureRing.removeReader(streamShared);
+    return AAudioServiceEndpointShared::unregisterStream(stream);
+}
+
 // Read data from the shared MMAP stream and then distribute it to the client streams.
 void *AAudioServiceEndpointCapture::callbackLoop() {
     ALOGD("callbackLoop() entering");
@@ -61,8 +91,8 @@ void *AAudioServiceEndpointCapture::callbackLoop() {
 
         int64_t mmapFramesRead = getStreamInternal()->getFramesRead();
 
-        // Read audio data from stream using a blocking read.
-        result = getStreamInternal()->read(mDistributionBuffer.get(),
+        // Read audio data from stream directly into the capture ring using a blocking read.
+        result = getStreamInternal()->read(mCaptureRing.getWriteAddress(),
                 getFramesPerBurst(), timeoutNanos);
         if (result == AAUDIO_ERROR_DISCONNECTED) {
             ALOGD("%s() read() returned AAUDIO_ERROR_DISCONNECTED", __func__);
@@ -75,18 +105,14 @@ void *AAudioServiceEndpointCapture::callbackLoop() {
             break;
         }
 
-        // Distribute data to each active stream.
-        { // brackets are for lock_guard
-            std::lock_guard <std::mutex> lock(mLockStreams);
-            for (const auto& clientStream : mRegisteredStreams) {
-                if (clientStream->isRunning() && !clientStream->isSuspended()) {
-                    sp<AAudioServiceStreamShared> streamShared =
-                            static_cast<AAudioServiceStreamShared *>(clientStream.get());
-                    streamShared->writeDataIfRoom(mmapFramesRead,
-                                                  mDistributionBuffer.get(),
-                                                  getFramesPerBurst());
-                }
-            }
+        // Distribute data to each active stream without taking mLockStreams.
+        int64_t startNanos = AudioClock::getNanoseconds();
+        mCaptureRing.publish(mmapFramesRead);
+        mCaptureRing.distribute();
+        int64_t distributionNanos = AudioClock::getNanoseconds() - startNanos;
+        mLastDistributionNanos.store(distributionNanos);
+        if (distributionNanos > mMaxDistributionNanos.load()) {
+            mMaxDistributionNanos.store(distributionNanos);
         }
     }
 
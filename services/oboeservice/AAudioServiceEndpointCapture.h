@@ -24,6 +24,7 @@
 
 #include "AAudioServiceEndpointShared.h"
 #include "AAudioServiceStreamShared.h"
+#include "CaptureRing.h"
 
 namespace aaudio {
 
@@ -32,12 +33,24 @@ public:
     explicit AAudioServiceEndpointCapture(android::AAudioService &audioService);
     virtual ~AAudioServiceEndpointCapture() = default;
 
+    std::string dump() const override;
+
     aaudio_result_t open(const aaudio::AAudioStreamRequest &request) override;
 
+    aaudio_result_t registerStream(android::sp<AAudioServiceStreamBase> stream) override;
+
+    aaudio_result_t unregisterStream(android::sp<AAudioServiceStreamBase> stream) override;
+
     void *callbackLoop() override;
 
 private:
-    std::unique_ptr<uint8_t[]>  mDistributionBuffer;
+    // The callback loop reads each burst into this ring once. The client streams are
+    // readers of the ring, so they can come and go without blocking the callback loop.
+    CaptureRing                 mCaptureRing;
+
+    // Time the callback loop spent distributing a burst, for dump().
+    std::atomic<int64_t>        mLastDistributionNanos{0};
+    std::atomic<int64_t>        mMaxDistributionNanos{0};
 };
 
 } /* namespace aaudio */
@@ -111,6 +111,7 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
                         int64_t positionOffset = mmapFramesWritten - clientFramesRead;
                         streamShared->setTimestampPositionOffset(positionOffset);
 
+                        // The client applies and ramps the stream volume, mix at unity gain.
                         int32_t framesMixed = mMixer.mix(index, fifo, allowUnderflow);
 
                         if (streamShared->isFlowing()) {
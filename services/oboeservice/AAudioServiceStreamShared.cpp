@@ -267,27 +267,28 @@ aaudio_result_t AAudioServiceStreamShared::getHardwareTimestamp(int64_t *positio
     return result;
 }
 
-void AAudioServiceStreamShared::writeDataIfRoom(int64_t mmapFramesRead,
+bool AAudioServiceStreamShared::writeDataIfRoom(int64_t mmapFramesRead,
                                                 const void *buffer, int32_t numFrames) {
     int64_t clientFramesWritten = 0;
+    bool written = false;
 
     // Lock the AudioFifo to protect against close.
     std::lock_guard <std::mutex> lock(audioDataQueueLock);
 
     if (mAudioDataQueue != nullptr) {
         std::shared_ptr<FifoBuffer> fifo = mAudioDataQueue->getFifoBuffer();
-        // Determine offset between framePosition in client's stream
-        // vs the underlying MMAP stream.
-        clientFramesWritten = fifo->getWriteCounter();
-        // There are two indices that refer to the same frame.
-        int64_t positionOffset = mmapFramesRead - clientFramesWritten;
-        setTimestampPositionOffset(positionOffset);
-
         // Is the buffer too full to write a burst?
-        if (fifo->getEmptyFramesAvailable() < getFramesPerBurst()) {
-            incrementXRunCount();
-        } else {
+        // Then leave the data in the capture ring and try again later.
+        if (fifo->getEmptyFramesAvailable() >= numFrames) {
+            // Determine offset between framePosition in client's stream
+            // vs the underlying MMAP stream.
+            clientFramesWritten = fifo->getWriteCounter();
+            // There are two indices that refer to the same frame.
+            int64_t positionOffset = mmapFramesRead - clientFramesWritten;
+            setTimestampPositionOffset(positionOffset);
+
             fifo->write(buffer, numFrames);
+            written = true;
         }
         clientFramesWritten = fifo->getWriteCounter();
     }
@@ -299,4 +300,5 @@ void AAudioServiceStreamShared::writeDataIfRoom(int64_t mmapFramesRead,
         Timestamp timestamp(clientFramesWritten, AudioClock::getNanoseconds());
         markTransferTime(timestamp);
     }
+    return written;
 }
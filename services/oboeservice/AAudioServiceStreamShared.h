@@ -24,6 +24,7 @@
 
 #include "AAudioService.h"
 #include "AAudioServiceStreamBase.h"
+#include "CaptureRing.h"
 
 namespace aaudio {
 
@@ -40,7 +41,9 @@ class SharedRingBuffer;
  *
  * Each Shared stream will register itself with an AAudioServiceEndpoint when it is opened.
  */
-class AAudioServiceStreamShared : public AAudioServiceStreamBase {
+class AAudioServiceStreamShared
+        : public AAudioServiceStreamBase
+        , public CaptureRingReader {
 
 public:
     explicit AAudioServiceStreamShared(android::AAudioService &aAudioService);
@@ -52,7 +55,17 @@ public:
 
     aaudio_result_t open(const aaudio::AAudioStreamRequest &request) override;
 
-    void writeDataIfRoom(int64_t mmapFramesRead, const void *buffer, int32_t numFrames);
+    // CaptureRingReader, used by a shared capture endpoint to distribute data.
+    bool isReadingCapture() const override {
+        return isRunning() && !isSuspended();
+    }
+
+    bool writeDataIfRoom(int64_t mmapFramesRead, const void *buffer,
+                         int32_t numFrames) override;
+
+    void onCaptureOverrun() override {
+        incrementXRunCount();
+    }
 
     /**
      * This must only be called under getAudioDataQueueLock().
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "CaptureRing"
+//#define LOG_NDEBUG 0
+#include <utils/Log.h>
+
+#include <unistd.h>
+
+#include "CaptureRing.h"
+
+using android::sp;
+using namespace aaudio;
+
+// How long removeReader() sleeps while waiting for a distribution pass to finish.
+static constexpr useconds_t kRemoveReaderSleepMicros = 200;
+
+CaptureRing::~CaptureRing() {
+    for (auto &slot : mCursors) {
+        delete slot.exchange(nullptr);
+    }
+}
+
+aaudio_result_t CaptureRing::allocate(int32_t bytesPerFrame, int32_t framesPerBurst,
+                                      int32_t capacityInBursts) {
+    if (bytesPerFrame <= 0 || framesPerBurst <= 0 || capacityInBursts <= 0) {
+        ALOGE("%s() invalid size, %d bytes per frame, %d frames per burst, %d bursts",
+              __func__, bytesPerFrame, framesPerBurst, capacityInBursts);
+        return AAUDIO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    mFramesPerBurst = framesPerBurst;
+    mBytesPerBurst = bytesPerFrame * framesPerBurst;
+    mCapacityInBursts = capacityInBursts;
+    mData = std::make_unique<uint8_t[]>(mBytesPerBurst * capacityInBursts);
+    mPositions = std::make_unique<int64_t[]>(capacityInBursts);
+    return AAUDIO_OK;
+}
+
+aaudio_result_t CaptureRing::addReader(const sp<CaptureRingReader>& reader) {
+    Cursor *cursor = new Cursor();
+    cursor->reader = reader;
+    // Only deliver data that is published from now on.
+    cursor->nextBurst = mWriteCounter.load();
+    std::lock_guard<std::mutex> lock(mReaderLock);
+    for (auto &slot : mCursors) {
+        if (slot.load() == nullptr) {
+            slot.store(cursor);
+            return AAUDIO_OK;
+        }
+    }
+    ALOGE("%s() more than %d readers", __func__, kMaxReaders);
+    delete cursor;
+    return AAUDIO_ERROR_NO_FREE_HANDLES;
+}
+
+void CaptureRing::removeReader(const sp<CaptureRingReader>& reader) {
+    std::lock_guard<std::mutex> lock(mReaderLock);
+    for (auto &slot : mCursors) {
+        Cursor *cursor = slot.load();
+        if (cursor == nullptr || cursor->reader != reader) {
+            continue;
+        }
+        slot.store(nullptr);
+        // A distribution pass that started before the slot was cleared may still use the
+        // cursor. Wait for that pass to end. Later passes can no longer see it.
+        const uint32_t sequence = mDistributeSequence.load();
+        if (sequence & 1) {
+            while (mDistributeSequence.load() == sequence) {
+                usleep(kRemoveReaderSleepMicros);
+            }
+        }
+        delete cursor;
+        return;
+    }
+}
+
+uint8_t *CaptureRing::getWriteAddress() const {
+    const int32_t index = static_cast<int32_t>(mWriteCounter.load() % mCapacityInBursts);
+    return &mData[index * mBytesPerBurst];
+}
+
+void CaptureRing::publish(int64_t mmapFramesRead) {
+    const int64_t writeCounter = mWriteCounter.load();
+    mPositions[writeCounter % mCapacityInBursts] = mmapFramesRead;
+    mWriteCounter.store(writeCounter + 1);
+}
+
+void CaptureRing::distribute() {
+    mDistributeSequence.fetch_add(1); // now odd
+    const int64_t writeCounter = mWriteCounter.load();
+    for (auto &slot : mCursors) {
+        Cursor *cursor = slot.load();
+        if (cursor == nullptr) {
+            continue;
+        }
+        CaptureRingReader *reader = cursor->reader.get();
+        if (!reader->isReadingCapture()) {
+            cursor->nextBurst = writeCounter;
+            continue;
+        }
+        // Has the writer already overwritten bursts that this reader did not get?
+        if (writeCounter - cursor->nextBurst > mCapacityInBursts) {
+            cursor->nextBurst = writeCounter - mCapacityInBursts;
+            reader->onCaptureOverrun();
+        }
+        while (cursor->nextBurst < writeCounter) {
+            const int32_t index = static_cast<int32_t>(cursor->nextBurst % mCapacityInBursts);
+            if (!reader->writeDataIfRoom(mPositions[index], &mData[index * mBytesPerBurst],
+                                         mFramesPerBurst)) {
+                break; // no room, try again on the next pass
+            }
+            cursor->nextBurst++;
+        }
+    }
+    mDistributeSequence.fetch_add(1); // now even
+}
+
+int32_t CaptureRing::getReaderCount() const {
+    int32_t count = 0;
+    for (const auto &slot : mCursors) {
+        if (slot.load() != nullptr) {
+            count++;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AAUDIO_CAPTURE_RING_H
+#define AAUDIO_CAPTURE_RING_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+
+#include <aaudio/AAudio.h>
+#include <utils/RefBase.h>
+
+namespace aaudio {
+
+/**
+ * A reader that receives the data published in a CaptureRing, eg. a shared capture stream.
+ */
+class CaptureRingReader : public virtual android::RefBase {
+public:
+    virtual ~CaptureRingReader() = default;
+
+    /**
+     * @return true if the reader wants data now. While this is false the reader skips
+     *         the data that gets published.
+     */
+    virtual bool isReadingCapture() const = 0;
+
+    /**
+     * Copy one burst into the reader's own buffer if there is room.
+     *
+     * @param mmapFramesRead position of the first frame of the burst in the endpoint stream
+     * @param buffer burst in the format of the ring
+     * @param numFrames frames in the burst
+     * @return true if the burst was consumed, false if the reader has to try again later
+     */
+    virtual bool writeDataIfRoom(int64_t mmapFramesRead, const void *buffer,
+                                 int32_t numFrames) = 0;
+
+    /**
+     * Called when the reader fell more than the ring capacity behind and data was lost.
+     */
+    virtual void onCaptureOverrun() = 0;
+};
+
+/**
+ * Single writer, multiple reader ring of capture bursts.
+ *
+ * The endpoint thread reads each burst from the device directly into the ring and then
+ * lets every reader copy the bursts it has not seen yet, starting at its own cursor.
+ * A reader whose buffer is full stays behind and catches up on a later pass,
+ * so data is only lost once a reader falls more than the ring capacity behind.
+ *
+ * Readers are kept in a fixed array of atomic slots. addReader() and removeReader() only
+ * serialize with each other and do not take any lock that the endpoint thread uses.
+ * removeReader() waits for a distribution pass that is in progress to finish before it
+ * releases the reader, which takes at most the time of one pass.
+ */
+class CaptureRing {
+public:
+    static constexpr int32_t kMaxReaders = 32;
+    static constexpr int32_t kDefaultCapacityInBursts = 4;
+
+    CaptureRing() = default;
+    ~CaptureRing();
+
+    aaudio_result_t allocate(int32_t bytesPerFrame, int32_t framesPerBurst,
+                             int32_t capacityInBursts = kDefaultCapacityInBursts);
+
+    /**
+     * Add a reader. It will receive the bursts published after this call.
+     * Must not be called from the thread calling distribute().
+     *
+     * @return AAUDIO_OK or AAUDIO_ERROR_NO_FREE_HANDLES if there are too many readers
+     */
+    aaudio_result_t addReader(const android::sp<CaptureRingReader>& reader);
+
+    /**
+     * Remove a reader. After this returns the ring no longer references the reader.
+     * Must not be called from the thread calling distribute().
+     */
+    void removeReader(const android::sp<CaptureRingReader>& reader);
+
+    /**
+     * @return address of the next burst, to be filled by the writer and then published
+     */
+    uint8_t *getWriteAddress() const;
+
+    /**
+     * Make the burst at getWriteAddress() available to the readers.
+     * @param mmapFramesRead position of the first frame of the burst in the endpoint stream
+     */
+    void publish(int64_t mmapFramesRead);
+
+    /**
+     * Pass the unread bursts to each reader. Called by the writer after publish().
+     */
+    void distribute();
+
+    int32_t getReaderCount() const;
+
+    int64_t getBurstsPublished() const {
+        return mWriteCounter.load();
+    }
+
+private:
+    struct Cursor {
+        android::sp<CaptureRingReader> reader;
+        int64_t                        nextBurst = 0; // only used by the distributing thread
+    };
+
+    // Serializes addReader() and removeReader(). Never taken by the distributing thread.
+    std::mutex                  mReaderLock;
+    std::atomic<Cursor *>       mCursors[kMaxReaders] = {};
+    // Odd while distribute() is looking at the cursors.
+    std::atomic<uint32_t>       mDistributeSequence{0};
+    std::atomic<int64_t>        mWriteCounter{0};
+
+    std::unique_ptr<uint8_t[]>  mData;
+    std::unique_ptr<int64_t[]>  mPositions;
+    int32_t                     mFramesPerBurst = 0;
+    int32_t                     mBytesPerBurst = 0;
+    int32_t                     mCapacityInBursts = 0;
+};
+
+} /* namespace aaudio */
+
+#endif //AAUDIO_CAPTURE_RING_H
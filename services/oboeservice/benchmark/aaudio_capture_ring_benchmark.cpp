@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Benchmark measuring the jitter of distributing one capture burst to a number of
+ * shared stream clients, as done on the endpoint thread of a shared capture endpoint.
+ * A second thread keeps opening and closing one more client while the bursts are distributed.
+ *
+ * The locked mode copies each burst to the clients under a mutex that is also taken to
+ * register and unregister clients. The ring mode uses CaptureRing.
+ *
+ * To run the benchmark:
+ *   adb shell /data/benchmarktest64/aaudio_capture_ring_benchmark/aaudio_capture_ring_benchmark
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <fifo/FifoBuffer.h>
+
+#include "CaptureRing.h"
+
+using aaudio::CaptureRing;
+using aaudio::CaptureRingReader;
+using android::FifoBufferAllocated;
+using android::sp;
+
+static constexpr int32_t kSamplesPerFrame = 2;
+static constexpr int32_t kBytesPerFrame = kSamplesPerFrame * sizeof(float);
+static constexpr int32_t kFramesPerBurst = 192;
+static constexpr int32_t kFifoCapacityInFrames = 4 * kFramesPerBurst;
+
+enum DistributionMode {
+    kLocked = 0,
+    kRing = 1,
+};
+
+// Client stream whose application reads every burst right away.
+class BenchmarkReader : public CaptureRingReader {
+public:
+    BenchmarkReader() : mFifo(kBytesPerFrame, kFifoCapacityInFrames) {}
+
+    bool isReadingCapture() const override { return true; }
+
+    bool writeDataIfRoom(int64_t mmapFramesRead, const void *buffer,
+                         int32_t numFrames) override {
+        std::lock_guard<std::mutex> lock(mFifoLock);
+        if (mFifo.getEmptyFramesAvailable() < numFrames) {
+            return false;
+        }
+        mFifo.write(buffer, numFrames);
+        mFifo.advanceReadIndex(numFrames);
+        return true;
+    }
+
+    void onCaptureOverrun() override {}
+
+private:
+    std::mutex          mFifoLock;
+    FifoBufferAllocated mFifo;
+};
+
+/*
+ * Distributes one burst to each client.
+ * Args: number of clients, DistributionMode.
+ */
+static void BM_CaptureDistribute(benchmark::State& state) {
+    const int32_t numClients = state.range(0);
+    const DistributionMode mode = static_cast<DistributionMode>(state.range(1));
+
+    CaptureRing ring;
+    ring.allocate(kBytesPerFrame, kFramesPerBurst);
+    std::mutex lockStreams;
+    std::vector<sp<BenchmarkReader>> lockedReaders;
+    for (int32_t i = 0; i < numClients; i++) {
+        sp<BenchmarkReader> reader = new BenchmarkReader();
+        if (mode == kRing) {
+            ring.addReader(reader);
+        } else {
+            lockedReaders.push_back(reader);
+        }
+    }
+    std::vector<uint8_t> burst(kFramesPerBurst * kBytesPerFrame);
+
+    // Open and close another client in a loop, like apps starting and stopping recordings.
+    std::atomic<bool> churning{true};
+    std::thread churnThread([&]() {
+        while (churning.load()) {
+            sp<BenchmarkReader> reader = new BenchmarkReader();
+            if (mode == kRing) {
+                ring.addReader(reader);
+                ring.removeReader(reader);
+            } else {
+                {
+                    std::lock_guard<std::mutex> lock(lockStreams);
+                    lockedReaders.push_back(reader);
+                }
+                std::lock_guard<std::mutex> lock(lockStreams);
+                lockedReaders.erase(std::remove(lockedReaders.begin(), lockedReaders.end(),
+                                                reader), lockedReaders.end());
+            }
+        }
+    });
+
+    std::vector<double> burstMicros;
+    burstMicros.reserve(1 << 16);
+    int64_t burstCount = 0;
+    for (auto _ : state) {
+        auto start = std::chrono::steady_clock::now();
+        if (mode == kRing) {
+            uint8_t *address = ring.getWriteAddress();
+            std::copy(burst.begin(), burst.end(), address); // stands in for the MMAP read
+            ring.publish(burstCount * kFramesPerBurst);
+            ring.distribute();
+        } else {
+            std::lock_guard<std::mutex> lock(lockStreams);
+            for (const auto& reader : lockedReaders) {
+                reader->writeDataIfRoom(burstCount * kFramesPerBurst, burst.data(),
+                                        kFramesPerBurst);
+            }
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        if (burstMicros.size() < burstMicros.capacity()) {
+            burstMicros.push_back(
+                    std::chrono::duration<double, std::micro>(elapsed).count());
+        }
+        burstCount++;
+    }
+
+    churning.store(false);
+    churnThread.join();
+
+    std::sort(burstMicros.begin(), burstMicros.end());
+    if (!burstMicros.empty()) {
+        state.counters["p50_us"] = burstMicros[burstMicros.size() / 2];
+        state.counters["p99_us"] = burstMicros[burstMicros.size() * 99 / 100];
+        state.counters["max_us"] = burstMicros.back();
+    }
+    state.SetItemsProcessed(state.iterations() * numClients * kFramesPerBurst);
+}
+
+static void DistributeArgs(benchmark::internal::Benchmark* b) {
+    for (int mode : {kLocked, kRing}) {
+        for (int numClients : {1, 2, 4, 8, 16}) {
+            b->Args({numClients, mode});
+        }
+    }
+}
+
+BENCHMARK(BM_CaptureDistribute)->Apply(DistributeArgs)->UseRealTime();
+
+BENCHMARK_MAIN();
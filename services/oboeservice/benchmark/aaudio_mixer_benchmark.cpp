@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Benchmark measuring the time AAudioMixer takes to mix one burst from a number of
+ * shared stream clients, as done on the endpoint thread of a shared playback endpoint.
+ *
+ * To run the benchmark:
+ *   adb shell /data/benchmarktest64/aaudio_mixer_benchmark/aaudio_mixer_benchmark
+ */
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <fifo/FifoBuffer.h>
+
+#include "AAudioMixer.h"
+
+using android::FifoBuffer;
+using android::FifoBufferAllocated;
+using android::fifo_frames_t;
+
+static constexpr int32_t kSamplesPerFrame = 2;
+static constexpr int32_t kFramesPerBurst = 192;
+// Not a multiple of the burst so that reads regularly wrap around the end of the FIFO.
+static constexpr int32_t kFifoCapacityInFrames = 4 * kFramesPerBurst + 48;
+
+enum GainMode {
+    kUnityGain = 0,
+    kConstantGain = 1,
+    kRampedGain = 2,
+};
+
+/*
+ * Mixes one burst from each client.
+ * Args: number of clients, GainMode.
+ */
+static void BM_AAudioMixer_Mix(benchmark::State& state) {
+    const int32_t numClients = state.range(0);
+    const GainMode gainMode = static_cast<GainMode>(state.range(1));
+
+    std::minstd_rand gen(42);
+    std::uniform_real_distribution<> dis(-0.5f, 0.5f);
+
+    std::vector<float> burst(kFramesPerBurst * kSamplesPerFrame);
+    std::vector<std::shared_ptr<FifoBuffer>> fifos;
+    for (int32_t i = 0; i < numClients; i++) {
+        auto fifo = std::make_shared<FifoBufferAllocated>(kSamplesPerFrame * sizeof(float),
+                                                          kFifoCapacityInFrames);
+        // Fill the whole FIFO storage once. The benchmark then only moves the indices.
+        for (fifo_frames_t framesLeft = kFifoCapacityInFrames; framesLeft > 0;) {
+            for (auto& sample : burst) sample = dis(gen);
+            framesLeft -= fifo->write(burst.data(), std::min(framesLeft, kFramesPerBurst));
+        }
+        fifo->advanceReadIndex(kFifoCapacityInFrames);
+        fifos.push_back(std::move(fifo));
+    }
+    std::vector<float> gains(numClients, 1.0f);
+
+    AAudioMixer mixer;
+    mixer.allocate(kSamplesPerFrame, kFramesPerBurst);
+
+    int64_t burstCount = 0;
+    for (auto _ : state) {
+        mixer.clear();
+        for (int32_t i = 0; i < numClients; i++) {
+            fifos[i]->advanceWriteIndex(kFramesPerBurst);
+            switch (gainMode) {
+                case kUnityGain:
+                    mixer.mix(i, fifos[i], false /* allowUnderflow */);
+                    break;
+                case kConstantGain:
+                    mixer.mix(i, fifos[i], false /* allowUnderflow */, 0.5f);
+                    break;
+                case kRampedGain:
+                    // Alternate the target gain so that every burst is ramped.
+                    mixer.mix(i, fifos[i], false /* allowUnderflow */,
+                              (burstCount & 1) ? 0.25f : 0.75f, &gains[i]);
+                    break;
+            }
+        }
+        benchmark::DoNotOptimize(mixer.getOutputBuffer());
+        benchmark::ClobberMemory();
+        burstCount++;
+    }
+
+    state.SetComplexityN(numClients);
+    state.SetItemsProcessed(state.iterations() * numClients * kFramesPerBurst);
+}
+
+static void MixerArgs(benchmark::internal::Benchmark* b) {
+    for (int gainMode : {kUnityGain, kConstantGain, kRampedGain}) {
+        for (int numClients : {1, 2, 4, 8, 16}) {
+            b->Args({numClients, gainMode});
+        }
+    }
+}
+
+BENCHMARK(BM_AAudioMixer_Mix)->Apply(MixerArgs);
+
+BENCHMARK_MAIN();